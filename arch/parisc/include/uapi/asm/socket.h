@@ -116,6 +116,8 @@
 
 #define SO_DETACH_REUSEPORT_BPF 0x4042
 
+#define SO_RESERVE_MEM		0x4043
+
 #if !defined(__KERNEL__)
 
 #if __BITS_PER_LONG == 64
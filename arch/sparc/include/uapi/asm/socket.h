@@ -117,6 +117,8 @@
 
 #define SO_DETACH_REUSEPORT_BPF  0x0047
 
+#define SO_RESERVE_MEM           0x0048
+
 #if !defined(__KERNEL__)
 
 
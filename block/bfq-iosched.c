@@ -400,18 +400,41 @@ static struct bfq_io_cq *bfq_bic_lookup(struct bfq_data *bfqd,
 					struct io_context *ioc,
 					struct request_queue *q)
 {
-	if (ioc) {
-		unsigned long flags;
-		struct bfq_io_cq *icq;
+	unsigned long flags;
+	struct io_cq *icq;
 
-		spin_lock_irqsave(&q->queue_lock, flags);
-		icq = icq_to_bic(ioc_lookup_icq(ioc, q));
-		spin_unlock_irqrestore(&q->queue_lock, flags);
+	if (!ioc)
+		return NULL;
 
-		return icq;
+	/*
+	 * Fast path: icqs are freed through RCU and flagged ICQ_DESTROYED
+	 * before the grace period, so the radix tree can be walked under
+	 * rcu_read_lock() without taking the queue_lock.  This keeps the
+	 * hot submission path off a lock that is hammered from every CPU.
+	 */
+	rcu_read_lock();
+	icq = rcu_dereference(ioc->icq_hint);
+	if (icq && icq->q == q && !(icq->flags & ICQ_DESTROYED)) {
+		rcu_read_unlock();
+		return icq_to_bic(icq);
 	}
 
-	return NULL;
+	icq = radix_tree_lookup(&ioc->icq_tree, q->id);
+	if (icq && !(icq->flags & ICQ_DESTROYED)) {
+		rcu_read_unlock();
+		return icq_to_bic(icq);
+	}
+	rcu_read_unlock();
+
+	/*
+	 * Slow path, only taken when the RCU walk comes up empty: the
+	 * locked lookup also refreshes ioc->icq_hint for later callers.
+	 */
+	spin_lock_irqsave(&q->queue_lock, flags);
+	icq = ioc_lookup_icq(ioc, q);
+	spin_unlock_irqrestore(&q->queue_lock, flags);
+
+	return icq_to_bic(icq);
 }
 
 /*
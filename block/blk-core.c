@@ -692,12 +692,20 @@ no_merge:
  *
  * Caller must ensure !blk_queue_nomerges(q) beforehand.
  */
+/*
+ * Bound the number of plugged requests inspected per bio so that huge
+ * plugs don't turn the merge scan into a CPU sink.
+ */
+#define BLK_PLUG_MERGE_SCAN	64
+
 bool blk_attempt_plug_merge(struct request_queue *q, struct bio *bio,
 		unsigned int nr_segs, struct request **same_queue_rq)
 {
 	struct blk_plug *plug;
 	struct request *rq;
 	struct list_head *plug_list;
+	unsigned int to_scan = BLK_PLUG_MERGE_SCAN;
+	const bool discard = bio_op(bio) == REQ_OP_DISCARD;
 
 	plug = blk_mq_plug(q, bio);
 	if (!plug)
@@ -717,7 +725,25 @@ bool blk_attempt_plug_merge(struct request_queue *q, struct bio *bio,
 			*same_queue_rq = rq;
 		}
 
-		if (rq->q != q || !blk_rq_merge_ok(rq, bio))
+		if (rq->q != q)
+			continue;
+
+		if (!to_scan--)
+			break;
+
+		/*
+		 * Cheap positional check first: unless this is a discard
+		 * (which can merge non-adjacent ranges), the bio has to
+		 * line up exactly with one end of the request before the
+		 * full merge checks are worth running.
+		 */
+		if (!discard &&
+		    blk_rq_pos(rq) + blk_rq_sectors(rq) !=
+						bio->bi_iter.bi_sector &&
+		    blk_rq_pos(rq) != bio_end_sector(bio))
+			continue;
+
+		if (!blk_rq_merge_ok(rq, bio))
 			continue;
 
 		switch (blk_try_merge(rq, bio)) {
@@ -416,6 +416,7 @@ struct ioc {
 	int				busy_level;	/* saturation history */
 
 	u64				inuse_margin_vtime;
+	u64				vtime_batch;
 	bool				weights_updated;
 	atomic_t			hweight_gen;	/* for lazy hweights */
 
@@ -426,6 +427,11 @@ struct ioc {
 	bool				user_cost_model:1;
 };
 
+/* per device-cgroup-cpu batched vtime, see iocg_commit_bio_batched() */
+struct iocg_pcpu_vtime {
+	atomic64_t			vtime;
+};
+
 /* per device-cgroup pair */
 struct ioc_gq {
 	struct blkg_policy_data		pd;
@@ -472,6 +478,14 @@ struct ioc_gq {
 	u64				abs_vdebt;
 	u64				last_vtime;
 
+	/*
+	 * The hot issue path accumulates cost here while the iocg has
+	 * plenty of budget and only folds it into @vtime once the local
+	 * batch exceeds ioc->vtime_batch, keeping the common
+	 * within-budget path free of shared cacheline traffic.
+	 */
+	struct iocg_pcpu_vtime __percpu	*pcpu_vtime;
+
 	/*
 	 * The period this iocg was last active in.  Used for deactivation
 	 * and invalidating `vtime`.
@@ -675,6 +689,50 @@ static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio, u64 cost)
 	atomic64_add(cost, &iocg->vtime);
 }
 
+/*
+ * Like iocg_commit_bio() but accumulates the cost in a per-CPU batch
+ * which is only folded into the shared vtime cursor once it grows
+ * beyond ioc->vtime_batch.  The per-CPU counters are still atomics so
+ * that the period timer can fold them from any CPU, but in steady
+ * state each is only ever touched from its own CPU and stays cache
+ * hot there.
+ */
+static void iocg_commit_bio_batched(struct ioc_gq *iocg, struct bio *bio,
+				    u64 cost)
+{
+	struct iocg_pcpu_vtime *pv;
+	u64 batched;
+
+	bio->bi_iocost_cost = cost;
+
+	pv = get_cpu_ptr(iocg->pcpu_vtime);
+	batched = atomic64_add_return(cost, &pv->vtime);
+	if (batched >= iocg->ioc->vtime_batch) {
+		atomic64_sub(batched, &pv->vtime);
+		atomic64_add(batched, &iocg->vtime);
+	}
+	put_cpu_ptr(iocg->pcpu_vtime);
+}
+
+/*
+ * Fold all batched per-CPU vtime into @iocg->vtime so that budget and
+ * idle decisions see an up-to-date cursor.  Called from the period
+ * timer with ioc->lock held.
+ */
+static void iocg_fold_pcpu_vtime(struct ioc_gq *iocg)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct iocg_pcpu_vtime *pv =
+			per_cpu_ptr(iocg->pcpu_vtime, cpu);
+		u64 batched = atomic64_xchg(&pv->vtime, 0);
+
+		if (batched)
+			atomic64_add(batched, &iocg->vtime);
+	}
+}
+
 #define CREATE_TRACE_POINTS
 #include <trace/events/iocost.h>
 
@@ -714,6 +772,13 @@ static void ioc_refresh_period_us(struct ioc *ioc)
 	ioc->margin_us = period_us * MARGIN_PCT / 100;
 	ioc->inuse_margin_vtime = DIV64_U64_ROUND_UP(
 			period_us * VTIME_PER_USEC * INUSE_MARGIN_PCT, 100);
+	/*
+	 * Cap the per-CPU accounting slop at a fraction of the inuse
+	 * margin.  Batched accounting is only used when at least a full
+	 * margin of budget slack remains, so the aggregate slop can't
+	 * push an iocg across the throttling edge undetected.
+	 */
+	ioc->vtime_batch = ioc->inuse_margin_vtime >> 4;
 }
 
 static int ioc_autop_idx(struct ioc *ioc)
@@ -1377,6 +1442,9 @@ static void ioc_timer_fn(struct timer_list *timer)
 	 * should have woken up in the last period and expire idle iocgs.
 	 */
 	list_for_each_entry_safe(iocg, tiocg, &ioc->active_iocgs, active_list) {
+		/* make idle and budget decisions against the real vtime */
+		iocg_fold_pcpu_vtime(iocg);
+
 		if (!waitqueue_active(&iocg->waitq) && iocg->abs_vdebt &&
 		    !iocg_is_idle(iocg))
 			continue;
@@ -1728,7 +1796,16 @@ static void ioc_rqos_throttle(struct rq_qos *rqos, struct bio *bio)
 	 */
 	if (!waitqueue_active(&iocg->waitq) && !iocg->abs_vdebt &&
 	    time_before_eq64(vtime + cost, now.vnow)) {
-		iocg_commit_bio(iocg, bio, cost);
+		/*
+		 * With more than an inuse margin of slack left, account
+		 * the cost in the per-CPU batch and avoid bouncing the
+		 * shared vtime cacheline around.
+		 */
+		if (time_before_eq64(vtime + cost + ioc->inuse_margin_vtime,
+				     now.vnow))
+			iocg_commit_bio_batched(iocg, bio, cost);
+		else
+			iocg_commit_bio(iocg, bio, cost);
 		return;
 	}
 
@@ -2010,6 +2087,12 @@ static struct blkg_policy_data *ioc_pd_alloc(gfp_t gfp, struct request_queue *q,
 	if (!iocg)
 		return NULL;
 
+	iocg->pcpu_vtime = alloc_percpu_gfp(struct iocg_pcpu_vtime, gfp);
+	if (!iocg->pcpu_vtime) {
+		kfree(iocg);
+		return NULL;
+	}
+
 	return &iocg->pd;
 }
 
@@ -2066,6 +2149,7 @@ static void ioc_pd_free(struct blkg_policy_data *pd)
 		hrtimer_cancel(&iocg->waitq_timer);
 		hrtimer_cancel(&iocg->delay_timer);
 	}
+	free_percpu(iocg->pcpu_vtime);
 	kfree(iocg);
 }
 
@@ -13,6 +13,7 @@
 #include "blk-mq-debugfs.h"
 #include "blk-mq-tag.h"
 #include "blk-rq-qos.h"
+#include "blk-stat.h"
 
 static void print_stat(struct seq_file *m, struct blk_rq_stat *stat)
 {
@@ -606,6 +607,60 @@ static ssize_t hctx_run_write(void *data, const char __user *buf, size_t count,
 	return count;
 }
 
+static int hctx_lat_hist_show(void *data, struct seq_file *m)
+{
+	static const char *const op_name[BLK_LAT_HIST_NR] = {
+		"read", "write", "discard",
+	};
+	struct blk_mq_hw_ctx *hctx = data;
+	u64 sum[BLK_LAT_HIST_BUCKETS];
+	int op, bucket, cpu;
+
+	if (!hctx->lat_hist)
+		return 0;
+
+	for (op = 0; op < BLK_LAT_HIST_NR; op++) {
+		memset(sum, 0, sizeof(sum));
+		for_each_possible_cpu(cpu) {
+			struct blk_lat_hist *hist;
+
+			hist = per_cpu_ptr(hctx->lat_hist, cpu);
+			for (bucket = 0; bucket < BLK_LAT_HIST_BUCKETS; bucket++)
+				sum[bucket] += hist->count[op][bucket];
+		}
+		for (bucket = 0; bucket < BLK_LAT_HIST_BUCKETS; bucket++) {
+			if (!sum[bucket])
+				continue;
+			if (bucket == BLK_LAT_HIST_BUCKETS - 1)
+				seq_printf(m, "%s >=%lluns %llu\n",
+					   op_name[op],
+					   1ULL << (BLK_LAT_HIST_SHIFT + bucket - 1),
+					   sum[bucket]);
+			else
+				seq_printf(m, "%s <%lluns %llu\n",
+					   op_name[op],
+					   1ULL << (BLK_LAT_HIST_SHIFT + bucket),
+					   sum[bucket]);
+		}
+	}
+	return 0;
+}
+
+static ssize_t hctx_lat_hist_write(void *data, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct blk_mq_hw_ctx *hctx = data;
+	int cpu;
+
+	if (!hctx->lat_hist)
+		return count;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(hctx->lat_hist, cpu), 0,
+		       sizeof(struct blk_lat_hist));
+	return count;
+}
+
 static int hctx_active_show(void *data, struct seq_file *m)
 {
 	struct blk_mq_hw_ctx *hctx = data;
@@ -789,6 +844,7 @@ static const struct blk_mq_debugfs_attr blk_mq_debugfs_hctx_attrs[] = {
 	{"dispatched", 0600, hctx_dispatched_show, hctx_dispatched_write},
 	{"queued", 0600, hctx_queued_show, hctx_queued_write},
 	{"run", 0600, hctx_run_show, hctx_run_write},
+	{"lat_hist", 0600, hctx_lat_hist_show, hctx_lat_hist_write},
 	{"active", 0400, hctx_active_show},
 	{"dispatch_busy", 0400, hctx_dispatch_busy_show},
 	{"type", 0400, hctx_type_show},
@@ -41,6 +41,7 @@ static void blk_mq_hw_sysfs_release(struct kobject *kobj)
 	if (hctx->flags & BLK_MQ_F_BLOCKING)
 		cleanup_srcu_struct(hctx->srcu);
 	blk_free_flush_queue(hctx->fq);
+	free_percpu(hctx->lat_hist);
 	sbitmap_free(&hctx->ctx_map);
 	free_cpumask_var(hctx->cpumask);
 	kfree(hctx->ctxs);
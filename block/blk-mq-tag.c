@@ -183,6 +183,35 @@ found_tag:
 	return tag + tag_offset;
 }
 
+/*
+ * Bulk version of blk_mq_get_tag() for batched dispatch: try to grab a
+ * run of up to @nr_tags normal tags with one sbitmap operation.  On
+ * success *@offset holds the first tag number (reserved tags already
+ * accounted for) and the returned mask marks which tags relative to it
+ * were obtained.  Never waits; callers fall back to blk_mq_get_tag()
+ * for anything the batch didn't cover.
+ */
+unsigned long blk_mq_get_tags(struct blk_mq_alloc_data *data, int nr_tags,
+			      unsigned int *offset)
+{
+	struct blk_mq_tags *tags = blk_mq_tags_from_data(data);
+	struct sbitmap_queue *bt = &tags->bitmap_tags;
+	unsigned long tag_mask;
+
+	if (data->flags & BLK_MQ_REQ_RESERVED)
+		return 0;
+	if (data->shallow_depth)
+		return 0;
+	if (!(data->flags & BLK_MQ_REQ_INTERNAL) &&
+	    !hctx_may_queue(data->hctx, bt))
+		return 0;
+
+	tag_mask = __sbitmap_queue_get_batch(bt, nr_tags, offset);
+	if (tag_mask)
+		*offset += tags->nr_reserved_tags;
+	return tag_mask;
+}
+
 void blk_mq_put_tag(struct blk_mq_tags *tags, struct blk_mq_ctx *ctx,
 		    unsigned int tag)
 {
@@ -42,6 +42,7 @@
 
 static void blk_mq_poll_stats_start(struct request_queue *q);
 static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb);
+static void blk_mq_poll_hist_add(struct blk_mq_hw_ctx *hctx, u64 nsecs);
 
 static int blk_mq_poll_stats_bkt(const struct request *rq)
 {
@@ -525,6 +526,9 @@ inline void __blk_mq_end_request(struct request *rq, blk_status_t error)
 	if (rq->rq_flags & RQF_STATS) {
 		blk_mq_poll_stats_start(rq->q);
 		blk_stat_add(rq, now);
+		if (rq->cmd_flags & REQ_HIPRI)
+			blk_mq_poll_hist_add(rq->mq_hctx,
+					     now - rq->io_start_time_ns);
 	}
 
 	if (rq->internal_tag != -1)
@@ -641,6 +645,32 @@ bool blk_mq_complete_request(struct request *rq)
 }
 EXPORT_SYMBOL(blk_mq_complete_request);
 
+/**
+ * blk_mq_complete_request_batch - end I/O on a list of requests
+ * @list:	list of completed requests, linked through rq->queuelist
+ *
+ * Description:
+ *	Complete a driver-collected batch of requests in one pass on the
+ *	local CPU.  Unlike calling blk_mq_complete_request() once per
+ *	request, no IPI or softirq is raised per request; drivers that
+ *	harvest many completions per interrupt (or per poll) can use this
+ *	to amortize the completion cost.  Requests are removed from @list
+ *	as they are completed.
+ **/
+void blk_mq_complete_request_batch(struct list_head *list)
+{
+	struct request *rq, *next;
+
+	list_for_each_entry_safe(rq, next, list, queuelist) {
+		list_del_init(&rq->queuelist);
+		if (unlikely(blk_should_fake_timeout(rq->q)))
+			continue;
+		WRITE_ONCE(rq->state, MQ_RQ_COMPLETE);
+		rq->q->mq_ops->complete(rq);
+	}
+}
+EXPORT_SYMBOL_GPL(blk_mq_complete_request_batch);
+
 /**
  * blk_mq_start_request - Start processing a request
  * @rq: Pointer to request to be started
@@ -1056,6 +1086,74 @@ bool blk_mq_get_driver_tag(struct request *rq)
 	return rq->tag != -1;
 }
 
+/* largest driver tag batch grabbed with a single sbitmap operation */
+#define BLK_MQ_TAG_BATCH_MAX	16
+
+/*
+ * Assign driver tags to the leading requests of @list with one bulk
+ * sbitmap grab, so that the per-request blk_mq_get_driver_tag() calls
+ * in the dispatch loop become rq->tag != -1 fast path hits.  Requests
+ * the batch doesn't cover simply fall back to single tag allocation.
+ */
+static void blk_mq_get_driver_tags(struct blk_mq_hw_ctx *hctx,
+				   struct list_head *list)
+{
+	struct blk_mq_alloc_data data = {
+		.q = hctx->queue,
+		.hctx = hctx,
+		.flags = BLK_MQ_REQ_NOWAIT,
+	};
+	struct request *rq;
+	unsigned long tag_mask;
+	unsigned int offset, nr_tags = 0;
+	bool shared;
+
+	list_for_each_entry(rq, list, queuelist) {
+		if (rq->mq_hctx != hctx || rq->tag != -1 ||
+		    blk_mq_tag_is_reserved(hctx->sched_tags, rq->internal_tag))
+			break;
+		if (++nr_tags == BLK_MQ_TAG_BATCH_MAX)
+			break;
+	}
+	if (nr_tags < 2)
+		return;
+
+	shared = blk_mq_tag_busy(hctx);
+	tag_mask = blk_mq_get_tags(&data, nr_tags, &offset);
+	if (!tag_mask)
+		return;
+
+	list_for_each_entry(rq, list, queuelist) {
+		int bit;
+
+		if (!tag_mask)
+			break;
+		if (rq->mq_hctx != hctx || rq->tag != -1 ||
+		    blk_mq_tag_is_reserved(hctx->sched_tags, rq->internal_tag))
+			break;
+
+		bit = __ffs(tag_mask);
+		tag_mask &= tag_mask - 1;
+
+		rq->tag = offset + bit;
+		if (shared) {
+			rq->rq_flags |= RQF_MQ_INFLIGHT;
+			atomic_inc(&hctx->nr_active);
+		}
+		hctx->tags->rqs[rq->tag] = rq;
+	}
+
+	/* leftover bits the list was too short for */
+	while (tag_mask) {
+		int bit = __ffs(tag_mask);
+
+		tag_mask &= tag_mask - 1;
+		sbitmap_queue_clear(&hctx->tags->bitmap_tags,
+				    offset + bit - hctx->tags->nr_reserved_tags,
+				    raw_smp_processor_id());
+	}
+}
+
 static int blk_mq_dispatch_wake(wait_queue_entry_t *wait, unsigned mode,
 				int flags, void *key)
 {
@@ -1195,6 +1293,11 @@ bool blk_mq_dispatch_rq_list(struct request_queue *q, struct list_head *list,
 
 	WARN_ON(!list_is_singular(list) && got_budget);
 
+	if (!list_is_singular(list)) {
+		rq = list_first_entry(list, struct request, queuelist);
+		blk_mq_get_driver_tags(rq->mq_hctx, list);
+	}
+
 	/*
 	 * Now process all the entries, sending them to the driver.
 	 */
@@ -1287,6 +1390,14 @@ bool blk_mq_dispatch_rq_list(struct request_queue *q, struct list_head *list,
 		if (q->mq_ops->commit_rqs)
 			q->mq_ops->commit_rqs(hctx);
 
+		/*
+		 * Give back driver tags the bulk grab assigned to requests
+		 * we never got to dispatch; they'll pick tags up again when
+		 * the queue is rerun.
+		 */
+		list_for_each_entry(rq, list, queuelist)
+			blk_mq_put_driver_tag(rq);
+
 		spin_lock(&hctx->lock);
 		list_splice_tail_init(list, &hctx->dispatch);
 		spin_unlock(&hctx->lock);
@@ -2416,6 +2527,9 @@ blk_mq_alloc_hctx(struct request_queue *q, struct blk_mq_tag_set *set,
 	if (!hctx->fq)
 		goto free_bitmap;
 
+	/* optional; completions are simply not histogrammed on failure */
+	hctx->lat_hist = alloc_percpu_gfp(struct blk_lat_hist, gfp);
+
 	if (hctx->flags & BLK_MQ_F_BLOCKING)
 		init_srcu_struct(hctx->srcu);
 	blk_mq_hctx_kobj_init(hctx);
@@ -2938,11 +3052,15 @@ struct request_queue *blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	 * Default to classic polling
 	 */
 	q->poll_nsec = BLK_MQ_POLL_CLASSIC;
+	q->poll_percentile = 90;
 
 	blk_mq_init_cpu_queues(q, set->nr_hw_queues);
 	blk_mq_add_queue_tag_set(set, q);
 	blk_mq_map_swqueue(q);
 
+	/* keep the per-hctx latency histograms fed even without wbt etc. */
+	blk_stat_enable_accounting(q);
+
 	if (elevator_init)
 		elevator_init_mq(q);
 
@@ -3410,6 +3528,62 @@ static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb)
 	}
 }
 
+/*
+ * Decay the histogram once enough samples have accumulated, so the
+ * estimate tracks workload and media changes.  The halving is racy
+ * versus concurrent increments, but this is only statistics.
+ */
+#define BLK_MQ_POLL_HIST_DECAY	(128 * 1024)
+/* Don't trust the percentile estimate before this many samples */
+#define BLK_MQ_POLL_HIST_MIN_SAMPLES	64
+
+static void blk_mq_poll_hist_add(struct blk_mq_hw_ctx *hctx, u64 nsecs)
+{
+	int bucket = nsecs ? min_t(int, ilog2(nsecs),
+				   BLK_MQ_POLL_HIST_BKTS - 1) : 0;
+
+	atomic_inc(&hctx->poll_hist[bucket]);
+
+	if (atomic_inc_return(&hctx->poll_hist_samples) >=
+	    BLK_MQ_POLL_HIST_DECAY) {
+		atomic_set(&hctx->poll_hist_samples, 0);
+		for (bucket = 0; bucket < BLK_MQ_POLL_HIST_BKTS; bucket++)
+			atomic_set(&hctx->poll_hist[bucket],
+				   atomic_read(&hctx->poll_hist[bucket]) >> 1);
+	}
+}
+
+/*
+ * Estimate the completion latency of the target percentile of polled
+ * requests on this hardware queue.  Returns the lower bound of the
+ * bucket the percentile falls into, so the sleep stays conservative,
+ * or 0 if there aren't enough samples yet.
+ */
+static unsigned long blk_mq_poll_hist_nsecs(struct request_queue *q,
+					    struct blk_mq_hw_ctx *hctx)
+{
+	u64 counts[BLK_MQ_POLL_HIST_BKTS];
+	u64 total = 0, thresh, seen = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < BLK_MQ_POLL_HIST_BKTS; bucket++) {
+		counts[bucket] = atomic_read(&hctx->poll_hist[bucket]);
+		total += counts[bucket];
+	}
+
+	if (total < BLK_MQ_POLL_HIST_MIN_SAMPLES)
+		return 0;
+
+	thresh = div_u64(total * q->poll_percentile, 100);
+	for (bucket = 0; bucket < BLK_MQ_POLL_HIST_BKTS; bucket++) {
+		seen += counts[bucket];
+		if (seen >= thresh)
+			return 1UL << bucket;
+	}
+
+	return 0;
+}
+
 static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 				       struct request *rq)
 {
@@ -3423,6 +3597,15 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 	if (!blk_poll_stats_enable(q))
 		return 0;
 
+	/*
+	 * Prefer the per-hctx latency histogram: sleeping up to the
+	 * target percentile latency polls far less than half-mean on
+	 * devices with tight latency distributions.
+	 */
+	ret = blk_mq_poll_hist_nsecs(q, rq->mq_hctx);
+	if (ret)
+		return ret;
+
 	/*
 	 * As an optimistic guess, use half of the mean service time
 	 * for this type of request. We can (and should) make this smarter.
@@ -3544,6 +3727,13 @@ int blk_poll(struct request_queue *q, blk_qc_t cookie, bool spin)
 	if (current->plug)
 		blk_flush_plug_list(current->plug, false);
 
+	/*
+	 * Bio-based queues (stacking drivers) have no hardware contexts;
+	 * they poll the queues below them through ->poll_fn.
+	 */
+	if (!queue_is_mq(q))
+		return q->poll_fn ? q->poll_fn(q, cookie, spin) : 0;
+
 	hctx = q->queue_hw_ctx[blk_qc_t_to_queue_num(cookie)];
 
 	/*
@@ -48,6 +48,32 @@ void blk_rq_stat_add(struct blk_rq_stat *stat, u64 value)
 	stat->nr_samples++;
 }
 
+/* always-on per-hctx latency histogram, one percpu inc per completion */
+static void blk_stat_hist_add(struct request *rq, u64 value)
+{
+	struct blk_mq_hw_ctx *hctx = rq->mq_hctx;
+	int op;
+
+	if (!hctx || !hctx->lat_hist)
+		return;
+
+	switch (req_op(rq)) {
+	case REQ_OP_READ:
+		op = BLK_LAT_HIST_READ;
+		break;
+	case REQ_OP_WRITE:
+		op = BLK_LAT_HIST_WRITE;
+		break;
+	case REQ_OP_DISCARD:
+		op = BLK_LAT_HIST_DISCARD;
+		break;
+	default:
+		return;
+	}
+
+	this_cpu_inc(hctx->lat_hist->count[op][blk_lat_hist_bucket(value)]);
+}
+
 void blk_stat_add(struct request *rq, u64 now)
 {
 	struct request_queue *q = rq->q;
@@ -59,6 +85,7 @@ void blk_stat_add(struct request *rq, u64 now)
 	value = (now >= rq->io_start_time_ns) ? now - rq->io_start_time_ns : 0;
 
 	blk_throtl_stat_add(rq, value);
+	blk_stat_hist_add(rq, value);
 
 	rcu_read_lock();
 	cpu = get_cpu();
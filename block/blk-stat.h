@@ -62,6 +62,35 @@ struct blk_stat_callback {
 	struct rcu_head rcu;
 };
 
+/*
+ * Always-on per-hctx completion latency histograms.  Unlike the callback
+ * machinery above, these are maintained for every completed request while
+ * QUEUE_FLAG_STATS is set, whether or not a consumer like wbt is attached,
+ * and are exported through blk-mq debugfs.  Buckets are log2 in
+ * nanoseconds: bucket 0 holds everything below 2^BLK_LAT_HIST_SHIFT ns,
+ * bucket i everything below 2^(BLK_LAT_HIST_SHIFT + i) ns, and the last
+ * bucket is open ended.
+ */
+#define BLK_LAT_HIST_SHIFT	10
+#define BLK_LAT_HIST_BUCKETS	32
+
+enum blk_lat_hist_op {
+	BLK_LAT_HIST_READ,
+	BLK_LAT_HIST_WRITE,
+	BLK_LAT_HIST_DISCARD,
+	BLK_LAT_HIST_NR,
+};
+
+struct blk_lat_hist {
+	u64 count[BLK_LAT_HIST_NR][BLK_LAT_HIST_BUCKETS];
+};
+
+static inline int blk_lat_hist_bucket(u64 nsecs)
+{
+	return min_t(int, fls64(nsecs >> BLK_LAT_HIST_SHIFT),
+		     BLK_LAT_HIST_BUCKETS - 1);
+}
+
 struct blk_queue_stats *blk_alloc_queue_stats(void);
 void blk_free_queue_stats(struct blk_queue_stats *);
 
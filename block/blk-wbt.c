@@ -68,6 +68,16 @@ enum {
 	 */
 	RWB_MIN_WRITE_SAMPLES	= 3,
 
+	/*
+	 * Don't trust the read latency percentile below this many samples
+	 */
+	RWB_MIN_READ_SAMPLES	= 8,
+
+	/*
+	 * Default read latency percentile to throttle against
+	 */
+	RWB_DEF_PERCENTILE	= 95,
+
 	/*
 	 * If we have this number of consecutive windows with not enough
 	 * information to scale up or down, scale up.
@@ -178,6 +188,43 @@ static void __wbt_done(struct rq_qos *rqos, enum wbt_flags wb_acct)
 	wbt_rqw_done(rwb, rqw, wb_acct);
 }
 
+static void wbt_lat_hist_add(struct rq_wb *rwb, u64 nsecs)
+{
+	int bucket = nsecs ? min_t(int, ilog2(nsecs),
+				   WBT_LAT_HIST_BKTS - 1) : 0;
+
+	atomic_inc(&rwb->read_lat_hist[bucket]);
+}
+
+/*
+ * Drain the read latency histogram and return the latency of the
+ * target percentile (rounded up to the bucket edge), or 0 if there
+ * weren't enough samples to make a call.
+ */
+static u64 wbt_lat_hist_percentile(struct rq_wb *rwb)
+{
+	u64 counts[WBT_LAT_HIST_BKTS];
+	u64 total = 0, thresh, seen = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < WBT_LAT_HIST_BKTS; bucket++) {
+		counts[bucket] = atomic_xchg(&rwb->read_lat_hist[bucket], 0);
+		total += counts[bucket];
+	}
+
+	if (total < RWB_MIN_READ_SAMPLES)
+		return 0;
+
+	thresh = div_u64(total * rwb->lat_percentile, 100);
+	for (bucket = 0; bucket < WBT_LAT_HIST_BKTS; bucket++) {
+		seen += counts[bucket];
+		if (seen >= thresh)
+			return 1ULL << (bucket + 1);
+	}
+
+	return 0;
+}
+
 /*
  * Called on completion of a request. Note that it's also called when
  * a request is merged, when the request gets freed.
@@ -186,6 +233,9 @@ static void wbt_done(struct rq_qos *rqos, struct request *rq)
 {
 	struct rq_wb *rwb = RQWB(rqos);
 
+	if (wbt_is_read(rq) && rq->io_start_time_ns)
+		wbt_lat_hist_add(rwb, ktime_get_ns() - rq->io_start_time_ns);
+
 	if (!wbt_is_tracked(rq)) {
 		if (rwb->sync_cookie == rq) {
 			rwb->sync_issue = 0;
@@ -270,9 +320,20 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 	}
 
 	/*
-	 * If the 'min' latency exceeds our target, step down.
+	 * Compare the target percentile of read latencies accumulated
+	 * since the last valid window against our target: a handful of
+	 * slow outliers shouldn't halve write depth, and a low minimum
+	 * shouldn't mask a collapsed distribution.  Fall back to the
+	 * window minimum if we didn't see enough reads.
 	 */
-	if (stat[READ].min > rwb->min_lat_nsec) {
+	rwb->last_pctl_nsec = wbt_lat_hist_percentile(rwb);
+	if (rwb->last_pctl_nsec) {
+		if (rwb->last_pctl_nsec > rwb->min_lat_nsec) {
+			trace_wbt_lat(bdi, rwb->last_pctl_nsec);
+			trace_wbt_stat(bdi, stat);
+			return LAT_EXCEEDED;
+		}
+	} else if (stat[READ].min > rwb->min_lat_nsec) {
 		trace_wbt_lat(bdi, stat[READ].min);
 		trace_wbt_stat(bdi, stat);
 		return LAT_EXCEEDED;
@@ -369,6 +430,13 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 	switch (status) {
 	case LAT_EXCEEDED:
 		scale_down(rwb, true);
+		/*
+		 * Proportional response: if the percentile overshot the
+		 * target by more than 2x, one step per window converges
+		 * too slowly - take a second one right away.
+		 */
+		if (rwb->last_pctl_nsec > 2 * rwb->min_lat_nsec)
+			scale_down(rwb, true);
 		break;
 	case LAT_OK:
 		scale_up(rwb);
@@ -841,6 +909,7 @@ int wbt_init(struct request_queue *q)
 	rwb->last_comp = rwb->last_issue = jiffies;
 	rwb->win_nsec = RWB_WINDOW_NSEC;
 	rwb->enable_state = WBT_STATE_ON_DEFAULT;
+	rwb->lat_percentile = RWB_DEF_PERCENTILE;
 	rwb->wc = 1;
 	rwb->rq_depth.default_depth = RWB_DEF_DEPTH;
 	__wbt_update_limits(rwb);
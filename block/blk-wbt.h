@@ -36,6 +36,9 @@ enum {
 	WBT_STATE_ON_MANUAL	= 2,
 };
 
+/* power-of-two buckets of the read completion latency histogram */
+#define WBT_LAT_HIST_BKTS	32
+
 struct rq_wb {
 	/*
 	 * Settings that govern how we throttle
@@ -64,6 +67,17 @@ struct rq_wb {
 	unsigned long last_issue;		/* last non-throttled issue */
 	unsigned long last_comp;		/* last non-throttled comp */
 	unsigned long min_lat_nsec;
+
+	/*
+	 * Read completion latencies bucketed by power of two, drained
+	 * each stat window.  min_lat_nsec is compared against the
+	 * lat_percentile'th percentile of this histogram rather than
+	 * against the window minimum.
+	 */
+	atomic_t read_lat_hist[WBT_LAT_HIST_BKTS];
+	unsigned int lat_percentile;
+	u64 last_pctl_nsec;			/* percentile of last window */
+
 	struct rq_qos rqos;
 	struct rq_wait rq_wait[WBT_NUM_RWQ];
 	struct rq_depth rq_depth;
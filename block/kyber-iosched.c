@@ -64,6 +64,16 @@ static const unsigned int kyber_depth[] = {
 	[KYBER_OTHER] = 16,
 };
 
+/*
+ * On multi-socket machines the domain token pools are sharded per NUMA
+ * node so that the sbitmap atomics stay node-local; a hardware queue
+ * only touches a remote shard when its own node's pool has run dry.  A
+ * token value encodes both the shard it was taken from and the bit
+ * number within that shard's pool.
+ */
+#define KYBER_TOKEN_SHARD_SHIFT	16
+#define KYBER_TOKEN_NR_MASK	((1 << KYBER_TOKEN_SHARD_SHIFT) - 1)
+
 /*
  * Default latency targets for each scheduling domain.
  */
@@ -152,9 +162,11 @@ struct kyber_queue_data {
 
 	/*
 	 * Each scheduling domain has a limited number of in-flight requests
-	 * device-wide, limited by these tokens.
+	 * device-wide, limited by these tokens.  Each entry points to an
+	 * array of nr_token_shards per-NUMA-node pools.
 	 */
-	struct sbitmap_queue domain_tokens[KYBER_NUM_DOMAINS];
+	struct sbitmap_queue *domain_tokens[KYBER_NUM_DOMAINS];
+	unsigned int nr_token_shards;
 
 	/*
 	 * Async request percentage, converted to per-word depth for
@@ -184,6 +196,8 @@ struct kyber_hctx_data {
 	unsigned int batching;
 	struct kyber_ctx_queue *kcqs;
 	struct sbitmap kcq_map[KYBER_NUM_DOMAINS];
+	/* home NUMA shard of the domain token pools for this hctx */
+	unsigned int token_shard;
 	struct sbq_wait domain_wait[KYBER_NUM_DOMAINS];
 	struct sbq_wait_state *domain_ws[KYBER_NUM_DOMAINS];
 	atomic_t wait_index[KYBER_NUM_DOMAINS];
@@ -262,12 +276,24 @@ static int calculate_percentile(struct kyber_queue_data *kqd,
 	return bucket;
 }
 
+/* each shard gets an equal share of a domain's token depth */
+static unsigned int kyber_shard_depth(struct kyber_queue_data *kqd,
+				      unsigned int sched_domain)
+{
+	return max(kyber_depth[sched_domain] / kqd->nr_token_shards, 1U);
+}
+
 static void kyber_resize_domain(struct kyber_queue_data *kqd,
 				unsigned int sched_domain, unsigned int depth)
 {
-	depth = clamp(depth, 1U, kyber_depth[sched_domain]);
-	if (depth != kqd->domain_tokens[sched_domain].sb.depth) {
-		sbitmap_queue_resize(&kqd->domain_tokens[sched_domain], depth);
+	unsigned int shard;
+
+	depth = clamp(depth, 1U, kyber_shard_depth(kqd, sched_domain));
+	if (depth != kqd->domain_tokens[sched_domain][0].sb.depth) {
+		for (shard = 0; shard < kqd->nr_token_shards; shard++)
+			sbitmap_queue_resize(
+				&kqd->domain_tokens[sched_domain][shard],
+				depth);
 		trace_kyber_adjust(kqd->q, kyber_domain_names[sched_domain],
 				   depth);
 	}
@@ -346,7 +372,7 @@ static void kyber_timer_fn(struct timer_list *t)
 		 * is 2x the target, then we double the depth.
 		 */
 		if (bad || p99 >= KYBER_GOOD_BUCKETS) {
-			orig_depth = kqd->domain_tokens[sched_domain].sb.depth;
+			orig_depth = kqd->domain_tokens[sched_domain][0].sb.depth;
 			depth = (orig_depth * (p99 + 1)) >> KYBER_LATENCY_SHIFT;
 			kyber_resize_domain(kqd, sched_domain, depth);
 		}
@@ -362,6 +388,53 @@ static unsigned int kyber_sched_tags_shift(struct request_queue *q)
 	return q->queue_hw_ctx[0]->sched_tags->bitmap_tags.sb.shift;
 }
 
+static void kyber_free_domain_tokens(struct kyber_queue_data *kqd)
+{
+	unsigned int i, shard;
+
+	for (i = 0; i < KYBER_NUM_DOMAINS; i++) {
+		if (!kqd->domain_tokens[i])
+			continue;
+		for (shard = 0; shard < kqd->nr_token_shards; shard++)
+			sbitmap_queue_free(&kqd->domain_tokens[i][shard]);
+		kfree(kqd->domain_tokens[i]);
+		kqd->domain_tokens[i] = NULL;
+	}
+}
+
+static int kyber_alloc_domain_tokens(struct kyber_queue_data *kqd,
+				     unsigned int sched_domain)
+{
+	unsigned int shard;
+	int ret;
+
+	kqd->domain_tokens[sched_domain] =
+		kcalloc(kqd->nr_token_shards,
+			sizeof(*kqd->domain_tokens[sched_domain]), GFP_KERNEL);
+	if (!kqd->domain_tokens[sched_domain])
+		return -ENOMEM;
+
+	for (shard = 0; shard < kqd->nr_token_shards; shard++) {
+		/* with a single shard, keep the pool next to the queue */
+		int node = kqd->nr_token_shards > 1 ? shard : kqd->q->node;
+
+		ret = sbitmap_queue_init_node(
+				&kqd->domain_tokens[sched_domain][shard],
+				kyber_shard_depth(kqd, sched_domain), -1,
+				false, GFP_KERNEL, node);
+		if (ret) {
+			while (shard-- > 0)
+				sbitmap_queue_free(
+					&kqd->domain_tokens[sched_domain][shard]);
+			kfree(kqd->domain_tokens[sched_domain]);
+			kqd->domain_tokens[sched_domain] = NULL;
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
 static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 {
 	struct kyber_queue_data *kqd;
@@ -382,15 +455,14 @@ static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 
 	timer_setup(&kqd->timer, kyber_timer_fn, 0);
 
+	kqd->nr_token_shards = nr_online_nodes > 1 ? nr_node_ids : 1;
+
 	for (i = 0; i < KYBER_NUM_DOMAINS; i++) {
 		WARN_ON(!kyber_depth[i]);
 		WARN_ON(!kyber_batch_size[i]);
-		ret = sbitmap_queue_init_node(&kqd->domain_tokens[i],
-					      kyber_depth[i], -1, false,
-					      GFP_KERNEL, q->node);
+		ret = kyber_alloc_domain_tokens(kqd, i);
 		if (ret) {
-			while (--i >= 0)
-				sbitmap_queue_free(&kqd->domain_tokens[i]);
+			kyber_free_domain_tokens(kqd);
 			goto err_buckets;
 		}
 	}
@@ -439,12 +511,10 @@ static int kyber_init_sched(struct request_queue *q, struct elevator_type *e)
 static void kyber_exit_sched(struct elevator_queue *e)
 {
 	struct kyber_queue_data *kqd = e->elevator_data;
-	int i;
 
 	del_timer_sync(&kqd->timer);
 
-	for (i = 0; i < KYBER_NUM_DOMAINS; i++)
-		sbitmap_queue_free(&kqd->domain_tokens[i]);
+	kyber_free_domain_tokens(kqd);
 	free_percpu(kqd->cpu_latency);
 	kfree(kqd);
 }
@@ -498,6 +568,11 @@ static int kyber_init_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
 		atomic_set(&khd->wait_index[i], 0);
 	}
 
+	if (kqd->nr_token_shards > 1 && hctx->numa_node != NUMA_NO_NODE)
+		khd->token_shard = hctx->numa_node;
+	else
+		khd->token_shard = 0;
+
 	khd->cur_domain = 0;
 	khd->batching = 0;
 
@@ -543,8 +618,11 @@ static void rq_clear_domain_token(struct kyber_queue_data *kqd,
 
 	nr = rq_get_domain_token(rq);
 	if (nr != -1) {
+		unsigned int shard = nr >> KYBER_TOKEN_SHARD_SHIFT;
+
 		sched_domain = kyber_sched_domain(rq->cmd_flags);
-		sbitmap_queue_clear(&kqd->domain_tokens[sched_domain], nr,
+		sbitmap_queue_clear(&kqd->domain_tokens[sched_domain][shard],
+				    nr & KYBER_TOKEN_NR_MASK,
 				    rq->mq_ctx->cpu);
 	}
 }
@@ -699,21 +777,47 @@ static int kyber_domain_wake(wait_queue_entry_t *wqe, unsigned mode, int flags,
 	return 1;
 }
 
+/*
+ * Grab a token, preferring @shard's node-local pool and work-stealing
+ * from the other shards when it has run dry.  The returned value
+ * encodes the shard the token came from.
+ */
+static int kyber_shard_token_get(struct kyber_queue_data *kqd,
+				 unsigned int sched_domain,
+				 unsigned int shard)
+{
+	unsigned int i, cur = shard;
+	int nr;
+
+	for (i = 0; i < kqd->nr_token_shards; i++) {
+		nr = __sbitmap_queue_get(&kqd->domain_tokens[sched_domain][cur]);
+		if (nr >= 0)
+			return (cur << KYBER_TOKEN_SHARD_SHIFT) | nr;
+		if (++cur == kqd->nr_token_shards)
+			cur = 0;
+	}
+
+	return -1;
+}
+
 static int kyber_get_domain_token(struct kyber_queue_data *kqd,
 				  struct kyber_hctx_data *khd,
 				  struct blk_mq_hw_ctx *hctx)
 {
 	unsigned int sched_domain = khd->cur_domain;
-	struct sbitmap_queue *domain_tokens = &kqd->domain_tokens[sched_domain];
+	struct sbitmap_queue *domain_tokens =
+		&kqd->domain_tokens[sched_domain][khd->token_shard];
 	struct sbq_wait *wait = &khd->domain_wait[sched_domain];
 	struct sbq_wait_state *ws;
 	int nr;
 
-	nr = __sbitmap_queue_get(domain_tokens);
+	nr = kyber_shard_token_get(kqd, sched_domain, khd->token_shard);
 
 	/*
 	 * If we failed to get a domain token, make sure the hardware queue is
-	 * run when one becomes available. Note that this is serialized on
+	 * run when one becomes available.  We wait on our node-local shard;
+	 * its tokens are freed back to it no matter which CPU releases them,
+	 * so the wakeup can't get lost.  Note that this is serialized on
 	 * khd->lock, but we still need to be careful about the waker.
 	 */
 	if (nr < 0 && list_empty_careful(&wait->wait.entry)) {
@@ -726,7 +830,7 @@ static int kyber_get_domain_token(struct kyber_queue_data *kqd,
 		 * Try again in case a token was freed before we got on the wait
 		 * queue.
 		 */
-		nr = __sbitmap_queue_get(domain_tokens);
+		nr = kyber_shard_token_get(kqd, sched_domain, khd->token_shard);
 	}
 
 	/*
@@ -898,8 +1002,10 @@ static int kyber_##name##_tokens_show(void *data, struct seq_file *m)	\
 {									\
 	struct request_queue *q = data;					\
 	struct kyber_queue_data *kqd = q->elevator->elevator_data;	\
+	unsigned int shard;						\
 									\
-	sbitmap_queue_show(&kqd->domain_tokens[domain], m);		\
+	for (shard = 0; shard < kqd->nr_token_shards; shard++)		\
+		sbitmap_queue_show(&kqd->domain_tokens[domain][shard], m); \
 	return 0;							\
 }									\
 									\
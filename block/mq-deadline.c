@@ -15,6 +15,7 @@
 #include <linux/slab.h>
 #include <linux/init.h>
 #include <linux/compiler.h>
+#include <linux/list_sort.h>
 #include <linux/rbtree.h>
 #include <linux/sbitmap.h>
 
@@ -520,12 +521,33 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 	}
 }
 
+static int dd_request_cmp(void *priv, struct list_head *a, struct list_head *b)
+{
+	struct request *rqa = list_entry(a, struct request, queuelist);
+	struct request *rqb = list_entry(b, struct request, queuelist);
+
+	if (rq_data_dir(rqa) != rq_data_dir(rqb))
+		return rq_data_dir(rqa) < rq_data_dir(rqb) ? -1 : 1;
+	if (blk_rq_pos(rqa) != blk_rq_pos(rqb))
+		return blk_rq_pos(rqa) < blk_rq_pos(rqb) ? -1 : 1;
+	return 0;
+}
+
 static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 			       struct list_head *list, bool at_head)
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
 
+	/*
+	 * Sort the batch by direction and sector before grabbing dd->lock:
+	 * the rbtree inserts below then descend mostly adjacent paths and
+	 * the sort FIFOs are filled in ascending order, which shortens the
+	 * single critical section the whole plug batch is inserted under.
+	 */
+	if (!at_head && !list_is_singular(list))
+		list_sort(NULL, list, dd_request_cmp);
+
 	spin_lock(&dd->lock);
 	while (!list_empty(list)) {
 		struct request *rq;
@@ -803,6 +803,12 @@ static void af_alg_data_wakeup(struct sock *sk)
  * in ctx->tsgl_list. This implies allocation of the required numbers of
  * struct af_alg_tsgl.
  *
+ * With MSG_ZEROCOPY the user pages are pinned into ctx->tsgl_list
+ * instead of being copied. The caller must then leave the buffer alone
+ * until the cipher operation consuming it has completed, i.e. until the
+ * matching recvmsg system call (or its AIO completion) has returned -
+ * the same contract as for data submitted via sendpage or splice.
+ *
  * In addition, the ctx is filled with the information sent via CMSG.
  *
  * @sock socket of connection to user space
@@ -860,6 +866,84 @@ int af_alg_sendmsg(struct socket *sock, struct msghdr *msg, size_t size,
 		ctx->aead_assoclen = con.aead_assoclen;
 	}
 
+	if (msg->msg_flags & MSG_ZEROCOPY) {
+		/*
+		 * Pin the user pages straight into the TX SGL instead of
+		 * copying the data through freshly allocated pages. The
+		 * references are dropped by af_alg_pull_tsgl() once the
+		 * cipher operation has consumed the data, exactly as for
+		 * pages obtained via sendpage.
+		 */
+		ctx->merge = 0;
+
+		while (size) {
+			struct scatterlist *sg;
+			struct page *pages[ALG_MAX_PAGES];
+			size_t len;
+			size_t off;
+			size_t plen;
+			ssize_t bytes;
+			int i;
+
+			if (!af_alg_writable(sk)) {
+				err = af_alg_wait_for_wmem(sk, msg->msg_flags);
+				if (err)
+					goto unlock;
+			}
+
+			len = min_t(size_t, size, af_alg_sndbuf(sk));
+
+			err = af_alg_alloc_tsgl(sk);
+			if (err)
+				goto unlock;
+
+			sgl = list_entry(ctx->tsgl_list.prev,
+					 struct af_alg_tsgl, list);
+			sg = sgl->sg;
+			if (sgl->cur)
+				sg_unmark_end(sg + sgl->cur - 1);
+
+			while (len && sgl->cur < MAX_SGL_ENTS) {
+				bytes = iov_iter_get_pages(&msg->msg_iter,
+							   pages, len,
+							   min_t(unsigned int,
+								 ALG_MAX_PAGES,
+								 MAX_SGL_ENTS -
+								 sgl->cur),
+							   &off);
+				if (bytes <= 0) {
+					err = bytes ?: -EFAULT;
+					goto unlock;
+				}
+				iov_iter_advance(&msg->msg_iter, bytes);
+
+				len -= bytes;
+				size -= bytes;
+				ctx->used += bytes;
+				copied += bytes;
+
+				for (i = 0; bytes; i++) {
+					plen = min_t(size_t, bytes,
+						     PAGE_SIZE - off);
+
+					sg_set_page(sg + sgl->cur, pages[i],
+						    plen, off);
+					sgl->cur++;
+
+					off = 0;
+					bytes -= plen;
+				}
+			}
+
+			sg_mark_end(sg + sgl->cur - 1);
+		}
+
+		err = 0;
+
+		ctx->more = msg->msg_flags & MSG_MORE;
+		goto unlock;
+	}
+
 	while (size) {
 		struct scatterlist *sg;
 		size_t len = size;
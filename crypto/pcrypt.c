@@ -15,6 +15,7 @@
 #include <linux/slab.h>
 #include <linux/kobject.h>
 #include <linux/cpu.h>
+#include <linux/topology.h>
 #include <crypto/pcrypt.h>
 
 static struct padata_instance *pencrypt;
@@ -23,22 +24,23 @@ static struct kset           *pcrypt_kset;
 
 struct pcrypt_instance_ctx {
 	struct crypto_aead_spawn spawn;
-	struct padata_shell *psenc;
-	struct padata_shell *psdec;
 	atomic_t tfm_count;
 };
 
+/*
+ * Each transform owns its padata shells and thereby its own sequence
+ * domain: requests are only ordered against other requests of the same
+ * transform.  For IPsec that is one domain per SA, so a stall on one
+ * flow no longer delays serialization of every other flow behind a
+ * global sequence counter.
+ */
 struct pcrypt_aead_ctx {
 	struct crypto_aead *child;
+	struct padata_shell *psenc;
+	struct padata_shell *psdec;
 	unsigned int cb_cpu;
 };
 
-static inline struct pcrypt_instance_ctx *pcrypt_tfm_ictx(
-	struct crypto_aead *tfm)
-{
-	return aead_instance_ctx(aead_alg_instance(tfm));
-}
-
 static int pcrypt_aead_setkey(struct crypto_aead *parent,
 			      const u8 *key, unsigned int keylen)
 {
@@ -96,9 +98,6 @@ static int pcrypt_aead_encrypt(struct aead_request *req)
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(aead);
 	u32 flags = aead_request_flags(req);
-	struct pcrypt_instance_ctx *ictx;
-
-	ictx = pcrypt_tfm_ictx(aead);
 
 	memset(padata, 0, sizeof(struct padata_priv));
 
@@ -112,7 +111,7 @@ static int pcrypt_aead_encrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psenc, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ctx->psenc, padata, &ctx->cb_cpu);
 	if (!err)
 		return -EINPROGRESS;
 
@@ -141,9 +140,6 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(aead);
 	u32 flags = aead_request_flags(req);
-	struct pcrypt_instance_ctx *ictx;
-
-	ictx = pcrypt_tfm_ictx(aead);
 
 	memset(padata, 0, sizeof(struct padata_priv));
 
@@ -157,7 +153,7 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psdec, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ctx->psdec, padata, &ctx->cb_cpu);
 	if (!err)
 		return -EINPROGRESS;
 
@@ -166,23 +162,54 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 
 static int pcrypt_aead_init_tfm(struct crypto_aead *tfm)
 {
-	int cpu, cpu_index;
+	int cpu, cpu_index, nr_node_cpus = 0;
+	int err = -ENOMEM;
 	struct aead_instance *inst = aead_alg_instance(tfm);
 	struct pcrypt_instance_ctx *ictx = aead_instance_ctx(inst);
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	const struct cpumask *node_mask = cpumask_of_node(numa_node_id());
 	struct crypto_aead *cipher;
 
-	cpu_index = (unsigned int)atomic_inc_return(&ictx->tfm_count) %
-		    cpumask_weight(cpu_online_mask);
+	ctx->psenc = padata_alloc_shell(pencrypt);
+	if (!ctx->psenc)
+		return -ENOMEM;
 
-	ctx->cb_cpu = cpumask_first(cpu_online_mask);
-	for (cpu = 0; cpu < cpu_index; cpu++)
-		ctx->cb_cpu = cpumask_next(ctx->cb_cpu, cpu_online_mask);
+	ctx->psdec = padata_alloc_shell(pdecrypt);
+	if (!ctx->psdec)
+		goto err_free_psenc;
+
+	/*
+	 * Round-robin the serialization callback over the cpus of the
+	 * node the transform is set up on, so completions stay
+	 * NUMA-local to the flow; fall back to all online cpus on
+	 * nodes without any.
+	 */
+	for_each_cpu_and(cpu, node_mask, cpu_online_mask)
+		nr_node_cpus++;
+
+	cpu_index = (unsigned int)atomic_inc_return(&ictx->tfm_count);
+	if (nr_node_cpus) {
+		cpu_index %= nr_node_cpus;
+		for_each_cpu_and(cpu, node_mask, cpu_online_mask) {
+			if (!cpu_index)
+				break;
+			cpu_index--;
+		}
+		ctx->cb_cpu = cpu;
+	} else {
+		cpu_index %= cpumask_weight(cpu_online_mask);
+		ctx->cb_cpu = cpumask_first(cpu_online_mask);
+		for (cpu = 0; cpu < cpu_index; cpu++)
+			ctx->cb_cpu = cpumask_next(ctx->cb_cpu,
+						   cpu_online_mask);
+	}
 
 	cipher = crypto_spawn_aead(&ictx->spawn);
 
-	if (IS_ERR(cipher))
-		return PTR_ERR(cipher);
+	if (IS_ERR(cipher)) {
+		err = PTR_ERR(cipher);
+		goto err_free_psdec;
+	}
 
 	ctx->child = cipher;
 	crypto_aead_set_reqsize(tfm, sizeof(struct pcrypt_request) +
@@ -190,6 +217,12 @@ static int pcrypt_aead_init_tfm(struct crypto_aead *tfm)
 				     crypto_aead_reqsize(cipher));
 
 	return 0;
+
+err_free_psdec:
+	padata_free_shell(ctx->psdec);
+err_free_psenc:
+	padata_free_shell(ctx->psenc);
+	return err;
 }
 
 static void pcrypt_aead_exit_tfm(struct crypto_aead *tfm)
@@ -197,6 +230,8 @@ static void pcrypt_aead_exit_tfm(struct crypto_aead *tfm)
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(tfm);
 
 	crypto_free_aead(ctx->child);
+	padata_free_shell(ctx->psdec);
+	padata_free_shell(ctx->psenc);
 }
 
 static void pcrypt_free(struct aead_instance *inst)
@@ -204,8 +239,6 @@ static void pcrypt_free(struct aead_instance *inst)
 	struct pcrypt_instance_ctx *ctx = aead_instance_ctx(inst);
 
 	crypto_drop_aead(&ctx->spawn);
-	padata_free_shell(ctx->psdec);
-	padata_free_shell(ctx->psenc);
 	kfree(inst);
 }
 
@@ -247,21 +280,11 @@ static int pcrypt_create_aead(struct crypto_template *tmpl, struct rtattr **tb,
 	if (!inst)
 		return -ENOMEM;
 
-	err = -ENOMEM;
-
 	ctx = aead_instance_ctx(inst);
-	ctx->psenc = padata_alloc_shell(pencrypt);
-	if (!ctx->psenc)
-		goto out_free_inst;
-
-	ctx->psdec = padata_alloc_shell(pdecrypt);
-	if (!ctx->psdec)
-		goto out_free_psenc;
-
 	err = crypto_grab_aead(&ctx->spawn, aead_crypto_instance(inst),
 			       name, 0, 0);
 	if (err)
-		goto out_free_psdec;
+		goto out_free_inst;
 
 	alg = crypto_spawn_aead_alg(&ctx->spawn);
 	err = pcrypt_init_instance(aead_crypto_instance(inst), &alg->base);
@@ -294,10 +317,6 @@ out:
 
 out_drop_aead:
 	crypto_drop_aead(&ctx->spawn);
-out_free_psdec:
-	padata_free_shell(ctx->psdec);
-out_free_psenc:
-	padata_free_shell(ctx->psenc);
 out_free_inst:
 	kfree(inst);
 	goto out;
@@ -36,6 +36,13 @@ static DEFINE_PER_CPU(struct scomp_scratch, scomp_scratch) = {
 
 static const struct crypto_type crypto_scomp_type;
 static int scomp_scratch_users;
+/*
+ * Current size of the per-cpu scratch buffers: the largest scratch_size
+ * declared by any live algorithm, SCOMP_SCRATCH_SIZE for algorithms that
+ * do not declare one.  Only grows while there are users; see the
+ * ordering comment in crypto_scomp_grow_scratches().
+ */
+static unsigned int scomp_scratch_size;
 static DEFINE_MUTEX(scomp_lock);
 
 #ifdef CONFIG_NET
@@ -78,9 +85,10 @@ static void crypto_scomp_free_scratches(void)
 		scratch->src = NULL;
 		scratch->dst = NULL;
 	}
+	scomp_scratch_size = 0;
 }
 
-static int crypto_scomp_alloc_scratches(void)
+static int crypto_scomp_alloc_scratches(unsigned int size)
 {
 	struct scomp_scratch *scratch;
 	int i;
@@ -90,28 +98,72 @@ static int crypto_scomp_alloc_scratches(void)
 
 		scratch = per_cpu_ptr(&scomp_scratch, i);
 
-		mem = vmalloc_node(SCOMP_SCRATCH_SIZE, cpu_to_node(i));
+		mem = vmalloc_node(size, cpu_to_node(i));
 		if (!mem)
 			goto error;
 		scratch->src = mem;
-		mem = vmalloc_node(SCOMP_SCRATCH_SIZE, cpu_to_node(i));
+		mem = vmalloc_node(size, cpu_to_node(i));
 		if (!mem)
 			goto error;
 		scratch->dst = mem;
 	}
+	scomp_scratch_size = size;
 	return 0;
 error:
 	crypto_scomp_free_scratches();
 	return -ENOMEM;
 }
 
+static int crypto_scomp_grow_scratches(unsigned int size)
+{
+	struct scomp_scratch *scratch;
+	void *src, *dst, *old_src, *old_dst;
+	int i;
+
+	for_each_possible_cpu(i) {
+		src = vmalloc_node(size, cpu_to_node(i));
+		dst = src ? vmalloc_node(size, cpu_to_node(i)) : NULL;
+		if (!dst) {
+			vfree(src);
+			return -ENOMEM;
+		}
+
+		scratch = per_cpu_ptr(&scomp_scratch, i);
+		spin_lock(&scratch->lock);
+		old_src = scratch->src;
+		old_dst = scratch->dst;
+		scratch->src = src;
+		scratch->dst = dst;
+		spin_unlock(&scratch->lock);
+		vfree(old_src);
+		vfree(old_dst);
+	}
+
+	/*
+	 * Requests validate their length against scomp_scratch_size
+	 * before taking the scratch lock, so the new limit must only
+	 * become visible once every cpu carries the larger buffers.
+	 * A request that still saw the old limit simply underuses them.
+	 */
+	WRITE_ONCE(scomp_scratch_size, size);
+	return 0;
+}
+
 static int crypto_scomp_init_tfm(struct crypto_tfm *tfm)
 {
+	unsigned int size = crypto_scomp_alg(__crypto_scomp_tfm(tfm))->scratch_size;
 	int ret = 0;
 
+	if (!size || size > SCOMP_SCRATCH_SIZE)
+		size = SCOMP_SCRATCH_SIZE;
+
 	mutex_lock(&scomp_lock);
-	if (!scomp_scratch_users++)
-		ret = crypto_scomp_alloc_scratches();
+	if (!scomp_scratch_users)
+		ret = crypto_scomp_alloc_scratches(size);
+	else if (size > scomp_scratch_size)
+		ret = crypto_scomp_grow_scratches(size);
+	if (!ret)
+		scomp_scratch_users++;
 	mutex_unlock(&scomp_lock);
 
 	return ret;
@@ -124,16 +176,17 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 	struct crypto_scomp *scomp = *tfm_ctx;
 	void **ctx = acomp_request_ctx(req);
 	struct scomp_scratch *scratch;
+	unsigned int scratch_size = READ_ONCE(scomp_scratch_size);
 	int ret;
 
-	if (!req->src || !req->slen || req->slen > SCOMP_SCRATCH_SIZE)
+	if (!req->src || !req->slen || req->slen > scratch_size)
 		return -EINVAL;
 
 	if (req->dst && !req->dlen)
 		return -EINVAL;
 
-	if (!req->dlen || req->dlen > SCOMP_SCRATCH_SIZE)
-		req->dlen = SCOMP_SCRATCH_SIZE;
+	if (!req->dlen || req->dlen > scratch_size)
+		req->dlen = scratch_size;
 
 	scratch = raw_cpu_ptr(&scomp_scratch);
 	spin_lock(&scratch->lock);
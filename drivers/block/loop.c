@@ -921,9 +921,14 @@ static int loop_kthread_worker_fn(void *worker_ptr)
 	return kthread_worker_fn(worker_ptr);
 }
 
+static void loop_process_work(struct kthread_work *work);
+
 static int loop_prepare_queue(struct loop_device *lo)
 {
 	kthread_init_worker(&lo->worker);
+	spin_lock_init(&lo->cmd_lock);
+	INIT_LIST_HEAD(&lo->cmd_list);
+	kthread_init_work(&lo->rq_work, loop_process_work);
 	lo->worker_task = kthread_run(loop_kthread_worker_fn,
 			&lo->worker, "loop%d", lo->lo_number);
 	if (IS_ERR(lo->worker_task))
@@ -1952,7 +1957,11 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 	} else
 #endif
 		cmd->css = NULL;
-	kthread_queue_work(&lo->worker, &cmd->work);
+
+	spin_lock_irq(&lo->cmd_lock);
+	list_add_tail(&cmd->list_entry, &lo->cmd_list);
+	spin_unlock_irq(&lo->cmd_lock);
+	kthread_queue_work(&lo->worker, &lo->rq_work);
 
 	return BLK_STS_OK;
 }
@@ -1978,26 +1987,42 @@ static void loop_handle_cmd(struct loop_cmd *cmd)
 	}
 }
 
-static void loop_queue_work(struct kthread_work *work)
+static void loop_process_work(struct kthread_work *work)
 {
-	struct loop_cmd *cmd =
-		container_of(work, struct loop_cmd, work);
+	struct loop_device *lo =
+		container_of(work, struct loop_device, rq_work);
+	struct loop_cmd *cmd;
+	struct blk_plug plug;
+	LIST_HEAD(cmd_list);
 
-	loop_handle_cmd(cmd);
-}
+	/*
+	 * Plug across the whole batch so the io we issue to the backing
+	 * file gets merged and submitted in one go rather than request
+	 * by request.
+	 */
+	blk_start_plug(&plug);
+
+	spin_lock_irq(&lo->cmd_lock);
+	while (!list_empty(&lo->cmd_list)) {
+		list_splice_init(&lo->cmd_list, &cmd_list);
+		spin_unlock_irq(&lo->cmd_lock);
+
+		while (!list_empty(&cmd_list)) {
+			cmd = list_first_entry(&cmd_list, struct loop_cmd,
+					       list_entry);
+			list_del(&cmd->list_entry);
+			loop_handle_cmd(cmd);
+		}
 
-static int loop_init_request(struct blk_mq_tag_set *set, struct request *rq,
-		unsigned int hctx_idx, unsigned int numa_node)
-{
-	struct loop_cmd *cmd = blk_mq_rq_to_pdu(rq);
+		spin_lock_irq(&lo->cmd_lock);
+	}
+	spin_unlock_irq(&lo->cmd_lock);
 
-	kthread_init_work(&cmd->work, loop_queue_work);
-	return 0;
+	blk_finish_plug(&plug);
 }
 
 static const struct blk_mq_ops loop_mq_ops = {
 	.queue_rq       = loop_queue_rq,
-	.init_request	= loop_init_request,
 	.complete	= lo_complete_rq,
 };
 
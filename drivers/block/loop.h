@@ -56,6 +56,9 @@ struct loop_device {
 	int			lo_state;
 	struct kthread_worker	worker;
 	struct task_struct	*worker_task;
+	spinlock_t		cmd_lock;
+	struct list_head	cmd_list;
+	struct kthread_work	rq_work;
 	bool			use_dio;
 	bool			sysfs_inited;
 
@@ -65,7 +68,7 @@ struct loop_device {
 };
 
 struct loop_cmd {
-	struct kthread_work work;
+	struct list_head list_entry;
 	bool use_aio; /* use AIO interface to handle I/O */
 	atomic_t ref; /* only for aio */
 	long ret;
@@ -20,6 +20,9 @@ struct nullb_cmd {
 	blk_status_t error;
 	struct nullb_queue *nq;
 	struct hrtimer timer;
+	struct list_head list;
+	ktime_t start_time;
+	ktime_t deadline;
 };
 
 struct nullb_queue {
@@ -29,6 +32,19 @@ struct nullb_queue {
 	struct nullb_device *dev;
 	unsigned int requeue_selection;
 
+	/*
+	 * Commands waiting for a coalesced completion, and the timer
+	 * that emulates the interrupt.  Only used when completion_batch
+	 * is greater than one.
+	 */
+	spinlock_t cq_lock;
+	struct list_head cq_list;
+	struct hrtimer cq_timer;
+	bool cq_armed;
+
+	atomic_long_t nr_ios;
+	atomic_long_t lat_nsec;
+
 	struct nullb_cmd *cmds;
 };
 
@@ -47,6 +63,10 @@ struct nullb_device {
 
 	unsigned long size; /* device size in MB */
 	unsigned long completion_nsec; /* time in ns to complete a request */
+	unsigned long completion_jitter_nsec; /* uniform random extra latency */
+	unsigned long completion_slow_nsec; /* latency of the slow mode */
+	unsigned int completion_slow_permille; /* requests per 1000 that are slow */
+	unsigned int completion_batch; /* max completions per timer fire */
 	unsigned long cache_size; /* disk cache size in MB */
 	unsigned long zone_size; /* zone size in MB if device is zoned */
 	unsigned int zone_nr_conv; /* number of conventional zones */
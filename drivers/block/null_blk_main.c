@@ -9,6 +9,7 @@
 #include <linux/sched.h>
 #include <linux/fs.h>
 #include <linux/init.h>
+#include <linux/random.h>
 #include "null_blk.h"
 
 #define PAGE_SECTORS_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
@@ -173,6 +174,22 @@ static unsigned long g_completion_nsec = 10000;
 module_param_named(completion_nsec, g_completion_nsec, ulong, 0444);
 MODULE_PARM_DESC(completion_nsec, "Time in ns to complete a request in hardware. Default: 10,000ns");
 
+static unsigned long g_completion_jitter_nsec;
+module_param_named(completion_jitter_nsec, g_completion_jitter_nsec, ulong, 0444);
+MODULE_PARM_DESC(completion_jitter_nsec, "Uniform random latency in ns added to each request. Default: 0");
+
+static unsigned long g_completion_slow_nsec;
+module_param_named(completion_slow_nsec, g_completion_slow_nsec, ulong, 0444);
+MODULE_PARM_DESC(completion_slow_nsec, "Time in ns to complete a slow mode request. Default: 0");
+
+static unsigned int g_completion_slow_permille;
+module_param_named(completion_slow_permille, g_completion_slow_permille, uint, 0444);
+MODULE_PARM_DESC(completion_slow_permille, "Requests per thousand that take completion_slow_nsec. Default: 0");
+
+static unsigned int g_completion_batch = 1;
+module_param_named(completion_batch, g_completion_batch, uint, 0444);
+MODULE_PARM_DESC(completion_batch, "Max completions per timer fire with irqmode=2, to emulate interrupt coalescing. Default: 1");
+
 static int g_hw_queue_depth = 64;
 module_param_named(hw_queue_depth, g_hw_queue_depth, int, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: 64");
@@ -309,6 +326,10 @@ static int nullb_apply_submit_queues(struct nullb_device *dev,
 
 NULLB_DEVICE_ATTR(size, ulong, NULL);
 NULLB_DEVICE_ATTR(completion_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(completion_jitter_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(completion_slow_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(completion_slow_permille, uint, NULL);
+NULLB_DEVICE_ATTR(completion_batch, uint, NULL);
 NULLB_DEVICE_ATTR(submit_queues, uint, nullb_apply_submit_queues);
 NULLB_DEVICE_ATTR(home_node, uint, NULL);
 NULLB_DEVICE_ATTR(queue_mode, uint, NULL);
@@ -420,9 +441,40 @@ out:
 }
 CONFIGFS_ATTR(nullb_device_, badblocks);
 
+static ssize_t nullb_device_queue_stats_show(struct config_item *item,
+					     char *page)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+	ssize_t len = 0;
+	int i;
+
+	mutex_lock(&lock);
+	if (dev->nullb) {
+		struct nullb *nullb = dev->nullb;
+
+		for (i = 0; i < nullb->nr_queues && len < PAGE_SIZE; i++) {
+			struct nullb_queue *nq = &nullb->queues[i];
+
+			len += snprintf(page + len, PAGE_SIZE - len,
+					"%d %ld %ld\n", i,
+					atomic_long_read(&nq->nr_ios),
+					atomic_long_read(&nq->lat_nsec));
+		}
+	}
+	mutex_unlock(&lock);
+
+	return len;
+}
+CONFIGFS_ATTR_RO(nullb_device_, queue_stats);
+
 static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_size,
 	&nullb_device_attr_completion_nsec,
+	&nullb_device_attr_completion_jitter_nsec,
+	&nullb_device_attr_completion_slow_nsec,
+	&nullb_device_attr_completion_slow_permille,
+	&nullb_device_attr_completion_batch,
+	&nullb_device_attr_queue_stats,
 	&nullb_device_attr_submit_queues,
 	&nullb_device_attr_home_node,
 	&nullb_device_attr_queue_mode,
@@ -493,7 +545,7 @@ nullb_group_drop_item(struct config_group *group, struct config_item *item)
 
 static ssize_t memb_group_features_show(struct config_item *item, char *page)
 {
-	return snprintf(page, PAGE_SIZE, "memory_backed,discard,bandwidth,cache,badblocks,zoned,zone_size,zone_nr_conv\n");
+	return snprintf(page, PAGE_SIZE, "memory_backed,discard,bandwidth,cache,badblocks,zoned,zone_size,zone_nr_conv,completion_jitter,completion_batch,queue_stats\n");
 }
 
 CONFIGFS_ATTR_RO(memb_group_, features);
@@ -544,6 +596,10 @@ static struct nullb_device *null_alloc_dev(void)
 
 	dev->size = g_gb * 1024;
 	dev->completion_nsec = g_completion_nsec;
+	dev->completion_jitter_nsec = g_completion_jitter_nsec;
+	dev->completion_slow_nsec = g_completion_slow_nsec;
+	dev->completion_slow_permille = g_completion_slow_permille;
+	dev->completion_batch = g_completion_batch;
 	dev->submit_queues = g_submit_queues;
 	dev->home_node = g_home_node;
 	dev->queue_mode = g_queue_mode;
@@ -607,6 +663,7 @@ static struct nullb_cmd *__alloc_cmd(struct nullb_queue *nq)
 		cmd->tag = tag;
 		cmd->error = BLK_STS_OK;
 		cmd->nq = nq;
+		cmd->start_time = ktime_get();
 		if (nq->dev->irqmode == NULL_IRQ_TIMER) {
 			hrtimer_init(&cmd->timer, CLOCK_MONOTONIC,
 				     HRTIMER_MODE_REL);
@@ -644,6 +701,10 @@ static void end_cmd(struct nullb_cmd *cmd)
 {
 	int queue_mode = cmd->nq->dev->queue_mode;
 
+	atomic_long_inc(&cmd->nq->nr_ios);
+	atomic_long_add(ktime_to_ns(ktime_sub(ktime_get(), cmd->start_time)),
+			&cmd->nq->lat_nsec);
+
 	switch (queue_mode)  {
 	case NULL_Q_MQ:
 		blk_mq_end_request(cmd->rq, cmd->error);
@@ -664,9 +725,96 @@ static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
+static ktime_t null_cmd_latency(struct nullb_device *dev)
+{
+	unsigned long nsec = dev->completion_nsec;
+
+	/*
+	 * A cheap two mode distribution: most requests complete around
+	 * completion_nsec, a configurable fraction per thousand take the
+	 * slow path, and uniform jitter spreads each mode out.
+	 */
+	if (dev->completion_slow_permille &&
+	    prandom_u32_max(1000) < dev->completion_slow_permille)
+		nsec = dev->completion_slow_nsec;
+
+	if (dev->completion_jitter_nsec)
+		nsec += prandom_u32_max(dev->completion_jitter_nsec);
+
+	return nsec;
+}
+
+static enum hrtimer_restart null_cq_timer_expired(struct hrtimer *timer)
+{
+	struct nullb_queue *nq = container_of(timer, struct nullb_queue,
+					      cq_timer);
+	unsigned int batch = nq->dev->completion_batch;
+	struct nullb_cmd *cmd;
+	unsigned int done = 0;
+	ktime_t now = ktime_get();
+	bool restart = false;
+	LIST_HEAD(done_list);
+
+	spin_lock(&nq->cq_lock);
+	while (!list_empty(&nq->cq_list)) {
+		cmd = list_first_entry(&nq->cq_list, struct nullb_cmd, list);
+		if (done >= batch || ktime_after(cmd->deadline, now)) {
+			/*
+			 * More work left; fire again at the next deadline,
+			 * or straight away if we only stopped because the
+			 * batch was full.
+			 */
+			hrtimer_set_expires(timer,
+				ktime_after(cmd->deadline, now) ?
+					cmd->deadline : now);
+			restart = true;
+			break;
+		}
+		list_move_tail(&cmd->list, &done_list);
+		done++;
+	}
+	if (!restart)
+		nq->cq_armed = false;
+	spin_unlock(&nq->cq_lock);
+
+	while (!list_empty(&done_list)) {
+		cmd = list_first_entry(&done_list, struct nullb_cmd, list);
+		list_del(&cmd->list);
+		end_cmd(cmd);
+	}
+
+	return restart ? HRTIMER_RESTART : HRTIMER_NORESTART;
+}
+
+/*
+ * Completions are coalesced in submission order; a later request whose
+ * jittered deadline lands earlier just has the difference absorbed into
+ * the coalescing delay, much like real interrupt moderation.
+ */
+static void null_cmd_queue_batched(struct nullb_cmd *cmd, ktime_t kt)
+{
+	struct nullb_queue *nq = cmd->nq;
+	unsigned long flags;
+
+	cmd->deadline = ktime_add(ktime_get(), kt);
+
+	spin_lock_irqsave(&nq->cq_lock, flags);
+	list_add_tail(&cmd->list, &nq->cq_list);
+	if (!nq->cq_armed) {
+		nq->cq_armed = true;
+		hrtimer_start(&nq->cq_timer, cmd->deadline, HRTIMER_MODE_ABS);
+	}
+	spin_unlock_irqrestore(&nq->cq_lock, flags);
+}
+
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	ktime_t kt = null_cmd_latency(cmd->nq->dev);
+
+	if (cmd->nq->dev->completion_batch > 1) {
+		null_cmd_queue_batched(cmd, kt);
+		return;
+	}
 
 	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
 }
@@ -1388,6 +1536,7 @@ static blk_status_t null_queue_rq(struct blk_mq_hw_ctx *hctx,
 	cmd->rq = bd->rq;
 	cmd->error = BLK_STS_OK;
 	cmd->nq = nq;
+	cmd->start_time = ktime_get();
 
 	blk_mq_start_request(bd->rq);
 
@@ -1488,6 +1637,11 @@ static void null_init_queue(struct nullb *nullb, struct nullb_queue *nq)
 	init_waitqueue_head(&nq->wait);
 	nq->queue_depth = nullb->queue_depth;
 	nq->dev = nullb->dev;
+	spin_lock_init(&nq->cq_lock);
+	INIT_LIST_HEAD(&nq->cq_list);
+	hrtimer_init(&nq->cq_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	nq->cq_timer.function = null_cq_timer_expired;
+	nq->cq_armed = false;
 }
 
 static void null_init_queues(struct nullb *nullb)
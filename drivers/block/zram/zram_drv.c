@@ -620,18 +620,91 @@ static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 #define HUGE_WRITEBACK 1
 #define IDLE_WRITEBACK 2
 
+/*
+ * Maximum number of slots written back with one bio.  Backing blocks
+ * are allocated by an ascending bitmap scan, so consecutive candidates
+ * usually get consecutive blocks and coalesce into a single large bio.
+ */
+#define ZRAM_WB_BATCH 32
+
+/*
+ * Write @nr pages to @nr contiguous backing blocks starting at
+ * @first_blk, then do the per-slot bookkeeping.  Returns the bio error,
+ * if any.  On error, or if a slot changed while we didn't hold its
+ * lock, the slot is left alone and the backing block is released.
+ */
+static int zram_writeback_flush(struct zram *zram, struct page **pages,
+				unsigned long *indexes, int nr,
+				unsigned long first_blk)
+{
+	struct bio_vec bvecs[ZRAM_WB_BATCH];
+	struct bio bio;
+	int i, err;
+
+	bio_init(&bio, bvecs, nr);
+	bio_set_dev(&bio, zram->bdev);
+	bio.bi_iter.bi_sector = first_blk * (PAGE_SIZE >> 9);
+	bio.bi_opf = REQ_OP_WRITE | REQ_SYNC;
+
+	for (i = 0; i < nr; i++)
+		bio_add_page(&bio, pages[i], PAGE_SIZE, 0);
+
+	err = submit_bio_wait(&bio);
+
+	for (i = 0; i < nr; i++) {
+		unsigned long index = indexes[i];
+		unsigned long blk_idx = first_blk + i;
+
+		if (!err)
+			atomic64_inc(&zram->stats.bd_writes);
+
+		/*
+		 * We released zram_slot_lock so need to check if the slot was
+		 * changed. If there is freeing for the slot, we can catch it
+		 * easily by zram_allocated.
+		 * A subtle case is the slot is freed/reallocated/marked as
+		 * ZRAM_IDLE again. To close the race, idle_store doesn't
+		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
+		 * Thus, we could close the race by checking ZRAM_IDLE bit.
+		 */
+		zram_slot_lock(zram, index);
+		if (err || !zram_allocated(zram, index) ||
+		    !zram_test_flag(zram, index, ZRAM_IDLE)) {
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_clear_flag(zram, index, ZRAM_IDLE);
+			zram_slot_unlock(zram, index);
+			free_block_bdev(zram, blk_idx);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_set_flag(zram, index, ZRAM_WB);
+		zram_set_element(zram, index, blk_idx);
+		zram_slot_unlock(zram, index);
+
+		atomic64_inc(&zram->stats.pages_stored);
+		spin_lock(&zram->wb_limit_lock);
+		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
+			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
+		spin_unlock(&zram->wb_limit_lock);
+	}
+
+	return err;
+}
+
 static ssize_t writeback_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	struct zram *zram = dev_to_zram(dev);
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
-	unsigned long index;
-	struct bio bio;
-	struct bio_vec bio_vec;
-	struct page *page;
+	unsigned long indexes[ZRAM_WB_BATCH];
+	struct page *pages[ZRAM_WB_BATCH];
+	unsigned long index, blk_idx;
+	unsigned long first_blk = 0;
 	ssize_t ret = len;
-	int mode;
-	unsigned long blk_idx = 0;
+	int i, nr = 0;
+	int mode, err;
 
 	if (sysfs_streq(buf, "idle"))
 		mode = IDLE_WRITEBACK;
@@ -651,16 +724,20 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
-		ret = -ENOMEM;
-		goto release_init_lock;
+	for (i = 0; i < ZRAM_WB_BATCH; i++) {
+		pages[i] = alloc_page(GFP_KERNEL);
+		if (!pages[i]) {
+			while (i--)
+				__free_page(pages[i]);
+			ret = -ENOMEM;
+			goto release_init_lock;
+		}
 	}
 
 	for (index = 0; index < nr_pages; index++) {
 		struct bio_vec bvec;
 
-		bvec.bv_page = page;
+		bvec.bv_page = pages[nr];
 		bvec.bv_len = PAGE_SIZE;
 		bvec.bv_offset = 0;
 
@@ -672,14 +749,6 @@ static ssize_t writeback_store(struct device *dev,
 		}
 		spin_unlock(&zram->wb_limit_lock);
 
-		if (!blk_idx) {
-			blk_idx = alloc_block_bdev(zram);
-			if (!blk_idx) {
-				ret = -ENOSPC;
-				break;
-			}
-		}
-
 		zram_slot_lock(zram, index);
 		if (!zram_allocated(zram, index))
 			goto next;
@@ -711,61 +780,63 @@ static ssize_t writeback_store(struct device *dev,
 			continue;
 		}
 
-		bio_init(&bio, &bio_vec, 1);
-		bio_set_dev(&bio, zram->bdev);
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-		bio.bi_opf = REQ_OP_WRITE | REQ_SYNC;
-
-		bio_add_page(&bio, bvec.bv_page, bvec.bv_len,
-				bvec.bv_offset);
-		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
-		 */
-		ret = submit_bio_wait(&bio);
-		if (ret) {
+		blk_idx = alloc_block_bdev(zram);
+		if (!blk_idx) {
 			zram_slot_lock(zram, index);
 			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
 			zram_clear_flag(zram, index, ZRAM_IDLE);
 			zram_slot_unlock(zram, index);
-			continue;
+			ret = -ENOSPC;
+			break;
 		}
 
-		atomic64_inc(&zram->stats.bd_writes);
 		/*
-		 * We released zram_slot_lock so need to check if the slot was
-		 * changed. If there is freeing for the slot, we can catch it
-		 * easily by zram_allocated.
-		 * A subtle case is the slot is freed/reallocated/marked as
-		 * ZRAM_IDLE again. To close the race, idle_store doesn't
-		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
-		 * Thus, we could close the race by checking ZRAM_IDLE bit.
+		 * The block doesn't extend the current run, so write out
+		 * what we've gathered and start a new one.  The page we
+		 * just filled has to move down to slot zero with it.
 		 */
-		zram_slot_lock(zram, index);
-		if (!zram_allocated(zram, index) ||
-			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			goto next;
+		if (nr && blk_idx != first_blk + nr) {
+			err = zram_writeback_flush(zram, pages, indexes, nr,
+						   first_blk);
+			swap(pages[0], pages[nr]);
+			nr = 0;
+			if (err) {
+				zram_slot_lock(zram, index);
+				zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+				zram_clear_flag(zram, index, ZRAM_IDLE);
+				zram_slot_unlock(zram, index);
+				free_block_bdev(zram, blk_idx);
+				ret = err;
+				break;
+			}
 		}
 
-		zram_free_page(zram, index);
-		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
-		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
+		if (!nr)
+			first_blk = blk_idx;
+		indexes[nr++] = index;
+
+		if (nr == ZRAM_WB_BATCH) {
+			err = zram_writeback_flush(zram, pages, indexes, nr,
+						   first_blk);
+			nr = 0;
+			if (err) {
+				ret = err;
+				break;
+			}
+		}
+		continue;
 next:
 		zram_slot_unlock(zram, index);
 	}
 
-	if (blk_idx)
-		free_block_bdev(zram, blk_idx);
-	__free_page(page);
+	if (nr) {
+		err = zram_writeback_flush(zram, pages, indexes, nr, first_blk);
+		if (err)
+			ret = err;
+	}
+
+	for (i = 0; i < ZRAM_WB_BATCH; i++)
+		__free_page(pages[i]);
 release_init_lock:
 	up_read(&zram->init_lock);
 
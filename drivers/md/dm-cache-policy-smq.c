@@ -687,6 +687,100 @@ static void h_remove(struct smq_hash_table *ht, struct entry *e)
 
 /*----------------------------------------------------------------*/
 
+/*
+ * A small counting bloom filter sits in front of the mapping hash table.
+ * Misses are the common case for many workloads, and the filter lets us
+ * reject most of them without walking a bucket chain.
+ *
+ * Counters saturate rather than wrap, and a saturated counter is never
+ * decremented again.  So a stale counter can only cause false positives,
+ * which just cost a wasted chain walk, never false negatives.
+ */
+#define FILTER_COUNTER_MAX 255u
+
+struct lookup_filter {
+	u8 *counters;
+	unsigned long long hash_bits;
+};
+
+static void lf_init(struct lookup_filter *lf, unsigned nr_entries)
+{
+	unsigned nr_counters = roundup_pow_of_two(max(nr_entries * 4u, 1024u));
+
+	lf->hash_bits = __ffs(nr_counters);
+
+	/*
+	 * The filter is only an optimisation, so we carry on without it
+	 * if the allocation fails.
+	 */
+	lf->counters = vzalloc(nr_counters);
+}
+
+static void lf_exit(struct lookup_filter *lf)
+{
+	vfree(lf->counters);
+}
+
+static void lf_hash(struct lookup_filter *lf, dm_oblock_t oblock,
+		    unsigned *h1, unsigned *h2)
+{
+	*h1 = hash_64(from_oblock(oblock), lf->hash_bits);
+	*h2 = hash_64(~from_oblock(oblock), lf->hash_bits);
+}
+
+static void lf_inc(struct lookup_filter *lf, unsigned h)
+{
+	if (lf->counters[h] < FILTER_COUNTER_MAX)
+		lf->counters[h]++;
+}
+
+static void lf_dec(struct lookup_filter *lf, unsigned h)
+{
+	/*
+	 * Once a counter has saturated we no longer know how many
+	 * entries hash to it, so it has to stay set.
+	 */
+	if (lf->counters[h] && lf->counters[h] < FILTER_COUNTER_MAX)
+		lf->counters[h]--;
+}
+
+static void lf_add(struct lookup_filter *lf, dm_oblock_t oblock)
+{
+	unsigned h1, h2;
+
+	if (!lf->counters)
+		return;
+
+	lf_hash(lf, oblock, &h1, &h2);
+	lf_inc(lf, h1);
+	lf_inc(lf, h2);
+}
+
+static void lf_remove(struct lookup_filter *lf, dm_oblock_t oblock)
+{
+	unsigned h1, h2;
+
+	if (!lf->counters)
+		return;
+
+	lf_hash(lf, oblock, &h1, &h2);
+	lf_dec(lf, h1);
+	lf_dec(lf, h2);
+}
+
+static bool lf_may_contain(struct lookup_filter *lf, dm_oblock_t oblock)
+{
+	unsigned h1, h2;
+
+	if (!lf->counters)
+		return true;
+
+	lf_hash(lf, oblock, &h1, &h2);
+	return lf->counters[h1] && lf->counters[h2];
+}
+
+/*----------------------------------------------------------------*/
+
 struct entry_alloc {
 	struct entry_space *es;
 	unsigned begin;
@@ -840,6 +934,12 @@ struct smq_policy {
 	struct smq_hash_table table;
 	struct smq_hash_table hotspot_table;
 
+	/*
+	 * Rejects most lookups of blocks that aren't in the cache
+	 * without touching the mapping hash table.
+	 */
+	struct lookup_filter filter;
+
 	bool current_writeback_sentinels;
 	unsigned long next_writeback_period;
 
@@ -964,6 +1064,7 @@ static void push_queue(struct smq_policy *mq, struct entry *e)
 static void push(struct smq_policy *mq, struct entry *e)
 {
 	h_insert(&mq->table, e);
+	lf_add(&mq->filter, e->oblock);
 	if (!e->pending_work)
 		push_queue(mq, e);
 }
@@ -979,6 +1080,7 @@ static void push_queue_front(struct smq_policy *mq, struct entry *e)
 static void push_front(struct smq_policy *mq, struct entry *e)
 {
 	h_insert(&mq->table, e);
+	lf_add(&mq->filter, e->oblock);
 	if (!e->pending_work)
 		push_queue_front(mq, e);
 }
@@ -1352,6 +1454,7 @@ static void smq_destroy(struct dm_cache_policy *p)
 	struct smq_policy *mq = to_smq_policy(p);
 
 	btracker_destroy(mq->bg_work);
+	lf_exit(&mq->filter);
 	h_exit(&mq->hotspot_table);
 	h_exit(&mq->table);
 	free_bitset(mq->hotspot_hit_bits);
@@ -1371,7 +1474,10 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 
 	*background_work = false;
 
-	e = h_lookup(&mq->table, oblock);
+	if (lf_may_contain(&mq->filter, oblock))
+		e = h_lookup(&mq->table, oblock);
+	else
+		e = NULL;
 	if (e) {
 		stats_level_accessed(&mq->cache_stats, e->level);
 
@@ -1481,6 +1587,7 @@ static void __complete_background_work(struct smq_policy *mq,
 		// h, !q, a
 		if (success) {
 			h_remove(&mq->table, e);
+			lf_remove(&mq->filter, e->oblock);
 			free_entry(&mq->cache_alloc, e);
 			// !h, !q, !a
 		} else {
@@ -1585,6 +1692,7 @@ static int smq_invalidate_mapping(struct dm_cache_policy *p, dm_cblock_t cblock)
 	// FIXME: what if this block has pending background work?
 	del_queue(mq, e);
 	h_remove(&mq->table, e);
+	lf_remove(&mq->filter, e->oblock);
 	free_entry(&mq->cache_alloc, e);
 	return 0;
 }
@@ -1796,6 +1904,8 @@ static struct dm_cache_policy *__smq_create(dm_cblock_t cache_size,
 	if (h_init(&mq->hotspot_table, &mq->es, mq->nr_hotspot_blocks))
 		goto bad_alloc_hotspot_table;
 
+	lf_init(&mq->filter, from_cblock(cache_size));
+
 	sentinels_init(mq);
 	mq->write_promote_level = mq->read_promote_level = NR_HOTSPOT_LEVELS;
 
@@ -1811,6 +1921,7 @@ static struct dm_cache_policy *__smq_create(dm_cblock_t cache_size,
 	return &mq->policy;
 
 bad_btracker:
+	lf_exit(&mq->filter);
 	h_exit(&mq->hotspot_table);
 bad_alloc_hotspot_table:
 	h_exit(&mq->table);
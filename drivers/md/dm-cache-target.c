@@ -1643,19 +1643,41 @@ static int invalidate_start(struct cache *cache, dm_cblock_t cblock,
 
 enum busy {
 	IDLE,
-	BUSY
+	BUSY,
+	THROTTLED
 };
 
+/*
+ * We'd like to judge from the origin's latency how much migration io it
+ * can absorb, but we have no per io timings.  The io tracker's idle time
+ * is a good proxy: the longer the device has been quiet, the more copy
+ * bandwidth we allow.
+ */
+static sector_t migration_volume_limit(struct cache *cache)
+{
+	if (iot_idle_for(&cache->tracker, HZ))
+		return cache->migration_threshold;
+
+	if (iot_idle_for(&cache->tracker, HZ / 4))
+		return cache->migration_threshold / 4u;
+
+	/*
+	 * Foreground io is active; keep a trickle of migrations going so
+	 * urgent background work (eg, writeback) still makes progress.
+	 */
+	return max(cache->migration_threshold / 16u,
+		   2u * cache->sectors_per_block);
+}
+
 static enum busy spare_migration_bandwidth(struct cache *cache)
 {
-	bool idle = iot_idle_for(&cache->tracker, HZ);
 	sector_t current_volume = (atomic_read(&cache->nr_io_migrations) + 1) *
 		cache->sectors_per_block;
 
-	if (idle && current_volume <= cache->migration_threshold)
-		return IDLE;
-	else
-		return BUSY;
+	if (current_volume > migration_volume_limit(cache))
+		return THROTTLED;
+
+	return iot_idle_for(&cache->tracker, HZ) ? IDLE : BUSY;
 }
 
 static void inc_hit_counter(struct cache *cache, struct bio *bio)
@@ -1937,6 +1959,13 @@ static void check_migrations(struct work_struct *ws)
 
 	for (;;) {
 		b = spare_migration_bandwidth(cache);
+		if (b == THROTTLED) {
+			/*
+			 * A completing migration will wake us again, as
+			 * will the periodic waker.
+			 */
+			break;
+		}
 
 		r = policy_get_background_work(cache->policy, b == IDLE, &op);
 		if (r == -ENODATA)
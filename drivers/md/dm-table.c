@@ -1786,6 +1786,30 @@ static bool dm_table_supports_write_zeroes(struct dm_table *t)
 	return true;
 }
 
+static int device_not_poll_capable(struct dm_target *ti, struct dm_dev *dev,
+				   sector_t start, sector_t len, void *data)
+{
+	struct request_queue *q = bdev_get_queue(dev->bdev);
+
+	return !q || !test_bit(QUEUE_FLAG_POLL, &q->queue_flags);
+}
+
+static bool dm_table_supports_poll(struct dm_table *t)
+{
+	struct dm_target *ti;
+	unsigned i = 0;
+
+	while (i < dm_table_get_num_targets(t)) {
+		ti = dm_table_get_target(t, i++);
+
+		if (!ti->type->iterate_devices ||
+		    ti->type->iterate_devices(ti, device_not_poll_capable, NULL))
+			return false;
+	}
+
+	return true;
+}
+
 static int device_not_discard_capable(struct dm_target *ti, struct dm_dev *dev,
 				      sector_t start, sector_t len, void *data)
 {
@@ -1963,6 +1987,15 @@ void dm_table_set_restrictions(struct dm_table *t, struct request_queue *q,
 	}
 #endif
 
+	/*
+	 * Pass polled IO through only if every underlying queue can poll,
+	 * otherwise REQ_HIPRI is stripped on submission to the dm device.
+	 */
+	if (!queue_is_mq(q) && dm_table_supports_poll(t))
+		blk_queue_flag_set(QUEUE_FLAG_POLL, q);
+	else
+		blk_queue_flag_clear(QUEUE_FLAG_POLL, q);
+
 	/* Allow reads to exceed readahead limits */
 	q->backing_dev_info->io_pages = limits->max_sectors >> (PAGE_SHIFT - 9);
 }
@@ -2101,6 +2134,35 @@ int dm_table_any_congested(struct dm_table *t, int bdi_bits)
 	return r;
 }
 
+/*
+ * Poll the underlying queues for the completion identified by @cookie.
+ * The cookie was produced by whichever device the final clone of the
+ * original bio was submitted to; polling another pollable device with it
+ * is wasted work but harmless, so simply try every device that can poll.
+ */
+int dm_table_poll(struct dm_table *t, blk_qc_t cookie, bool spin)
+{
+	struct dm_dev_internal *dd;
+	struct list_head *devices = dm_table_get_devices(t);
+	int r = 0;
+
+	list_for_each_entry(dd, devices, list) {
+		struct request_queue *q = bdev_get_queue(dd->dm_dev->bdev);
+
+		if (!q || !test_bit(QUEUE_FLAG_POLL, &q->queue_flags))
+			continue;
+		if (queue_is_mq(q) &&
+		    blk_qc_t_to_queue_num(cookie) >= q->nr_hw_queues)
+			continue;
+
+		r = blk_poll(q, cookie, spin);
+		if (r)
+			break;
+	}
+
+	return r;
+}
+
 struct mapped_device *dm_table_get_md(struct dm_table *t)
 {
 	return t->md;
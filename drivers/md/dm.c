@@ -716,6 +716,13 @@ static void queue_io(struct mapped_device *md, struct bio *bio)
 {
 	unsigned long flags;
 
+	/*
+	 * Deferred bios are resubmitted from dm_wq_work(), where the cookie
+	 * generic_make_request() returns is lost; a REQ_HIPRI clone would
+	 * then sit on an interrupt-less poll hctx with nobody polling it.
+	 */
+	bio->bi_opf &= ~REQ_HIPRI;
+
 	spin_lock_irqsave(&md->deferred_lock, flags);
 	bio_list_add(&md->deferred, bio);
 	spin_unlock_irqrestore(&md->deferred_lock, flags);
@@ -1248,6 +1255,7 @@ static blk_qc_t __map_bio(struct dm_target_io *tio)
 	struct mapped_device *md = io->md;
 	struct dm_target *ti = tio->ti;
 	blk_qc_t ret = BLK_QC_T_NONE;
+	unsigned int hipri;
 
 	clone->bi_end_io = clone_endio;
 
@@ -1259,6 +1267,18 @@ static blk_qc_t __map_bio(struct dm_target_io *tio)
 	atomic_inc(&io->io_count);
 	sector = clone->bi_iter.bi_sector;
 
+	/*
+	 * Polled completion only works for a clone dispatched right here,
+	 * whose cookie is handed back through the make_request return.  A
+	 * target that returns DM_MAPIO_SUBMITTED owns the clone and may
+	 * submit it (or clones derived from its bi_opf, as dm-crypt's
+	 * kcryptd does) from another context where the cookie is lost, so
+	 * strip REQ_HIPRI before ->map() and restore it only for the
+	 * inline DM_MAPIO_REMAPPED dispatch.
+	 */
+	hipri = clone->bi_opf & REQ_HIPRI;
+	clone->bi_opf &= ~REQ_HIPRI;
+
 	r = ti->type->map(ti, clone);
 	switch (r) {
 	case DM_MAPIO_SUBMITTED:
@@ -1267,6 +1287,7 @@ static blk_qc_t __map_bio(struct dm_target_io *tio)
 		/* the bio has been remapped so dispatch it */
 		trace_block_bio_remap(clone->bi_disk->queue, clone,
 				      bio_dev(io->orig_bio), sector);
+		clone->bi_opf |= hipri;
 		if (md->type == DM_TYPE_NVME_BIO_BASED)
 			ret = direct_make_request(clone);
 		else
@@ -1435,6 +1456,15 @@ static int __clone_and_map_data_bio(struct clone_info *ci, struct dm_target *ti,
 		free_tio(tio);
 		return r;
 	}
+
+	/*
+	 * Only the final clone of a polled bio can be found through the
+	 * cookie generic_make_request() hands back, so any earlier clone
+	 * must fall back to IRQ completion or it would never be reaped.
+	 */
+	if (*len < ci->sector_count)
+		tio->clone.bi_opf &= ~REQ_HIPRI;
+
 	(void) __map_bio(tio);
 
 	return 0;
@@ -1777,6 +1807,20 @@ static blk_qc_t dm_make_request(struct request_queue *q, struct bio *bio)
 	return ret;
 }
 
+static int dm_poll_fn(struct request_queue *q, blk_qc_t cookie, bool spin)
+{
+	struct mapped_device *md = q->queuedata;
+	struct dm_table *map;
+	int srcu_idx, r = 0;
+
+	map = dm_get_live_table(md, &srcu_idx);
+	if (map)
+		r = dm_table_poll(map, cookie, spin);
+	dm_put_live_table(md, srcu_idx);
+
+	return r;
+}
+
 static int dm_any_congested(void *congested_data, int bdi_bits)
 {
 	int r = bdi_bits;
@@ -1949,6 +1993,7 @@ static struct mapped_device *alloc_dev(int minor)
 	 * table is loaded: blk-mq will override accordingly.
 	 */
 	blk_queue_make_request(md->queue, dm_make_request);
+	md->queue->poll_fn = dm_poll_fn;
 
 	md->disk = alloc_disk_node(1, md->numa_node_id);
 	if (!md->disk)
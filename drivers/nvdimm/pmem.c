@@ -276,6 +276,15 @@ static long pmem_dax_direct_access(struct dax_device *dax_dev,
 	return __pmem_direct_access(pmem, pgoff, nr_pages, kaddr, pfn);
 }
 
+/*
+ * Streaming writes go through the non-temporal flushcache path so they
+ * don't push the working set out of the cache.  Writes below this size
+ * are usually metadata that is read back shortly; for those a cached
+ * copy followed by a writeback of the touched lines is cheaper than
+ * forcing the next read to go to media.
+ */
+#define PMEM_NONTEMPORAL_THRESHOLD	256
+
 /*
  * Use the 'no check' versions of copy_from_iter_flushcache() and
  * copy_to_iter_mcsafe() to bypass HARDENED_USERCOPY overhead. Bounds
@@ -285,6 +294,12 @@ static long pmem_dax_direct_access(struct dax_device *dax_dev,
 static size_t pmem_copy_from_iter(struct dax_device *dax_dev, pgoff_t pgoff,
 		void *addr, size_t bytes, struct iov_iter *i)
 {
+	if (bytes < PMEM_NONTEMPORAL_THRESHOLD) {
+		size_t ret = _copy_from_iter(addr, bytes, i);
+
+		arch_wb_cache_pmem(addr, ret);
+		return ret;
+	}
 	return _copy_from_iter_flushcache(addr, bytes, i);
 }
 
@@ -307,6 +307,8 @@ static void vhost_vq_reset(struct vhost_dev *dev,
 	vq->used = NULL;
 	vq->last_avail_idx = 0;
 	vq->avail_idx = 0;
+	vq->avail_heads_base = 0;
+	vq->navail_heads = 0;
 	vq->last_used_idx = 0;
 	vq->signalled_used = 0;
 	vq->signalled_used_valid = false;
@@ -996,6 +998,48 @@ static inline int vhost_get_avail_head(struct vhost_virtqueue *vq,
 			       &vq->avail->ring[idx & (vq->num - 1)]);
 }
 
+/* Prefetch a window of avail ring heads starting at @idx with a single
+ * copy from user memory.  The guest must not touch entries it has made
+ * available, so the cached window stays valid until last_avail_idx moves
+ * past it or userspace changes the ring layout.
+ */
+static int vhost_fetch_avail_heads(struct vhost_virtqueue *vq, u16 idx)
+{
+	unsigned int off = idx & (vq->num - 1);
+	unsigned int n;
+
+	n = (u16)(vq->avail_idx - idx);
+	n = min3(n, (unsigned int)VHOST_AVAIL_BATCH, vq->num - off);
+
+	if (!vq->iotlb) {
+		if (__copy_from_user(vq->avail_heads, &vq->avail->ring[off],
+				     n * sizeof(vq->avail_heads[0])))
+			return -EFAULT;
+	} else {
+		void __user *from = vhost_vq_meta_fetch(vq,
+				(u64)(uintptr_t)&vq->avail->ring[off],
+				n * sizeof(vq->avail_heads[0]),
+				VHOST_ADDR_AVAIL);
+
+		if (from) {
+			if (__copy_from_user(vq->avail_heads, from,
+					     n * sizeof(vq->avail_heads[0])))
+				return -EFAULT;
+		} else {
+			/* No cached translation covering the whole window;
+			 * fall back to a single head through the slow path.
+			 */
+			if (vhost_get_avail_head(vq, &vq->avail_heads[0], idx))
+				return -EFAULT;
+			n = 1;
+		}
+	}
+
+	vq->avail_heads_base = idx;
+	vq->navail_heads = n;
+	return 0;
+}
+
 static inline int vhost_get_avail_flags(struct vhost_virtqueue *vq,
 					__virtio16 *flags)
 {
@@ -1560,6 +1604,7 @@ static long vhost_vring_set_addr(struct vhost_dev *d,
 	vq->avail = (void __user *)(unsigned long)a.avail_user_addr;
 	vq->log_addr = a.log_guest_addr;
 	vq->used = (void __user *)(unsigned long)a.used_user_addr;
+	vq->navail_heads = 0;
 
 	return 0;
 }
@@ -1633,8 +1678,9 @@ long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *arg
 			break;
 		}
 		vq->last_avail_idx = s.num;
-		/* Forget the cached index value. */
+		/* Forget the cached index value and prefetched heads. */
 		vq->avail_idx = vq->last_avail_idx;
+		vq->navail_heads = 0;
 		break;
 	case VHOST_GET_VRING_BASE:
 		s.index = idx;
@@ -2253,13 +2299,19 @@ int vhost_get_vq_desc(struct vhost_virtqueue *vq,
 	}
 
 	/* Grab the next descriptor number they're advertising, and increment
-	 * the index we've seen. */
-	if (unlikely(vhost_get_avail_head(vq, &ring_head, last_avail_idx))) {
-		vq_err(vq, "Failed to read head: idx %d address %p\n",
-		       last_avail_idx,
-		       &vq->avail->ring[last_avail_idx % vq->num]);
-		return -EFAULT;
+	 * the index we've seen.  Heads are read from the avail ring a
+	 * window at a time, so batches of buffers cost one copy from user
+	 * memory instead of one per buffer. */
+	if ((u16)(last_avail_idx - vq->avail_heads_base) >= vq->navail_heads) {
+		if (unlikely(vhost_fetch_avail_heads(vq, last_avail_idx))) {
+			vq_err(vq, "Failed to read head: idx %d address %p\n",
+			       last_avail_idx,
+			       &vq->avail->ring[last_avail_idx % vq->num]);
+			return -EFAULT;
+		}
 	}
+	ring_head = vq->avail_heads[(u16)(last_avail_idx -
+					  vq->avail_heads_base)];
 
 	head = vhost16_to_cpu(vq, ring_head);
 
@@ -80,6 +80,9 @@ enum vhost_uaddr_type {
 	VHOST_NUM_ADDRS = 3,
 };
 
+/* How many avail ring heads are prefetched with a single copy. */
+#define VHOST_AVAIL_BATCH 64
+
 /* The virtqueue structure describes a queue attached to a device. */
 struct vhost_virtqueue {
 	struct vhost_dev *dev;
@@ -107,6 +110,13 @@ struct vhost_virtqueue {
 	/* Caches available index value from user. */
 	u16 avail_idx;
 
+	/* Batch of avail ring heads fetched with a single copy.  Valid
+	 * entries cover avail indices [avail_heads_base,
+	 * avail_heads_base + navail_heads). */
+	__virtio16 avail_heads[VHOST_AVAIL_BATCH];
+	u16 avail_heads_base;
+	u16 navail_heads;
+
 	/* Last index we used. */
 	u16 last_used_idx;
 
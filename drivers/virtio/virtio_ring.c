@@ -93,6 +93,10 @@ struct vring_virtqueue {
 	/* Is DMA API used? */
 	bool use_dma_api;
 
+	/* Driver premaps the buffers itself, the ring only maps
+	 * its own indirect tables. */
+	bool premapped;
+
 	/* Can we use weak barriers? */
 	bool weak_barriers;
 
@@ -326,6 +330,9 @@ static dma_addr_t vring_map_one_sg(const struct vring_virtqueue *vq,
 				   struct scatterlist *sg,
 				   enum dma_data_direction direction)
 {
+	if (vq->premapped)
+		return sg_dma_address(sg);
+
 	if (!vq->use_dma_api)
 		return (dma_addr_t)sg_phys(sg);
 
@@ -381,6 +388,9 @@ static void vring_unmap_one_split(const struct vring_virtqueue *vq,
 				 (flags & VRING_DESC_F_WRITE) ?
 				 DMA_FROM_DEVICE : DMA_TO_DEVICE);
 	} else {
+		if (vq->premapped)
+			return;
+
 		dma_unmap_page(vring_dma_dev(vq),
 			       virtio64_to_cpu(vq->vq.vdev, desc->addr),
 			       virtio32_to_cpu(vq->vq.vdev, desc->len),
@@ -541,17 +551,12 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	else
 		vq->split.desc_state[head].indir_desc = ctx;
 
-	/* Put entry in available array (but don't update avail->idx until they
-	 * do sync). */
+	/* Put entry in available array (but don't update avail->idx until
+	 * the flush in virtqueue_kick_prepare(), so that a whole batch of
+	 * buffers is published with a single barrier). */
 	avail = vq->split.avail_idx_shadow & (vq->split.vring.num - 1);
 	vq->split.vring.avail->ring[avail] = cpu_to_virtio16(_vq->vdev, head);
-
-	/* Descriptors and available array need to be set before we expose the
-	 * new available array entries. */
-	virtio_wmb(vq->weak_barriers);
 	vq->split.avail_idx_shadow++;
-	vq->split.vring.avail->idx = cpu_to_virtio16(_vq->vdev,
-						vq->split.avail_idx_shadow);
 	vq->num_added++;
 
 	pr_debug("Added buffer head %i to %p\n", head, vq);
@@ -586,6 +591,15 @@ unmap_release:
 	return -ENOMEM;
 }
 
+static void virtqueue_flush_avail_split(struct vring_virtqueue *vq)
+{
+	/* Descriptors and available array need to be set before we expose
+	 * the new avail->idx value. */
+	virtio_wmb(vq->weak_barriers);
+	vq->split.vring.avail->idx = cpu_to_virtio16(vq->vq.vdev,
+						vq->split.avail_idx_shadow);
+}
+
 static bool virtqueue_kick_prepare_split(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -593,6 +607,9 @@ static bool virtqueue_kick_prepare_split(struct virtqueue *_vq)
 	bool needs_kick;
 
 	START_USE(vq);
+	if (vq->num_added)
+		virtqueue_flush_avail_split(vq);
+
 	/* We need to expose available array entries before checking avail
 	 * event. */
 	virtio_mb(vq->weak_barriers);
@@ -927,6 +944,9 @@ static void vring_unmap_state_packed(const struct vring_virtqueue *vq,
 				 (flags & VRING_DESC_F_WRITE) ?
 				 DMA_FROM_DEVICE : DMA_TO_DEVICE);
 	} else {
+		if (vq->premapped)
+			return;
+
 		dma_unmap_page(vring_dma_dev(vq),
 			       state->addr, state->len,
 			       (flags & VRING_DESC_F_WRITE) ?
@@ -951,6 +971,9 @@ static void vring_unmap_desc_packed(const struct vring_virtqueue *vq,
 				 (flags & VRING_DESC_F_WRITE) ?
 				 DMA_FROM_DEVICE : DMA_TO_DEVICE);
 	} else {
+		if (vq->premapped)
+			return;
+
 		dma_unmap_page(vring_dma_dev(vq),
 			       le64_to_cpu(desc->addr),
 			       le32_to_cpu(desc->len),
@@ -1608,6 +1631,7 @@ static struct virtqueue *vring_create_virtqueue_packed(
 	vq->num_added = 0;
 	vq->packed_ring = true;
 	vq->use_dma_api = vring_use_dma_api(vdev);
+	vq->premapped = false;
 	list_add_tail(&vq->vq.list, &vdev->vqs);
 #ifdef DEBUG
 	vq->in_use = false;
@@ -1707,6 +1731,61 @@ static inline int virtqueue_add(struct virtqueue *_vq,
 					out_sgs, in_sgs, data, ctx, gfp);
 }
 
+/**
+ * virtqueue_dma_dev - get the dma dev
+ * @_vq: the struct virtqueue we're talking about.
+ *
+ * Returns the dma dev. That can been used for dma api.
+ */
+struct device *virtqueue_dma_dev(struct virtqueue *_vq)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+
+	if (vq->use_dma_api)
+		return vring_dma_dev(vq);
+	else
+		return NULL;
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_dev);
+
+/**
+ * virtqueue_set_dma_premapped - set the vring premapped mode
+ * @_vq: the struct virtqueue we're talking about.
+ *
+ * Enable the premapped mode of the vq.
+ *
+ * The vring in premapped mode does not do dma internally, so the driver
+ * must do dma mapping in advance.  The driver must pass the dma_address
+ * of every sg through sg_dma_address(), and is responsible for unmapping
+ * the buffers after they have been detached from the ring.  Indirect
+ * descriptor tables are still mapped and unmapped by the ring itself.
+ *
+ * This can only be called immediately after creation or reset, before
+ * any buffer has been added, and requires the DMA api to be in use.
+ *
+ * Returns zero or a negative error.
+ */
+int virtqueue_set_dma_premapped(struct virtqueue *_vq)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	u32 num;
+
+	START_USE(vq);
+
+	num = vq->packed_ring ? vq->packed.vring.num : vq->split.vring.num;
+
+	if (num != vq->vq.num_free || !vq->use_dma_api) {
+		END_USE(vq);
+		return -EINVAL;
+	}
+
+	vq->premapped = true;
+
+	END_USE(vq);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(virtqueue_set_dma_premapped);
+
 /**
  * virtqueue_add_sgs - expose buffers to other end
  * @_vq: the struct virtqueue we're talking about.
@@ -2082,6 +2161,7 @@ struct virtqueue *__vring_new_virtqueue(unsigned int index,
 	vq->last_used_idx = 0;
 	vq->num_added = 0;
 	vq->use_dma_api = vring_use_dma_api(vdev);
+	vq->premapped = false;
 	list_add_tail(&vq->vq.list, &vdev->vqs);
 #ifdef DEBUG
 	vq->in_use = false;
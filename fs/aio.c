@@ -29,6 +29,7 @@
 #include <linux/mman.h>
 #include <linux/mmu_context.h>
 #include <linux/percpu.h>
+#include <linux/irq_work.h>
 #include <linux/slab.h>
 #include <linux/timer.h>
 #include <linux/aio.h>
@@ -85,8 +86,26 @@ struct kioctx_table {
 	struct kioctx __rcu	*table[];
 };
 
+/*
+ * Completions are staged per cpu and published to the user-visible ring
+ * in batches, so that aio_complete() doesn't bounce ctx->completion_lock
+ * between cpus on every event.  Each staged entry owns the eventfd
+ * reference of its iocb until the event is published.
+ */
+#define AIO_COMPLETION_BATCH	8
+
+struct aio_staged_event {
+	struct io_event		ev;
+	struct eventfd_ctx	*eventfd;
+};
+
 struct kioctx_cpu {
 	unsigned		reqs_available;
+	unsigned		nr_staged;
+	spinlock_t		stage_lock;
+	struct irq_work		flush_work;
+	struct kioctx		*ctx;
+	struct aio_staged_event	staged[AIO_COMPLETION_BATCH];
 };
 
 struct ctx_rq_wait {
@@ -232,6 +251,8 @@ static struct vfsmount *aio_mnt;
 static const struct file_operations aio_ring_fops;
 static const struct address_space_operations aio_ctx_aops;
 
+static void aio_flush_work(struct irq_work *work);
+
 static struct file *aio_private_file(struct kioctx *ctx, loff_t nr_pages)
 {
 	struct file *file;
@@ -583,8 +604,17 @@ static void free_ioctx(struct work_struct *work)
 {
 	struct kioctx *ctx = container_of(to_rcu_work(work), struct kioctx,
 					  free_rwork);
+	int cpu;
+
 	pr_debug("freeing %p\n", ctx);
 
+	/*
+	 * All requests have completed, but their flush work may still be
+	 * in flight and touches the ring pages.
+	 */
+	for_each_possible_cpu(cpu)
+		irq_work_sync(&per_cpu_ptr(ctx->cpu, cpu)->flush_work);
+
 	aio_free_ring(ctx);
 	free_percpu(ctx->cpu);
 	percpu_ref_exit(&ctx->reqs);
@@ -703,6 +733,7 @@ static struct kioctx *ioctx_alloc(unsigned nr_events)
 	struct mm_struct *mm = current->mm;
 	struct kioctx *ctx;
 	int err = -ENOMEM;
+	int cpu;
 
 	/*
 	 * Store the original nr_events -- what userspace passed to io_setup(),
@@ -757,6 +788,14 @@ static struct kioctx *ioctx_alloc(unsigned nr_events)
 	if (!ctx->cpu)
 		goto err;
 
+	for_each_possible_cpu(cpu) {
+		struct kioctx_cpu *kcpu = per_cpu_ptr(ctx->cpu, cpu);
+
+		spin_lock_init(&kcpu->stage_lock);
+		init_irq_work(&kcpu->flush_work, aio_flush_work);
+		kcpu->ctx = ctx;
+	}
+
 	err = aio_setup_ring(ctx, nr_events);
 	if (err < 0)
 		goto err;
@@ -1082,46 +1121,43 @@ static inline void iocb_destroy(struct aio_kiocb *iocb)
 	kmem_cache_free(kiocb_cachep, iocb);
 }
 
-/* aio_complete
- *	Called when the io request on the given iocb is complete.
+/* aio_ring_append
+ *	Publish a batch of staged events to the user-visible ring buffer.
+ *	Must be done holding ctx->completion_lock to prevent other code
+ *	from messing with the tail pointer since we might be called from
+ *	irq context.
  */
-static void aio_complete(struct aio_kiocb *iocb)
+static void aio_ring_append(struct kioctx *ctx, struct aio_staged_event *evs,
+			    unsigned int nr)
 {
-	struct kioctx	*ctx = iocb->ki_ctx;
 	struct aio_ring	*ring;
 	struct io_event	*ev_page, *event;
 	unsigned tail, pos, head;
 	unsigned long	flags;
+	unsigned int	i;
+
+	if (!nr)
+		return;
 
-	/*
-	 * Add a completion event to the ring buffer. Must be done holding
-	 * ctx->completion_lock to prevent other code from messing with the tail
-	 * pointer since we might be called from irq context.
-	 */
 	spin_lock_irqsave(&ctx->completion_lock, flags);
 
 	tail = ctx->tail;
-	pos = tail + AIO_EVENTS_OFFSET;
-
-	if (++tail >= ctx->nr_events)
-		tail = 0;
+	for (i = 0; i < nr; i++) {
+		pos = tail + AIO_EVENTS_OFFSET;
 
-	ev_page = kmap_atomic(ctx->ring_pages[pos / AIO_EVENTS_PER_PAGE]);
-	event = ev_page + pos % AIO_EVENTS_PER_PAGE;
+		if (++tail >= ctx->nr_events)
+			tail = 0;
 
-	*event = iocb->ki_res;
+		ev_page = kmap_atomic(ctx->ring_pages[pos / AIO_EVENTS_PER_PAGE]);
+		event = ev_page + pos % AIO_EVENTS_PER_PAGE;
 
-	kunmap_atomic(ev_page);
-	flush_dcache_page(ctx->ring_pages[pos / AIO_EVENTS_PER_PAGE]);
+		*event = evs[i].ev;
 
-	pr_debug("%p[%u]: %p: %p %Lx %Lx %Lx\n", ctx, tail, iocb,
-		 (void __user *)(unsigned long)iocb->ki_res.obj,
-		 iocb->ki_res.data, iocb->ki_res.res, iocb->ki_res.res2);
+		kunmap_atomic(ev_page);
+		flush_dcache_page(ctx->ring_pages[pos / AIO_EVENTS_PER_PAGE]);
+	}
 
-	/* after flagging the request as done, we
-	 * must never even look at it again
-	 */
-	smp_wmb();	/* make event visible before updating tail */
+	smp_wmb();	/* make events visible before updating tail */
 
 	ctx->tail = tail;
 
@@ -1131,20 +1167,24 @@ static void aio_complete(struct aio_kiocb *iocb)
 	kunmap_atomic(ring);
 	flush_dcache_page(ctx->ring_pages[0]);
 
-	ctx->completed_events++;
+	ctx->completed_events += nr;
 	if (ctx->completed_events > 1)
 		refill_reqs_available(ctx, head, tail);
 	spin_unlock_irqrestore(&ctx->completion_lock, flags);
 
-	pr_debug("added to ring %p at [%u]\n", iocb, tail);
+	pr_debug("added %u events to ring %p, tail [%u]\n", nr, ctx, tail);
 
 	/*
-	 * Check if the user asked us to deliver the result through an
+	 * Check if the user asked us to deliver the results through an
 	 * eventfd. The eventfd_signal() function is safe to be called
 	 * from IRQ context.
 	 */
-	if (iocb->ki_eventfd)
-		eventfd_signal(iocb->ki_eventfd, 1);
+	for (i = 0; i < nr; i++) {
+		if (evs[i].eventfd) {
+			eventfd_signal(evs[i].eventfd, 1);
+			eventfd_ctx_put(evs[i].eventfd);
+		}
+	}
 
 	/*
 	 * We have to order our ring_info tail store above and test
@@ -1158,6 +1198,108 @@ static void aio_complete(struct aio_kiocb *iocb)
 		wake_up(&ctx->wait);
 }
 
+static void aio_flush_cpu_completions(struct kioctx *ctx,
+				      struct kioctx_cpu *kcpu)
+{
+	struct aio_staged_event evs[AIO_COMPLETION_BATCH];
+	unsigned long flags;
+	unsigned int nr;
+
+	spin_lock_irqsave(&kcpu->stage_lock, flags);
+	nr = kcpu->nr_staged;
+	memcpy(evs, kcpu->staged, nr * sizeof(*evs));
+	kcpu->nr_staged = 0;
+	spin_unlock_irqrestore(&kcpu->stage_lock, flags);
+
+	aio_ring_append(ctx, evs, nr);
+}
+
+static void aio_flush_work(struct irq_work *work)
+{
+	struct kioctx_cpu *kcpu = container_of(work, struct kioctx_cpu,
+					       flush_work);
+
+	aio_flush_cpu_completions(kcpu->ctx, kcpu);
+}
+
+/* aio_flush_completions
+ *	Publish every cpu's staged events.  Called on the reap side so
+ *	io_getevents() observes completions that haven't hit their batch
+ *	watermark yet.
+ */
+static void aio_flush_completions(struct kioctx *ctx)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		aio_flush_cpu_completions(ctx, per_cpu_ptr(ctx->cpu, cpu));
+}
+
+/* aio_complete
+ *	Called when the io request on the given iocb is complete.
+ */
+static void aio_complete(struct aio_kiocb *iocb)
+{
+	struct aio_staged_event evs[AIO_COMPLETION_BATCH];
+	struct kioctx	*ctx = iocb->ki_ctx;
+	struct kioctx_cpu *kcpu;
+	struct aio_staged_event *ev;
+	unsigned long	flags;
+	unsigned int	nr = 0;
+	bool		full;
+
+	/*
+	 * Stage the completion in the local cpu's buffer instead of writing
+	 * the shared ring directly, so that completing cpus do not contend
+	 * on ctx->completion_lock.  The buffer is published by the irq_work
+	 * below, when it reaches its watermark, or by the reap side.  The
+	 * eventfd reference moves into the staged entry and is dropped once
+	 * the event is visible.
+	 *
+	 * A full buffer is drained here, while the lock is held with irqs
+	 * off: an eager flush of a full batch below runs after irqs are
+	 * re-enabled, so an interrupt-context completion can find the
+	 * buffer still full and must not stage past the end of it.
+	 */
+	local_irq_save(flags);
+	kcpu = this_cpu_ptr(ctx->cpu);
+	spin_lock(&kcpu->stage_lock);
+	if (unlikely(kcpu->nr_staged == AIO_COMPLETION_BATCH)) {
+		nr = kcpu->nr_staged;
+		memcpy(evs, kcpu->staged, sizeof(evs));
+		kcpu->nr_staged = 0;
+	}
+	ev = &kcpu->staged[kcpu->nr_staged++];
+	ev->ev = iocb->ki_res;
+	ev->eventfd = iocb->ki_eventfd;
+	iocb->ki_eventfd = NULL;
+	full = kcpu->nr_staged == AIO_COMPLETION_BATCH;
+	spin_unlock(&kcpu->stage_lock);
+	local_irq_restore(flags);
+
+	/* Publish the drained batch first to keep per-cpu ordering. */
+	if (unlikely(nr))
+		aio_ring_append(ctx, evs, nr);
+
+	pr_debug("staged %p: %p %Lx %Lx %Lx\n", iocb,
+		 (void __user *)(unsigned long)iocb->ki_res.obj,
+		 iocb->ki_res.data, iocb->ki_res.res, iocb->ki_res.res2);
+
+	if (full)
+		aio_flush_cpu_completions(ctx, kcpu);
+	else
+		irq_work_queue(&kcpu->flush_work);
+
+	/*
+	 * Wake any waiters now; they re-check for events under
+	 * ctx->ring_lock, which flushes the staged buffers first.
+	 */
+	smp_mb();
+
+	if (waitqueue_active(&ctx->wait))
+		wake_up(&ctx->wait);
+}
+
 static inline void iocb_put(struct aio_kiocb *iocb)
 {
 	if (refcount_dec_and_test(&iocb->ki_refcnt)) {
@@ -1187,6 +1329,9 @@ static long aio_read_events_ring(struct kioctx *ctx,
 	sched_annotate_sleep();
 	mutex_lock(&ctx->ring_lock);
 
+	/* Publish completions still sitting in the percpu staging buffers. */
+	aio_flush_completions(ctx);
+
 	/* Access to ->ring_pages here is protected by ctx->ring_lock. */
 	ring = kmap_atomic(ctx->ring_pages[0]);
 	head = ring->head;
@@ -99,6 +99,32 @@ static struct linux_binfmt elf_format = {
 
 #define BAD_ADDR(x) (unlikely((unsigned long)(x) >= TASK_SIZE))
 
+/*
+ * Opt-in exec-time prefaulting (fs.elf-exec-prefault): read-only
+ * PT_LOAD segments are read ahead in one sweep and populated at map
+ * time, so large binaries don't pay a synchronous 4k fault per page
+ * while starting up.  Off by default - it trades exec latency and
+ * memory for runtime faults, which only pays off for services whose
+ * whole text is hot.
+ */
+int elf_exec_prefault;
+
+static void elf_segment_readahead(struct file *file,
+				  const struct elf_phdr *eppnt)
+{
+	unsigned long off = eppnt->p_offset - ELF_PAGEOFFSET(eppnt->p_vaddr);
+	unsigned long size = eppnt->p_filesz + ELF_PAGEOFFSET(eppnt->p_vaddr);
+
+	force_page_cache_readahead(file->f_mapping, file, off >> PAGE_SHIFT,
+				   DIV_ROUND_UP(size, PAGE_SIZE));
+}
+
+static bool elf_prefault_segment(const struct elf_phdr *eppnt)
+{
+	return elf_exec_prefault && !(eppnt->p_flags & PF_W) &&
+		eppnt->p_filesz;
+}
+
 static int set_brk(unsigned long start, unsigned long end, int prot)
 {
 	start = ELF_PAGEALIGN(start);
@@ -981,6 +1007,9 @@ out_free_interp:
 			}
 		}
 
+		if (elf_prefault_segment(elf_ppnt))
+			elf_segment_readahead(bprm->file, elf_ppnt);
+
 		error = elf_map(bprm->file, load_bias + vaddr, elf_ppnt,
 				elf_prot, elf_flags, total_size);
 		if (BAD_ADDR(error)) {
@@ -989,6 +1018,14 @@ out_free_interp:
 			goto out_free_dentry;
 		}
 
+		/*
+		 * Fault the freshly read-ahead segment in now; best effort,
+		 * the pages just fault at runtime if this fails.
+		 */
+		if (elf_prefault_segment(elf_ppnt))
+			mm_populate(error, ELF_PAGEALIGN(elf_ppnt->p_filesz +
+					ELF_PAGEOFFSET(elf_ppnt->p_vaddr)));
+
 		if (!load_addr_set) {
 			load_addr_set = 1;
 			load_addr = (elf_ppnt->p_vaddr - elf_ppnt->p_offset);
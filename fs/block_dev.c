@@ -1984,6 +1984,40 @@ static long block_ioctl(struct file *file, unsigned cmd, unsigned long arg)
 	return blkdev_ioctl(bdev, mode, cmd, arg);
 }
 
+/*
+ * Buffered writes to a block device are submitted for writeback as soon as
+ * a full chunk has been dirtied, and the writer is made to wait for chunks
+ * that fall out of a bounded in-flight window.  Streaming writers (image
+ * provisioning and the like) thus run at device speed without accumulating
+ * enough dirty pages to trip balance_dirty_pages(), and without the
+ * alignment constraints of O_DIRECT.  Chunk crossings are rare for small
+ * random writes, which are left to ordinary background writeback.
+ */
+#define BLKDEV_WRITE_BEHIND_CHUNK	(2UL << 20)
+#define BLKDEV_WRITE_BEHIND_WINDOW	(16UL << 20)
+
+static void blkdev_write_behind(struct address_space *mapping, loff_t start,
+				loff_t end)
+{
+	loff_t from = round_down(start, BLKDEV_WRITE_BEHIND_CHUNK);
+	loff_t to = round_down(end, BLKDEV_WRITE_BEHIND_CHUNK);
+
+	if (from == to)
+		return;
+
+	__filemap_fdatawrite_range(mapping, from, to - 1, WB_SYNC_NONE);
+
+	/*
+	 * Wait for the chunks this write pushed out of the window.  Errors
+	 * are left in the mapping so that fsync() and close() still see
+	 * them through the file's wb_err cursor.
+	 */
+	if (to > BLKDEV_WRITE_BEHIND_WINDOW)
+		filemap_fdatawait_range_keep_errors(mapping,
+				max_t(loff_t, 0, from - BLKDEV_WRITE_BEHIND_WINDOW),
+				to - BLKDEV_WRITE_BEHIND_WINDOW - 1);
+}
+
 /*
  * Write data to the block device.  Only intended for the block device itself
  * and the raw driver which basically is a fake block device.
@@ -1996,6 +2030,7 @@ ssize_t blkdev_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	struct file *file = iocb->ki_filp;
 	struct inode *bd_inode = bdev_file_inode(file);
 	loff_t size = i_size_read(bd_inode);
+	loff_t pos = iocb->ki_pos;
 	struct blk_plug plug;
 	ssize_t ret;
 
@@ -2022,6 +2057,9 @@ ssize_t blkdev_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	if (ret > 0)
 		ret = generic_write_sync(iocb, ret);
 	blk_finish_plug(&plug);
+
+	if (ret > 0 && !(iocb->ki_flags & (IOCB_DIRECT | IOCB_DSYNC)))
+		blkdev_write_behind(file->f_mapping, pos, iocb->ki_pos);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(blkdev_write_iter);
@@ -949,6 +949,26 @@ static void free_workspace(int type, struct list_head *ws)
 	}
 }
 
+/*
+ * Grab a cached workspace from any cpu's slot. Slots are only ever updated
+ * with xchg/cmpxchg, so emptying a remote cpu's slot is safe.
+ */
+static struct list_head *btrfs_steal_pcp_workspace(struct workspace_manager *wsm)
+{
+	struct list_head *workspace;
+	int cpu;
+
+	if (!wsm->idle_pcp)
+		return NULL;
+
+	for_each_possible_cpu(cpu) {
+		workspace = xchg(per_cpu_ptr(wsm->idle_pcp, cpu), NULL);
+		if (workspace)
+			return workspace;
+	}
+	return NULL;
+}
+
 static void btrfs_init_workspace_manager(int type)
 {
 	struct workspace_manager *wsm;
@@ -960,6 +980,11 @@ static void btrfs_init_workspace_manager(int type)
 	atomic_set(&wsm->total_ws, 0);
 	init_waitqueue_head(&wsm->ws_wait);
 
+	/* degrades to the locked idle list if this fails */
+	wsm->idle_pcp = alloc_percpu(struct list_head *);
+	if (!wsm->idle_pcp)
+		pr_warn("BTRFS: cannot allocate per-cpu workspace cache\n");
+
 	/*
 	 * Preallocate one workspace for each compression type so we can
 	 * guarantee forward progress in the worst case
@@ -981,6 +1006,12 @@ static void btrfs_cleanup_workspace_manager(int type)
 	struct list_head *ws;
 
 	wsman = btrfs_compress_op[type]->workspace_manager;
+	while ((ws = btrfs_steal_pcp_workspace(wsman))) {
+		free_workspace(type, ws);
+		atomic_dec(&wsman->total_ws);
+	}
+	free_percpu(wsman->idle_pcp);
+	wsman->idle_pcp = NULL;
 	while (!list_empty(&wsman->idle_ws)) {
 		ws = wsman->idle_ws.next;
 		list_del(ws);
@@ -1014,6 +1045,14 @@ struct list_head *btrfs_get_workspace(int type, unsigned int level)
 	ws_wait	 = &wsm->ws_wait;
 	free_ws	 = &wsm->free_ws;
 
+	/* cpu-local cache first, no lock required */
+	if (wsm->idle_pcp) {
+		workspace = xchg(get_cpu_ptr(wsm->idle_pcp), NULL);
+		put_cpu_ptr(wsm->idle_pcp);
+		if (workspace)
+			return workspace;
+	}
+
 again:
 	spin_lock(ws_lock);
 	if (!list_empty(idle_ws)) {
@@ -1028,7 +1067,24 @@ again:
 		DEFINE_WAIT(wait);
 
 		spin_unlock(ws_lock);
+
+		/*
+		 * Every idle workspace may be parked in a per-cpu slot, so
+		 * try stealing one before and after queueing up to sleep.
+		 * The post-prepare steal pairs with the put side caching the
+		 * workspace before it checks for waiters, so either we see
+		 * the cached workspace here or the put sees us and wakes us.
+		 */
+		workspace = btrfs_steal_pcp_workspace(wsm);
+		if (workspace)
+			return workspace;
+
 		prepare_to_wait(ws_wait, &wait, TASK_UNINTERRUPTIBLE);
+		workspace = btrfs_steal_pcp_workspace(wsm);
+		if (workspace) {
+			finish_wait(ws_wait, &wait);
+			return workspace;
+		}
 		if (atomic_read(total_ws) > cpus && !*free_ws)
 			schedule();
 		finish_wait(ws_wait, &wait);
@@ -1110,6 +1166,22 @@ void btrfs_put_workspace(int type, struct list_head *ws)
 	ws_wait	 = &wsm->ws_wait;
 	free_ws	 = &wsm->free_ws;
 
+	/*
+	 * Park the workspace in this cpu's slot if it is empty. The wakeup
+	 * after caching is what keeps waiters from missing a workspace that
+	 * only exists in a per-cpu slot; they re-scan the slots on wakeup.
+	 */
+	if (wsm->idle_pcp) {
+		struct list_head **slot = get_cpu_ptr(wsm->idle_pcp);
+		bool cached = cmpxchg(slot, NULL, ws) == NULL;
+
+		put_cpu_ptr(wsm->idle_pcp);
+		if (cached) {
+			cond_wake_up(ws_wait);
+			return;
+		}
+	}
+
 	spin_lock(ws_lock);
 	if (*free_ws <= num_online_cpus()) {
 		list_add(ws, idle_ws);
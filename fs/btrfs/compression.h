@@ -117,6 +117,11 @@ struct workspace_manager {
 	atomic_t total_ws;
 	/* Waiters for a free workspace */
 	wait_queue_head_t ws_wait;
+	/*
+	 * One cached idle workspace per cpu, exchanged atomically so remote
+	 * cpus can steal and drain the slots. Not accounted in free_ws.
+	 */
+	struct list_head * __percpu *idle_pcp;
 };
 
 struct list_head *btrfs_get_workspace(int type, unsigned int level);
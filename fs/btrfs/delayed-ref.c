@@ -572,6 +572,33 @@ again:
 	return head;
 }
 
+/*
+ * Select up to @nr ref heads for processing under a single acquisition of
+ * delayed_refs->lock. Each returned head is marked as processing and carries
+ * an extra reference, which keeps the structure alive even if the transaction
+ * is aborted and the head deleted before the caller gets around to it.
+ * Unprocessed leftovers must have the reference dropped and the processing
+ * flag cleared by the caller.
+ */
+int btrfs_select_ref_heads(struct btrfs_delayed_ref_root *delayed_refs,
+			   struct btrfs_delayed_ref_head **heads, int nr)
+{
+	int found = 0;
+
+	lockdep_assert_held(&delayed_refs->lock);
+
+	while (found < nr) {
+		struct btrfs_delayed_ref_head *head;
+
+		head = btrfs_select_ref_head(delayed_refs);
+		if (!head)
+			break;
+		refcount_inc(&head->refs);
+		heads[found++] = head;
+	}
+	return found;
+}
+
 void btrfs_delete_ref_head(struct btrfs_delayed_ref_root *delayed_refs,
 			   struct btrfs_delayed_ref_head *head)
 {
@@ -361,6 +361,8 @@ void btrfs_delete_ref_head(struct btrfs_delayed_ref_root *delayed_refs,
 
 struct btrfs_delayed_ref_head *btrfs_select_ref_head(
 		struct btrfs_delayed_ref_root *delayed_refs);
+int btrfs_select_ref_heads(struct btrfs_delayed_ref_root *delayed_refs,
+			   struct btrfs_delayed_ref_head **heads, int nr);
 
 int btrfs_check_delayed_seq(struct btrfs_fs_info *fs_info, u64 seq);
 
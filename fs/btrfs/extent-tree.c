@@ -1883,39 +1883,91 @@ static int cleanup_ref_head(struct btrfs_trans_handle *trans,
 	return 0;
 }
 
+/*
+ * Ref heads are selected in batches so one trip through delayed_refs->lock
+ * amortizes over several heads instead of being paid per head.  The batch
+ * owns a reference on every head from ->cur onwards.
+ */
+#define DELAYED_REF_HEAD_BATCH	8
+
+struct ref_head_batch {
+	struct btrfs_delayed_ref_head *heads[DELAYED_REF_HEAD_BATCH];
+	int nr;
+	int cur;
+};
+
 static struct btrfs_delayed_ref_head *btrfs_obtain_ref_head(
-					struct btrfs_trans_handle *trans)
+					struct btrfs_trans_handle *trans,
+					struct ref_head_batch *batch)
 {
 	struct btrfs_delayed_ref_root *delayed_refs =
 		&trans->transaction->delayed_refs;
-	struct btrfs_delayed_ref_head *head = NULL;
+	struct btrfs_delayed_ref_head *head;
 	int ret;
 
-	spin_lock(&delayed_refs->lock);
-	head = btrfs_select_ref_head(delayed_refs);
-	if (!head) {
+	if (batch->cur == batch->nr) {
+		spin_lock(&delayed_refs->lock);
+		batch->cur = 0;
+		batch->nr = btrfs_select_ref_heads(delayed_refs, batch->heads,
+						   DELAYED_REF_HEAD_BATCH);
 		spin_unlock(&delayed_refs->lock);
-		return head;
+		if (batch->nr == 0)
+			return NULL;
 	}
+	head = batch->heads[batch->cur++];
 
 	/*
 	 * Grab the lock that says we are going to process all the refs for
-	 * this head
+	 * this head.  The batch reference keeps the head memory stable, so
+	 * the trylock doesn't need delayed_refs->lock; only the sleeping
+	 * slow path does, for the revalidation it performs.
 	 */
-	ret = btrfs_delayed_ref_lock(delayed_refs, head);
-	spin_unlock(&delayed_refs->lock);
+	if (!mutex_trylock(&head->mutex)) {
+		spin_lock(&delayed_refs->lock);
+		ret = btrfs_delayed_ref_lock(delayed_refs, head);
+		spin_unlock(&delayed_refs->lock);
+		if (ret == -EAGAIN) {
+			btrfs_put_delayed_ref_head(head);
+			return ERR_PTR(-EAGAIN);
+		}
+	}
 
 	/*
-	 * We may have dropped the spin lock to get the head mutex lock, and
-	 * that might have given someone else time to free the head.  If that's
-	 * true, it has been removed from our list and we can move on.
+	 * The head may have been deleted (e.g. by a transaction abort) while
+	 * it sat in the batch.  Deleters hold the mutex, so the check is
+	 * stable now that we got it.  Treat this like the classic lost race.
 	 */
-	if (ret == -EAGAIN)
-		head = ERR_PTR(-EAGAIN);
+	if (RB_EMPTY_NODE(&head->href_node)) {
+		mutex_unlock(&head->mutex);
+		btrfs_put_delayed_ref_head(head);
+		return ERR_PTR(-EAGAIN);
+	}
 
+	btrfs_put_delayed_ref_head(head);
 	return head;
 }
 
+/*
+ * Return the unprocessed remainder of the batch to the delayed ref tree and
+ * drop the references the batch held.
+ */
+static void btrfs_release_ref_head_batch(
+				struct btrfs_delayed_ref_root *delayed_refs,
+				struct ref_head_batch *batch)
+{
+	while (batch->cur < batch->nr) {
+		struct btrfs_delayed_ref_head *head = batch->heads[batch->cur++];
+
+		spin_lock(&delayed_refs->lock);
+		if (!RB_EMPTY_NODE(&head->href_node)) {
+			head->processing = 0;
+			delayed_refs->num_heads_ready++;
+		}
+		spin_unlock(&delayed_refs->lock);
+		btrfs_put_delayed_ref_head(head);
+	}
+}
+
 static int btrfs_run_delayed_refs_for_head(struct btrfs_trans_handle *trans,
 				    struct btrfs_delayed_ref_head *locked_ref,
 				    unsigned long *run_refs)
@@ -2006,6 +2058,7 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 	struct btrfs_fs_info *fs_info = trans->fs_info;
 	struct btrfs_delayed_ref_root *delayed_refs;
 	struct btrfs_delayed_ref_head *locked_ref = NULL;
+	struct ref_head_batch batch = { .nr = 0, .cur = 0 };
 	ktime_t start = ktime_get();
 	int ret;
 	unsigned long count = 0;
@@ -2014,9 +2067,10 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 	delayed_refs = &trans->transaction->delayed_refs;
 	do {
 		if (!locked_ref) {
-			locked_ref = btrfs_obtain_ref_head(trans);
+			locked_ref = btrfs_obtain_ref_head(trans, &batch);
 			if (IS_ERR_OR_NULL(locked_ref)) {
 				if (PTR_ERR(locked_ref) == -EAGAIN) {
+					locked_ref = NULL;
 					continue;
 				} else {
 					break;
@@ -2046,6 +2100,7 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 			 * Error, btrfs_run_delayed_refs_for_head already
 			 * unlocked everything so just bail out
 			 */
+			btrfs_release_ref_head_batch(delayed_refs, &batch);
 			return ret;
 		} else if (!ret) {
 			/*
@@ -2058,6 +2113,8 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 				ret = 0;
 				continue;
 			} else if (ret) {
+				btrfs_release_ref_head_batch(delayed_refs,
+							     &batch);
 				return ret;
 			}
 		}
@@ -2071,6 +2128,8 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 		cond_resched();
 	} while ((nr != -1 && count < nr) || locked_ref);
 
+	btrfs_release_ref_head_batch(delayed_refs, &batch);
+
 	/*
 	 * We don't want to include ref heads since we can have empty ref heads
 	 * and those will drastically skew our runtime down since we just do
@@ -2305,6 +2305,17 @@ int clean_io_failure(struct btrfs_fs_info *fs_info,
 	int num_copies;
 	int ret;
 
+	/*
+	 * This is called for every page of every successful read, and the
+	 * failure tree is empty unless a recent read of this inode actually
+	 * failed. Peek at the tree root locklessly so the common case doesn't
+	 * take the tree lock at all. If we race with a record being inserted
+	 * we may miss it here, but the repaired read that insertion triggers
+	 * will come back through this path and clean the record up.
+	 */
+	if (RB_EMPTY_ROOT(&failure_tree->state))
+		return 0;
+
 	private = 0;
 	ret = count_range_bits(failure_tree, &private, (u64)-1, 1,
 			       EXTENT_DIRTY, 0);
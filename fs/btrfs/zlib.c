@@ -107,12 +107,38 @@ int zlib_compress_pages(struct list_head *ws, struct address_space *mapping,
 	unsigned long len = *total_out;
 	unsigned long nr_dest_pages = *out_pages;
 	const unsigned long max_out = nr_dest_pages * PAGE_SIZE;
+	int level = workspace->level;
 
 	*out_pages = 0;
 	*total_out = 0;
 	*total_in = 0;
 
-	if (Z_OK != zlib_deflateInit(&workspace->strm, workspace->level)) {
+	/*
+	 * A cheap entropy sample of the first page decides how much
+	 * effort this block deserves, so mixed datasets do not burn the
+	 * configured level on incompressible media.  The fast levels
+	 * still use deflate_fast, only the match search gets cheaper;
+	 * blocks judged incompressible are left to the uncompressed
+	 * fallback right away.
+	 */
+	in_page = find_get_page(mapping, start >> PAGE_SHIFT);
+	if (in_page) {
+		int effort;
+
+		data_in = kmap(in_page);
+		effort = zlib_deflate_effort(data_in,
+				min_t(unsigned long, len, PAGE_SIZE));
+		kunmap(in_page);
+		put_page(in_page);
+		in_page = NULL;
+
+		if (effort == Z_EFFORT_STORE)
+			return -E2BIG;
+		if (effort == Z_EFFORT_FAST)
+			level = min(level, 3);
+	}
+
+	if (Z_OK != zlib_deflateInit(&workspace->strm, level)) {
 		pr_warn("BTRFS: deflateInit failed\n");
 		ret = -EIO;
 		goto out;
@@ -54,6 +54,9 @@
 static int fsync_buffers_list(spinlock_t *lock, struct list_head *list);
 static int submit_bh_wbc(int op, int op_flags, struct buffer_head *bh,
 			 enum rw_hint hint, struct writeback_control *wbc);
+static void submit_bh_batch_wbc(int op, int op_flags, struct buffer_head **bhs,
+				unsigned int nr, enum rw_hint hint,
+				struct writeback_control *wbc);
 
 #define BH_ENTRY(list) list_entry((list), struct buffer_head, b_assoc_buffers)
 
@@ -1237,7 +1240,12 @@ static struct buffer_head *__bread_slow(struct buffer_head *bh)
  * a local interrupt disable for that.
  */
 
-#define BH_LRU_SIZE	16
+/*
+ * 16 entries used to be enough, but metadata-heavy workloads touch more
+ * distinct blocks between repeats than that; the scan and install costs
+ * are trivial either way.
+ */
+#define BH_LRU_SIZE	32
 
 struct bh_lru {
 	struct buffer_head *bhs[BH_LRU_SIZE];
@@ -1724,7 +1732,7 @@ int __block_write_full_page(struct inode *inode, struct page *page,
 	int err;
 	sector_t block;
 	sector_t last_block;
-	struct buffer_head *bh, *head;
+	struct buffer_head *bh, *head, *arr[MAX_BUF_PER_PAGE];
 	unsigned int blocksize, bbits;
 	int nr_underway = 0;
 	int write_flags = wbc_to_write_flags(wbc);
@@ -1814,13 +1822,13 @@ int __block_write_full_page(struct inode *inode, struct page *page,
 
 	do {
 		struct buffer_head *next = bh->b_this_page;
-		if (buffer_async_write(bh)) {
-			submit_bh_wbc(REQ_OP_WRITE, write_flags, bh,
-					inode->i_write_hint, wbc);
-			nr_underway++;
-		}
+		if (buffer_async_write(bh))
+			arr[nr_underway++] = bh;
 		bh = next;
 	} while (bh != head);
+	if (nr_underway)
+		submit_bh_batch_wbc(REQ_OP_WRITE, write_flags, arr,
+				nr_underway, inode->i_write_hint, wbc);
 	unlock_page(page);
 
 	err = 0;
@@ -1870,12 +1878,13 @@ recover:
 		struct buffer_head *next = bh->b_this_page;
 		if (buffer_async_write(bh)) {
 			clear_buffer_dirty(bh);
-			submit_bh_wbc(REQ_OP_WRITE, write_flags, bh,
-					inode->i_write_hint, wbc);
-			nr_underway++;
+			arr[nr_underway++] = bh;
 		}
 		bh = next;
 	} while (bh != head);
+	if (nr_underway)
+		submit_bh_batch_wbc(REQ_OP_WRITE, write_flags, arr,
+				nr_underway, inode->i_write_hint, wbc);
 	unlock_page(page);
 	goto done;
 }
@@ -2270,7 +2279,7 @@ int block_read_full_page(struct page *page, get_block_t *get_block)
 	sector_t iblock, lblock;
 	struct buffer_head *bh, *head, *arr[MAX_BUF_PER_PAGE];
 	unsigned int blocksize, bbits;
-	int nr, i;
+	int nr, nr_read, i;
 	int fully_mapped = 1;
 
 	head = create_page_buffers(page, inode, 0);
@@ -2338,14 +2347,19 @@ int block_read_full_page(struct page *page, get_block_t *get_block)
 	 * Stage 3: start the IO.  Check for uptodateness
 	 * inside the buffer lock in case another process reading
 	 * the underlying blockdev brought it uptodate (the sct fix).
+	 * The remaining buffers are submitted as one batch so that
+	 * adjacent blocks share a bio.
 	 */
+	nr_read = 0;
 	for (i = 0; i < nr; i++) {
 		bh = arr[i];
 		if (buffer_uptodate(bh))
 			end_buffer_async_read(bh, 1);
 		else
-			submit_bh(REQ_OP_READ, 0, bh);
+			arr[nr_read++] = bh;
 	}
+	if (nr_read)
+		submit_bh_batch_wbc(REQ_OP_READ, 0, arr, nr_read, 0, NULL);
 	return 0;
 }
 EXPORT_SYMBOL(block_read_full_page);
@@ -3130,6 +3144,132 @@ int submit_bh(int op, int op_flags, struct buffer_head *bh)
 }
 EXPORT_SYMBOL(submit_bh);
 
+/*
+ * Several buffer_heads sharing one bio.  The completion fans back out to
+ * each bh's b_end_io, so this is transparent to the async read/write
+ * endio machinery.
+ */
+struct bh_batch {
+	unsigned int		nr;
+	struct buffer_head	*bhs[];
+};
+
+static void end_bio_bh_batch(struct bio *bio)
+{
+	struct bh_batch *batch = bio->bi_private;
+	int uptodate = !bio->bi_status;
+	unsigned int i;
+
+	for (i = 0; i < batch->nr; i++) {
+		struct buffer_head *bh = batch->bhs[i];
+
+		if (unlikely(bio_flagged(bio, BIO_QUIET)))
+			set_bit(BH_Quiet, &bh->b_state);
+		bh->b_end_io(bh, uptodate);
+	}
+	kfree(batch);
+	bio_put(bio);
+}
+
+/*
+ * Submit a run of buffer_heads that are contiguous on disk as a single
+ * multi-segment bio.  Falls back to one bio per bh for a run of one or
+ * when the tracking structure can't be allocated.
+ */
+static void submit_bh_run_wbc(int op, int op_flags, struct buffer_head **bhs,
+			      unsigned int nr, enum rw_hint write_hint,
+			      struct writeback_control *wbc)
+{
+	struct bh_batch *batch;
+	struct bio *bio;
+	unsigned int i;
+
+	if (nr == 1) {
+		submit_bh_wbc(op, op_flags, bhs[0], write_hint, wbc);
+		return;
+	}
+
+	batch = kmalloc(struct_size(batch, bhs, nr), GFP_NOIO);
+	if (unlikely(!batch)) {
+		for (i = 0; i < nr; i++)
+			submit_bh_wbc(op, op_flags, bhs[i], write_hint, wbc);
+		return;
+	}
+
+	bio = bio_alloc(GFP_NOIO, nr);
+
+	bio->bi_iter.bi_sector = bhs[0]->b_blocknr * (bhs[0]->b_size >> 9);
+	bio_set_dev(bio, bhs[0]->b_bdev);
+	bio->bi_write_hint = write_hint;
+
+	for (i = 0; i < nr; i++) {
+		struct buffer_head *bh = bhs[i];
+
+		BUG_ON(!buffer_locked(bh));
+		BUG_ON(!buffer_mapped(bh));
+		BUG_ON(!bh->b_end_io);
+		BUG_ON(buffer_delay(bh));
+		BUG_ON(buffer_unwritten(bh));
+
+		/*
+		 * Only clear out a write error when rewriting
+		 */
+		if (test_set_buffer_req(bh) && (op == REQ_OP_WRITE))
+			clear_buffer_write_io_error(bh);
+
+		/* can't fail: the bio was sized for nr segments */
+		WARN_ON(bio_add_page(bio, bh->b_page, bh->b_size,
+				     bh_offset(bh)) != bh->b_size);
+		batch->bhs[i] = bh;
+
+		if (wbc)
+			wbc_account_cgroup_owner(wbc, bh->b_page, bh->b_size);
+	}
+	batch->nr = nr;
+
+	bio->bi_end_io = end_bio_bh_batch;
+	bio->bi_private = batch;
+
+	if (buffer_meta(bhs[0]))
+		op_flags |= REQ_META;
+	if (buffer_prio(bhs[0]))
+		op_flags |= REQ_PRIO;
+	bio_set_op_attrs(bio, op, op_flags);
+
+	/* Take care of bh's that straddle the end of the device */
+	guard_bio_eod(bio);
+
+	if (wbc)
+		wbc_init_bio(wbc, bio);
+
+	submit_bio(bio);
+}
+
+/*
+ * Submit an array of buffer_heads, gathering bhs that are adjacent on
+ * disk into multi-segment bios so a stream of small blocks goes down as
+ * a few large requests instead of one bio per bh.  The bhs may span
+ * several pages; each must be locked and mapped with b_end_io set, as
+ * for submit_bh().
+ */
+static void submit_bh_batch_wbc(int op, int op_flags, struct buffer_head **bhs,
+				unsigned int nr, enum rw_hint write_hint,
+				struct writeback_control *wbc)
+{
+	unsigned int start = 0, i;
+
+	for (i = 1; i <= nr; i++) {
+		if (i < nr &&
+		    bhs[i]->b_bdev == bhs[start]->b_bdev &&
+		    bhs[i]->b_size == bhs[i - 1]->b_size &&
+		    bhs[i]->b_blocknr == bhs[i - 1]->b_blocknr + 1)
+			continue;
+		submit_bh_run_wbc(op, op_flags, bhs + start, i - start,
+				  write_hint, wbc);
+		start = i;
+	}
+}
+
 /**
  * ll_rw_block: low-level access to block devices (DEPRECATED)
  * @op: whether to %READ or %WRITE
@@ -3158,7 +3298,8 @@ EXPORT_SYMBOL(submit_bh);
  */
 void ll_rw_block(int op, int op_flags,  int nr, struct buffer_head *bhs[])
 {
-	int i;
+	struct buffer_head *batch[MAX_BUF_PER_PAGE];
+	int i, nb = 0;
 
 	for (i = 0; i < nr; i++) {
 		struct buffer_head *bh = bhs[i];
@@ -3169,19 +3310,27 @@ void ll_rw_block(int op, int op_flags,  int nr, struct buffer_head *bhs[])
 			if (test_clear_buffer_dirty(bh)) {
 				bh->b_end_io = end_buffer_write_sync;
 				get_bh(bh);
-				submit_bh(op, op_flags, bh);
-				continue;
+				batch[nb++] = bh;
+				goto batched;
 			}
 		} else {
 			if (!buffer_uptodate(bh)) {
 				bh->b_end_io = end_buffer_read_sync;
 				get_bh(bh);
-				submit_bh(op, op_flags, bh);
-				continue;
+				batch[nb++] = bh;
+				goto batched;
 			}
 		}
 		unlock_buffer(bh);
+		continue;
+batched:
+		if (nb == ARRAY_SIZE(batch)) {
+			submit_bh_batch_wbc(op, op_flags, batch, nb, 0, NULL);
+			nb = 0;
+		}
 	}
+	if (nb)
+		submit_bh_batch_wbc(op, op_flags, batch, nb, 0, NULL);
 }
 EXPORT_SYMBOL(ll_rw_block);
 
@@ -39,6 +39,7 @@
 #include <linux/oom.h>
 #include <linux/compat.h>
 #include <linux/fs.h>
+#include <linux/writeback.h>
 #include <linux/path.h>
 #include <linux/timekeeping.h>
 
@@ -535,6 +536,41 @@ static void wait_for_dump_helpers(struct file *file)
 	pipe_unlock(pipe);
 }
 
+/*
+ * A multi-gigabyte dump written through the page cache evicts everything
+ * else the cgroup has cached.  Stream the dump instead: once per window
+ * of written data, queue what was just written for asynchronous
+ * writeback and drop the pages that were queued on the previous pass,
+ * which have normally reached the disk by then.  Pages still dirty or
+ * under writeback are skipped by invalidate_mapping_pages(), so this is
+ * only an LRU hint and never loses data.
+ */
+#define DUMP_PAGECACHE_WINDOW	(8 * 1024 * 1024)
+
+static void dump_drop_behind(struct coredump_params *cprm, bool final)
+{
+	struct address_space *mapping = cprm->file->f_mapping;
+
+	/* Piped dumps don't go through the page cache. */
+	if (!S_ISREG(file_inode(cprm->file)->i_mode))
+		return;
+
+	if (!final && cprm->pos - cprm->wb_start < DUMP_PAGECACHE_WINDOW)
+		return;
+
+	if (cprm->wb_start > cprm->drop_start) {
+		invalidate_mapping_pages(mapping,
+					 cprm->drop_start >> PAGE_SHIFT,
+					 (cprm->wb_start >> PAGE_SHIFT) - 1);
+		cprm->drop_start = cprm->wb_start;
+	}
+	if (cprm->pos > cprm->wb_start) {
+		__filemap_fdatawrite_range(mapping, cprm->wb_start,
+					   cprm->pos - 1, WB_SYNC_NONE);
+		cprm->wb_start = cprm->pos;
+	}
+}
+
 /*
  * umh_pipe_setup
  * helper function to customize the process used
@@ -798,6 +834,8 @@ void do_coredump(const kernel_siginfo_t *siginfo)
 		}
 		file_start_write(cprm.file);
 		core_dumped = binfmt->core_dump(&cprm);
+		if (core_dumped && !ispipe)
+			dump_drop_behind(&cprm, true);
 		file_end_write(cprm.file);
 	}
 	if (ispipe && core_pipe_limit)
@@ -842,6 +880,7 @@ int dump_emit(struct coredump_params *cprm, const void *addr, int nr)
 		cprm->pos += n;
 		nr -= n;
 	}
+	dump_drop_behind(cprm, false);
 	return 1;
 }
 EXPORT_SYMBOL(dump_emit);
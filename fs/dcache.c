@@ -175,6 +175,38 @@ int proc_nr_dentry(struct ctl_table *table, int write, void __user *buffer,
 }
 #endif
 
+/*
+ * Cap on negative dentries per superblock, 0 means no limit. Settable
+ * via the fs.negative-dentry-limit sysctl. Enforcement is asynchronous:
+ * when a superblock goes over the limit its pruning work is kicked,
+ * which evicts only negative dentries from the LRU.
+ */
+unsigned long sysctl_neg_dentry_limit __read_mostly;
+
+/*
+ * Per-superblock mirrors of the nr_dentry_negative updates below. These
+ * must be kept in step with the global counter: a dentry is accounted
+ * while it is negative and on the superblock LRU list, not while it is
+ * on a shrink list.
+ */
+static inline void neg_dentry_inc(struct dentry *dentry)
+{
+	struct super_block *sb = dentry->d_sb;
+
+	this_cpu_inc(nr_dentry_negative);
+	percpu_counter_inc(&sb->s_ndentry_neg);
+	if (unlikely(sysctl_neg_dentry_limit &&
+		     percpu_counter_read_positive(&sb->s_ndentry_neg) >
+		     sysctl_neg_dentry_limit))
+		schedule_work(&sb->s_prune_neg_work);
+}
+
+static inline void neg_dentry_dec(struct dentry *dentry)
+{
+	this_cpu_dec(nr_dentry_negative);
+	percpu_counter_dec(&dentry->d_sb->s_ndentry_neg);
+}
+
 /*
  * Compare 2 name strings, return 0 if they match, otherwise non-zero.
  * The strings are both count bytes long, and count is non-zero.
@@ -330,7 +362,7 @@ static inline void __d_clear_type_and_inode(struct dentry *dentry)
 	WRITE_ONCE(dentry->d_flags, flags);
 	dentry->d_inode = NULL;
 	if (dentry->d_flags & DCACHE_LRU_LIST)
-		this_cpu_inc(nr_dentry_negative);
+		neg_dentry_inc(dentry);
 }
 
 static void dentry_free(struct dentry *dentry)
@@ -400,7 +432,7 @@ static void d_lru_add(struct dentry *dentry)
 	dentry->d_flags |= DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_inc(nr_dentry_negative);
+		neg_dentry_inc(dentry);
 	WARN_ON_ONCE(!list_lru_add(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
@@ -410,7 +442,7 @@ static void d_lru_del(struct dentry *dentry)
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		neg_dentry_dec(dentry);
 	WARN_ON_ONCE(!list_lru_del(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
@@ -442,7 +474,7 @@ static void d_lru_isolate(struct list_lru_one *lru, struct dentry *dentry)
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		neg_dentry_dec(dentry);
 	list_lru_isolate(lru, &dentry->d_lru);
 }
 
@@ -452,7 +484,7 @@ static void d_lru_shrink_move(struct list_lru_one *lru, struct dentry *dentry,
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
 	dentry->d_flags |= DCACHE_SHRINK_LIST;
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		neg_dentry_dec(dentry);
 	list_lru_isolate_move(lru, &dentry->d_lru, list);
 }
 
@@ -1244,6 +1276,80 @@ void shrink_dcache_sb(struct super_block *sb)
 }
 EXPORT_SYMBOL(shrink_dcache_sb);
 
+static enum lru_status dentry_negative_lru_isolate(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct list_head *freeable = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	/*
+	 * we are inverting the lru lock/dentry->d_lock here,
+	 * so use a trylock. If we fail to get the lock, just skip
+	 * it
+	 */
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	/*
+	 * Positive dentries are what we are trying to preserve; leave
+	 * them where they are.  DCACHE_REFERENCED is ignored on purpose:
+	 * the limit is a hard cap, and a hot negative dentry will simply
+	 * be recreated on the next failed lookup.
+	 */
+	if (!d_is_negative(dentry)) {
+		spin_unlock(&dentry->d_lock);
+		return LRU_SKIP;
+	}
+
+	/*
+	 * Dentries with an active reference get taken off the LRU and
+	 * put back when the last reference is dropped, as in
+	 * dentry_lru_isolate().
+	 */
+	if (dentry->d_lockref.count) {
+		d_lru_isolate(lru, dentry);
+		spin_unlock(&dentry->d_lock);
+		return LRU_REMOVED;
+	}
+
+	d_lru_shrink_move(lru, dentry, freeable);
+	spin_unlock(&dentry->d_lock);
+
+	return LRU_REMOVED;
+}
+
+/*
+ * Work callback for sb->s_prune_neg_work: walk the superblock LRU and
+ * evict negative dentries until the superblock is back under
+ * fs.negative-dentry-limit or a walk frees nothing. Scanning is done in
+ * bounded batches, so a stream of mostly positive dentries cannot keep
+ * us on the LRU indefinitely; the work is simply kicked again the next
+ * time the limit is crossed.
+ */
+void prune_negative_dentries(struct work_struct *work)
+{
+	struct super_block *sb = container_of(work, struct super_block,
+					      s_prune_neg_work);
+	unsigned long limit = sysctl_neg_dentry_limit;
+	long freed;
+
+	if (!trylock_super(sb))
+		return;
+
+	do {
+		LIST_HEAD(dispose);
+
+		freed = list_lru_walk(&sb->s_dentry_lru,
+				      dentry_negative_lru_isolate, &dispose,
+				      1024);
+		shrink_dentry_list(&dispose);
+		cond_resched();
+	} while (freed > 0 && limit &&
+		 percpu_counter_read_positive(&sb->s_ndentry_neg) > limit);
+
+	up_read(&sb->s_umount);
+}
+
 /**
  * enum d_walk_ret - action to talke during tree walk
  * @D_WALK_CONTINUE:	contrinue walk
@@ -1783,6 +1889,56 @@ struct dentry *d_alloc(struct dentry * parent, const struct qstr *name)
 }
 EXPORT_SYMBOL(d_alloc);
 
+/**
+ * d_alloc_bulk	-	allocate a batch of dcache entries
+ * @parent: parent of the entries to allocate
+ * @names: array of @nr qstrs, one per entry
+ * @nr: number of entries to allocate
+ * @res: array the new dentries are returned in
+ *
+ * Allocates @nr children of @parent in one go, taking the parent lock
+ * only once instead of once per entry.  Intended for readdir-plus style
+ * bursts which know up front which names they are about to look up or
+ * create.  The names are copied as in d_alloc().
+ *
+ * The new dentries are unhashed, exactly as if each had come from
+ * d_alloc(); the caller instantiates and hashes them individually.
+ *
+ * Returns 0 on success or -ENOMEM, in which case no entries are
+ * allocated.
+ */
+int d_alloc_bulk(struct dentry *parent, const struct qstr *names,
+		 unsigned int nr, struct dentry **res)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		res[i] = __d_alloc(parent->d_sb, &names[i]);
+		if (!res[i])
+			goto fail;
+	}
+
+	spin_lock(&parent->d_lock);
+	/*
+	 * don't need the child locks because the entries are not subject
+	 * to concurrency here
+	 */
+	for (i = 0; i < nr; i++) {
+		__dget_dlock(parent);
+		res[i]->d_parent = parent;
+		list_add(&res[i]->d_child, &parent->d_subdirs);
+	}
+	spin_unlock(&parent->d_lock);
+
+	return 0;
+
+fail:
+	while (i--)
+		dput(res[i]);
+	return -ENOMEM;
+}
+EXPORT_SYMBOL(d_alloc_bulk);
+
 struct dentry *d_alloc_anon(struct super_block *sb)
 {
 	return __d_alloc(sb, NULL);
@@ -1923,7 +2079,7 @@ static void __d_instantiate(struct dentry *dentry, struct inode *inode)
 	 * Decrement negative dentry count if it was in the LRU list.
 	 */
 	if (dentry->d_flags & DCACHE_LRU_LIST)
-		this_cpu_dec(nr_dentry_negative);
+		neg_dentry_dec(dentry);
 	hlist_add_head(&dentry->d_u.d_alias, &inode->i_dentry);
 	raw_write_seqcount_begin(&dentry->d_seq);
 	__d_set_inode_and_type(dentry, inode, add_flags);
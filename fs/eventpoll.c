@@ -256,6 +256,8 @@ struct ep_send_events_data {
 	int maxevents;
 	struct epoll_event __user *events;
 	int res;
+	/* Stop transferring events past this time, 0 == no budget */
+	ktime_t deadline;
 };
 
 /*
@@ -264,6 +266,14 @@ struct ep_send_events_data {
 /* Maximum number of epoll watched descriptors, per user */
 static long max_user_watches __read_mostly;
 
+/*
+ * Time budget for a single epoll_wait() event transfer, in microseconds.
+ * Zero (the default) means delivery is bounded by maxevents only. Under
+ * an event storm a large maxevents otherwise keeps one epoll_wait()
+ * caller harvesting while new events pile up on ->ovflist behind it.
+ */
+static long event_budget_us __read_mostly;
+
 /*
  * This mutex is used to serialize ep_free() and eventpoll_release_file().
  */
@@ -304,6 +314,15 @@ struct ctl_table epoll_table[] = {
 		.extra1		= &long_zero,
 		.extra2		= &long_max,
 	},
+	{
+		.procname	= "event_budget_us",
+		.data		= &event_budget_us,
+		.maxlen		= sizeof(event_budget_us),
+		.mode		= 0644,
+		.proc_handler	= proc_doulongvec_minmax,
+		.extra1		= &long_zero,
+		.extra2		= &long_max,
+	},
 	{ }
 };
 #endif /* CONFIG_SYSCTL */
@@ -1695,6 +1714,16 @@ static __poll_t ep_send_events_proc(struct eventpoll *ep, struct list_head *head
 		if (esed->res >= esed->maxevents)
 			break;
 
+		/*
+		 * Once over the time budget, return what we have gathered so
+		 * far; the remainder of the batch is re-injected into the
+		 * ready list by ep_scan_ready_list(). The clock is only read
+		 * every 16 events to keep it off the hot path.
+		 */
+		if (esed->deadline && esed->res && !(esed->res % 16) &&
+		    ktime_after(ktime_get(), esed->deadline))
+			break;
+
 		/*
 		 * Activate ep->ws before deactivating epi->ws to prevent
 		 * triggering auto-suspend here (in case we reactive epi->ws
@@ -1759,9 +1788,12 @@ static int ep_send_events(struct eventpoll *ep,
 			  struct epoll_event __user *events, int maxevents)
 {
 	struct ep_send_events_data esed;
+	long budget = READ_ONCE(event_budget_us);
 
 	esed.maxevents = maxevents;
 	esed.events = events;
+	esed.deadline = budget ?
+		ktime_add_us(ktime_get(), budget) : 0;
 
 	ep_scan_ready_list(ep, ep_send_events_proc, &esed, 0, false);
 	return esed.res;
@@ -1814,17 +1846,15 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 	} else if (timeout == 0) {
 		/*
 		 * Avoid the unnecessary trip to the wait queue loop, if the
-		 * caller specified a non blocking operation. We still need
-		 * lock because we could race and not see an epi being added
-		 * to the ready list while in irq callback. Thus incorrectly
-		 * returning 0 back to userspace.
+		 * caller specified a non blocking operation. A nonblocking
+		 * caller cannot order itself against a concurrent irq
+		 * callback anyway, and ep_events_available() is safe to run
+		 * locklessly (list_empty_careful() plus READ_ONCE() on
+		 * ->ovflist), so there is no need to take ep->lock just to
+		 * read the state of the lists.
 		 */
 		timed_out = 1;
-
-		write_lock_irq(&ep->lock);
 		eavail = ep_events_available(ep);
-		write_unlock_irq(&ep->lock);
-
 		goto send_events;
 	}
 
@@ -1045,6 +1045,9 @@ struct ext4_inode_info {
 	ext4_lblk_t i_es_shrink_lblk;	/* Offset where we start searching for
 					   extents to shrink. Protected by
 					   i_es_lock  */
+	unsigned long i_es_access;	/* jiffies of the last extent status
+					   cache hit, so the shrinker can
+					   leave hot inodes alone */
 
 	/* ialloc */
 	ext4_group_t	i_last_alloc_group;
@@ -1438,6 +1441,10 @@ struct ext4_sb_info {
 	struct journal_s *s_journal;
 	struct list_head s_orphan;
 	struct mutex s_orphan_lock;
+	/* coalescing of cache flushes issued by concurrent fsyncs */
+	struct mutex s_flush_lock;
+	atomic64_t s_flush_started;
+	atomic64_t s_flush_completed;
 	unsigned long s_ext4_flags;		/* Ext4 superblock flags */
 	unsigned long s_commit_interval;
 	u32 s_max_batch_time;
@@ -1467,6 +1474,14 @@ struct ext4_sb_info {
 	spinlock_t s_md_lock;
 	unsigned short *s_mb_offsets;
 	unsigned int *s_mb_maxs;
+	/*
+	 * Block groups indexed by the order of their largest free buddy
+	 * chunk, so the allocator can jump straight to groups that can
+	 * satisfy a request instead of scanning linearly.  One list and
+	 * one lock per order.
+	 */
+	struct list_head *s_mb_largest_free_orders;
+	rwlock_t *s_mb_largest_free_orders_locks;
 	unsigned int s_group_info_size;
 	unsigned int s_mb_free_pending;
 	struct list_head s_freed_data_list;	/* List of blocks to be freed
@@ -3083,7 +3098,9 @@ struct ext4_group_info {
 	ext4_grpblk_t	bb_free;	/* total free blocks */
 	ext4_grpblk_t	bb_fragments;	/* nr of freespace fragments */
 	ext4_grpblk_t	bb_largest_free_order;/* order of largest frag in BG */
+	ext4_group_t	bb_group;	/* Group number */
 	struct          list_head bb_prealloc_list;
+	struct          list_head bb_largest_free_order_node;
 #ifdef DOUBLE_CHECK
 	void            *bb_bitmap;
 #endif
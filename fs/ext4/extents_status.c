@@ -855,6 +855,8 @@ retry:
 error:
 	write_unlock(&EXT4_I(inode)->i_es_lock);
 
+	WRITE_ONCE(EXT4_I(inode)->i_es_access, jiffies);
+
 	ext4_es_print_tree(inode);
 
 	return err;
@@ -948,6 +950,7 @@ out:
 		es->es_pblk = es1->es_pblk;
 		if (!ext4_es_is_referenced(es1))
 			ext4_es_set_referenced(es1);
+		WRITE_ONCE(EXT4_I(inode)->i_es_access, jiffies);
 		percpu_counter_inc(&stats->es_stats_cache_hits);
 		if (next_lblk) {
 			node = rb_next(&es1->rb_node);
@@ -1479,6 +1482,17 @@ retry:
 			continue;
 		}
 
+		/*
+		 * Likewise leave inodes whose extent cache was hit within
+		 * the last second alone on the first pass; evicting a hot
+		 * inode's extents only makes it re-read them right away.
+		 */
+		if (!retried && time_before(jiffies,
+				READ_ONCE(ei->i_es_access) + HZ)) {
+			nr_skipped++;
+			continue;
+		}
+
 		if (ei == locked_ei || !write_trylock(&ei->i_es_lock)) {
 			nr_skipped++;
 			continue;
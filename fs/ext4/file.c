@@ -198,16 +198,25 @@ static bool ext4_overwrite_io(struct inode *inode, loff_t pos, loff_t len)
 		return false;
 
 	map.m_lblk = pos >> blkbits;
-	map.m_len = EXT4_MAX_BLOCKS(len, pos, blkbits);
-	blklen = map.m_len;
+	blklen = EXT4_MAX_BLOCKS(len, pos, blkbits);
 
-	err = ext4_map_blocks(NULL, inode, &map, 0);
 	/*
-	 * 'err==len' means that all of the blocks have been preallocated,
-	 * regardless of whether they have been initialized or not. To exclude
-	 * unwritten extents, we need to check m_flags.
+	 * ext4_map_blocks() returns one extent at a time, and on an aged
+	 * file the range is often covered by several written extents.
+	 * Walk them all instead of declaring any fragmented overwrite
+	 * non-overwriting, which would needlessly force the exclusive
+	 * inode lock.  A mapping short of the request (a hole) or an
+	 * unwritten extent means this is not a pure overwrite.
 	 */
-	return err == blklen && (map.m_flags & EXT4_MAP_MAPPED);
+	while (blklen > 0) {
+		map.m_len = blklen;
+		err = ext4_map_blocks(NULL, inode, &map, 0);
+		if (err <= 0 || !(map.m_flags & EXT4_MAP_MAPPED))
+			return false;
+		map.m_lblk += err;
+		blklen -= err;
+	}
+	return true;
 }
 
 static ssize_t ext4_generic_write_checks(struct kiocb *iocb,
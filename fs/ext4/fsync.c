@@ -117,6 +117,33 @@ static int ext4_fsync_journal(struct inode *inode, bool datasync,
 	return jbd2_complete_transaction(journal, commit_tid);
 }
 
+/*
+ * Issue the cache flush an fsync needs, coalescing it with flushes
+ * issued by concurrent fsyncs.  @pre is the value of s_flush_started
+ * sampled after everything the caller must persist had been written
+ * out: if a flush whose index is above that sample has completed by
+ * the time we get the lock, it started after our writes finished and
+ * therefore covers them, so the device need not be flushed again.  An
+ * fsync storm thus issues one flush per "generation" instead of one
+ * flush per caller.
+ */
+static int ext4_sync_flush(struct super_block *sb, u64 pre)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	int err = 0;
+
+	mutex_lock(&sbi->s_flush_lock);
+	if (atomic64_read(&sbi->s_flush_completed) <= pre) {
+		atomic64_inc(&sbi->s_flush_started);
+		err = blkdev_issue_flush(sb->s_bdev, GFP_KERNEL, NULL);
+		/* a failed flush covers nobody */
+		if (!err)
+			atomic64_inc(&sbi->s_flush_completed);
+	}
+	mutex_unlock(&sbi->s_flush_lock);
+	return err;
+}
+
 /*
  * akpm: A new design for ext4_sync_file().
  *
@@ -176,7 +203,17 @@ int ext4_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
 		ret = ext4_fsync_journal(inode, datasync, &needs_barrier);
 
 	if (needs_barrier) {
-		err = blkdev_issue_flush(inode->i_sb->s_bdev, GFP_KERNEL, NULL);
+		u64 pre;
+
+		/*
+		 * Everything we depend on has been written by now, so any
+		 * flush that starts from here on covers us.  The barrier
+		 * keeps the sample from being reordered before the
+		 * preceding IO waits.
+		 */
+		smp_mb();
+		pre = atomic64_read(&sbi->s_flush_started);
+		err = ext4_sync_flush(inode->i_sb, pre);
 		if (!ret)
 			ret = err;
 	}
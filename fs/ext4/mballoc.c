@@ -693,18 +693,36 @@ static void ext4_mb_mark_free_simple(struct super_block *sb,
 static void
 mb_set_largest_free_order(struct super_block *sb, struct ext4_group_info *grp)
 {
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
 	int i;
 	int bits;
-
-	grp->bb_largest_free_order = -1; /* uninit */
+	int new_order = -1; /* uninit */
 
 	bits = sb->s_blocksize_bits + 1;
 	for (i = bits; i >= 0; i--) {
 		if (grp->bb_counters[i] > 0) {
-			grp->bb_largest_free_order = i;
+			new_order = i;
 			break;
 		}
 	}
+	if (new_order == grp->bb_largest_free_order)
+		return;
+
+	/* Move the group to the list matching its new largest order. */
+	if (grp->bb_largest_free_order >= 0) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[
+					      grp->bb_largest_free_order]);
+		list_del_init(&grp->bb_largest_free_order_node);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[
+					      grp->bb_largest_free_order]);
+	}
+	grp->bb_largest_free_order = new_order;
+	if (new_order >= 0) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[new_order]);
+		list_add_tail(&grp->bb_largest_free_order_node,
+			      &sbi->s_mb_largest_free_orders[new_order]);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[new_order]);
+	}
 }
 
 static noinline_for_stack
@@ -2097,6 +2115,111 @@ static int ext4_mb_good_group(struct ext4_allocation_context *ac,
 	return 0;
 }
 
+/*
+ * Scan one group for free space matching the request.  This is the old
+ * body of the group loop in ext4_mb_regular_allocator(), factored out
+ * so the largest-free-order index can drive it as well.  Returns a
+ * negative error or 0; progress is reported through ac->ac_status.
+ */
+static int ext4_mb_scan_group(struct ext4_allocation_context *ac,
+			      ext4_group_t group, int cr,
+			      struct ext4_buddy *e4b, int *first_err)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	int ret;
+	int err;
+
+	/* This now checks without needing the buddy page */
+	ret = ext4_mb_good_group(ac, group, cr);
+	if (ret <= 0) {
+		if (!*first_err)
+			*first_err = ret;
+		return 0;
+	}
+
+	err = ext4_mb_load_buddy(sb, group, e4b);
+	if (err)
+		return err;
+
+	ext4_lock_group(sb, group);
+
+	/*
+	 * We need to check again after locking the
+	 * block group
+	 */
+	ret = ext4_mb_good_group(ac, group, cr);
+	if (ret <= 0) {
+		ext4_unlock_group(sb, group);
+		ext4_mb_unload_buddy(e4b);
+		if (!*first_err)
+			*first_err = ret;
+		return 0;
+	}
+
+	ac->ac_groups_scanned++;
+	if (cr == 0)
+		ext4_mb_simple_scan_group(ac, e4b);
+	else if (cr == 1 && sbi->s_stripe &&
+			!(ac->ac_g_ex.fe_len % sbi->s_stripe))
+		ext4_mb_scan_aligned(ac, e4b);
+	else
+		ext4_mb_complex_scan_group(ac, e4b);
+
+	ext4_unlock_group(sb, group);
+	ext4_mb_unload_buddy(e4b);
+	return 0;
+}
+
+/* Number of groups sampled from each order list per pass. */
+#define MB_INDEX_SCAN_GROUPS	8
+
+/*
+ * Try groups advertised by the largest-free-order index before falling
+ * back to the linear group scan.  A group on list i holds a free buddy
+ * chunk of 2^i clusters, so any list of at least the order of the
+ * request is a promising candidate; ext4_mb_scan_group() revalidates
+ * each group under the group lock as usual.  The candidates are
+ * snapshotted under the list lock and scanned outside of it.
+ */
+static int ext4_mb_indexed_scan(struct ext4_allocation_context *ac, int cr,
+				struct ext4_buddy *e4b, int *first_err)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	ext4_group_t candidates[MB_INDEX_SCAN_GROUPS];
+	struct ext4_group_info *grp;
+	int order, nr, i, err;
+
+	order = ac->ac_2order ? ac->ac_2order : fls(ac->ac_g_ex.fe_len);
+	for (; order <= sb->s_blocksize_bits + 1 &&
+	       ac->ac_status == AC_STATUS_CONTINUE; order++) {
+		if (list_empty(&sbi->s_mb_largest_free_orders[order]))
+			continue;
+
+		nr = 0;
+		read_lock(&sbi->s_mb_largest_free_orders_locks[order]);
+		list_for_each_entry(grp,
+				    &sbi->s_mb_largest_free_orders[order],
+				    bb_largest_free_order_node) {
+			candidates[nr++] = grp->bb_group;
+			if (nr == MB_INDEX_SCAN_GROUPS)
+				break;
+		}
+		read_unlock(&sbi->s_mb_largest_free_orders_locks[order]);
+
+		for (i = 0; i < nr && ac->ac_status == AC_STATUS_CONTINUE;
+		     i++) {
+			cond_resched();
+			err = ext4_mb_scan_group(ac, candidates[i], cr, e4b,
+						 first_err);
+			if (err)
+				return err;
+		}
+	}
+	return 0;
+}
+
 static noinline_for_stack int
 ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 {
@@ -2165,6 +2288,22 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 repeat:
 	for (; cr < 4 && ac->ac_status == AC_STATUS_CONTINUE; cr++) {
 		ac->ac_criteria = cr;
+
+		/*
+		 * For the cheap passes, let the largest-free-order index
+		 * point us at promising groups before resorting to a
+		 * linear walk of all groups.  Non-extent files are
+		 * restricted to the low groups, where the index does not
+		 * honour the restriction, so they always scan linearly.
+		 */
+		if (cr < 2 && ngroups == ext4_get_groups_count(sb)) {
+			err = ext4_mb_indexed_scan(ac, cr, &e4b, &first_err);
+			if (err)
+				goto out;
+			if (ac->ac_status != AC_STATUS_CONTINUE)
+				break;
+		}
+
 		/*
 		 * searching for the right group start
 		 * from the goal value specified
@@ -2172,7 +2311,6 @@ repeat:
 		group = ac->ac_g_ex.fe_group;
 
 		for (i = 0; i < ngroups; group++, i++) {
-			int ret = 0;
 			cond_resched();
 			/*
 			 * Artificially restricted ngroups for non-extent
@@ -2181,45 +2319,11 @@ repeat:
 			if (group >= ngroups)
 				group = 0;
 
-			/* This now checks without needing the buddy page */
-			ret = ext4_mb_good_group(ac, group, cr);
-			if (ret <= 0) {
-				if (!first_err)
-					first_err = ret;
-				continue;
-			}
-
-			err = ext4_mb_load_buddy(sb, group, &e4b);
+			err = ext4_mb_scan_group(ac, group, cr, &e4b,
+						 &first_err);
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
-
-			/*
-			 * We need to check again after locking the
-			 * block group
-			 */
-			ret = ext4_mb_good_group(ac, group, cr);
-			if (ret <= 0) {
-				ext4_unlock_group(sb, group);
-				ext4_mb_unload_buddy(&e4b);
-				if (!first_err)
-					first_err = ret;
-				continue;
-			}
-
-			ac->ac_groups_scanned++;
-			if (cr == 0)
-				ext4_mb_simple_scan_group(ac, &e4b);
-			else if (cr == 1 && sbi->s_stripe &&
-					!(ac->ac_g_ex.fe_len % sbi->s_stripe))
-				ext4_mb_scan_aligned(ac, &e4b);
-			else
-				ext4_mb_complex_scan_group(ac, &e4b);
-
-			ext4_unlock_group(sb, group);
-			ext4_mb_unload_buddy(&e4b);
-
 			if (ac->ac_status != AC_STATUS_CONTINUE)
 				break;
 		}
@@ -2441,9 +2545,11 @@ int ext4_mb_add_groupinfo(struct super_block *sb, ext4_group_t group,
 	}
 
 	INIT_LIST_HEAD(&meta_group_info[i]->bb_prealloc_list);
+	INIT_LIST_HEAD(&meta_group_info[i]->bb_largest_free_order_node);
 	init_rwsem(&meta_group_info[i]->alloc_sem);
 	meta_group_info[i]->bb_free_root = RB_ROOT;
 	meta_group_info[i]->bb_largest_free_order = -1;  /* uninit */
+	meta_group_info[i]->bb_group = group;
 
 #ifdef DOUBLE_CHECK
 	{
@@ -2604,6 +2710,27 @@ int ext4_mb_init(struct super_block *sb)
 		goto out;
 	}
 
+	sbi->s_mb_largest_free_orders =
+		kmalloc_array(sb->s_blocksize_bits + 2,
+			      sizeof(*sbi->s_mb_largest_free_orders),
+			      GFP_KERNEL);
+	if (sbi->s_mb_largest_free_orders == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	sbi->s_mb_largest_free_orders_locks =
+		kmalloc_array(sb->s_blocksize_bits + 2,
+			      sizeof(*sbi->s_mb_largest_free_orders_locks),
+			      GFP_KERNEL);
+	if (sbi->s_mb_largest_free_orders_locks == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < sb->s_blocksize_bits + 2; i++) {
+		INIT_LIST_HEAD(&sbi->s_mb_largest_free_orders[i]);
+		rwlock_init(&sbi->s_mb_largest_free_orders_locks[i]);
+	}
+
 	ret = ext4_groupinfo_create_slab(sb->s_blocksize);
 	if (ret < 0)
 		goto out;
@@ -2687,6 +2814,10 @@ out_free_locality_groups:
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
 out:
+	kfree(sbi->s_mb_largest_free_orders);
+	sbi->s_mb_largest_free_orders = NULL;
+	kfree(sbi->s_mb_largest_free_orders_locks);
+	sbi->s_mb_largest_free_orders_locks = NULL;
 	kfree(sbi->s_mb_offsets);
 	sbi->s_mb_offsets = NULL;
 	kfree(sbi->s_mb_maxs);
@@ -2743,6 +2874,8 @@ int ext4_mb_release(struct super_block *sb)
 		kvfree(group_info);
 		rcu_read_unlock();
 	}
+	kfree(sbi->s_mb_largest_free_orders);
+	kfree(sbi->s_mb_largest_free_orders_locks);
 	kfree(sbi->s_mb_offsets);
 	kfree(sbi->s_mb_maxs);
 	iput(sbi->s_buddy_cache);
@@ -1451,6 +1451,8 @@ struct f2fs_sb_info {
 	unsigned int max_victim_search;
 	/* migration granularity of garbage collection, unit: segment */
 	unsigned int migration_granularity;
+	/* minimum victim age for background GC, unit: second, 0: disabled */
+	unsigned int gc_age_threshold;
 
 	/*
 	 * for stat information.
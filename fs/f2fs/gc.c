@@ -284,6 +284,25 @@ static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 		return get_cb_cost(sbi, segno);
 }
 
+/*
+ * A section is "aged" once its newest data is at least gc_age_threshold
+ * seconds old. Background GC prefers aged victims: data that was written
+ * recently tends to be invalidated again soon, and migrating it just
+ * multiplies the write amplification for nothing.
+ */
+static bool section_is_aged(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	unsigned int start = GET_SEG_FROM_SEC(sbi, GET_SEC_FROM_SEG(sbi, segno));
+	unsigned long long mtime = 0;
+	unsigned int i;
+
+	for (i = 0; i < sbi->segs_per_sec; i++)
+		mtime = max(mtime, (unsigned long long)
+				get_seg_entry(sbi, start + i)->mtime);
+
+	return mtime + sbi->gc_age_threshold <= get_mtime(sbi, false);
+}
+
 static unsigned int count_bits(const unsigned long *addr,
 				unsigned int offset, unsigned int len)
 {
@@ -313,6 +332,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 	unsigned int secno, last_victim;
 	unsigned int last_segment;
 	unsigned int nsearched = 0;
+	bool aged_only;
 
 	mutex_lock(&dirty_i->seglist_lock);
 	last_segment = MAIN_SECS(sbi) * sbi->segs_per_sec;
@@ -356,6 +376,9 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	aged_only = gc_type == BG_GC && p.alloc_mode == LFS &&
+					sbi->gc_age_threshold;
+retry:
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -403,6 +426,8 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto next;
 		if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
 			goto next;
+		if (aged_only && !section_is_aged(sbi, segno))
+			goto next;
 
 		cost = get_gc_cost(sbi, segno, &p);
 
@@ -421,6 +446,19 @@ next:
 			break;
 		}
 	}
+
+	/*
+	 * Everything dirty within search range is too young; rescan without
+	 * the age filter rather than leaving background GC idle.
+	 */
+	if (p.min_segno == NULL_SEGNO && aged_only) {
+		aged_only = false;
+		last_segment = MAIN_SECS(sbi) * sbi->segs_per_sec;
+		p.offset = 0;
+		nsearched = 0;
+		goto retry;
+	}
+
 	if (p.min_segno != NULL_SEGNO) {
 got_it:
 		*result = (p.min_segno / p.ofs_unit) * p.ofs_unit;
@@ -150,9 +150,22 @@ static int expand_fdtable(struct files_struct *files, unsigned int nr)
 	__acquires(files->file_lock)
 {
 	struct fdtable *new_fdt, *cur_fdt;
+	unsigned int want = nr;
+
+	/*
+	 * Every resize of a shared table costs a full copy of the fd array
+	 * and bitmaps plus a synchronize_rcu() stall for all threads
+	 * installing fds.  Once the table is large those resizes dominate
+	 * fd-hungry workloads, so quadruple rather than double from 64k
+	 * entries on: the climb to an nr_open-sized table takes half as
+	 * many copies.  alloc_fdtable() still clamps to sysctl_nr_open.
+	 */
+	cur_fdt = files_fdtable(files);
+	if (cur_fdt->max_fds >= 64 * 1024)
+		want = max(nr, 2 * cur_fdt->max_fds);
 
 	spin_unlock(&files->file_lock);
-	new_fdt = alloc_fdtable(nr);
+	new_fdt = alloc_fdtable(want);
 
 	/* make sure all __fd_install() have seen resize_in_progress
 	 * or have finished their rcu_read_lock_sched() section.
@@ -491,7 +504,12 @@ repeat:
 	if (fd < files->next_fd)
 		fd = files->next_fd;
 
-	if (fd < fdt->max_fds)
+	/*
+	 * The hint is the lowest fd that might be free; if its slot is
+	 * actually free (the common case outside dup2() games) there is
+	 * nothing lower to find and both bitmap scans can be skipped.
+	 */
+	if (fd < fdt->max_fds && test_bit(fd, fdt->open_fds))
 		fd = find_next_fd(fdt, fd);
 
 	/*
@@ -42,6 +42,22 @@ static struct kmem_cache *filp_cachep __read_mostly;
 
 static struct percpu_counter nr_files __cacheline_aligned_in_smp;
 
+/*
+ * Per-cpu slack for the nr_files counter: scale the fold-over batch with
+ * file-max so that open/close churn rarely touches the shared sum.  The
+ * divisor includes the cpu count, so the aggregate error stays below
+ * max_files/16, which the expensive percpu_counter_sum_positive()
+ * fallback in alloc_empty_file() tolerates.
+ */
+static unsigned int files_slack_divisor __read_mostly = 16;
+
+static inline s32 nr_files_batch(void)
+{
+	unsigned long batch = files_stat.max_files / files_slack_divisor;
+
+	return max(batch, 32UL);
+}
+
 static void file_free_rcu(struct rcu_head *head)
 {
 	struct file *f = container_of(head, struct file, f_u.fu_rcuhead);
@@ -54,7 +70,7 @@ static inline void file_free(struct file *f)
 {
 	security_file_free(f);
 	if (!(f->f_mode & FMODE_NOACCOUNT))
-		percpu_counter_dec(&nr_files);
+		percpu_counter_add_batch(&nr_files, -1, nr_files_batch());
 	call_rcu(&f->f_u.fu_rcuhead, file_free_rcu);
 }
 
@@ -150,7 +166,7 @@ struct file *alloc_empty_file(int flags, const struct cred *cred)
 
 	f = __alloc_file(flags, cred);
 	if (!IS_ERR(f))
-		percpu_counter_inc(&nr_files);
+		percpu_counter_add_batch(&nr_files, 1, nr_files_batch());
 
 	return f;
 
@@ -308,9 +324,15 @@ static void delayed_fput(struct work_struct *unused)
 		__fput(f);
 }
 
-static void ____fput(struct callback_head *work)
+static void task_fput_work(struct callback_head *work)
 {
-	__fput(container_of(work, struct file, f_u.fu_rcuhead));
+	struct task_struct *task = container_of(work, struct task_struct,
+						fput_work);
+	struct llist_node *node = llist_del_all(&task->fput_list);
+	struct file *f, *t;
+
+	llist_for_each_entry_safe(f, t, node, f_u.fu_llist)
+		__fput(f);
 }
 
 /*
@@ -331,20 +353,41 @@ EXPORT_SYMBOL_GPL(flush_delayed_fput);
 
 static DECLARE_DELAYED_WORK(delayed_fput_work, delayed_fput);
 
+static void fput_queue_delayed(struct llist_node *node)
+{
+	struct file *f, *t;
+	bool queued = false;
+
+	llist_for_each_entry_safe(f, t, node, f_u.fu_llist)
+		if (llist_add(&f->f_u.fu_llist, &delayed_fput_list))
+			queued = true;
+	if (queued)
+		schedule_delayed_work(&delayed_fput_work, 1);
+}
+
 void fput_many(struct file *file, unsigned int refs)
 {
 	if (atomic_long_sub_and_test(refs, &file->f_count)) {
 		struct task_struct *task = current;
 
 		if (likely(!in_interrupt() && !(task->flags & PF_KTHREAD))) {
-			init_task_work(&file->f_u.fu_rcuhead, ____fput);
-			if (!task_work_add(task, &file->f_u.fu_rcuhead, true))
+			/*
+			 * One pending task_work drains the whole per-task
+			 * list, so only the fput that makes the list
+			 * non-empty needs to queue it.
+			 */
+			if (!llist_add(&file->f_u.fu_llist, &task->fput_list))
+				return;
+			init_task_work(&task->fput_work, task_fput_work);
+			if (!task_work_add(task, &task->fput_work, true))
 				return;
 			/*
 			 * After this task has run exit_task_work(),
-			 * task_work_add() will fail.  Fall through to delayed
-			 * fput to avoid leaking *file.
+			 * task_work_add() will fail.  Move what we staged
+			 * over to the delayed list to avoid leaking *file.
 			 */
+			fput_queue_delayed(llist_del_all(&task->fput_list));
+			return;
 		}
 
 		if (llist_add(&file->f_u.fu_llist, &delayed_fput_list))
@@ -381,6 +424,7 @@ void __init files_init(void)
 	filp_cachep = kmem_cache_create("filp", sizeof(struct file), 0,
 			SLAB_HWCACHE_ALIGN | SLAB_PANIC | SLAB_ACCOUNT, NULL);
 	percpu_counter_init(&nr_files, 0, GFP_KERNEL);
+	files_slack_divisor = 16 * num_possible_cpus();
 }
 
 /*
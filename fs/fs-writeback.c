@@ -68,6 +68,14 @@ struct wb_writeback_work {
  */
 unsigned int dirtytime_expire_interval = 12 * 60 * 60;
 
+/*
+ * Number of concurrent flush streams per bdi_writeback, settable via
+ * vm.writeback_flushers. The default of 1 keeps the traditional single
+ * flusher; raising it lets fast devices with huge dirty inode counts be
+ * flushed from several workers at once.
+ */
+int writeback_nr_flushers __read_mostly = 1;
+
 static inline struct inode *wb_inode(struct list_head *head)
 {
 	return list_entry(head, struct inode, i_io_list);
@@ -2053,6 +2061,43 @@ static long wb_do_writeback(struct bdi_writeback *wb)
 	return wrote;
 }
 
+/*
+ * Auxiliary background flush stream. The streams run the same background
+ * pass as wb_check_background_flush() and pull inodes off the shared
+ * ->b_io list under ->list_lock, with I_SYNC keeping two streams off the
+ * same inode, so they simply fan the dirty pages out to the device in
+ * parallel. Every stream stops at the same background threshold, which
+ * keeps the dirty-throttling budget shared rather than multiplied.
+ */
+void wb_aux_workfn(struct work_struct *work)
+{
+	struct wb_aux_flusher *aux = container_of(work,
+						struct wb_aux_flusher, work);
+	struct bdi_writeback *wb = aux->wb;
+	long pages_written;
+
+	set_worker_desc("flush-%s", bdi_dev_name(wb->bdi));
+	current->flags |= PF_SWAPWRITE;
+	pages_written = wb_check_background_flush(wb);
+	trace_writeback_pages_written(pages_written);
+	current->flags &= ~PF_SWAPWRITE;
+}
+
+static void wb_kick_aux_flushers(struct bdi_writeback *wb)
+{
+	int extra, i;
+
+	extra = min(READ_ONCE(writeback_nr_flushers) - 1,
+		    WB_MAX_AUX_FLUSHERS);
+	if (extra <= 0)
+		return;
+	if (!test_bit(WB_registered, &wb->state) || !wb_over_bg_thresh(wb))
+		return;
+
+	for (i = 0; i < extra; i++)
+		queue_work(bdi_wq, &wb->aux_flushers[i].work);
+}
+
 /*
  * Handle writeback of dirty data for the device backed by this bdi. Also
  * reschedules periodically and does kupdated style flushing.
@@ -2074,6 +2119,7 @@ void wb_workfn(struct work_struct *work)
 		 * if @wb is shutting down even when we're running off the
 		 * rescuer as work_list needs to be drained.
 		 */
+		wb_kick_aux_flushers(wb);
 		do {
 			pages_written = wb_do_writeback(wb);
 			trace_writeback_pages_written(pages_written);
@@ -202,13 +202,17 @@ static unsigned int fuse_req_hash(u64 unique)
 
 /**
  * A new request is available, wake fiq->waitq
+ *
+ * Drop fiq->lock before waking: the woken reader immediately takes
+ * that lock to dequeue, so waking while still holding it just makes
+ * the reader block behind the producer.
  */
 static void fuse_dev_wake_and_unlock(struct fuse_iqueue *fiq)
 __releases(fiq->lock)
 {
+	spin_unlock(&fiq->lock);
 	wake_up(&fiq->waitq);
 	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
-	spin_unlock(&fiq->lock);
 }
 
 const struct fuse_iqueue_ops fuse_dev_fiq_ops = {
@@ -1908,6 +1912,14 @@ static ssize_t fuse_dev_do_write(struct fuse_dev *fud,
 		list_del_init(&req->list);
 	spin_unlock(&fpq->lock);
 
+	/*
+	 * Resolve a passthrough backing fd while still in the daemon's
+	 * context; the requester picks the file up from req->args.
+	 */
+	if (!err && !req->out.h.error &&
+	    (req->args->opcode == FUSE_OPEN || req->args->opcode == FUSE_CREATE))
+		fuse_passthrough_setup(fc, req->args);
+
 	fuse_request_end(fc, req);
 out:
 	return err ? err : nbytes;
@@ -481,6 +481,12 @@ static int fuse_create_open(struct inode *dir, struct dentry *entry,
 	if (err)
 		goto out_free_ff;
 
+	/*
+	 * Take ownership of the backing file before validating the reply,
+	 * so the error paths below release it via fuse_file_free().
+	 */
+	ff->passthrough_filp = args.passthrough_filp;
+
 	err = -EIO;
 	if (!S_ISREG(outentry.attr.mode) || invalid_nodeid(outentry.nodeid) ||
 	    fuse_invalid_attr(&outentry.attr))
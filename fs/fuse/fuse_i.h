@@ -186,6 +186,9 @@ struct fuse_file {
 	/** FOPEN_* flags returned by open */
 	u32 open_flags;
 
+	/** Backing file to serve reads/writes from, or NULL */
+	struct file *passthrough_filp;
+
 	/** Entry on inode's write_files list */
 	struct list_head write_entry;
 
@@ -251,6 +254,8 @@ struct fuse_args {
 	bool page_replace:1;
 	struct fuse_in_arg in_args[3];
 	struct fuse_arg out_args[2];
+	/* Backing file resolved from a FOPEN_PASSTHROUGH open reply */
+	struct file *passthrough_filp;
 	void (*end)(struct fuse_conn *fc, struct fuse_args *args, int error);
 };
 
@@ -680,6 +685,9 @@ struct fuse_conn {
 	/** Filesystem is fully reponsible for page cache invalidation. */
 	unsigned explicit_inval_data:1;
 
+	/** Daemon may register backing files for read/write passthrough */
+	unsigned passthrough:1;
+
 	/** Does the filesystem support readdirplus? */
 	unsigned do_readdirplus:1;
 
@@ -1081,6 +1089,12 @@ int fuse_set_acl(struct inode *inode, struct posix_acl *acl, int type);
 /* readdir.c */
 int fuse_readdir(struct file *file, struct dir_context *ctx);
 
+/* passthrough.c */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_args *args);
+void fuse_passthrough_release(struct fuse_file *ff);
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to);
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from);
+
 /**
  * Return the number of bytes in an arguments list
  */
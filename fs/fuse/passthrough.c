@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * FUSE passthrough: service reads and writes on an open file directly
+ * from a backing file registered by the daemon, skipping the userspace
+ * round trip per IO.
+ */
+
+#include "fuse_i.h"
+
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/magic.h>
+#include <linux/uio.h>
+
+/*
+ * Resolve the backing fd from a FOPEN_PASSTHROUGH open reply.  Called
+ * from the daemon's write(2) to /dev/fuse, so the fd is looked up in
+ * the daemon's file table.  Failure to resolve is not fatal: the open
+ * simply proceeds without passthrough.
+ */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_args *args)
+{
+	struct fuse_open_out *openout =
+		args->out_args[args->out_numargs - 1].value;
+	struct file *filp;
+
+	if (!(openout->open_flags & FOPEN_PASSTHROUGH))
+		return;
+
+	if (!fc->passthrough || openout->passthrough_fd < 0)
+		return;
+
+	filp = fget(openout->passthrough_fd);
+	if (!filp)
+		return;
+
+	/*
+	 * Only regular files that can do iter IO, and never another
+	 * fuse file: stacking passthrough on fuse could loop back into
+	 * the same (or a deadlocked) connection.
+	 */
+	if (!S_ISREG(file_inode(filp)->i_mode) ||
+	    file_inode(filp)->i_sb->s_magic == FUSE_SUPER_MAGIC ||
+	    !filp->f_op->read_iter || !filp->f_op->write_iter) {
+		fput(filp);
+		return;
+	}
+
+	args->passthrough_filp = filp;
+}
+
+void fuse_passthrough_release(struct fuse_file *ff)
+{
+	if (ff->passthrough_filp) {
+		fput(ff->passthrough_filp);
+		ff->passthrough_filp = NULL;
+	}
+}
+
+static rwf_t fuse_iocb_to_rwf(struct kiocb *iocb)
+{
+	int ifl = iocb->ki_flags;
+	rwf_t flags = 0;
+
+	if (ifl & IOCB_NOWAIT)
+		flags |= RWF_NOWAIT;
+	if (ifl & IOCB_HIPRI)
+		flags |= RWF_HIPRI;
+	if (ifl & IOCB_DSYNC)
+		flags |= RWF_DSYNC;
+	if (ifl & IOCB_SYNC)
+		flags |= RWF_SYNC;
+
+	return flags;
+}
+
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct fuse_file *ff = iocb->ki_filp->private_data;
+
+	if (!iov_iter_count(to))
+		return 0;
+
+	return vfs_iter_read(ff->passthrough_filp, to, &iocb->ki_pos,
+			     fuse_iocb_to_rwf(iocb));
+}
+
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	struct inode *inode = file_inode(file);
+	struct file *passthrough = ff->passthrough_filp;
+	ssize_t ret;
+
+	if (!iov_iter_count(from))
+		return 0;
+
+	inode_lock(inode);
+	file_start_write(passthrough);
+	ret = vfs_iter_write(passthrough, from, &iocb->ki_pos,
+			     fuse_iocb_to_rwf(iocb));
+	file_end_write(passthrough);
+	if (ret > 0)
+		fuse_write_update_size(inode, iocb->ki_pos);
+	fuse_invalidate_attr(inode);
+	inode_unlock(inode);
+
+	return ret;
+}
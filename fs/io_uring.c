@@ -71,6 +71,7 @@
 #include <linux/sizes.h>
 #include <linux/hugetlb.h>
 #include <linux/highmem.h>
+#include <linux/vmalloc.h>
 #include <linux/namei.h>
 #include <linux/fsnotify.h>
 #include <linux/fadvise.h>
@@ -183,6 +184,22 @@ struct fixed_file_table {
 	struct file		**files;
 };
 
+/*
+ * Buffer group registered with IORING_REGISTER_PBUF_RING. The ring
+ * itself lives in userspace memory; we pin and vmap it so the kernel can
+ * consume entries directly. The kernel owns ->head, the application
+ * publishes new buffers by advancing the tail in the shared ring.
+ */
+struct io_buffer_list {
+	struct io_uring_buf_ring	*buf_ring;
+	struct page			**buf_pages;
+	int				buf_nr_pages;
+	__u16				bgid;
+	__u16				nr_entries;
+	__u16				mask;
+	__u16				head;
+};
+
 struct fixed_file_data {
 	struct fixed_file_table		*table;
 	struct io_ring_ctx		*ctx;
@@ -193,6 +210,26 @@ struct fixed_file_data {
 	struct completion		done;
 };
 
+/*
+ * SQPOLL thread state, shareable between rings. A ring created with
+ * IORING_SETUP_SQPOLL|IORING_SETUP_ATTACH_WQ attaches to the sq_data of
+ * the ring given in params->wq_fd instead of spawning its own thread,
+ * and the single thread then round-robins over all attached rings.
+ * ->ctx_list is only modified with the thread parked, so io_sq_thread()
+ * can walk it without locking; ->lock serializes attach/detach.
+ */
+struct io_sq_data {
+	refcount_t		refs;
+	struct mutex		lock;
+	struct list_head	ctx_list;
+
+	struct task_struct	*thread;
+	struct wait_queue_head	wait;
+	struct completion	startup;
+
+	unsigned		sq_thread_idle;
+};
+
 struct io_ring_ctx {
 	struct {
 		struct percpu_ref	refs;
@@ -238,9 +275,9 @@ struct io_ring_ctx {
 
 	/* IO offload */
 	struct io_wq		*io_wq;
-	struct task_struct	*sqo_thread;	/* if using sq thread polling */
+	struct io_sq_data	*sq_data;	/* if using sq thread polling */
+	struct list_head	sqd_list;	/* entry in sq_data->ctx_list */
 	struct mm_struct	*sqo_mm;
-	wait_queue_head_t	sqo_wait;
 
 	/*
 	 * If used, fixed file set. Writers must ensure that ->refs is dead,
@@ -260,7 +297,7 @@ struct io_ring_ctx {
 
 	const struct cred	*creds;
 
-	/* 0 is for ctx quiesce/reinit/free, 1 is for sqo_thread started */
+	/* 0 is for ctx quiesce/reinit/free */
 	struct completion	*completions;
 
 	/* if all else fails... */
@@ -272,6 +309,9 @@ struct io_ring_ctx {
 
 	struct idr		personality_idr;
 
+	/* provided buffer rings, keyed by buffer group ID */
+	struct idr		io_bl_idr;
+
 	struct {
 		unsigned		cached_cq_tail;
 		unsigned		cq_entries;
@@ -387,6 +427,8 @@ struct io_sr_msg {
 	};
 	int				msg_flags;
 	size_t				len;
+	__u16				bgid;
+	__u16				bid;
 };
 
 struct io_open {
@@ -464,6 +506,7 @@ enum {
 	REQ_F_LINK_BIT		= IOSQE_IO_LINK_BIT,
 	REQ_F_HARDLINK_BIT	= IOSQE_IO_HARDLINK_BIT,
 	REQ_F_FORCE_ASYNC_BIT	= IOSQE_ASYNC_BIT,
+	REQ_F_BUFFER_SELECT_BIT	= IOSQE_BUFFER_SELECT_BIT,
 
 	REQ_F_LINK_NEXT_BIT,
 	REQ_F_FAIL_LINK_BIT,
@@ -480,6 +523,7 @@ enum {
 	REQ_F_NEED_CLEANUP_BIT,
 	REQ_F_OVERFLOW_BIT,
 	REQ_F_NO_FILE_TABLE_BIT,
+	REQ_F_BUFFER_SELECTED_BIT,
 };
 
 enum {
@@ -493,6 +537,8 @@ enum {
 	REQ_F_HARDLINK		= BIT(REQ_F_HARDLINK_BIT),
 	/* IOSQE_ASYNC */
 	REQ_F_FORCE_ASYNC	= BIT(REQ_F_FORCE_ASYNC_BIT),
+	/* IOSQE_BUFFER_SELECT */
+	REQ_F_BUFFER_SELECT	= BIT(REQ_F_BUFFER_SELECT_BIT),
 
 	/* already grabbed next link */
 	REQ_F_LINK_NEXT		= BIT(REQ_F_LINK_NEXT_BIT),
@@ -524,6 +570,8 @@ enum {
 	REQ_F_OVERFLOW		= BIT(REQ_F_OVERFLOW_BIT),
 	/* doesn't need file table for this request */
 	REQ_F_NO_FILE_TABLE	= BIT(REQ_F_NO_FILE_TABLE_BIT),
+	/* buffer already selected from a provide ring */
+	REQ_F_BUFFER_SELECTED	= BIT(REQ_F_BUFFER_SELECTED_BIT),
 };
 
 /*
@@ -571,6 +619,7 @@ struct io_kiocb {
 	unsigned long		fsize;
 	u64			user_data;
 	u32			result;
+	u32			cflags;
 	u32			sequence;
 
 	struct list_head	inflight_entry;
@@ -619,6 +668,8 @@ struct io_op_def {
 	unsigned		file_table : 1;
 	/* needs ->fs */
 	unsigned		needs_fs : 1;
+	/* supports IOSQE_BUFFER_SELECT */
+	unsigned		buffer_select : 1;
 };
 
 static const struct io_op_def io_op_defs[] = {
@@ -737,6 +788,7 @@ static const struct io_op_def io_op_defs[] = {
 		.needs_mm		= 1,
 		.needs_file		= 1,
 		.unbound_nonreg_file	= 1,
+		.buffer_select		= 1,
 	},
 	[IORING_OP_OPENAT2] = {
 		.file_table		= 1,
@@ -798,7 +850,7 @@ static struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	if (!ctx->fallback_req)
 		goto err;
 
-	ctx->completions = kmalloc(2 * sizeof(struct completion), GFP_KERNEL);
+	ctx->completions = kmalloc(sizeof(struct completion), GFP_KERNEL);
 	if (!ctx->completions)
 		goto err;
 
@@ -822,12 +874,12 @@ static struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 		goto err;
 
 	ctx->flags = p->flags;
-	init_waitqueue_head(&ctx->sqo_wait);
+	INIT_LIST_HEAD(&ctx->sqd_list);
 	init_waitqueue_head(&ctx->cq_wait);
 	INIT_LIST_HEAD(&ctx->cq_overflow_list);
 	init_completion(&ctx->completions[0]);
-	init_completion(&ctx->completions[1]);
 	idr_init(&ctx->personality_idr);
+	idr_init(&ctx->io_bl_idr);
 	mutex_init(&ctx->uring_lock);
 	init_waitqueue_head(&ctx->wait);
 	spin_lock_init(&ctx->completion_lock);
@@ -1061,8 +1113,8 @@ static void __io_cqring_ev_posted(struct io_ring_ctx *ctx, bool trigger_ev)
 {
 	if (waitqueue_active(&ctx->wait))
 		wake_up(&ctx->wait);
-	if (waitqueue_active(&ctx->sqo_wait))
-		wake_up(&ctx->sqo_wait);
+	if (ctx->sq_data && waitqueue_active(&ctx->sq_data->wait))
+		wake_up(&ctx->sq_data->wait);
 	if (trigger_ev)
 		eventfd_signal(ctx->cq_ev_fd, 1);
 }
@@ -1108,7 +1160,7 @@ static bool io_cqring_overflow_flush(struct io_ring_ctx *ctx, bool force)
 		if (cqe) {
 			WRITE_ONCE(cqe->user_data, req->user_data);
 			WRITE_ONCE(cqe->res, req->result);
-			WRITE_ONCE(cqe->flags, 0);
+			WRITE_ONCE(cqe->flags, req->cflags);
 		} else {
 			WRITE_ONCE(ctx->rings->cq_overflow,
 				atomic_inc_return(&ctx->cached_cq_overflow));
@@ -1132,7 +1184,8 @@ static bool io_cqring_overflow_flush(struct io_ring_ctx *ctx, bool force)
 	return cqe != NULL;
 }
 
-static void io_cqring_fill_event(struct io_kiocb *req, long res)
+static void __io_cqring_fill_event(struct io_kiocb *req, long res,
+				   unsigned int cflags)
 {
 	struct io_ring_ctx *ctx = req->ctx;
 	struct io_uring_cqe *cqe;
@@ -1148,7 +1201,7 @@ static void io_cqring_fill_event(struct io_kiocb *req, long res)
 	if (likely(cqe)) {
 		WRITE_ONCE(cqe->user_data, req->user_data);
 		WRITE_ONCE(cqe->res, res);
-		WRITE_ONCE(cqe->flags, 0);
+		WRITE_ONCE(cqe->flags, cflags);
 	} else if (ctx->cq_overflow_flushed) {
 		WRITE_ONCE(ctx->rings->cq_overflow,
 				atomic_inc_return(&ctx->cached_cq_overflow));
@@ -1160,23 +1213,35 @@ static void io_cqring_fill_event(struct io_kiocb *req, long res)
 		req->flags |= REQ_F_OVERFLOW;
 		refcount_inc(&req->refs);
 		req->result = res;
+		req->cflags = cflags;
 		list_add_tail(&req->list, &ctx->cq_overflow_list);
 	}
 }
 
-static void io_cqring_add_event(struct io_kiocb *req, long res)
+static void io_cqring_fill_event(struct io_kiocb *req, long res)
+{
+	__io_cqring_fill_event(req, res, 0);
+}
+
+static void __io_cqring_add_event(struct io_kiocb *req, long res,
+				  unsigned int cflags)
 {
 	struct io_ring_ctx *ctx = req->ctx;
 	unsigned long flags;
 
 	spin_lock_irqsave(&ctx->completion_lock, flags);
-	io_cqring_fill_event(req, res);
+	__io_cqring_fill_event(req, res, cflags);
 	io_commit_cqring(ctx);
 	spin_unlock_irqrestore(&ctx->completion_lock, flags);
 
 	io_cqring_ev_posted(ctx);
 }
 
+static void io_cqring_add_event(struct io_kiocb *req, long res)
+{
+	__io_cqring_add_event(req, res, 0);
+}
+
 static inline bool io_is_fallback_req(struct io_kiocb *req)
 {
 	return req == (struct io_kiocb *)
@@ -1820,8 +1885,8 @@ static void io_iopoll_req_issued(struct io_kiocb *req)
 		list_add_tail(&req->list, &ctx->poll_list);
 
 	if ((ctx->flags & IORING_SETUP_SQPOLL) &&
-	    wq_has_sleeper(&ctx->sqo_wait))
-		wake_up(&ctx->sqo_wait);
+	    wq_has_sleeper(&ctx->sq_data->wait))
+		wake_up(&ctx->sq_data->wait);
 }
 
 static void io_file_put(struct io_submit_state *state)
@@ -3179,6 +3244,7 @@ static int io_recvmsg_prep(struct io_kiocb *req,
 	sr->msg_flags = READ_ONCE(sqe->msg_flags);
 	sr->msg = u64_to_user_ptr(READ_ONCE(sqe->addr));
 	sr->len = READ_ONCE(sqe->len);
+	sr->bgid = READ_ONCE(sqe->buf_group);
 
 #ifdef CONFIG_COMPAT
 	if (req->ctx->compat)
@@ -3276,10 +3342,75 @@ static int io_recvmsg(struct io_kiocb *req, struct io_kiocb **nxt,
 #endif
 }
 
+#if defined(CONFIG_NET)
+static void io_ring_submit_lock(struct io_ring_ctx *ctx, bool needs_lock)
+{
+	if (needs_lock)
+		mutex_lock(&ctx->uring_lock);
+}
+
+static void io_ring_submit_unlock(struct io_ring_ctx *ctx, bool needs_lock)
+{
+	if (needs_lock)
+		mutex_unlock(&ctx->uring_lock);
+}
+
+/*
+ * Consume one buffer from the provide ring of the request's buffer
+ * group. The submission path already holds ->uring_lock; the io-wq punt
+ * path must take it, which is what @needs_lock conveys. The consumed
+ * buffer sticks to the request across retries (REQ_F_BUFFER_SELECTED),
+ * so an -EAGAIN round trip does not eat a second one.
+ */
+static int io_recv_buffer_select(struct io_kiocb *req, bool needs_lock)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_sr_msg *sr = &req->sr_msg;
+	struct io_buffer_list *bl;
+	int ret = -ENOBUFS;
+
+	if (req->flags & REQ_F_BUFFER_SELECTED)
+		return 0;
+
+	io_ring_submit_lock(ctx, needs_lock);
+
+	bl = idr_find(&ctx->io_bl_idr, sr->bgid);
+	if (bl) {
+		/* pairs with the application publishing the new tail */
+		__u16 tail = smp_load_acquire(&bl->buf_ring->tail);
+
+		if (tail != bl->head) {
+			struct io_uring_buf *buf;
+
+			buf = &bl->buf_ring->bufs[bl->head & bl->mask];
+			sr->buf = u64_to_user_ptr(READ_ONCE(buf->addr));
+			sr->len = READ_ONCE(buf->len);
+			sr->bid = READ_ONCE(buf->bid);
+			bl->head++;
+			req->flags |= REQ_F_BUFFER_SELECTED;
+			ret = 0;
+		}
+	}
+
+	io_ring_submit_unlock(ctx, needs_lock);
+	return ret;
+}
+
+static unsigned int io_put_recv_kbuf(struct io_kiocb *req)
+{
+	if (!(req->flags & REQ_F_BUFFER_SELECTED))
+		return 0;
+	req->flags &= ~REQ_F_BUFFER_SELECTED;
+	return IORING_CQE_F_BUFFER |
+		((unsigned int)req->sr_msg.bid << IORING_CQE_BUFFER_SHIFT);
+}
+#endif
+
 static int io_recv(struct io_kiocb *req, struct io_kiocb **nxt,
 		   bool force_nonblock)
 {
 #if defined(CONFIG_NET)
+	unsigned int cflags = 0;
 	struct socket *sock;
 	int ret;
 
@@ -3293,6 +3424,12 @@ static int io_recv(struct io_kiocb *req, struct io_kiocb **nxt,
 		struct iovec iov;
 		unsigned flags;
 
+		if (req->flags & REQ_F_BUFFER_SELECT) {
+			ret = io_recv_buffer_select(req, !force_nonblock);
+			if (ret)
+				return ret;
+		}
+
 		ret = import_single_range(READ, sr->buf, sr->len, &iov,
 						&msg.msg_iter);
 		if (ret)
@@ -3318,7 +3455,8 @@ static int io_recv(struct io_kiocb *req, struct io_kiocb **nxt,
 			ret = -EINTR;
 	}
 
-	io_cqring_add_event(req, ret);
+	cflags = io_put_recv_kbuf(req);
+	__io_cqring_add_event(req, ret, cflags);
 	if (ret < 0)
 		req_set_fail_links(req);
 	io_put_req_find_next(req, nxt);
@@ -4853,7 +4991,8 @@ static inline void io_queue_link_head(struct io_kiocb *req)
 }
 
 #define SQE_VALID_FLAGS	(IOSQE_FIXED_FILE|IOSQE_IO_DRAIN|IOSQE_IO_LINK|	\
-				IOSQE_IO_HARDLINK | IOSQE_ASYNC)
+				IOSQE_IO_HARDLINK | IOSQE_ASYNC | \
+				IOSQE_BUFFER_SELECT)
 
 static bool io_submit_sqe(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 			  struct io_submit_state *state, struct io_kiocb **link)
@@ -4870,6 +5009,12 @@ static bool io_submit_sqe(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 		goto err_req;
 	}
 
+	if ((sqe_flags & IOSQE_BUFFER_SELECT) &&
+	    !io_op_defs[req->opcode].buffer_select) {
+		ret = -EOPNOTSUPP;
+		goto err_req;
+	}
+
 	id = READ_ONCE(sqe->personality);
 	if (id) {
 		req->work.creds = idr_find(&ctx->personality_idr, id);
@@ -4882,7 +5027,7 @@ static bool io_submit_sqe(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 
 	/* same numerical values with corresponding REQ_F_*, safe to copy */
 	req->flags |= sqe_flags & (IOSQE_IO_DRAIN|IOSQE_IO_HARDLINK|
-					IOSQE_ASYNC);
+					IOSQE_ASYNC|IOSQE_BUFFER_SELECT);
 
 	ret = io_req_set_file(state, req, sqe);
 	if (unlikely(ret)) {
@@ -5127,125 +5272,163 @@ fail_req:
 	return submitted;
 }
 
+static int __io_sq_thread(struct io_ring_ctx *ctx, struct mm_struct **cur_mm,
+			  bool cap_entries)
+{
+	unsigned int to_submit;
+	int ret = 0;
+
+	if (!list_empty(&ctx->poll_list)) {
+		unsigned nr_events = 0;
+
+		mutex_lock(&ctx->uring_lock);
+		if (!list_empty(&ctx->poll_list))
+			io_iopoll_getevents(ctx, &nr_events, 0);
+		mutex_unlock(&ctx->uring_lock);
+	}
+
+	to_submit = io_sqring_entries(ctx);
+	/* if sharing the thread, cap the per-ring budget to keep it fair */
+	if (cap_entries && to_submit > 8)
+		to_submit = 8;
+
+	if (to_submit) {
+		const struct cred *old_cred = override_creds(ctx->creds);
+
+		mutex_lock(&ctx->uring_lock);
+		ret = io_submit_sqes(ctx, to_submit, NULL, -1, cur_mm, true);
+		mutex_unlock(&ctx->uring_lock);
+		revert_creds(old_cred);
+	}
+
+	return ret;
+}
+
+static void io_sq_thread_drop_mm(struct mm_struct **cur_mm)
+{
+	if (*cur_mm) {
+		unuse_mm(*cur_mm);
+		mmput(*cur_mm);
+		*cur_mm = NULL;
+	}
+}
+
 static int io_sq_thread(void *data)
 {
-	struct io_ring_ctx *ctx = data;
+	struct io_sq_data *sqd = data;
 	struct mm_struct *cur_mm = NULL;
-	const struct cred *old_cred;
+	struct io_ring_ctx *ctx;
 	mm_segment_t old_fs;
 	DEFINE_WAIT(wait);
 	unsigned long timeout;
-	int ret = 0;
 
-	complete(&ctx->completions[1]);
+	complete_all(&sqd->startup);
 
 	old_fs = get_fs();
 	set_fs(USER_DS);
-	old_cred = override_creds(ctx->creds);
-
-	timeout = jiffies + ctx->sq_thread_idle;
-	while (!kthread_should_park()) {
-		unsigned int to_submit;
 
-		if (!list_empty(&ctx->poll_list)) {
-			unsigned nr_events = 0;
+	timeout = jiffies + sqd->sq_thread_idle;
+	while (!kthread_should_stop()) {
+		bool cap_entries, sqt_spin = false;
 
-			mutex_lock(&ctx->uring_lock);
-			if (!list_empty(&ctx->poll_list))
-				io_iopoll_getevents(ctx, &nr_events, 0);
-			else
-				timeout = jiffies + ctx->sq_thread_idle;
-			mutex_unlock(&ctx->uring_lock);
+		/*
+		 * Attach and detach park us, mutate ->ctx_list and unpark;
+		 * everywhere below the list is stable and walked unlocked.
+		 */
+		if (kthread_should_park()) {
+			io_sq_thread_drop_mm(&cur_mm);
+			kthread_parkme();
+			timeout = jiffies + sqd->sq_thread_idle;
+			continue;
 		}
 
-		to_submit = io_sqring_entries(ctx);
+		cap_entries = !list_is_singular(&sqd->ctx_list);
+		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
+			int ret;
 
-		/*
-		 * If submit got -EBUSY, flag us as needing the application
-		 * to enter the kernel to reap and flush events.
-		 */
-		if (!to_submit || ret == -EBUSY) {
 			/*
-			 * Drop cur_mm before scheduling, we can't hold it for
-			 * long periods (or over schedule()). Do this before
-			 * adding ourselves to the waitqueue, as the unuse/drop
-			 * may sleep.
+			 * Rings of different processes can share the thread;
+			 * switch mm when crossing a process boundary. Drop
+			 * before the submit, io_submit_sqes() grabs the right
+			 * one on demand.
 			 */
-			if (cur_mm) {
-				unuse_mm(cur_mm);
-				mmput(cur_mm);
-				cur_mm = NULL;
-			}
+			if (cur_mm && cur_mm != ctx->sqo_mm)
+				io_sq_thread_drop_mm(&cur_mm);
 
-			/*
-			 * We're polling. If we're within the defined idle
-			 * period, then let us spin without work before going
-			 * to sleep. The exception is if we got EBUSY doing
-			 * more IO, we should wait for the application to
-			 * reap events and wake us up.
-			 */
-			if (!list_empty(&ctx->poll_list) ||
-			    (!time_after(jiffies, timeout) && ret != -EBUSY &&
-			    !percpu_ref_is_dying(&ctx->refs))) {
-				cond_resched();
-				continue;
-			}
+			ret = __io_sq_thread(ctx, &cur_mm, cap_entries);
+			if (ret > 0 || !list_empty(&ctx->poll_list))
+				sqt_spin = true;
+		}
 
-			prepare_to_wait(&ctx->sqo_wait, &wait,
-						TASK_INTERRUPTIBLE);
+		/*
+		 * If any ring had work, or we're within the idle period,
+		 * spin without sleeping. A ring whose submit got -EBUSY
+		 * does not count as busy; the application has to enter the
+		 * kernel to reap and flush events, and wakes us back up.
+		 */
+		if (sqt_spin || !time_after(jiffies, timeout)) {
+			if (sqt_spin)
+				timeout = jiffies + sqd->sq_thread_idle;
+			cond_resched();
+			continue;
+		}
 
-			/*
-			 * While doing polled IO, before going to sleep, we need
-			 * to check if there are new reqs added to poll_list, it
-			 * is because reqs may have been punted to io worker and
-			 * will be added to poll_list later, hence check the
-			 * poll_list again.
-			 */
-			if ((ctx->flags & IORING_SETUP_IOPOLL) &&
-			    !list_empty_careful(&ctx->poll_list)) {
-				finish_wait(&ctx->sqo_wait, &wait);
-				continue;
+		/*
+		 * Drop cur_mm before scheduling, we can't hold it for long
+		 * periods (or over schedule()). Do this before adding
+		 * ourselves to the waitqueue, as the unuse/drop may sleep.
+		 */
+		io_sq_thread_drop_mm(&cur_mm);
+
+		prepare_to_wait(&sqd->wait, &wait, TASK_INTERRUPTIBLE);
+		if (!kthread_should_park()) {
+			bool needs_sched = true;
+
+			list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
+				/*
+				 * While doing polled IO, before going to
+				 * sleep, we need to check if there are new
+				 * reqs added to poll_list, it is because reqs
+				 * may have been punted to io worker and will
+				 * be added to poll_list later, hence check
+				 * the poll_list again.
+				 */
+				if ((ctx->flags & IORING_SETUP_IOPOLL) &&
+				    !list_empty_careful(&ctx->poll_list)) {
+					needs_sched = false;
+					break;
+				}
+				/* Tell userspace we may need a wakeup call */
+				ctx->rings->sq_flags |= IORING_SQ_NEED_WAKEUP;
 			}
-
-			/* Tell userspace we may need a wakeup call */
-			ctx->rings->sq_flags |= IORING_SQ_NEED_WAKEUP;
-			/* make sure to read SQ tail after writing flags */
+			/* make sure to read SQ tails after writing flags */
 			smp_mb();
 
-			to_submit = io_sqring_entries(ctx);
-			if (!to_submit || ret == -EBUSY) {
-				if (kthread_should_park()) {
-					finish_wait(&ctx->sqo_wait, &wait);
-					break;
+			if (needs_sched) {
+				list_for_each_entry(ctx, &sqd->ctx_list,
+						    sqd_list) {
+					if (io_sqring_entries(ctx)) {
+						needs_sched = false;
+						break;
+					}
 				}
+			}
+
+			if (needs_sched) {
 				if (signal_pending(current))
 					flush_signals(current);
 				schedule();
-				finish_wait(&ctx->sqo_wait, &wait);
-
-				ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
-				ret = 0;
-				continue;
 			}
-			finish_wait(&ctx->sqo_wait, &wait);
 
-			ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
+			list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+				ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
 		}
-
-		mutex_lock(&ctx->uring_lock);
-		ret = io_submit_sqes(ctx, to_submit, NULL, -1, &cur_mm, true);
-		mutex_unlock(&ctx->uring_lock);
-		timeout = jiffies + ctx->sq_thread_idle;
+		finish_wait(&sqd->wait, &wait);
+		timeout = jiffies + sqd->sq_thread_idle;
 	}
 
 	set_fs(old_fs);
-	if (cur_mm) {
-		unuse_mm(cur_mm);
-		mmput(cur_mm);
-	}
-	revert_creds(old_cred);
-
-	kthread_parkme();
+	io_sq_thread_drop_mm(&cur_mm);
 
 	return 0;
 }
@@ -5411,19 +5594,103 @@ static int io_sqe_files_unregister(struct io_ring_ctx *ctx)
 	return 0;
 }
 
+static void io_sq_thread_park(struct io_sq_data *sqd)
+{
+	if (sqd->thread)
+		kthread_park(sqd->thread);
+}
+
+static void io_sq_thread_unpark(struct io_sq_data *sqd)
+{
+	if (sqd->thread)
+		kthread_unpark(sqd->thread);
+}
+
+static void io_sqd_update_thread_idle(struct io_sq_data *sqd)
+{
+	struct io_ring_ctx *ctx;
+	unsigned sq_thread_idle = 0;
+
+	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+		sq_thread_idle = max(sq_thread_idle, ctx->sq_thread_idle);
+	sqd->sq_thread_idle = sq_thread_idle;
+}
+
+static struct io_sq_data *io_attach_sq_data(struct io_uring_params *p)
+{
+	struct io_ring_ctx *ctx_attach;
+	struct io_sq_data *sqd;
+	struct fd f;
+
+	f = fdget(p->wq_fd);
+	if (!f.file)
+		return ERR_PTR(-ENXIO);
+	if (f.file->f_op != &io_uring_fops) {
+		fdput(f);
+		return ERR_PTR(-EINVAL);
+	}
+
+	ctx_attach = f.file->private_data;
+	sqd = ctx_attach->sq_data;
+	if (!sqd) {
+		fdput(f);
+		return ERR_PTR(-EINVAL);
+	}
+
+	refcount_inc(&sqd->refs);
+	fdput(f);
+	return sqd;
+}
+
+static struct io_sq_data *io_get_sq_data(struct io_uring_params *p)
+{
+	struct io_sq_data *sqd;
+
+	if (p->flags & IORING_SETUP_ATTACH_WQ)
+		return io_attach_sq_data(p);
+
+	sqd = kzalloc(sizeof(*sqd), GFP_KERNEL);
+	if (!sqd)
+		return ERR_PTR(-ENOMEM);
+
+	refcount_set(&sqd->refs, 1);
+	mutex_init(&sqd->lock);
+	INIT_LIST_HEAD(&sqd->ctx_list);
+	init_waitqueue_head(&sqd->wait);
+	init_completion(&sqd->startup);
+	return sqd;
+}
+
 static void io_sq_thread_stop(struct io_ring_ctx *ctx)
 {
-	if (ctx->sqo_thread) {
-		wait_for_completion(&ctx->completions[1]);
-		/*
-		 * The park is a bit of a work-around, without it we get
-		 * warning spews on shutdown with SQPOLL set and affinity
-		 * set to a single CPU.
-		 */
-		kthread_park(ctx->sqo_thread);
-		kthread_stop(ctx->sqo_thread);
-		ctx->sqo_thread = NULL;
+	struct io_sq_data *sqd = ctx->sq_data;
+
+	if (!sqd)
+		return;
+
+	if (sqd->thread)
+		wait_for_completion(&sqd->startup);
+
+	mutex_lock(&sqd->lock);
+	/*
+	 * The park is a bit of a work-around, without it we get
+	 * warning spews on shutdown with SQPOLL set and affinity
+	 * set to a single CPU. It also keeps ->ctx_list stable for
+	 * the list walks in io_sq_thread().
+	 */
+	io_sq_thread_park(sqd);
+	list_del_init(&ctx->sqd_list);
+	io_sqd_update_thread_idle(sqd);
+	if (refcount_dec_and_test(&sqd->refs)) {
+		if (sqd->thread)
+			kthread_stop(sqd->thread);
+		mutex_unlock(&sqd->lock);
+		kfree(sqd);
+	} else {
+		io_sq_thread_unpark(sqd);
+		mutex_unlock(&sqd->lock);
 	}
+	ctx->sq_data = NULL;
 }
 
 static void io_finish_async(struct io_ring_ctx *ctx)
@@ -6017,6 +6284,8 @@ static int io_sq_offload_start(struct io_ring_ctx *ctx,
 	ctx->sqo_mm = current->mm;
 
 	if (ctx->flags & IORING_SETUP_SQPOLL) {
+		struct io_sq_data *sqd;
+
 		ret = -EPERM;
 		if (!capable(CAP_SYS_ADMIN))
 			goto err;
@@ -6025,6 +6294,24 @@ static int io_sq_offload_start(struct io_ring_ctx *ctx,
 		if (!ctx->sq_thread_idle)
 			ctx->sq_thread_idle = HZ;
 
+		sqd = io_get_sq_data(p);
+		if (IS_ERR(sqd)) {
+			ret = PTR_ERR(sqd);
+			goto err;
+		}
+		ctx->sq_data = sqd;
+
+		mutex_lock(&sqd->lock);
+		io_sq_thread_park(sqd);
+		list_add(&ctx->sqd_list, &sqd->ctx_list);
+		io_sqd_update_thread_idle(sqd);
+		io_sq_thread_unpark(sqd);
+		mutex_unlock(&sqd->lock);
+
+		/* attached to an existing thread, we're done */
+		if (sqd->thread)
+			goto done;
+
 		if (p->flags & IORING_SETUP_SQ_AFF) {
 			int cpu = p->sq_thread_cpu;
 
@@ -6034,25 +6321,26 @@ static int io_sq_offload_start(struct io_ring_ctx *ctx,
 			if (!cpu_online(cpu))
 				goto err;
 
-			ctx->sqo_thread = kthread_create_on_cpu(io_sq_thread,
-							ctx, cpu,
+			sqd->thread = kthread_create_on_cpu(io_sq_thread,
+							sqd, cpu,
 							"io_uring-sq");
 		} else {
-			ctx->sqo_thread = kthread_create(io_sq_thread, ctx,
+			sqd->thread = kthread_create(io_sq_thread, sqd,
 							"io_uring-sq");
 		}
-		if (IS_ERR(ctx->sqo_thread)) {
-			ret = PTR_ERR(ctx->sqo_thread);
-			ctx->sqo_thread = NULL;
+		if (IS_ERR(sqd->thread)) {
+			ret = PTR_ERR(sqd->thread);
+			sqd->thread = NULL;
 			goto err;
 		}
-		wake_up_process(ctx->sqo_thread);
+		wake_up_process(sqd->thread);
 	} else if (p->flags & IORING_SETUP_SQ_AFF) {
 		/* Can't have SQ_AFF without SQPOLL */
 		ret = -EINVAL;
 		goto err;
 	}
 
+done:
 	ret = io_init_wq_offload(ctx, p);
 	if (ret)
 		goto err;
@@ -6341,6 +6629,107 @@ err:
 	return ret;
 }
 
+static void io_free_pbuf_ring(struct io_buffer_list *bl)
+{
+	vunmap(bl->buf_ring);
+	unpin_user_pages(bl->buf_pages, bl->buf_nr_pages);
+	kvfree(bl->buf_pages);
+	kfree(bl);
+}
+
+static int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_buffer_list *bl;
+	struct io_uring_buf_reg reg;
+	struct page **pages;
+	int nr_pages, pret, ret;
+
+	if (copy_from_user(&reg, arg, sizeof(reg)))
+		return -EFAULT;
+	if (reg.pad || reg.resv[0] || reg.resv[1] || reg.resv[2])
+		return -EINVAL;
+	if (!reg.ring_addr || (reg.ring_addr & ~PAGE_MASK))
+		return -EINVAL;
+	if (!is_power_of_2(reg.ring_entries) || reg.ring_entries > 32768)
+		return -EINVAL;
+	if (idr_find(&ctx->io_bl_idr, reg.bgid))
+		return -EEXIST;
+
+	bl = kzalloc(sizeof(*bl), GFP_KERNEL);
+	if (!bl)
+		return -ENOMEM;
+
+	nr_pages = DIV_ROUND_UP(reg.ring_entries * sizeof(struct io_uring_buf),
+				PAGE_SIZE);
+	pages = kvmalloc_array(nr_pages, sizeof(struct page *), GFP_KERNEL);
+	if (!pages) {
+		kfree(bl);
+		return -ENOMEM;
+	}
+
+	down_read(&current->mm->mmap_sem);
+	pret = pin_user_pages(reg.ring_addr, nr_pages,
+			      FOLL_WRITE | FOLL_LONGTERM, pages, NULL);
+	up_read(&current->mm->mmap_sem);
+	if (pret != nr_pages) {
+		if (pret > 0)
+			unpin_user_pages(pages, pret);
+		ret = pret < 0 ? pret : -EFAULT;
+		goto err_pages;
+	}
+
+	bl->buf_ring = vmap(pages, nr_pages, VM_MAP, PAGE_KERNEL);
+	if (!bl->buf_ring) {
+		unpin_user_pages(pages, nr_pages);
+		ret = -ENOMEM;
+		goto err_pages;
+	}
+
+	bl->buf_pages = pages;
+	bl->buf_nr_pages = nr_pages;
+	bl->bgid = reg.bgid;
+	bl->nr_entries = reg.ring_entries;
+	bl->mask = reg.ring_entries - 1;
+	bl->head = 0;
+
+	ret = idr_alloc(&ctx->io_bl_idr, bl, reg.bgid, reg.bgid + 1,
+			GFP_KERNEL);
+	if (ret < 0) {
+		io_free_pbuf_ring(bl);
+		return ret;
+	}
+	return 0;
+err_pages:
+	kvfree(pages);
+	kfree(bl);
+	return ret;
+}
+
+static int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_uring_buf_reg reg;
+	struct io_buffer_list *bl;
+
+	if (copy_from_user(&reg, arg, sizeof(reg)))
+		return -EFAULT;
+	if (reg.ring_addr || reg.ring_entries || reg.pad ||
+	    reg.resv[0] || reg.resv[1] || reg.resv[2])
+		return -EINVAL;
+
+	bl = idr_remove(&ctx->io_bl_idr, reg.bgid);
+	if (!bl)
+		return -ENOENT;
+
+	io_free_pbuf_ring(bl);
+	return 0;
+}
+
+static int io_destroy_pbuf_ring(int id, void *p, void *data)
+{
+	io_free_pbuf_ring(p);
+	return 0;
+}
+
 static int io_eventfd_register(struct io_ring_ctx *ctx, void __user *arg)
 {
 	__s32 __user *fds = arg;
@@ -6383,6 +6772,8 @@ static void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	io_sqe_buffer_unregister(ctx);
 	io_sqe_files_unregister(ctx);
 	io_eventfd_unregister(ctx);
+	idr_for_each(&ctx->io_bl_idr, io_destroy_pbuf_ring, NULL);
+	idr_destroy(&ctx->io_bl_idr);
 	idr_destroy(&ctx->personality_idr);
 
 #if defined(CONFIG_UNIX)
@@ -6452,14 +6843,21 @@ static void io_ring_ctx_wait_and_kill(struct io_ring_ctx *ctx)
 	mutex_unlock(&ctx->uring_lock);
 
 	/*
-	 * Wait for sq thread to idle, if we have one. It won't spin on new
-	 * work after we've killed the ctx ref above. This is important to do
+	 * Quiesce the sq thread, if we have one. It won't spin on new work
+	 * after we've killed the ctx ref above. This is important to do
 	 * before we cancel existing commands, as the thread could otherwise
 	 * be queueing new work post that. If that's work we need to cancel,
-	 * it could cause shutdown to hang.
+	 * it could cause shutdown to hang. A park/unpark cycle guarantees
+	 * the thread is not mid-submit for this ring; waiting for it to
+	 * sleep won't do, as a thread shared with other rings may never
+	 * become idle.
 	 */
-	while (ctx->sqo_thread && !wq_has_sleeper(&ctx->sqo_wait))
-		cond_resched();
+	if (ctx->sq_data) {
+		mutex_lock(&ctx->sq_data->lock);
+		io_sq_thread_park(ctx->sq_data);
+		io_sq_thread_unpark(ctx->sq_data);
+		mutex_unlock(&ctx->sq_data->lock);
+	}
 
 	io_kill_timeouts(ctx);
 	io_poll_remove_all(ctx);
@@ -6663,7 +7061,7 @@ SYSCALL_DEFINE6(io_uring_enter, unsigned int, fd, u32, to_submit,
 		if (!list_empty_careful(&ctx->cq_overflow_list))
 			io_cqring_overflow_flush(ctx, false);
 		if (flags & IORING_ENTER_SQ_WAKEUP)
-			wake_up(&ctx->sqo_wait);
+			wake_up(&ctx->sq_data->wait);
 		submitted = to_submit;
 	} else if (to_submit) {
 		struct mm_struct *cur_mm;
@@ -7094,6 +7492,8 @@ static bool io_register_op_must_quiesce(int op)
 	case IORING_REGISTER_PROBE:
 	case IORING_REGISTER_PERSONALITY:
 	case IORING_UNREGISTER_PERSONALITY:
+	case IORING_REGISTER_PBUF_RING:
+	case IORING_UNREGISTER_PBUF_RING:
 		return false;
 	default:
 		return true;
@@ -7183,6 +7583,18 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_probe(ctx, arg, nr_args);
 		break;
+	case IORING_REGISTER_PBUF_RING:
+		ret = -EINVAL;
+		if (!arg || nr_args)
+			break;
+		ret = io_register_pbuf_ring(ctx, arg);
+		break;
+	case IORING_UNREGISTER_PBUF_RING:
+		ret = -EINVAL;
+		if (!arg || nr_args)
+			break;
+		ret = io_unregister_pbuf_ring(ctx, arg);
+		break;
 	case IORING_REGISTER_PERSONALITY:
 		ret = -EINVAL;
 		if (arg || nr_args)
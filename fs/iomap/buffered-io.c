@@ -15,6 +15,7 @@
 #include <linux/list_sort.h>
 #include <linux/swap.h>
 #include <linux/bio.h>
+#include <linux/blkdev.h>
 #include <linux/sched/signal.h>
 #include <linux/migrate.h>
 #include "trace.h"
@@ -177,37 +178,58 @@ iomap_set_range_uptodate(struct page *page, unsigned off, unsigned len)
 }
 
 static void
-iomap_read_finish(struct iomap_page *iop, struct page *page)
+iomap_read_finish(struct iomap_page *iop, struct page *page, int nr_segs)
 {
-	if (!iop || atomic_dec_and_test(&iop->read_count))
+	if (!iop || atomic_sub_and_test(nr_segs, &iop->read_count))
 		unlock_page(page);
 }
 
 static void
-iomap_read_page_end_io(struct bio_vec *bvec, int error)
+iomap_read_page_end_io(struct page *page, unsigned int off, unsigned int len,
+		int nr_segs, int error)
 {
-	struct page *page = bvec->bv_page;
 	struct iomap_page *iop = to_iomap_page(page);
 
 	if (unlikely(error)) {
 		ClearPageUptodate(page);
 		SetPageError(page);
 	} else {
-		iomap_set_range_uptodate(page, bvec->bv_offset, bvec->bv_len);
+		iomap_set_range_uptodate(page, off, len);
 	}
 
-	iomap_read_finish(iop, page);
+	iomap_read_finish(iop, page, nr_segs);
 }
 
 static void
 iomap_read_end_io(struct bio *bio)
 {
 	int error = blk_status_to_errno(bio->bi_status);
+	struct page *page = NULL;
+	unsigned int off = 0, len = 0;
+	int nr_segs = 0;
 	struct bio_vec *bvec;
 	struct bvec_iter_all iter_all;
 
-	bio_for_each_segment_all(bvec, bio, iter_all)
-		iomap_read_page_end_io(bvec, error);
+	/*
+	 * Handle each page in one go by coalescing adjacent segments, so
+	 * that sub-page blocks pay for the uptodate accounting once per
+	 * page rather than once per segment.
+	 */
+	bio_for_each_segment_all(bvec, bio, iter_all) {
+		if (bvec->bv_page == page && bvec->bv_offset == off + len) {
+			len += bvec->bv_len;
+			nr_segs++;
+			continue;
+		}
+		if (page)
+			iomap_read_page_end_io(page, off, len, nr_segs, error);
+		page = bvec->bv_page;
+		off = bvec->bv_offset;
+		len = bvec->bv_len;
+		nr_segs = 1;
+	}
+	if (page)
+		iomap_read_page_end_io(page, off, len, nr_segs, error);
 	bio_put(bio);
 }
 
@@ -216,6 +238,7 @@ struct iomap_readpage_ctx {
 	bool			cur_page_in_bio;
 	bool			is_readahead;
 	struct bio		*bio;
+	unsigned int		nr_bios;
 	struct list_head	*pages;
 };
 
@@ -310,6 +333,7 @@ iomap_readpage_actor(struct inode *inode, loff_t pos, loff_t length, void *data,
 		if (ctx->is_readahead) /* same as readahead_gfp_mask */
 			gfp |= __GFP_NORETRY | __GFP_NOWARN;
 		ctx->bio = bio_alloc(gfp, min(BIO_MAX_PAGES, nr_vecs));
+		ctx->nr_bios++;
 		ctx->bio->bi_opf = REQ_OP_READ;
 		if (ctx->is_readahead)
 			ctx->bio->bi_opf |= REQ_RAHEAD;
@@ -351,7 +375,29 @@ iomap_readpage(struct page *page, const struct iomap_ops *ops)
 	}
 
 	if (ctx.bio) {
-		submit_bio(ctx.bio);
+		struct request_queue *q = ctx.bio->bi_disk->queue;
+		bool poll = false;
+		blk_qc_t cookie;
+
+		/*
+		 * If the whole page went into a single bio and the queue has
+		 * polling enabled, complete the read inline instead of taking
+		 * an interrupt: the caller is about to wait on this page
+		 * anyway.  Only the last bio can be polled for, hence the
+		 * single-bio restriction.
+		 */
+		if (ctx.nr_bios == 1 &&
+		    test_bit(QUEUE_FLAG_POLL, &q->queue_flags)) {
+			ctx.bio->bi_opf |= REQ_HIPRI;
+			poll = true;
+		}
+		cookie = submit_bio(ctx.bio);
+		if (!blk_qc_t_valid(cookie))
+			poll = false;
+		while (poll && PageLocked(page)) {
+			if (blk_poll(q, cookie, true) <= 0)
+				cond_resched();
+		}
 		WARN_ON_ONCE(!ctx.cur_page_in_bio);
 	} else {
 		WARN_ON_ONCE(ctx.cur_page_in_bio);
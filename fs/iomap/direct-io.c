@@ -46,8 +46,18 @@ struct iomap_dio {
 			struct work_struct	work;
 		} aio;
 	};
+
+	bool			embedded_bio_used;
+	/*
+	 * The dio and the bio for the first fragment come out of
+	 * iomap_dio_bioset in one allocation; the bio's final reference
+	 * holds the dio.  Must be last.
+	 */
+	struct bio		bio;
 };
 
+static struct bio_set iomap_dio_bioset;
+
 int iomap_dio_iopoll(struct kiocb *kiocb, bool spin)
 {
 	struct request_queue *q = READ_ONCE(kiocb->private);
@@ -58,6 +68,22 @@ int iomap_dio_iopoll(struct kiocb *kiocb, bool spin)
 }
 EXPORT_SYMBOL_GPL(iomap_dio_iopoll);
 
+/*
+ * The first bio of a dio reuses the bio (and its bvecs) that was allocated
+ * together with the dio itself, so the common single-fragment case needs no
+ * further allocations.  The extra reference keeps the dio storage alive
+ * until iomap_dio_complete() drops it.
+ */
+static struct bio *iomap_dio_alloc_bio(struct iomap_dio *dio, int nr_vecs)
+{
+	if (!dio->embedded_bio_used && nr_vecs <= dio->bio.bi_max_vecs) {
+		dio->embedded_bio_used = true;
+		bio_get(&dio->bio);
+		return &dio->bio;
+	}
+	return bio_alloc(GFP_KERNEL, nr_vecs);
+}
+
 static void iomap_dio_submit_bio(struct iomap_dio *dio, struct iomap *iomap,
 		struct bio *bio)
 {
@@ -120,7 +146,7 @@ static ssize_t iomap_dio_complete(struct iomap_dio *dio)
 		ret = generic_write_sync(iocb, ret);
 
 	inode_dio_end(file_inode(iocb->ki_filp));
-	kfree(dio);
+	bio_put(&dio->bio);
 
 	return ret;
 }
@@ -182,7 +208,7 @@ iomap_dio_zero(struct iomap_dio *dio, struct iomap *iomap, loff_t pos,
 	int flags = REQ_SYNC | REQ_IDLE;
 	struct bio *bio;
 
-	bio = bio_alloc(GFP_KERNEL, 1);
+	bio = iomap_dio_alloc_bio(dio, 1);
 	bio_set_dev(bio, iomap->bdev);
 	bio->bi_iter.bi_sector = iomap_sector(iomap, pos);
 	bio->bi_private = dio;
@@ -264,7 +290,7 @@ iomap_dio_bio_actor(struct inode *inode, loff_t pos, loff_t length,
 			goto out;
 		}
 
-		bio = bio_alloc(GFP_KERNEL, nr_pages);
+		bio = iomap_dio_alloc_bio(dio, nr_pages);
 		bio_set_dev(bio, iomap->bdev);
 		bio->bi_iter.bi_sector = iomap_sector(iomap, pos);
 		bio->bi_write_hint = dio->iocb->ki_hint;
@@ -410,6 +436,7 @@ iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	unsigned int flags = IOMAP_DIRECT;
 	struct blk_plug plug;
 	struct iomap_dio *dio;
+	struct bio *bio;
 
 	lockdep_assert_held(&inode->i_rwsem);
 
@@ -419,9 +446,13 @@ iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	if (WARN_ON(is_sync_kiocb(iocb) && !wait_for_completion))
 		return -EIO;
 
-	dio = kmalloc(sizeof(*dio), GFP_KERNEL);
-	if (!dio)
+	bio = bio_alloc_bioset(GFP_KERNEL,
+			iov_iter_npages(iter, BIO_MAX_PAGES),
+			&iomap_dio_bioset);
+	if (!bio)
 		return -ENOMEM;
+	dio = container_of(bio, struct iomap_dio, bio);
+	dio->embedded_bio_used = false;
 
 	dio->iocb = iocb;
 	atomic_set(&dio->ref, 1);
@@ -569,7 +600,15 @@ iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	return iomap_dio_complete(dio);
 
 out_free_dio:
-	kfree(dio);
+	bio_put(&dio->bio);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(iomap_dio_rw);
+
+static int __init iomap_dio_init(void)
+{
+	return bioset_init(&iomap_dio_bioset, 4,
+			offsetof(struct iomap_dio, bio),
+			BIOSET_NEED_BVECS);
+}
+fs_initcall(iomap_dio_init);
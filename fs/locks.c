@@ -167,6 +167,7 @@
 #include <linux/rcupdate.h>
 #include <linux/pid_namespace.h>
 #include <linux/hashtable.h>
+#include <linux/interval_tree_generic.h>
 #include <linux/percpu.h>
 
 #define CREATE_TRACE_POINTS
@@ -242,6 +243,21 @@ static DEFINE_HASHTABLE(blocked_hash, BLOCKED_HASH_BITS);
  */
 static DEFINE_SPINLOCK(blocked_lock_lock);
 
+/*
+ * POSIX locks are additionally indexed in a per-inode interval tree so
+ * that conflict checks only visit the locks overlapping the byte range
+ * of interest instead of every lock on the inode.  The tree shadows the
+ * flc_posix list, is keyed on [fl_start, fl_end] and is protected by
+ * the flc_lock.  Range changes on a lock that is already in the tree
+ * must go through posix_lock_update_range() so the tree's augmented
+ * ordering stays valid.
+ */
+#define FL_ITREE_START(fl)	((fl)->fl_start)
+#define FL_ITREE_LAST(fl)	((fl)->fl_end)
+
+INTERVAL_TREE_DEFINE(struct file_lock, fl_node, loff_t, fl_subtree_last,
+		     FL_ITREE_START, FL_ITREE_LAST, static, posix_lock_tree)
+
 static struct kmem_cache *flctx_cache __read_mostly;
 static struct kmem_cache *filelock_cache __read_mostly;
 
@@ -262,6 +278,7 @@ locks_get_lock_context(struct inode *inode, int type)
 	spin_lock_init(&ctx->flc_lock);
 	INIT_LIST_HEAD(&ctx->flc_flock);
 	INIT_LIST_HEAD(&ctx->flc_posix);
+	ctx->flc_posix_tree = RB_ROOT_CACHED;
 	INIT_LIST_HEAD(&ctx->flc_lease);
 
 	/*
@@ -334,6 +351,7 @@ locks_free_lock_context(struct inode *inode)
 static void locks_init_lock_heads(struct file_lock *fl)
 {
 	INIT_HLIST_NODE(&fl->fl_link);
+	RB_CLEAR_NODE(&fl->fl_node);
 	INIT_LIST_HEAD(&fl->fl_list);
 	INIT_LIST_HEAD(&fl->fl_blocked_requests);
 	INIT_LIST_HEAD(&fl->fl_blocked_member);
@@ -355,6 +373,7 @@ EXPORT_SYMBOL_GPL(locks_alloc_lock);
 void locks_release_private(struct file_lock *fl)
 {
 	BUG_ON(waitqueue_active(&fl->fl_wait));
+	BUG_ON(!RB_EMPTY_NODE(&fl->fl_node));
 	BUG_ON(!list_empty(&fl->fl_list));
 	BUG_ON(!list_empty(&fl->fl_blocked_requests));
 	BUG_ON(!list_empty(&fl->fl_blocked_member));
@@ -899,6 +918,42 @@ locks_delete_lock_ctx(struct file_lock *fl, struct list_head *dispose)
 		locks_free_lock(fl);
 }
 
+/*
+ * Variants for POSIX locks that keep the per-inode interval tree in
+ * sync with the flc_posix list.
+ */
+static void
+posix_insert_lock_ctx(struct file_lock_context *ctx, struct file_lock *fl,
+		      struct list_head *before)
+{
+	posix_lock_tree_insert(fl, &ctx->flc_posix_tree);
+	locks_insert_lock_ctx(fl, before);
+}
+
+static void
+posix_delete_lock_ctx(struct file_lock_context *ctx, struct file_lock *fl,
+		      struct list_head *dispose)
+{
+	posix_lock_tree_remove(fl, &ctx->flc_posix_tree);
+	RB_CLEAR_NODE(&fl->fl_node);
+	locks_delete_lock_ctx(fl, dispose);
+}
+
+/*
+ * Change the range of a lock that is linked into the interval tree.
+ * The tree is keyed on [fl_start, fl_end], so the lock has to be taken
+ * out and reinserted around the update.
+ */
+static void
+posix_lock_update_range(struct file_lock_context *ctx, struct file_lock *fl,
+			loff_t start, loff_t end)
+{
+	posix_lock_tree_remove(fl, &ctx->flc_posix_tree);
+	fl->fl_start = start;
+	fl->fl_end = end;
+	posix_lock_tree_insert(fl, &ctx->flc_posix_tree);
+}
+
 /* Determine if lock sys_fl blocks lock caller_fl. Common functionality
  * checks for shared/exclusive status of overlapping locks.
  */
@@ -962,7 +1017,10 @@ posix_test_lock(struct file *filp, struct file_lock *fl)
 	}
 
 	spin_lock(&ctx->flc_lock);
-	list_for_each_entry(cfl, &ctx->flc_posix, fl_list) {
+	for (cfl = posix_lock_tree_iter_first(&ctx->flc_posix_tree,
+					      fl->fl_start, fl->fl_end);
+	     cfl;
+	     cfl = posix_lock_tree_iter_next(cfl, fl->fl_start, fl->fl_end)) {
 		if (posix_locks_conflict(fl, cfl)) {
 			locks_copy_conflock(fl, cfl);
 			goto out;
@@ -1161,12 +1219,18 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 	percpu_down_read(&file_rwsem);
 	spin_lock(&ctx->flc_lock);
 	/*
-	 * New lock request. Walk all POSIX locks and look for conflicts. If
+	 * New lock request. Search the interval tree for POSIX locks
+	 * overlapping the requested range and look for conflicts. If
 	 * there are any, either return error or put the request on the
 	 * blocker's list of waiters and the global blocked_hash.
 	 */
 	if (request->fl_type != F_UNLCK) {
-		list_for_each_entry(fl, &ctx->flc_posix, fl_list) {
+		for (fl = posix_lock_tree_iter_first(&ctx->flc_posix_tree,
+						     request->fl_start,
+						     request->fl_end);
+		     fl;
+		     fl = posix_lock_tree_iter_next(fl, request->fl_start,
+						    request->fl_end)) {
 			if (!posix_locks_conflict(request, fl))
 				continue;
 			if (conflock)
@@ -1230,18 +1294,16 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 			 * lock yielding from the lower start address of both
 			 * locks to the higher end address.
 			 */
-			if (fl->fl_start > request->fl_start)
-				fl->fl_start = request->fl_start;
-			else
-				request->fl_start = fl->fl_start;
-			if (fl->fl_end < request->fl_end)
-				fl->fl_end = request->fl_end;
-			else
-				request->fl_end = fl->fl_end;
 			if (added) {
-				locks_delete_lock_ctx(fl, &dispose);
+				posix_lock_update_range(ctx, request,
+					min(fl->fl_start, request->fl_start),
+					max(fl->fl_end, request->fl_end));
+				posix_delete_lock_ctx(ctx, fl, &dispose);
 				continue;
 			}
+			posix_lock_update_range(ctx, fl,
+					min(fl->fl_start, request->fl_start),
+					max(fl->fl_end, request->fl_end));
 			request = fl;
 			added = true;
 		} else {
@@ -1268,7 +1330,8 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 				 * one (This may happen several times).
 				 */
 				if (added) {
-					locks_delete_lock_ctx(fl, &dispose);
+					posix_delete_lock_ctx(ctx, fl,
+							      &dispose);
 					continue;
 				}
 				/*
@@ -1284,8 +1347,9 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 				locks_copy_lock(new_fl, request);
 				request = new_fl;
 				new_fl = NULL;
-				locks_insert_lock_ctx(request, &fl->fl_list);
-				locks_delete_lock_ctx(fl, &dispose);
+				posix_insert_lock_ctx(ctx, request,
+						      &fl->fl_list);
+				posix_delete_lock_ctx(ctx, fl, &dispose);
 				added = true;
 			}
 		}
@@ -1314,7 +1378,7 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 		}
 		locks_copy_lock(new_fl, request);
 		locks_move_blocks(new_fl, request);
-		locks_insert_lock_ctx(new_fl, &fl->fl_list);
+		posix_insert_lock_ctx(ctx, new_fl, &fl->fl_list);
 		fl = new_fl;
 		new_fl = NULL;
 	}
@@ -1326,13 +1390,15 @@ static int posix_lock_inode(struct inode *inode, struct file_lock *request,
 			left = new_fl2;
 			new_fl2 = NULL;
 			locks_copy_lock(left, right);
-			locks_insert_lock_ctx(left, &fl->fl_list);
+			posix_insert_lock_ctx(ctx, left, &fl->fl_list);
 		}
-		right->fl_start = request->fl_end + 1;
+		posix_lock_update_range(ctx, right, request->fl_end + 1,
+					right->fl_end);
 		locks_wake_up_blocks(right);
 	}
 	if (left) {
-		left->fl_end = request->fl_start - 1;
+		posix_lock_update_range(ctx, left, left->fl_start,
+					request->fl_start - 1);
 		locks_wake_up_blocks(left);
 	}
  out:
@@ -296,6 +296,7 @@ void nfs_init_cinfo_from_dreq(struct nfs_commit_info *cinfo,
 static inline struct nfs_direct_req *nfs_direct_req_alloc(void)
 {
 	struct nfs_direct_req *dreq;
+	int i;
 
 	dreq = kmem_cache_zalloc(nfs_direct_cachep, GFP_KERNEL);
 	if (!dreq)
@@ -304,7 +305,8 @@ static inline struct nfs_direct_req *nfs_direct_req_alloc(void)
 	kref_init(&dreq->kref);
 	kref_get(&dreq->kref);
 	init_completion(&dreq->completion);
-	INIT_LIST_HEAD(&dreq->mds_cinfo.list);
+	for (i = 0; i < NFS_COMMIT_BUCKETS; i++)
+		INIT_LIST_HEAD(&dreq->mds_cinfo.buckets[i]);
 	dreq->verf.committed = NFS_INVALID_STABLE_HOW;	/* not set yet */
 	INIT_WORK(&dreq->work, nfs_direct_write_schedule_work);
 	spin_lock_init(&dreq->lock);
@@ -610,12 +612,15 @@ nfs_direct_write_scan_commit_list(struct inode *inode,
 				  struct list_head *list,
 				  struct nfs_commit_info *cinfo)
 {
+	int i;
+
 	mutex_lock(&NFS_I(cinfo->inode)->commit_mutex);
 #ifdef CONFIG_NFS_V4_1
 	if (cinfo->ds != NULL && cinfo->ds->nwritten != 0)
 		NFS_SERVER(inode)->pnfs_curr_ld->recover_commit_reqs(list, cinfo);
 #endif
-	nfs_scan_commit_list(&cinfo->mds->list, list, cinfo, 0);
+	for (i = 0; i < NFS_COMMIT_BUCKETS; i++)
+		nfs_scan_commit_list(&cinfo->mds->buckets[i], list, cinfo, 0);
 	mutex_unlock(&NFS_I(cinfo->inode)->commit_mutex);
 }
 
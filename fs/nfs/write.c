@@ -823,6 +823,14 @@ nfs_mark_request_dirty(struct nfs_page *req)
 		__set_page_dirty_nobuffers(req->wb_page);
 }
 
+/* The commit bucket holding the requests that cover page index @idx */
+static struct list_head *
+nfs_mds_commit_bucket(struct nfs_mds_commit_info *mds, pgoff_t idx)
+{
+	return &mds->buckets[(idx >> NFS_COMMIT_BUCKET_SHIFT) %
+			     NFS_COMMIT_BUCKETS];
+}
+
 /*
  * nfs_page_search_commits_for_head_request_locked
  *
@@ -846,8 +854,11 @@ nfs_page_search_commits_for_head_request_locked(struct nfs_inode *nfsi,
 	if (freq)
 		return freq->wb_head;
 
-	/* Linearly search the commit list for the correct request */
-	list_for_each_entry_safe(freq, t, &cinfo.mds->list, wb_list) {
+	/* Linearly search the commit bucket for the correct request */
+	list_for_each_entry_safe(freq, t,
+				 nfs_mds_commit_bucket(cinfo.mds,
+						       page_index(page)),
+				 wb_list) {
 		if (freq->wb_page == page)
 			return freq->wb_head;
 	}
@@ -894,7 +905,9 @@ void
 nfs_request_add_commit_list(struct nfs_page *req, struct nfs_commit_info *cinfo)
 {
 	mutex_lock(&NFS_I(cinfo->inode)->commit_mutex);
-	nfs_request_add_commit_list_locked(req, &cinfo->mds->list, cinfo);
+	nfs_request_add_commit_list_locked(req,
+			nfs_mds_commit_bucket(cinfo->mds, req->wb_index),
+			cinfo);
 	mutex_unlock(&NFS_I(cinfo->inode)->commit_mutex);
 	if (req->wb_page)
 		nfs_mark_page_unstable(req->wb_page, cinfo);
@@ -1099,9 +1112,11 @@ nfs_scan_commit(struct inode *inode, struct list_head *dst,
 	mutex_lock(&NFS_I(cinfo->inode)->commit_mutex);
 	if (atomic_long_read(&cinfo->mds->ncommit) > 0) {
 		const int max = INT_MAX;
+		int i;
 
-		ret = nfs_scan_commit_list(&cinfo->mds->list, dst,
-					   cinfo, max);
+		for (i = 0; i < NFS_COMMIT_BUCKETS; i++)
+			ret += nfs_scan_commit_list(&cinfo->mds->buckets[i],
+						    dst, cinfo, max - ret);
 		ret += pnfs_scan_commit_lists(inode, cinfo, max - ret);
 	}
 	mutex_unlock(&NFS_I(cinfo->inode)->commit_mutex);
@@ -308,7 +308,9 @@ nfsd_file_put(struct nfsd_file *nf)
 		return;
 	}
 
-	filemap_flush(nf->nf_file->f_mapping);
+	/* Read-only opens have nothing dirty to push */
+	if (nf->nf_may & NFSD_MAY_WRITE)
+		filemap_flush(nf->nf_file->f_mapping);
 	is_hashed = test_bit(NFSD_FILE_HASHED, &nf->nf_flags) != 0;
 	nfsd_file_put_noref(nf);
 	if (is_hashed)
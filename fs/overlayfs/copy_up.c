@@ -18,6 +18,7 @@
 #include <linux/fdtable.h>
 #include <linux/ratelimit.h>
 #include <linux/exportfs.h>
+#include <linux/fadvise.h>
 #include "overlayfs.h"
 
 #define OVL_COPY_UP_CHUNK_SIZE (1 << 20)
@@ -194,6 +195,16 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 			}
 		}
 
+		/*
+		 * Kick off readahead for the next chunk so the lower fs
+		 * reads it while we are busy writing this one to the
+		 * upper fs.  Advisory only; errors don't matter.
+		 */
+		if (len > this_len)
+			vfs_fadvise(old_file, old_pos + this_len,
+				    OVL_COPY_UP_CHUNK_SIZE,
+				    POSIX_FADV_WILLNEED);
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
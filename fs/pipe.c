@@ -36,6 +36,13 @@
  */
 unsigned int pipe_max_size = 1048576;
 
+/*
+ * The default size of a freshly created pipe. Can be set by root in
+ * /proc/sys/fs/pipe-default-size; unprivileged users are still clamped
+ * to pipe-max-size and the per-user page limits below.
+ */
+unsigned int pipe_default_size = PIPE_DEF_BUFFERS * PAGE_SIZE;
+
 /* Maximum allocatable pages per user. Hard limit is unset by default, soft
  * matches default values.
  */
@@ -782,7 +789,7 @@ static bool is_unprivileged_user(void)
 struct pipe_inode_info *alloc_pipe_info(void)
 {
 	struct pipe_inode_info *pipe;
-	unsigned long pipe_bufs = PIPE_DEF_BUFFERS;
+	unsigned long pipe_bufs = READ_ONCE(pipe_default_size) >> PAGE_SHIFT;
 	struct user_struct *user = get_current_user();
 	unsigned long user_bufs;
 	unsigned int max_size = READ_ONCE(pipe_max_size);
@@ -1187,7 +1194,7 @@ unsigned int round_pipe_size(unsigned long size)
  * Allocate a new array of pipe buffers and copy the info over. Returns the
  * pipe size if successful, or return -ERROR on error.
  */
-static long pipe_set_size(struct pipe_inode_info *pipe, unsigned long arg)
+long pipe_set_size(struct pipe_inode_info *pipe, unsigned long arg)
 {
 	struct pipe_buffer *bufs;
 	unsigned int size, nr_slots, head, tail, mask, n;
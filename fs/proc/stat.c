@@ -12,6 +12,7 @@
 #include <linux/time.h>
 #include <linux/irqnr.h>
 #include <linux/sched/cputime.h>
+#include <linux/seqlock.h>
 #include <linux/tick.h>
 
 #ifndef arch_irq_stat_cpu
@@ -104,20 +105,34 @@ static void show_all_irqs(struct seq_file *p)
 	show_irq_gap(p, nr_irqs - next);
 }
 
-static int show_stat(struct seq_file *p, void *v)
+/*
+ * Monitoring agents tend to hammer /proc/stat several times a second,
+ * and the aggregated "cpu" line walks every possible CPU's kcpustat on
+ * each read.  Cache the aggregation and refresh it at most once per
+ * tick: whoever finds the snapshot stale and wins the trylock redoes
+ * the walk, everybody else copies the cached snapshot lock-free under
+ * the seqcount.  The values a reader sees are thus at most one tick
+ * older than a fresh walk would produce, which is below the clock_t
+ * granularity the file reports anyway.
+ */
+struct stat_agg {
+	u64 cpustat[NR_STATS];
+	u64 sum;
+	u64 sum_softirq;
+	unsigned int per_softirq_sums[NR_SOFTIRQS];
+};
+
+static struct stat_agg stat_agg_cache;
+static bool stat_agg_valid;
+static unsigned long stat_agg_jiffies;
+static seqcount_t stat_agg_seq = SEQCNT_ZERO(stat_agg_seq);
+static DEFINE_SPINLOCK(stat_agg_lock);
+
+static void stat_agg_update(struct stat_agg *agg)
 {
 	int i, j;
-	u64 user, nice, system, idle, iowait, irq, softirq, steal;
-	u64 guest, guest_nice;
-	u64 sum = 0;
-	u64 sum_softirq = 0;
-	unsigned int per_softirq_sums[NR_SOFTIRQS] = {0};
-	struct timespec64 boottime;
 
-	user = nice = system = idle = iowait =
-		irq = softirq = steal = 0;
-	guest = guest_nice = 0;
-	getboottime64(&boottime);
+	memset(agg, 0, sizeof(*agg));
 
 	for_each_possible_cpu(i) {
 		struct kernel_cpustat kcpustat;
@@ -125,38 +140,96 @@ static int show_stat(struct seq_file *p, void *v)
 
 		kcpustat_cpu_fetch(&kcpustat, i);
 
-		user		+= cpustat[CPUTIME_USER];
-		nice		+= cpustat[CPUTIME_NICE];
-		system		+= cpustat[CPUTIME_SYSTEM];
-		idle		+= get_idle_time(&kcpustat, i);
-		iowait		+= get_iowait_time(&kcpustat, i);
-		irq		+= cpustat[CPUTIME_IRQ];
-		softirq		+= cpustat[CPUTIME_SOFTIRQ];
-		steal		+= cpustat[CPUTIME_STEAL];
-		guest		+= cpustat[CPUTIME_GUEST];
-		guest_nice	+= cpustat[CPUTIME_GUEST_NICE];
-		sum		+= kstat_cpu_irqs_sum(i);
-		sum		+= arch_irq_stat_cpu(i);
+		agg->cpustat[CPUTIME_USER]	+= cpustat[CPUTIME_USER];
+		agg->cpustat[CPUTIME_NICE]	+= cpustat[CPUTIME_NICE];
+		agg->cpustat[CPUTIME_SYSTEM]	+= cpustat[CPUTIME_SYSTEM];
+		agg->cpustat[CPUTIME_IDLE]	+= get_idle_time(&kcpustat, i);
+		agg->cpustat[CPUTIME_IOWAIT]	+= get_iowait_time(&kcpustat, i);
+		agg->cpustat[CPUTIME_IRQ]	+= cpustat[CPUTIME_IRQ];
+		agg->cpustat[CPUTIME_SOFTIRQ]	+= cpustat[CPUTIME_SOFTIRQ];
+		agg->cpustat[CPUTIME_STEAL]	+= cpustat[CPUTIME_STEAL];
+		agg->cpustat[CPUTIME_GUEST]	+= cpustat[CPUTIME_GUEST];
+		agg->cpustat[CPUTIME_GUEST_NICE] += cpustat[CPUTIME_GUEST_NICE];
+		agg->sum	+= kstat_cpu_irqs_sum(i);
+		agg->sum	+= arch_irq_stat_cpu(i);
 
 		for (j = 0; j < NR_SOFTIRQS; j++) {
 			unsigned int softirq_stat = kstat_softirqs_cpu(j, i);
 
-			per_softirq_sums[j] += softirq_stat;
-			sum_softirq += softirq_stat;
+			agg->per_softirq_sums[j] += softirq_stat;
+			agg->sum_softirq += softirq_stat;
+		}
+	}
+	agg->sum += arch_irq_stat();
+}
+
+static void stat_agg_fetch(struct stat_agg *agg)
+{
+	unsigned int seq;
+
+	/*
+	 * The !valid check is not just for the very first reads: jiffies
+	 * starts at INITIAL_JIFFIES, so a zero-initialized timestamp would
+	 * keep time_after() false until jiffies wraps past zero.
+	 */
+	if (!READ_ONCE(stat_agg_valid) ||
+	    time_after(jiffies, READ_ONCE(stat_agg_jiffies))) {
+		if (spin_trylock(&stat_agg_lock)) {
+			if (!stat_agg_valid ||
+			    time_after(jiffies, stat_agg_jiffies)) {
+				stat_agg_update(agg);
+				write_seqcount_begin(&stat_agg_seq);
+				stat_agg_cache = *agg;
+				write_seqcount_end(&stat_agg_seq);
+				WRITE_ONCE(stat_agg_jiffies, jiffies);
+				WRITE_ONCE(stat_agg_valid, true);
+			}
+			spin_unlock(&stat_agg_lock);
+		} else if (unlikely(!READ_ONCE(stat_agg_valid))) {
+			/*
+			 * Never let the very first readers copy out the
+			 * zeroed cache - wait for the initial walk.
+			 */
+			spin_lock(&stat_agg_lock);
+			spin_unlock(&stat_agg_lock);
 		}
 	}
-	sum += arch_irq_stat();
-
-	seq_put_decimal_ull(p, "cpu  ", nsec_to_clock_t(user));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(nice));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(system));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(idle));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(iowait));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(irq));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(softirq));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(steal));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(guest));
-	seq_put_decimal_ull(p, " ", nsec_to_clock_t(guest_nice));
+
+	do {
+		seq = read_seqcount_begin(&stat_agg_seq);
+		*agg = stat_agg_cache;
+	} while (read_seqcount_retry(&stat_agg_seq, seq));
+}
+
+static int show_stat(struct seq_file *p, void *v)
+{
+	int i;
+	u64 user, nice, system, idle, iowait, irq, softirq, steal;
+	u64 guest, guest_nice;
+	struct stat_agg agg;
+	struct timespec64 boottime;
+
+	getboottime64(&boottime);
+
+	stat_agg_fetch(&agg);
+
+	seq_put_decimal_ull(p, "cpu  ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_USER]));
+	seq_put_decimal_ull(p, " ", nsec_to_clock_t(agg.cpustat[CPUTIME_NICE]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_SYSTEM]));
+	seq_put_decimal_ull(p, " ", nsec_to_clock_t(agg.cpustat[CPUTIME_IDLE]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_IOWAIT]));
+	seq_put_decimal_ull(p, " ", nsec_to_clock_t(agg.cpustat[CPUTIME_IRQ]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_SOFTIRQ]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_STEAL]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_GUEST]));
+	seq_put_decimal_ull(p, " ",
+			    nsec_to_clock_t(agg.cpustat[CPUTIME_GUEST_NICE]));
 	seq_putc(p, '\n');
 
 	for_each_online_cpu(i) {
@@ -189,7 +262,7 @@ static int show_stat(struct seq_file *p, void *v)
 		seq_put_decimal_ull(p, " ", nsec_to_clock_t(guest_nice));
 		seq_putc(p, '\n');
 	}
-	seq_put_decimal_ull(p, "intr ", (unsigned long long)sum);
+	seq_put_decimal_ull(p, "intr ", (unsigned long long)agg.sum);
 
 	show_all_irqs(p);
 
@@ -205,10 +278,10 @@ static int show_stat(struct seq_file *p, void *v)
 		nr_running(),
 		nr_iowait());
 
-	seq_put_decimal_ull(p, "softirq ", (unsigned long long)sum_softirq);
+	seq_put_decimal_ull(p, "softirq ", (unsigned long long)agg.sum_softirq);
 
 	for (i = 0; i < NR_SOFTIRQS; i++)
-		seq_put_decimal_ull(p, " ", per_softirq_sums[i]);
+		seq_put_decimal_ull(p, " ", agg.per_softirq_sums[i]);
 	seq_putc(p, '\n');
 
 	return 0;
@@ -20,6 +20,7 @@
 #include <linux/compat.h>
 #include <linux/mount.h>
 #include <linux/fs.h>
+#include <linux/workqueue.h>
 #include "internal.h"
 
 #include <linux/uaccess.h>
@@ -1642,12 +1643,118 @@ COMPAT_SYSCALL_DEFINE4(sendfile64, int, out_fd, int, in_fd,
  * failure.
  */
 
+/* Cap on workers for one generic copy, and the least work worth a worker */
+#define COPY_RANGE_MAX_WORKERS	4
+#define COPY_RANGE_MIN_CHUNK	(8 * 1024 * 1024)
+
+struct copy_range_work {
+	struct work_struct	work;
+	struct file		*file_in;
+	struct file		*file_out;
+	loff_t			pos_in;
+	loff_t			pos_out;
+	size_t			len;
+	ssize_t			ret;
+};
+
+static void copy_range_work_fn(struct work_struct *work)
+{
+	struct copy_range_work *crw = container_of(work,
+						struct copy_range_work, work);
+	loff_t pos_in = crw->pos_in;
+	loff_t pos_out = crw->pos_out;
+	size_t left = crw->len;
+	ssize_t ret = 0;
+
+	while (left) {
+		size_t chunk = min_t(size_t, left, MAX_RW_COUNT);
+
+		ret = do_splice_direct(crw->file_in, &pos_in, crw->file_out,
+				       &pos_out, chunk, 0);
+		if (ret <= 0)
+			break;
+		left -= ret;
+		/* a short copy means the rest is not there (yet), stop */
+		if (ret < chunk)
+			break;
+	}
+
+	if (left < crw->len)
+		crw->ret = crw->len - left;
+	else
+		crw->ret = ret;
+}
+
 ssize_t generic_copy_file_range(struct file *file_in, loff_t pos_in,
 				struct file *file_out, loff_t pos_out,
 				size_t len, unsigned int flags)
 {
-	return do_splice_direct(file_in, &pos_in, file_out, &pos_out,
-				len > MAX_RW_COUNT ? MAX_RW_COUNT : len, 0);
+	struct copy_range_work *crw;
+	ssize_t copied = 0;
+	size_t split;
+	int i, nr;
+
+	if (len > MAX_RW_COUNT)
+		len = MAX_RW_COUNT;
+
+	/* Small copies are not worth the worker setup */
+	nr = min_t(int, COPY_RANGE_MAX_WORKERS,
+		   len / COPY_RANGE_MIN_CHUNK);
+	if (nr < 2)
+		return do_splice_direct(file_in, &pos_in, file_out, &pos_out,
+					len, 0);
+
+	crw = kcalloc(nr, sizeof(*crw), GFP_KERNEL);
+	if (!crw)
+		return do_splice_direct(file_in, &pos_in, file_out, &pos_out,
+					len, 0);
+
+	/*
+	 * Split the range into one contiguous subrange per worker. Each
+	 * worker copies its subrange sequentially, so plain sequential
+	 * readahead covers it, and the workers overlap each other's page
+	 * cache fills and writeback. The output side still serializes on
+	 * the inode lock per write, which is what bounds the useful
+	 * worker count.
+	 */
+	split = round_up(DIV_ROUND_UP(len, nr), PAGE_SIZE);
+	for (i = 0; i < nr; i++) {
+		size_t chunk = min_t(size_t, split, len - i * split);
+
+		INIT_WORK(&crw[i].work, copy_range_work_fn);
+		crw[i].file_in = file_in;
+		crw[i].file_out = file_out;
+		crw[i].pos_in = pos_in + i * split;
+		crw[i].pos_out = pos_out + i * split;
+		crw[i].len = chunk;
+		queue_work(system_unbound_wq, &crw[i].work);
+		if (chunk < split) {
+			nr = i + 1;
+			break;
+		}
+	}
+
+	/*
+	 * Collect in file order and stop at the first hole, so the result
+	 * is the contiguous length copied from the start of the range -
+	 * anything a later worker wrote past a hole is simply recopied
+	 * when the caller retries the remainder.
+	 */
+	for (i = 0; i < nr; i++)
+		flush_work(&crw[i].work);
+	for (i = 0; i < nr; i++) {
+		if (crw[i].ret < 0) {
+			if (!copied)
+				copied = crw[i].ret;
+			break;
+		}
+		copied += crw[i].ret;
+		if (crw[i].ret < crw[i].len)
+			break;
+	}
+
+	kfree(crw);
+	return copied;
 }
 EXPORT_SYMBOL(generic_copy_file_range);
 
@@ -1664,10 +1771,22 @@ static ssize_t do_copy_file_range(struct file *file_in, loff_t pos_in,
 	 * using the same ->copy_file_range() function pointer.
 	 */
 	if (file_out->f_op->copy_file_range &&
-	    file_out->f_op->copy_file_range == file_in->f_op->copy_file_range)
-		return file_out->f_op->copy_file_range(file_in, pos_in,
-						       file_out, pos_out,
-						       len, flags);
+	    file_out->f_op->copy_file_range == file_in->f_op->copy_file_range) {
+		ssize_t ret;
+
+		ret = file_out->f_op->copy_file_range(file_in, pos_in,
+						      file_out, pos_out,
+						      len, flags);
+		/*
+		 * The filesystem may decline the range (or this combination
+		 * of files) entirely; in that case fall through and copy
+		 * through the page cache. A short positive return is passed
+		 * up as-is, the caller retries the remainder and the
+		 * filesystem gets to offload as much of it as it can.
+		 */
+		if (ret != -EOPNOTSUPP && ret != -EXDEV)
+			return ret;
+	}
 
 	return generic_copy_file_range(file_in, pos_in, file_out, pos_out, len,
 				       flags);
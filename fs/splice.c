@@ -943,6 +943,22 @@ ssize_t splice_direct_to_actor(struct file *in, struct splice_desc *sd,
 		current->splice_pipe = pipe;
 	}
 
+	/*
+	 * The internal pipe caps how much we move per read/write cycle.
+	 * For transfers larger than its current capacity, try to grow the
+	 * ring up to pipe-max-size so sendfile() and friends shuffle more
+	 * pages per iteration. This is best effort; if the resize fails
+	 * we simply keep the current size. The grown ring stays cached in
+	 * the task like the pipe itself.
+	 */
+	if (sd->total_len > (size_t)pipe->max_usage << PAGE_SHIFT) {
+		unsigned int max_size = READ_ONCE(pipe_max_size);
+
+		if ((size_t)pipe->max_usage << PAGE_SHIFT < max_size)
+			pipe_set_size(pipe, min_t(size_t, sd->total_len,
+						  max_size));
+	}
+
 	/*
 	 * Do the splice.
 	 */
@@ -180,6 +180,7 @@ static void destroy_unused_super(struct super_block *s)
 	up_write(&s->s_umount);
 	list_lru_destroy(&s->s_dentry_lru);
 	list_lru_destroy(&s->s_inode_lru);
+	percpu_counter_destroy(&s->s_ndentry_neg);
 	security_sb_free(s);
 	put_user_ns(s->s_user_ns);
 	kfree(s->s_subtype);
@@ -273,6 +274,9 @@ static struct super_block *alloc_super(struct file_system_type *type, int flags,
 		goto fail;
 	if (list_lru_init_memcg(&s->s_inode_lru, &s->s_shrink))
 		goto fail;
+	if (percpu_counter_init(&s->s_ndentry_neg, 0, GFP_KERNEL))
+		goto fail;
+	INIT_WORK(&s->s_prune_neg_work, prune_negative_dentries);
 	return s;
 
 fail:
@@ -332,6 +336,11 @@ void deactivate_locked_super(struct super_block *s)
 	if (atomic_dec_and_test(&s->s_active)) {
 		cleancache_invalidate_fs(s);
 		unregister_shrinker(&s->s_shrink);
+		/*
+		 * The pruner backs off when it cannot get s_umount, which we
+		 * hold, so this cannot deadlock.
+		 */
+		cancel_work_sync(&s->s_prune_neg_work);
 		fs->kill_sb(s);
 
 		/*
@@ -341,6 +350,7 @@ void deactivate_locked_super(struct super_block *s)
 		 */
 		list_lru_destroy(&s->s_dentry_lru);
 		list_lru_destroy(&s->s_inode_lru);
+		percpu_counter_destroy(&s->s_ndentry_neg);
 
 		put_filesystem(fs);
 		put_super(s);
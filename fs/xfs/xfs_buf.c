@@ -549,6 +549,137 @@ xfs_buf_hash_destroy(
 	rhashtable_destroy(&pag->pag_buf_hash);
 }
 
+/*
+ * Per-cpu lookaside cache of recently found buffers.
+ *
+ * Metadata hot spots - the AGF/AGI/AGFL headers of busy AGs above all - are
+ * looked up through the perag hash over and over again, and every one of
+ * those lookups takes the shared pag_buf_lock. Keep a small per-cpu array of
+ * referenced buffers so repeat lookups stay entirely CPU-local. The per-cpu
+ * spinlock is never contended in the fast path; it exists so that another
+ * CPU can safely empty the cache at unmount time and under memory pressure.
+ *
+ * The cached reference pins the buffer, so entries carry an expiry time and
+ * are aged out by the buftarg shrinker once they go cold. Stale buffers may
+ * have been replaced in the hash behind our back, so hits on XBF_STALE
+ * buffers are not taken from here - the caller falls back to the locked
+ * perag lookup which resolves that race under pag_buf_lock.
+ */
+#define XFS_BT_LOOKASIDE_SLOTS	8
+#define XFS_BT_LOOKASIDE_TTL	(5 * HZ)
+
+struct xfs_buf_lookaside {
+	spinlock_t		lock;
+	unsigned int		next;	/* round robin eviction cursor */
+	struct xfs_buf		*bufs[XFS_BT_LOOKASIDE_SLOTS];
+	unsigned long		expire[XFS_BT_LOOKASIDE_SLOTS];
+};
+
+static struct xfs_buf *
+xfs_buftarg_lookaside_find(
+	struct xfs_buftarg	*btp,
+	struct xfs_buf_map	*cmap)
+{
+	struct xfs_buf_lookaside *la;
+	struct xfs_buf		*bp = NULL;
+	int			i;
+
+	la = get_cpu_ptr(btp->bt_lookaside);
+	spin_lock(&la->lock);
+	for (i = 0; i < XFS_BT_LOOKASIDE_SLOTS; i++) {
+		struct xfs_buf	*cbp = la->bufs[i];
+
+		if (!cbp || cbp->b_bn != cmap->bm_bn ||
+		    cbp->b_length != cmap->bm_len)
+			continue;
+		la->expire[i] = jiffies + XFS_BT_LOOKASIDE_TTL;
+		xfs_buf_hold(cbp);
+		bp = cbp;
+		break;
+	}
+	spin_unlock(&la->lock);
+	put_cpu_ptr(btp->bt_lookaside);
+	return bp;
+}
+
+static void
+xfs_buftarg_lookaside_insert(
+	struct xfs_buftarg	*btp,
+	struct xfs_buf		*bp)
+{
+	struct xfs_buf_lookaside *la;
+	struct xfs_buf		*victim;
+	int			slot;
+	int			i;
+
+	/* the cache is keyed on a single contiguous extent */
+	if (bp->b_map_count != 1)
+		return;
+
+	la = get_cpu_ptr(btp->bt_lookaside);
+	spin_lock(&la->lock);
+	slot = la->next;
+	for (i = 0; i < XFS_BT_LOOKASIDE_SLOTS; i++) {
+		if (la->bufs[i] == bp) {
+			/* already cached, just refresh the expiry */
+			la->expire[i] = jiffies + XFS_BT_LOOKASIDE_TTL;
+			spin_unlock(&la->lock);
+			put_cpu_ptr(btp->bt_lookaside);
+			return;
+		}
+		/* prefer replacing entries that have gone cold */
+		if (la->bufs[i] && time_after(jiffies, la->expire[i]))
+			slot = i;
+	}
+	victim = la->bufs[slot];
+	xfs_buf_hold(bp);
+	la->bufs[slot] = bp;
+	la->expire[slot] = jiffies + XFS_BT_LOOKASIDE_TTL;
+	if (slot == la->next)
+		la->next = (slot + 1) % XFS_BT_LOOKASIDE_SLOTS;
+	spin_unlock(&la->lock);
+	put_cpu_ptr(btp->bt_lookaside);
+
+	if (victim)
+		xfs_buf_rele(victim);
+}
+
+/*
+ * Drop cached references on all CPUs. If @age_only is set, only entries
+ * whose expiry has passed are dropped; this is what allows the shrinker to
+ * reclaim buffers whose only remaining reference is a cold lookaside entry.
+ */
+static void
+xfs_buftarg_lookaside_flush(
+	struct xfs_buftarg	*btp,
+	bool			age_only)
+{
+	int			cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct xfs_buf_lookaside *la =
+				per_cpu_ptr(btp->bt_lookaside, cpu);
+		struct xfs_buf	*bufs[XFS_BT_LOOKASIDE_SLOTS];
+		int		i;
+
+		spin_lock(&la->lock);
+		for (i = 0; i < XFS_BT_LOOKASIDE_SLOTS; i++) {
+			bufs[i] = la->bufs[i];
+			if (!bufs[i] ||
+			    (age_only && time_before(jiffies, la->expire[i]))) {
+				bufs[i] = NULL;
+				continue;
+			}
+			la->bufs[i] = NULL;
+		}
+		spin_unlock(&la->lock);
+
+		for (i = 0; i < XFS_BT_LOOKASIDE_SLOTS; i++)
+			if (bufs[i])
+				xfs_buf_rele(bufs[i]);
+	}
+}
+
 /*
  * Look up a buffer in the buffer cache and return it referenced and locked
  * in @found_bp.
@@ -604,6 +735,37 @@ xfs_buf_find(
 		return -EFSCORRUPTED;
 	}
 
+	/* try the cpu-local lookaside before the full hash walk */
+	if (!new_bp) {
+		bp = xfs_buftarg_lookaside_find(btp, &cmap);
+		if (bp) {
+			if (!xfs_buf_trylock(bp)) {
+				if (flags & XBF_TRYLOCK) {
+					xfs_buf_rele(bp);
+					XFS_STATS_INC(btp->bt_mount,
+							xb_busy_locked);
+					return -EAGAIN;
+				}
+				xfs_buf_lock(bp);
+				XFS_STATS_INC(btp->bt_mount,
+						xb_get_locked_waited);
+			}
+			if (!(bp->b_flags & XBF_STALE)) {
+				trace_xfs_buf_find(bp, flags, _RET_IP_);
+				XFS_STATS_INC(btp->bt_mount, xb_get_locked);
+				*found_bp = bp;
+				return 0;
+			}
+			/*
+			 * Stale buffers may already have been replaced in the
+			 * hash, so they must be found through the locked
+			 * lookup below to avoid aliasing the replacement.
+			 */
+			xfs_buf_unlock(bp);
+			xfs_buf_rele(bp);
+		}
+	}
+
 	pag = xfs_perag_get(btp->bt_mount,
 			    xfs_daddr_to_agno(btp->bt_mount, cmap.bm_bn));
 
@@ -657,6 +819,12 @@ found:
 		bp->b_ops = NULL;
 	}
 
+	/*
+	 * A second lookup through the hash means the buffer is hot enough to
+	 * be worth a lookaside slot.
+	 */
+	xfs_buftarg_lookaside_insert(btp, bp);
+
 	trace_xfs_buf_find(bp, flags, _RET_IP_);
 	XFS_STATS_INC(btp->bt_mount, xb_get_locked);
 	*found_bp = bp;
@@ -1618,6 +1786,12 @@ xfs_wait_buftarg(
 	LIST_HEAD(dispose);
 	int loop = 0;
 
+	/*
+	 * Drop the lookaside references first, otherwise cached buffers are
+	 * never released and so never make the LRU list we drain below.
+	 */
+	xfs_buftarg_lookaside_flush(btp, false);
+
 	/*
 	 * First wait on the buftarg I/O count for all in-flight buffers to be
 	 * released. This is critical as new buffers do not make the LRU until
@@ -1699,6 +1873,9 @@ xfs_buftarg_shrink_scan(
 	LIST_HEAD(dispose);
 	unsigned long		freed;
 
+	/* release cold lookaside references so their buffers can be freed */
+	xfs_buftarg_lookaside_flush(btp, true);
+
 	freed = list_lru_shrink_walk(&btp->bt_lru, sc,
 				     xfs_buftarg_isolate, &dispose);
 
@@ -1729,6 +1906,7 @@ xfs_free_buftarg(
 	unregister_shrinker(&btp->bt_shrinker);
 	ASSERT(percpu_counter_sum(&btp->bt_io_count) == 0);
 	percpu_counter_destroy(&btp->bt_io_count);
+	free_percpu(btp->bt_lookaside);
 	list_lru_destroy(&btp->bt_lru);
 
 	xfs_blkdev_issue_flush(btp);
@@ -1779,6 +1957,7 @@ xfs_alloc_buftarg(
 	struct dax_device	*dax_dev)
 {
 	xfs_buftarg_t		*btp;
+	int			cpu;
 
 	btp = kmem_zalloc(sizeof(*btp), KM_NOFS);
 
@@ -1790,8 +1969,14 @@ xfs_alloc_buftarg(
 	if (xfs_setsize_buftarg_early(btp, bdev))
 		goto error_free;
 
-	if (list_lru_init(&btp->bt_lru))
+	btp->bt_lookaside = alloc_percpu(struct xfs_buf_lookaside);
+	if (!btp->bt_lookaside)
 		goto error_free;
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(btp->bt_lookaside, cpu)->lock);
+
+	if (list_lru_init(&btp->bt_lru))
+		goto error_lookaside;
 
 	if (percpu_counter_init(&btp->bt_io_count, 0, GFP_KERNEL))
 		goto error_lru;
@@ -1808,6 +1993,8 @@ error_pcpu:
 	percpu_counter_destroy(&btp->bt_io_count);
 error_lru:
 	list_lru_destroy(&btp->bt_lru);
+error_lookaside:
+	free_percpu(btp->bt_lookaside);
 error_free:
 	kmem_free(btp);
 	return NULL;
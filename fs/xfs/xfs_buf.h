@@ -76,6 +76,8 @@ typedef unsigned int xfs_buf_flags_t;
  * The latter is derived from the underlying device, and controls direct IO
  * alignment constraints.
  */
+struct xfs_buf_lookaside;
+
 typedef struct xfs_buftarg {
 	dev_t			bt_dev;
 	struct block_device	*bt_bdev;
@@ -86,6 +88,9 @@ typedef struct xfs_buftarg {
 	size_t			bt_logical_sectorsize;
 	size_t			bt_logical_sectormask;
 
+	/* per-cpu cache of recently found buffers */
+	struct xfs_buf_lookaside __percpu *bt_lookaside;
+
 	/* LRU control structures */
 	struct shrinker		bt_shrinker;
 	struct list_lru		bt_lru;
@@ -17,6 +17,8 @@
 #include "xfs_log_priv.h"
 #include "xfs_trace.h"
 
+#include <linux/list_sort.h>
+
 struct workqueue_struct *xfs_discard_wq;
 
 /*
@@ -391,6 +393,8 @@ xlog_cil_insert_items(
 	struct xfs_cil		*cil = log->l_cilp;
 	struct xfs_cil_ctx	*ctx = cil->xc_ctx;
 	struct xfs_log_item	*lip;
+	struct xlog_cil_pcp	*cilpcp;
+	unsigned int		order;
 	int			len = 0;
 	int			diff_iovecs = 0;
 	int			iclog_space;
@@ -404,6 +408,16 @@ xlog_cil_insert_items(
 	 */
 	xlog_cil_insert_format_items(log, tp, &len, &diff_iovecs);
 
+	/*
+	 * Each transaction takes a single order ID covering all the items it
+	 * commits. The items are spread over the per-cpu CIL lists, so the
+	 * order ID is what restores global commit ordering when the lists are
+	 * merged and sorted at push time. A relogged item just takes on the
+	 * new transaction's ID, which is equivalent to the move-to-tail
+	 * behaviour of the old single list.
+	 */
+	order = atomic_inc_return(&ctx->order_id);
+
 	spin_lock(&cil->xc_cil_lock);
 
 	/* account for space used by new iovec headers  */
@@ -458,27 +472,29 @@ xlog_cil_insert_items(
 		xlog_print_trans(tp);
 	}
 
+	spin_unlock(&cil->xc_cil_lock);
+
 	/*
-	 * Now (re-)position everything modified at the tail of the CIL.
-	 * We do this here so we only need to take the CIL lock once during
-	 * the transaction commit.
+	 * Now stage everything modified on the local CPU's CIL list. New
+	 * insertions are serialised against the push by xc_ctx_lock, so the
+	 * push cannot empty the per-cpu lists underneath us and we don't
+	 * need xc_cil_lock here. Items already resident in the CIL just get
+	 * the new order ID and stay on whatever list they were staged on.
 	 */
+	cilpcp = get_cpu_ptr(cil->xc_pcp);
 	list_for_each_entry(lip, &tp->t_items, li_trans) {
 
 		/* Skip items which aren't dirty in this transaction. */
 		if (!test_bit(XFS_LI_DIRTY, &lip->li_flags))
 			continue;
 
-		/*
-		 * Only move the item if it isn't already at the tail. This is
-		 * to prevent a transient list_empty() state when reinserting
-		 * an item that is already the only item in the CIL.
-		 */
-		if (!list_is_last(&lip->li_cil, &cil->xc_cil))
-			list_move_tail(&lip->li_cil, &cil->xc_cil);
+		lip->li_order_id = order;
+		if (!list_empty(&lip->li_cil))
+			continue;
+		list_add_tail(&lip->li_cil, &cilpcp->log_items);
+		atomic_inc(&cil->xc_cil_items);
 	}
-
-	spin_unlock(&cil->xc_cil_lock);
+	put_cpu_ptr(cil->xc_pcp);
 
 	if (tp->t_ticket->t_curr_res < 0)
 		xfs_force_shutdown(log->l_mp, SHUTDOWN_LOG_IO_ERROR);
@@ -625,6 +641,23 @@ xlog_cil_process_committed(
 	}
 }
 
+/*
+ * Order the merged per-cpu CIL lists by the order ID assigned at insertion
+ * time. list_sort() is stable, so items sharing an order ID (i.e. committed
+ * by the same transaction) keep their relative staging order.
+ */
+static int
+xlog_cil_order_cmp(
+	void			*priv,
+	struct list_head	*a,
+	struct list_head	*b)
+{
+	struct xfs_log_item	*l1 = container_of(a, struct xfs_log_item, li_cil);
+	struct xfs_log_item	*l2 = container_of(b, struct xfs_log_item, li_cil);
+
+	return l1->li_order_id > l2->li_order_id;
+}
+
 /*
  * Push the Committed Item List to the log. If @push_seq flag is zero, then it
  * is a background flush and so we can chose to ignore it. Otherwise, if the
@@ -656,6 +689,7 @@ xlog_cil_push(
 	struct xfs_log_vec	lvhdr = { NULL };
 	xfs_lsn_t		commit_lsn;
 	xfs_lsn_t		push_seq;
+	int			cpu;
 
 	if (!cil)
 		return 0;
@@ -666,6 +700,19 @@ xlog_cil_push(
 	down_write(&cil->xc_ctx_lock);
 	ctx = cil->xc_ctx;
 
+	/*
+	 * Merge the per-cpu staging lists into the global CIL list. We hold
+	 * xc_ctx_lock exclusively, so transaction commit cannot add to the
+	 * lists behind our back and no locking is needed. The merged list is
+	 * only coarsely ordered at this point; it is sorted into commit order
+	 * once we know the push is going ahead.
+	 */
+	for_each_possible_cpu(cpu) {
+		struct xlog_cil_pcp	*cilpcp = per_cpu_ptr(cil->xc_pcp, cpu);
+
+		list_splice_tail_init(&cilpcp->log_items, &cil->xc_cil);
+	}
+
 	spin_lock(&cil->xc_push_lock);
 	push_seq = cil->xc_push_seq;
 	ASSERT(push_seq <= ctx->sequence);
@@ -715,6 +762,14 @@ xlog_cil_push(
 	list_add(&ctx->committing, &cil->xc_committing);
 	spin_unlock(&cil->xc_push_lock);
 
+	/*
+	 * The per-cpu lists were spliced in arrival order per CPU, not
+	 * globally. Sort by order ID to restore the commit ordering the old
+	 * single-list insertion provided - replay depends on items relogged
+	 * by later transactions being formatted after the earlier copies.
+	 */
+	list_sort(NULL, &cil->xc_cil, xlog_cil_order_cmp);
+
 	/*
 	 * pull all the log vectors off the items in the CIL, and
 	 * remove the items from the CIL. We don't need the CIL lock
@@ -729,6 +784,8 @@ xlog_cil_push(
 		item = list_first_entry(&cil->xc_cil,
 					struct xfs_log_item, li_cil);
 		list_del_init(&item->li_cil);
+		item->li_order_id = 0;
+		atomic_dec(&cil->xc_cil_items);
 		if (!ctx->lv_chain)
 			ctx->lv_chain = item->li_lv;
 		else
@@ -908,7 +965,7 @@ xlog_cil_push_background(
 	 * The cil won't be empty because we are called while holding the
 	 * context lock so whatever we added to the CIL will still be there
 	 */
-	ASSERT(!list_empty(&cil->xc_cil));
+	ASSERT(atomic_read(&cil->xc_cil_items) != 0);
 
 	/*
 	 * don't do a background push if we haven't used up all the
@@ -952,7 +1009,7 @@ xlog_cil_push_now(
 	 * there's no work we need to do.
 	 */
 	spin_lock(&cil->xc_push_lock);
-	if (list_empty(&cil->xc_cil) || push_seq <= cil->xc_push_seq) {
+	if (!atomic_read(&cil->xc_cil_items) || push_seq <= cil->xc_push_seq) {
 		spin_unlock(&cil->xc_push_lock);
 		return;
 	}
@@ -970,7 +1027,7 @@ xlog_cil_empty(
 	bool		empty = false;
 
 	spin_lock(&cil->xc_push_lock);
-	if (list_empty(&cil->xc_cil))
+	if (!atomic_read(&cil->xc_cil_items))
 		empty = true;
 	spin_unlock(&cil->xc_push_lock);
 	return empty;
@@ -1119,7 +1176,7 @@ restart:
 	 * we would have found the context on the committing list.
 	 */
 	if (sequence == cil->xc_current_sequence &&
-	    !list_empty(&cil->xc_cil)) {
+	    atomic_read(&cil->xc_cil_items)) {
 		spin_unlock(&cil->xc_push_lock);
 		goto restart;
 	}
@@ -1178,13 +1235,23 @@ xlog_cil_init(
 {
 	struct xfs_cil	*cil;
 	struct xfs_cil_ctx *ctx;
+	int		cpu;
 
 	cil = kmem_zalloc(sizeof(*cil), KM_MAYFAIL);
 	if (!cil)
 		return -ENOMEM;
 
+	cil->xc_pcp = alloc_percpu(struct xlog_cil_pcp);
+	if (!cil->xc_pcp) {
+		kmem_free(cil);
+		return -ENOMEM;
+	}
+	for_each_possible_cpu(cpu)
+		INIT_LIST_HEAD(&per_cpu_ptr(cil->xc_pcp, cpu)->log_items);
+
 	ctx = kmem_zalloc(sizeof(*ctx), KM_MAYFAIL);
 	if (!ctx) {
+		free_percpu(cil->xc_pcp);
 		kmem_free(cil);
 		return -ENOMEM;
 	}
@@ -1219,7 +1286,8 @@ xlog_cil_destroy(
 		kmem_free(log->l_cilp->xc_ctx);
 	}
 
-	ASSERT(list_empty(&log->l_cilp->xc_cil));
+	ASSERT(atomic_read(&log->l_cilp->xc_cil_items) == 0);
+	free_percpu(log->l_cilp->xc_pcp);
 	kmem_free(log->l_cilp);
 }
 
@@ -243,6 +243,17 @@ struct xfs_cil_ctx {
 	struct list_head	iclog_entry;
 	struct list_head	committing;	/* ctx committing list */
 	struct work_struct	discard_endio_work;
+	atomic_t		order_id;	/* item insertion order */
+};
+
+/*
+ * Per-cpu CIL tracking items. Transaction commit stages dirty log items on
+ * the local CPU's list to avoid serialising every commit on a single global
+ * list lock; the lists are merged and sorted back into commit order when the
+ * checkpoint is pushed.
+ */
+struct xlog_cil_pcp {
+	struct list_head	log_items;
 };
 
 /*
@@ -265,6 +276,8 @@ struct xfs_cil {
 	struct xlog		*xc_log;
 	struct list_head	xc_cil;
 	spinlock_t		xc_cil_lock;
+	struct xlog_cil_pcp __percpu *xc_pcp;
+	atomic_t		xc_cil_items;
 
 	struct rw_semaphore	xc_ctx_lock ____cacheline_aligned_in_smp;
 	struct xfs_cil_ctx	*xc_ctx;
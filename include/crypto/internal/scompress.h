@@ -16,6 +16,23 @@ struct crypto_scomp {
 	struct crypto_tfm base;
 };
 
+/**
+ * struct scomp_batch_entry - one buffer of a batched (de)compression
+ *
+ * @src:	input buffer
+ * @dst:	output buffer
+ * @slen:	number of input bytes
+ * @dlen:	capacity of @dst on entry, bytes produced on return
+ * @ret:	per-entry completion status
+ */
+struct scomp_batch_entry {
+	const u8	*src;
+	u8		*dst;
+	unsigned int	slen;
+	unsigned int	dlen;
+	int		ret;
+};
+
 /**
  * struct scomp_alg - synchronous compression algorithm
  *
@@ -23,6 +40,13 @@ struct crypto_scomp {
  * @free_ctx:	Function frees context allocated with alloc_ctx
  * @compress:	Function performs a compress operation
  * @decompress:	Function performs a de-compress operation
+ * @compress_batch:	Optional: compress several buffers in one call so the
+ *			algorithm can reuse dictionaries or coding tables
+ *			across them.  Falls back to per-entry @compress.
+ * @decompress_batch:	Optional: batched counterpart of @decompress
+ * @scratch_size:	Optional: largest request the algorithm needs the
+ *			per-cpu scratch buffers to hold; 0 selects the
+ *			default SCOMP_SCRATCH_SIZE
  * @base:	Common crypto API algorithm data structure
  */
 struct scomp_alg {
@@ -34,6 +58,13 @@ struct scomp_alg {
 	int (*decompress)(struct crypto_scomp *tfm, const u8 *src,
 			  unsigned int slen, u8 *dst, unsigned int *dlen,
 			  void *ctx);
+	int (*compress_batch)(struct crypto_scomp *tfm,
+			      struct scomp_batch_entry *entries,
+			      unsigned int nr, void *ctx);
+	int (*decompress_batch)(struct crypto_scomp *tfm,
+				struct scomp_batch_entry *entries,
+				unsigned int nr, void *ctx);
+	unsigned int scratch_size;
 	struct crypto_alg base;
 };
 
@@ -89,6 +120,78 @@ static inline int crypto_scomp_decompress(struct crypto_scomp *tfm,
 						 ctx);
 }
 
+/**
+ * crypto_scomp_compress_batch() -- Compress several buffers in one call
+ *
+ * Algorithms providing @compress_batch get all entries at once and can
+ * amortize dictionary or coding table setup across them; for the rest
+ * the entries are compressed one by one.  Each entry carries its own
+ * result in @ret.
+ *
+ * @tfm:	synchronous compression tfm
+ * @entries:	buffers to compress
+ * @nr:		number of entries
+ * @ctx:	algorithm specific context, from crypto_scomp_alloc_ctx()
+ *
+ * Return: zero if every entry succeeded; the first entry error otherwise
+ */
+static inline int crypto_scomp_compress_batch(struct crypto_scomp *tfm,
+					      struct scomp_batch_entry *entries,
+					      unsigned int nr, void *ctx)
+{
+	struct scomp_alg *alg = crypto_scomp_alg(tfm);
+	unsigned int i;
+	int ret = 0;
+
+	if (alg->compress_batch)
+		return alg->compress_batch(tfm, entries, nr, ctx);
+
+	for (i = 0; i < nr; i++) {
+		struct scomp_batch_entry *entry = &entries[i];
+
+		entry->ret = alg->compress(tfm, entry->src, entry->slen,
+					   entry->dst, &entry->dlen, ctx);
+		if (entry->ret && !ret)
+			ret = entry->ret;
+	}
+	return ret;
+}
+
+/**
+ * crypto_scomp_decompress_batch() -- Decompress several buffers in one call
+ *
+ * Batched counterpart of crypto_scomp_decompress(), see
+ * crypto_scomp_compress_batch() for the calling convention.
+ *
+ * @tfm:	synchronous compression tfm
+ * @entries:	buffers to decompress
+ * @nr:		number of entries
+ * @ctx:	algorithm specific context, from crypto_scomp_alloc_ctx()
+ *
+ * Return: zero if every entry succeeded; the first entry error otherwise
+ */
+static inline int crypto_scomp_decompress_batch(struct crypto_scomp *tfm,
+						struct scomp_batch_entry *entries,
+						unsigned int nr, void *ctx)
+{
+	struct scomp_alg *alg = crypto_scomp_alg(tfm);
+	unsigned int i;
+	int ret = 0;
+
+	if (alg->decompress_batch)
+		return alg->decompress_batch(tfm, entries, nr, ctx);
+
+	for (i = 0; i < nr; i++) {
+		struct scomp_batch_entry *entry = &entries[i];
+
+		entry->ret = alg->decompress(tfm, entry->src, entry->slen,
+					     entry->dst, &entry->dlen, ctx);
+		if (entry->ret && !ret)
+			ret = entry->ret;
+	}
+	return ret;
+}
+
 int crypto_init_scomp_ops_async(struct crypto_tfm *tfm);
 struct acomp_req *crypto_acomp_scomp_alloc_ctx(struct acomp_req *req);
 void crypto_acomp_scomp_free_ctx(struct acomp_req *req);
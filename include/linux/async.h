@@ -18,6 +18,15 @@ typedef void (*async_func_t) (void *data, async_cookie_t cookie);
 struct async_domain {
 	struct list_head pending;
 	unsigned registered:1;
+	/*
+	 * Maximum number of entries of this domain executing at once, 0
+	 * means unlimited.  Entries over the limit sit on @throttled and
+	 * are kicked off as running ones complete; they stay visible to
+	 * the async_synchronize_*() family the whole time.
+	 */
+	unsigned int max_active;
+	unsigned int nr_active;
+	struct list_head throttled;
 };
 
 /*
@@ -25,7 +34,8 @@ struct async_domain {
  */
 #define ASYNC_DOMAIN(_name) \
 	struct async_domain _name = { .pending = LIST_HEAD_INIT(_name.pending),	\
-				      .registered = 1 }
+				      .registered = 1,			\
+				      .throttled = LIST_HEAD_INIT(_name.throttled) }
 
 /*
  * domain is free to go out of scope as soon as all pending work is
@@ -33,13 +43,24 @@ struct async_domain {
  */
 #define ASYNC_DOMAIN_EXCLUSIVE(_name) \
 	struct async_domain _name = { .pending = LIST_HEAD_INIT(_name.pending), \
-				      .registered = 0 }
+				      .registered = 0,			\
+				      .throttled = LIST_HEAD_INIT(_name.throttled) }
 
 async_cookie_t async_schedule_node(async_func_t func, void *data,
 				   int node);
 async_cookie_t async_schedule_node_domain(async_func_t func, void *data,
 					  int node,
 					  struct async_domain *domain);
+async_cookie_t async_schedule_dep_node_domain(async_func_t func, void *data,
+					      int node,
+					      struct async_domain *domain,
+					      const async_cookie_t *deps,
+					      unsigned int nr_deps);
+async_cookie_t async_schedule_dep(async_func_t func, void *data,
+				  const async_cookie_t *deps,
+				  unsigned int nr_deps);
+void async_domain_set_max_active(struct async_domain *domain,
+				 unsigned int max_active);
 
 /**
  * async_schedule - schedule a function for asynchronous execution
@@ -108,6 +108,19 @@ struct bdi_writeback_congested {
 #endif
 };
 
+/*
+ * Auxiliary flush streams per wb, kicked by wb_workfn() when
+ * vm.writeback_flushers allows more than one stream.  The streams pull
+ * inodes from the shared ->b_io list under ->list_lock, with I_SYNC
+ * keeping two of them off the same inode.
+ */
+#define WB_MAX_AUX_FLUSHERS	3
+
+struct wb_aux_flusher {
+	struct work_struct work;
+	struct bdi_writeback *wb;
+};
+
 /*
  * Each wb (bdi_writeback) can perform writeback operations, is measured
  * and throttled, independently.  Without cgroup writeback, each bdi
@@ -158,6 +171,16 @@ struct bdi_writeback {
 	unsigned long dirty_ratelimit;
 	unsigned long balanced_dirty_ratelimit;
 
+	/*
+	 * Snapshot of the global freerun region taken on the last full
+	 * pass through balance_dirty_pages().  Writers well below the
+	 * dirty limits use it to skip recomputing the limits on every
+	 * ratelimit expiry.
+	 */
+	unsigned long dirty_cache_time;	/* jiffies of the snapshot */
+	unsigned long dirty_thresh_cache; /* cached domain dirty thresh */
+	unsigned long dirty_freerun_cache; /* cached freerun ceiling */
+
 	struct fprop_local_percpu completions;
 	int dirty_exceeded;
 	enum wb_reason start_all_reason;
@@ -165,6 +188,7 @@ struct bdi_writeback {
 	spinlock_t work_lock;		/* protects work_list & dwork scheduling */
 	struct list_head work_list;
 	struct delayed_work dwork;	/* work item used for writeback */
+	struct wb_aux_flusher aux_flushers[WB_MAX_AUX_FLUSHERS];
 
 	unsigned long dirty_sleep;	/* last wait */
 
@@ -87,6 +87,9 @@ struct coredump_params {
 	unsigned long mm_flags;
 	loff_t written;
 	loff_t pos;
+	/* drop-behind state for file-backed dumps: */
+	loff_t wb_start;	/* dump data not yet queued for writeback */
+	loff_t drop_start;	/* queued data not yet dropped from cache */
 };
 
 /*
@@ -152,6 +152,22 @@ struct blk_mq_hw_ctx {
 	/** @poll_success: Count how many polled requests were completed. */
 	unsigned long		poll_success;
 
+	/**
+	 * @poll_hist: Power-of-two bucketed completion latency histogram
+	 * for polled requests, feeding the adaptive hybrid poll sleep
+	 * estimate.  Bucket i counts completions in [2^i, 2^(i+1)) ns.
+	 */
+	atomic_t		poll_hist[BLK_MQ_POLL_HIST_BKTS];
+
+	/**
+	 * @lat_hist: Always-on percpu log2 completion latency histograms
+	 * (separate read/write/discard), exported via debugfs.  NULL if
+	 * the allocation failed; completions are then not histogrammed.
+	 */
+	struct blk_lat_hist __percpu *lat_hist;
+	/** @poll_hist_samples: Samples since the last histogram decay. */
+	atomic_t		poll_hist_samples;
+
 #ifdef CONFIG_BLK_DEBUG_FS
 	/**
 	 * @debugfs_dir: debugfs directory for this hardware queue. Named
@@ -489,6 +505,7 @@ void blk_mq_requeue_request(struct request *rq, bool kick_requeue_list);
 void blk_mq_kick_requeue_list(struct request_queue *q);
 void blk_mq_delay_kick_requeue_list(struct request_queue *q, unsigned long msecs);
 bool blk_mq_complete_request(struct request *rq);
+void blk_mq_complete_request_batch(struct list_head *list);
 bool blk_mq_bio_list_merge(struct request_queue *q, struct list_head *list,
 			   struct bio *bio, unsigned int nr_segs);
 bool blk_mq_queue_stopped(struct request_queue *q);
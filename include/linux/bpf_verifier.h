@@ -352,6 +352,13 @@ struct bpf_subprog_info {
 	u16 stack_depth; /* max. stack depth used by this function */
 };
 
+/* Maximum number of register states that can exist at once */
+#define BPF_ID_MAP_SIZE (MAX_BPF_REG + MAX_BPF_STACK / BPF_REG_SIZE)
+struct bpf_id_pair {
+	u32 old;
+	u32 cur;
+};
+
 /* single container for all structs
  * one verifier_env per bpf_check() call
  */
@@ -376,6 +383,7 @@ struct bpf_verifier_env {
 	const struct bpf_line_info *prev_linfo;
 	struct bpf_verifier_log log;
 	struct bpf_subprog_info subprog_info[BPF_MAX_SUBPROGS + 1];
+	struct bpf_id_pair idmap_scratch[BPF_ID_MAP_SIZE];
 	struct {
 		int *insn_state;
 		int *insn_stack;
@@ -89,6 +89,11 @@ extern ssize_t arch_cpu_release(const char *, size_t);
 #ifdef CONFIG_SMP
 extern bool cpuhp_tasks_frozen;
 int cpu_up(unsigned int cpu);
+void bringup_nonboot_cpus(unsigned int setup_max_cpus);
+/* Implemented by architectures supporting parallel bringup */
+struct task_struct;
+bool arch_cpuhp_init_parallel_bringup(void);
+int arch_cpuhp_kick_ap_alive(unsigned int cpu, struct task_struct *tidle);
 void notify_cpu_starting(unsigned int cpu);
 extern void cpu_maps_update_begin(void);
 extern void cpu_maps_update_done(void);
@@ -69,6 +69,9 @@ struct dentry_stat_t {
 };
 extern struct dentry_stat_t dentry_stat;
 
+/* Per-superblock cap on negative dentries, 0 == no limit */
+extern unsigned long sysctl_neg_dentry_limit;
+
 /*
  * Try to keep struct dentry aligned on 64 byte cachelines (this will
  * give reasonable cacheline footprint with larger lines without the
@@ -234,6 +237,8 @@ extern void d_set_d_op(struct dentry *dentry, const struct dentry_operations *op
 
 /* allocate/de-allocate */
 extern struct dentry * d_alloc(struct dentry *, const struct qstr *);
+extern int d_alloc_bulk(struct dentry *, const struct qstr *, unsigned int,
+			struct dentry **);
 extern struct dentry * d_alloc_anon(struct super_block *);
 extern struct dentry * d_alloc_parallel(struct dentry *, const struct qstr *,
 					wait_queue_head_t *);
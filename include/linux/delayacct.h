@@ -53,6 +53,15 @@ struct task_delay_info {
 
 	u32 freepages_count;	/* total count of memory reclaim */
 	u32 thrashing_count;	/* total count of thrash waits */
+
+	/*
+	 * Per-delay-type log2 histograms, bucketed as described in
+	 * uapi/linux/taskstats.h and copied out through taskstats.
+	 */
+	u32 blkio_hist[TASKSTATS_HIST_BUCKETS];
+	u32 swapin_hist[TASKSTATS_HIST_BUCKETS];
+	u32 freepages_hist[TASKSTATS_HIST_BUCKETS];
+	u32 thrashing_hist[TASKSTATS_HIST_BUCKETS];
 };
 #endif
 
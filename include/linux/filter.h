@@ -655,24 +655,27 @@ static inline u8 *bpf_skb_cb(struct sk_buff *skb)
 	return qdisc_skb_cb(skb)->data;
 }
 
+#define __BPF_PROG_RUN_SAVE_CB(prog, skb, dfunc)	({		\
+	u8 *__cb_data = bpf_skb_cb(skb);				\
+	u8 __cb_saved[BPF_SKB_CB_LEN];					\
+	u32 __res;							\
+									\
+	if (unlikely((prog)->cb_access)) {				\
+		memcpy(__cb_saved, __cb_data, sizeof(__cb_saved));	\
+		memset(__cb_data, 0, sizeof(__cb_saved));		\
+	}								\
+									\
+	__res = __BPF_PROG_RUN(prog, skb, dfunc);			\
+									\
+	if (unlikely((prog)->cb_access))				\
+		memcpy(__cb_data, __cb_saved, sizeof(__cb_saved));	\
+									\
+	__res; })
+
 static inline u32 __bpf_prog_run_save_cb(const struct bpf_prog *prog,
 					 struct sk_buff *skb)
 {
-	u8 *cb_data = bpf_skb_cb(skb);
-	u8 cb_saved[BPF_SKB_CB_LEN];
-	u32 res;
-
-	if (unlikely(prog->cb_access)) {
-		memcpy(cb_saved, cb_data, sizeof(cb_saved));
-		memset(cb_data, 0, sizeof(cb_saved));
-	}
-
-	res = BPF_PROG_RUN(prog, skb);
-
-	if (unlikely(prog->cb_access))
-		memcpy(cb_data, cb_saved, sizeof(cb_saved));
-
-	return res;
+	return __BPF_PROG_RUN_SAVE_CB(prog, skb, bpf_dispatcher_nopfunc);
 }
 
 static inline u32 bpf_prog_run_save_cb(const struct bpf_prog *prog,
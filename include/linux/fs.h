@@ -32,6 +32,7 @@
 #include <linux/uidgid.h>
 #include <linux/lockdep.h>
 #include <linux/percpu-rwsem.h>
+#include <linux/percpu_counter.h>
 #include <linux/workqueue.h>
 #include <linux/delayed_call.h>
 #include <linux/uuid.h>
@@ -921,6 +922,8 @@ struct file_ra_state {
 
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
+	short ra_score;			/* Feedback score: speculation hits
+					   raise it, random misses lower it */
 	loff_t prev_pos;		/* Cache last read() position */
 };
 
@@ -1096,6 +1099,8 @@ struct file_lock {
 	struct file *fl_file;
 	loff_t fl_start;
 	loff_t fl_end;
+	struct rb_node fl_node;		/* node in ->flc_posix_tree */
+	loff_t fl_subtree_last;		/* interval tree augmentation */
 
 	struct fasync_struct *	fl_fasync; /* for lease break notifications */
 	/* for lease breaks: */
@@ -1119,6 +1124,7 @@ struct file_lock_context {
 	spinlock_t		flc_lock;
 	struct list_head	flc_flock;
 	struct list_head	flc_posix;
+	struct rb_root_cached	flc_posix_tree;
 	struct list_head	flc_lease;
 };
 
@@ -1533,6 +1539,14 @@ struct super_block {
 	 */
 	struct list_lru		s_dentry_lru;
 	struct list_lru		s_inode_lru;
+
+	/*
+	 * Negative dentries on s_dentry_lru, checked against
+	 * fs.negative-dentry-limit.  s_prune_neg_work evicts the excess.
+	 */
+	struct percpu_counter	s_ndentry_neg;
+	struct work_struct	s_prune_neg_work;
+
 	struct rcu_head		rcu;
 	struct work_struct	destroy_work;
 
@@ -3051,6 +3065,11 @@ extern struct inode *ilookup5_nowait(struct super_block *sb,
 extern struct inode *ilookup5(struct super_block *sb, unsigned long hashval,
 		int (*test)(struct inode *, void *), void *data);
 extern struct inode *ilookup(struct super_block *sb, unsigned long ino);
+extern struct inode *find_inode_rcu(struct super_block *sb,
+		unsigned long hashval, int (*test)(struct inode *, void *),
+		void *data);
+extern struct inode *find_inode_by_ino_rcu(struct super_block *sb,
+		unsigned long ino);
 
 extern struct inode *inode_insert5(struct inode *inode, unsigned long hashval,
 		int (*test)(struct inode *, void *),
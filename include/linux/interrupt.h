@@ -576,6 +576,9 @@ extern void raise_softirq(unsigned int nr);
 
 DECLARE_PER_CPU(struct task_struct *, ksoftirqd);
 
+/* softirq inline processing budget before deferring to the threads, in us */
+extern unsigned int softirq_inline_budget_us;
+
 static inline struct task_struct *this_cpu_ksoftirqd(void)
 {
 	return this_cpu_read(ksoftirqd);
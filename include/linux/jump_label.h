@@ -188,6 +188,14 @@ enum jump_label_type {
 
 struct module;
 
+/*
+ * One element of a static_key_update_batch() request.
+ */
+struct static_key_update {
+	struct static_key *key;
+	bool enable;
+};
+
 #ifdef CONFIG_JUMP_LABEL
 
 #define JUMP_TYPE_FALSE		0UL
@@ -229,6 +237,8 @@ extern void static_key_enable(struct static_key *key);
 extern void static_key_disable(struct static_key *key);
 extern void static_key_enable_cpuslocked(struct static_key *key);
 extern void static_key_disable_cpuslocked(struct static_key *key);
+extern void static_key_update_batch(struct static_key_update *updates,
+				    int count);
 
 /*
  * We should be using ATOMIC_INIT() for initializing .enabled, but
@@ -326,6 +336,19 @@ static inline void static_key_disable(struct static_key *key)
 #define static_key_enable_cpuslocked(k)		static_key_enable((k))
 #define static_key_disable_cpuslocked(k)	static_key_disable((k))
 
+static inline void static_key_update_batch(struct static_key_update *updates,
+					   int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (updates[i].enable)
+			static_key_enable(updates[i].key);
+		else
+			static_key_disable(updates[i].key);
+	}
+}
+
 #define STATIC_KEY_INIT_TRUE	{ .enabled = ATOMIC_INIT(1) }
 #define STATIC_KEY_INIT_FALSE	{ .enabled = ATOMIC_INIT(0) }
 
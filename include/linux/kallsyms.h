@@ -74,6 +74,10 @@ static inline void *dereference_symbol_descriptor(void *ptr)
 /* Lookup the address for a symbol. Returns 0 if not found. */
 unsigned long kallsyms_lookup_name(const char *name);
 
+/* Resolve a whole batch of names, returns how many were found. */
+unsigned int kallsyms_lookup_names(const char * const *names,
+				   unsigned int cnt, unsigned long *addrs);
+
 /* Call a function on each kallsyms symbol in the core kernel */
 int kallsyms_on_each_symbol(int (*fn)(void *, const char *, struct module *,
 				      unsigned long),
@@ -107,6 +111,15 @@ static inline unsigned long kallsyms_lookup_name(const char *name)
 	return 0;
 }
 
+static inline unsigned int kallsyms_lookup_names(const char * const *names,
+						 unsigned int cnt,
+						 unsigned long *addrs)
+{
+	while (cnt--)
+		addrs[cnt] = 0;
+	return 0;
+}
+
 static inline int kallsyms_on_each_symbol(int (*fn)(void *, const char *,
 						    struct module *,
 						    unsigned long),
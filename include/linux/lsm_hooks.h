@@ -2158,14 +2158,8 @@ extern struct lsm_info __start_early_lsm_info[], __end_early_lsm_info[];
  * disabling their module is a good idea needs to be at least as
  * careful as the SELinux team.
  */
-static inline void security_delete_hooks(struct security_hook_list *hooks,
-						int count)
-{
-	int i;
-
-	for (i = 0; i < count; i++)
-		hlist_del_rcu(&hooks[i].list);
-}
+extern void security_delete_hooks(struct security_hook_list *hooks,
+				  int count);
 #endif /* CONFIG_SECURITY_SELINUX_DISABLE */
 
 /* Currently required to handle SELinux runtime hook disable. */
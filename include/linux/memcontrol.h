@@ -11,6 +11,7 @@
 #ifndef _LINUX_MEMCONTROL_H
 #define _LINUX_MEMCONTROL_H
 #include <linux/cgroup.h>
+#include <linux/llist.h>
 #include <linux/vm_event_item.h>
 #include <linux/hardirq.h>
 #include <linux/jump_label.h>
@@ -84,10 +85,20 @@ enum mem_cgroup_events_target {
 };
 
 struct memcg_vmstats_percpu {
+	/* Cumulative counters, only ever written by this CPU */
 	long stat[MEMCG_NR_STAT];
 	unsigned long events[NR_VM_EVENT_ITEMS];
 	unsigned long nr_page_events;
 	unsigned long targets[MEM_CGROUP_NTARGETS];
+
+	/* Snapshots of the above at the time of the last stats flush */
+	long stat_prev[MEMCG_NR_STAT];
+	unsigned long events_prev[NR_VM_EVENT_ITEMS];
+
+	/* Linkage on this CPU's list of cgroups with pending updates */
+	struct mem_cgroup *memcg;
+	struct llist_node updated_node;
+	int updated;
 };
 
 struct mem_cgroup_reclaim_iter {
@@ -97,7 +108,11 @@ struct mem_cgroup_reclaim_iter {
 };
 
 struct lruvec_stat {
+	/* Cumulative counters, only ever written by this CPU */
 	long count[NR_VM_NODE_STAT_ITEMS];
+
+	/* Snapshot of the above at the time of the last stats flush */
+	long count_prev[NR_VM_NODE_STAT_ITEMS];
 };
 
 /*
@@ -116,7 +131,7 @@ struct mem_cgroup_per_node {
 	struct lruvec		lruvec;
 
 	/* Legacy local VM stats */
-	struct lruvec_stat __percpu *lruvec_stat_local;
+	atomic_long_t		lruvec_stat_local[NR_VM_NODE_STAT_ITEMS];
 
 	/* Subtree VM stats (batched updates) */
 	struct lruvec_stat __percpu *lruvec_stat_cpu;
@@ -280,9 +295,6 @@ struct mem_cgroup {
 	atomic_t		moving_account;
 	struct task_struct	*move_lock_task;
 
-	/* Legacy local VM stats and events */
-	struct memcg_vmstats_percpu __percpu *vmstats_local;
-
 	/* Subtree VM stats and events (batched updates) */
 	struct memcg_vmstats_percpu __percpu *vmstats_percpu;
 
@@ -291,6 +303,10 @@ struct mem_cgroup {
 	atomic_long_t		vmstats[MEMCG_NR_STAT];
 	atomic_long_t		vmevents[NR_VM_EVENT_ITEMS];
 
+	/* Legacy local VM stats and events */
+	atomic_long_t		vmstats_local[MEMCG_NR_STAT];
+	atomic_long_t		vmevents_local[NR_VM_EVENT_ITEMS];
+
 	/* memory.events */
 	atomic_long_t		memory_events[MEMCG_NR_MEMORY_EVENTS];
 	atomic_long_t		memory_events_local[MEMCG_NR_MEMORY_EVENTS];
@@ -577,10 +593,7 @@ struct mem_cgroup *lock_page_memcg(struct page *page);
 void __unlock_page_memcg(struct mem_cgroup *memcg);
 void unlock_page_memcg(struct page *page);
 
-/*
- * idx can be of type enum memcg_stat_item or node_stat_item.
- * Keep in sync with memcg_exact_page_state().
- */
+/* idx can be of type enum memcg_stat_item or node_stat_item */
 static inline unsigned long memcg_page_state(struct mem_cgroup *memcg, int idx)
 {
 	long x = atomic_long_read(&memcg->vmstats[idx]);
@@ -591,18 +604,11 @@ static inline unsigned long memcg_page_state(struct mem_cgroup *memcg, int idx)
 	return x;
 }
 
-/*
- * idx can be of type enum memcg_stat_item or node_stat_item.
- * Keep in sync with memcg_exact_page_state().
- */
+/* idx can be of type enum memcg_stat_item or node_stat_item */
 static inline unsigned long memcg_page_state_local(struct mem_cgroup *memcg,
 						   int idx)
 {
-	long x = 0;
-	int cpu;
-
-	for_each_possible_cpu(cpu)
-		x += per_cpu(memcg->vmstats_local->stat[idx], cpu);
+	long x = atomic_long_read(&memcg->vmstats_local[idx]);
 #ifdef CONFIG_SMP
 	if (x < 0)
 		x = 0;
@@ -676,15 +682,13 @@ static inline unsigned long lruvec_page_state_local(struct lruvec *lruvec,
 						    enum node_stat_item idx)
 {
 	struct mem_cgroup_per_node *pn;
-	long x = 0;
-	int cpu;
+	long x;
 
 	if (mem_cgroup_disabled())
 		return node_page_state(lruvec_pgdat(lruvec), idx);
 
 	pn = container_of(lruvec, struct mem_cgroup_per_node, lruvec);
-	for_each_possible_cpu(cpu)
-		x += per_cpu(pn->lruvec_stat_local->count[idx], cpu);
+	x = atomic_long_read(&pn->lruvec_stat_local[idx]);
 #ifdef CONFIG_SMP
 	if (x < 0)
 		x = 0;
@@ -13,11 +13,23 @@ struct kmem_cache;
 typedef void * (mempool_alloc_t)(gfp_t gfp_mask, void *pool_data);
 typedef void (mempool_free_t)(void *element, void *pool_data);
 
+/*
+ * Size of the optional per-CPU element cache, see
+ * mempool_enable_percpu_cache().
+ */
+#define MEMPOOL_CACHE_SIZE	8
+
+struct mempool_percpu_cache {
+	unsigned int nr;
+	void *elements[MEMPOOL_CACHE_SIZE];
+};
+
 typedef struct mempool_s {
 	spinlock_t lock;
 	int min_nr;		/* nr of elements at *elements */
 	int curr_nr;		/* Current nr of elements at *elements */
 	void **elements;
+	struct mempool_percpu_cache __percpu *cache;
 
 	void *pool_data;
 	mempool_alloc_t *alloc;
@@ -31,6 +43,7 @@ static inline bool mempool_initialized(mempool_t *pool)
 }
 
 void mempool_exit(mempool_t *pool);
+int mempool_enable_percpu_cache(mempool_t *pool);
 int mempool_init_node(mempool_t *pool, int min_nr, mempool_alloc_t *alloc_fn,
 		      mempool_free_t *free_fn, void *pool_data,
 		      gfp_t gfp_mask, int node_id);
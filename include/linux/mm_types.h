@@ -380,6 +380,7 @@ struct core_state {
 	struct completion startup;
 };
 
+struct futex_private_hash;
 struct kioctx_table;
 struct mm_struct {
 	struct {
@@ -538,6 +539,15 @@ struct mm_struct {
 		bool tlb_flush_batched;
 #endif
 		struct uprobes_state uprobes_state;
+#ifdef CONFIG_FUTEX
+		/*
+		 * Private futex hash installed via prctl(PR_FUTEX_HASH).
+		 * Set at most once while the process is single threaded
+		 * and freed together with the mm; NULL means the private
+		 * futexes of this process use the global hash.
+		 */
+		struct futex_private_hash *futex_phash;
+#endif
 #ifdef CONFIG_HUGETLB_PAGE
 		atomic_long_t hugetlb_usage;
 #endif
@@ -309,8 +309,17 @@ struct gro_list {
 /*
  * size of gro hash buckets, must less than bit number of
  * napi_struct::gro_bitmask
+ *
+ * 64bit hosts get a larger table so many-flow workloads (RPC fan-in,
+ * lots of short TCP streams) still find their bucket instead of
+ * constantly evicting each other; each bucket holds up to
+ * MAX_GRO_SKBS flows.
  */
+#ifdef CONFIG_64BIT
+#define GRO_HASH_BUCKETS	32
+#else
 #define GRO_HASH_BUCKETS	8
+#endif
 
 /*
  * Structure for NAPI scheduling similar to tasklet but with weighting
@@ -336,10 +345,12 @@ struct napi_struct {
 	struct sk_buff		*skb;
 	struct list_head	rx_list; /* Pending GRO_NORMAL skbs */
 	int			rx_count; /* length of rx_list */
+	unsigned int		avg_work; /* EWMA of work per poll */
 	struct hrtimer		timer;
 	struct list_head	dev_list;
 	struct hlist_node	napi_hash_node;
 	unsigned int		napi_id;
+	struct task_struct	*thread;
 };
 
 enum {
@@ -350,6 +361,8 @@ enum {
 	NAPI_STATE_HASHED,	/* In NAPI hash (busy polling possible) */
 	NAPI_STATE_NO_BUSY_POLL,/* Do not add in napi_hash, no busy polling */
 	NAPI_STATE_IN_BUSY_POLL,/* sk_busy_loop() owns this NAPI */
+	NAPI_STATE_THREADED,	/* The poll is performed inside its own thread*/
+	NAPI_STATE_SCHED_THREADED,	/* Napi is currently scheduled in threaded mode */
 };
 
 enum {
@@ -360,6 +373,8 @@ enum {
 	NAPIF_STATE_HASHED	 = BIT(NAPI_STATE_HASHED),
 	NAPIF_STATE_NO_BUSY_POLL = BIT(NAPI_STATE_NO_BUSY_POLL),
 	NAPIF_STATE_IN_BUSY_POLL = BIT(NAPI_STATE_IN_BUSY_POLL),
+	NAPIF_STATE_THREADED	 = BIT(NAPI_STATE_THREADED),
+	NAPIF_STATE_SCHED_THREADED = BIT(NAPI_STATE_SCHED_THREADED),
 };
 
 enum gro_result {
@@ -495,6 +510,19 @@ static inline bool napi_complete(struct napi_struct *n)
  */
 bool napi_hash_del(struct napi_struct *napi);
 
+/**
+ *	dev_set_threaded - set up threaded mode for device
+ *	@dev: device
+ *	@threaded: whether all NAPI instances of the device should
+ *	be serviced by kernel threads instead of the RX softirq
+ *
+ * This call creates (or wakes up) one kernel thread per NAPI
+ * instance; subsequent napi_schedule() calls wake the thread
+ * instead of raising NET_RX_SOFTIRQ, so the scheduler places and
+ * prioritizes RX processing like any other task.
+ */
+int dev_set_threaded(struct net_device *dev, bool threaded);
+
 /**
  *	napi_disable - prevent NAPI from scheduling
  *	@n: NAPI context
@@ -513,10 +541,16 @@ void napi_disable(struct napi_struct *n);
  */
 static inline void napi_enable(struct napi_struct *n)
 {
+	unsigned long val, new;
+
 	BUG_ON(!test_bit(NAPI_STATE_SCHED, &n->state));
 	smp_mb__before_atomic();
-	clear_bit(NAPI_STATE_SCHED, &n->state);
-	clear_bit(NAPI_STATE_NPSVC, &n->state);
+	do {
+		val = READ_ONCE(n->state);
+		new = val & ~(NAPIF_STATE_SCHED | NAPIF_STATE_NPSVC);
+		if (n->dev->threaded && n->thread)
+			new |= NAPIF_STATE_THREADED;
+	} while (cmpxchg(&n->state, val, new) != val);
 }
 
 /**
@@ -1814,6 +1848,8 @@ enum netdev_priv_flags {
  *
  *	@wol_enabled:	Wake-on-LAN is enabled
  *
+ *	@threaded:	napi threaded mode is enabled
+ *
  *	@net_notifier_list:	List of per-net netdev notifier block
  *				that follow this device when it is moved
  *				to another network namespace.
@@ -2110,6 +2146,7 @@ struct net_device {
 	struct lock_class_key	addr_list_lock_key;
 	bool			proto_down;
 	unsigned		wol_enabled:1;
+	unsigned		threaded:1;
 
 	struct list_head	net_notifier_list;
 };
@@ -3058,6 +3095,8 @@ struct softnet_data {
 	unsigned int		processed;
 	unsigned int		time_squeeze;
 	unsigned int		received_rps;
+	unsigned int		gro_coalesced;
+	unsigned int		gro_coalesced_bytes;
 #ifdef CONFIG_RPS
 	struct softnet_data	*rps_ipi_list;
 #endif
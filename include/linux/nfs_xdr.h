@@ -1558,10 +1558,18 @@ struct nfs_pgio_header {
 	int			pgio_mirror_idx;/* mirror index in pgio layer */
 };
 
+/*
+ * Unstable writes awaiting commit are sharded over a small number of
+ * lists, keyed by page index, so that searches and scans on a heavily
+ * written inode do not have to walk one long list.
+ */
+#define NFS_COMMIT_BUCKETS	16
+#define NFS_COMMIT_BUCKET_SHIFT	8	/* 1MB stripes with 4K pages */
+
 struct nfs_mds_commit_info {
 	atomic_t rpcs_out;
 	atomic_long_t		ncommit;
-	struct list_head	list;
+	struct list_head	buckets[NFS_COMMIT_BUCKETS];
 };
 
 struct nfs_commit_info;
@@ -218,6 +218,8 @@ void pipe_unlock(struct pipe_inode_info *);
 void pipe_double_lock(struct pipe_inode_info *, struct pipe_inode_info *);
 
 extern unsigned int pipe_max_size;
+extern unsigned int pipe_default_size;
+long pipe_set_size(struct pipe_inode_info *pipe, unsigned long arg);
 extern unsigned long pipe_user_pages_hard;
 extern unsigned long pipe_user_pages_soft;
 
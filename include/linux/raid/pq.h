@@ -120,6 +120,12 @@ extern const struct raid6_calls raid6_vpermxor8;
 struct raid6_recov_calls {
 	void (*data2)(int, size_t, int, int, void **);
 	void (*datap)(int, size_t, int, void **);
+	/*
+	 * Optional: recover a batch of stripes sharing the same failed
+	 * slots with a single table/FPU setup; absence means one data2
+	 * call per stripe.
+	 */
+	void (*data2_batch)(int, size_t, int, int, void ***, int);
 	int  (*valid)(void);
 	const char *name;
 	int priority;
@@ -164,6 +170,16 @@ extern void (*raid6_datap_recov)(int disks, size_t bytes, int faila,
 void raid6_dual_recov(int disks, size_t bytes, int faila, int failb,
 		      void **ptrs);
 
+/*
+ * Batched recovery: @ptrs is an array of @nr_stripes per-stripe pointer
+ * tables, each laid out like the one taken by raid6_2data_recov(), all
+ * with the same failed slots.
+ */
+void raid6_2data_recov_batch(int disks, size_t bytes, int faila, int failb,
+			     void ***ptrs, int nr_stripes);
+void raid6_datap_recov_batch(int disks, size_t bytes, int faila,
+			     void ***ptrs, int nr_stripes);
+
 /* Some definitions to allow code to be compiled for testing in userspace */
 #ifndef __KERNEL__
 
@@ -26,7 +26,7 @@
 /*
  * Tracks changes to rchan/rchan_buf structs
  */
-#define RELAYFS_CHANNEL_VERSION		7
+#define RELAYFS_CHANNEL_VERSION		8
 
 /*
  * Per-cpu relay channel buffer
@@ -38,6 +38,7 @@ struct rchan_buf
 	size_t offset;			/* current offset into sub-buffer */
 	size_t subbufs_produced;	/* count of sub-buffers produced */
 	size_t subbufs_consumed;	/* count of sub-buffers consumed */
+	size_t subbufs_notified;	/* produced count at last wakeup */
 	struct rchan *chan;		/* associated channel */
 	wait_queue_head_t read_wait;	/* reader wait queue */
 	struct irq_work wakeup_work;	/* reader wakeup */
@@ -68,6 +69,8 @@ struct rchan
 	size_t last_toobig;		/* tried to log event > subbuf size */
 	struct rchan_buf * __percpu *buf; /* per-cpu channel buffers */
 	int is_global;			/* One global buffer ? */
+	int overwrite;			/* ring wraps, newest data wins */
+	size_t wakeup_interval;		/* sub-buffers per reader wakeup */
 	struct list_head list;		/* for channel list */
 	struct dentry *parent;		/* parent dentry passed to open */
 	int has_base_filename;		/* has a filename associated? */
@@ -182,6 +185,10 @@ extern void relay_subbufs_consumed(struct rchan *chan,
 				   size_t consumed);
 extern void relay_reset(struct rchan *chan);
 extern int relay_buf_full(struct rchan_buf *buf);
+extern void relay_set_overwrite(struct rchan *chan, int overwrite);
+extern void relay_set_wakeup_interval(struct rchan *chan, size_t n_subbufs);
+extern size_t relay_snapshot(struct rchan *chan, unsigned int cpu,
+			     size_t *first, size_t *last);
 
 extern size_t relay_switch_subbuf(struct rchan_buf *buf,
 				  size_t length);
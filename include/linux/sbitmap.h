@@ -398,6 +398,72 @@ void sbitmap_queue_resize(struct sbitmap_queue *sbq, unsigned int depth);
  */
 int __sbitmap_queue_get(struct sbitmap_queue *sbq);
 
+/**
+ * __sbitmap_queue_get_batch() - Try to allocate a batch of free bits from a
+ * &struct sbitmap_queue with preemption already disabled.
+ * @sbq: Bitmap queue to allocate from.
+ * @nr_tags: Number of bits wanted.
+ * @offset: Output parameter; set to the bit number the mask is relative to
+ *	    on success.
+ *
+ * Grabs a run of up to @nr_tags free bits from a single word with one
+ * atomic operation.  The returned mask is relative to *@offset and may
+ * contain holes for bits that were taken concurrently.
+ *
+ * Return: Mask of allocated bits, or zero if no run could be grabbed in
+ * one operation; callers should fall back to single-bit allocation.
+ */
+static inline unsigned long __sbitmap_queue_get_batch(struct sbitmap_queue *sbq,
+						      int nr_tags,
+						      unsigned int *offset)
+{
+	struct sbitmap *sb = &sbq->sb;
+	unsigned int hint, index, i;
+
+	if (unlikely(sbq->round_robin))
+		return 0;
+
+	hint = this_cpu_read(*sbq->alloc_hint);
+	if (unlikely(hint >= sb->depth))
+		hint = 0;
+	index = SB_NR_TO_INDEX(sb, hint);
+
+	for (i = 0; i < sb->map_nr; i++) {
+		struct sbitmap_word *map = &sb->map[index];
+		unsigned long val = READ_ONCE(map->word);
+		unsigned long get_mask;
+		unsigned int map_depth = map->depth;
+		unsigned int nr;
+
+		nr = find_first_zero_bit(&val, map_depth);
+		if (nr + nr_tags <= map_depth) {
+			get_mask = ((1UL << nr_tags) - 1) << nr;
+			for (;;) {
+				unsigned long prev;
+
+				prev = cmpxchg(&map->word, val,
+					       val | get_mask);
+				if (prev == val)
+					break;
+				val = prev;
+			}
+			/* only the bits we actually flipped are ours */
+			get_mask = (get_mask & ~val) >> nr;
+			if (get_mask) {
+				*offset = nr + (index << sb->shift);
+				this_cpu_write(*sbq->alloc_hint,
+					       *offset + nr_tags);
+				return get_mask;
+			}
+		}
+
+		if (++index >= sb->map_nr)
+			index = 0;
+	}
+
+	return 0;
+}
+
 /**
  * __sbitmap_queue_get_shallow() - Try to allocate a free bit from a &struct
  * sbitmap_queue, limiting the depth used from each word, with preemption
@@ -113,10 +113,6 @@ struct task_group;
 
 #define task_is_stopped_or_traced(task)	((task->state & (__TASK_STOPPED | __TASK_TRACED)) != 0)
 
-#define task_contributes_to_load(task)	((task->state & TASK_UNINTERRUPTIBLE) != 0 && \
-					 (task->flags & PF_FROZEN) == 0 && \
-					 (task->state & TASK_NOLOAD) == 0)
-
 #ifdef CONFIG_DEBUG_ATOMIC_SLEEP
 
 /*
@@ -677,6 +673,8 @@ struct task_struct {
 	int				static_prio;
 	int				normal_prio;
 	unsigned int			rt_priority; // 实时优先级，用它计算实时进程调度时的weight值
+	/* Latency tolerance hint, [MIN_LATENCY_NICE..MAX_LATENCY_NICE] */
+	int				latency_nice;
 
 	const struct sched_class	*sched_class;
 	struct sched_entity		se; // 用于CFS调度
@@ -930,12 +928,18 @@ struct task_struct {
 	/* Restored if set_restore_sigmask() was used: */
 	sigset_t			saved_sigmask;
 	struct sigpending		pending; // 进程上是否有待处理的信号
+	/* Cached sigqueue, recycled on delivery; only touched by this task */
+	struct sigqueue			*sigqueue_cache;
 	unsigned long			sas_ss_sp;
 	size_t				sas_ss_size;
 	unsigned int			sas_ss_flags;
 
 	struct callback_head		*task_works;
 
+	/* Files whose final fput was deferred to task_work, drained in batch: */
+	struct llist_head		fput_list;
+	struct callback_head		fput_work;
+
 #ifdef CONFIG_AUDIT
 #ifdef CONFIG_AUDITSYSCALL
 	struct audit_context		*audit_context;
@@ -6,6 +6,15 @@
 #define MIN_NICE	-20
 #define NICE_WIDTH	(MAX_NICE - MIN_NICE + 1)
 
+/*
+ * latency_nice is a per-task hint in the same [-20, 19] range as the
+ * regular nice value: lower means latency sensitive, higher means
+ * latency tolerant. It does not affect a task's bandwidth.
+ */
+#define MAX_LATENCY_NICE	19
+#define MIN_LATENCY_NICE	-20
+#define DEFAULT_LATENCY_NICE	0
+
 /*
  * Priority of a process goes from 0..MAX_PRIO-1, valid RT
  * priority is 0..MAX_RT_PRIO-1, and SCHED_NORMAL/SCHED_BATCH
@@ -56,6 +56,7 @@ static inline bool wake_q_empty(struct wake_q_head *head)
 	return head->first == WAKE_Q_TAIL;
 }
 
+extern bool __wake_q_add(struct wake_q_head *head, struct task_struct *task);
 extern void wake_q_add(struct wake_q_head *head, struct task_struct *task);
 extern void wake_q_add_safe(struct wake_q_head *head, struct task_struct *task);
 extern void wake_up_q(struct wake_q_head *head);
@@ -45,6 +45,10 @@ struct kmem_cache_cpu {
 #ifdef CONFIG_SLUB_CPU_PARTIAL
 	struct page *partial;	/* Partially allocated frozen slabs */
 #endif
+#ifdef CONFIG_NUMA
+	void *remote_free;	/* Deferred frees to remote node slabs */
+	unsigned int nr_remote_free;
+#endif
 #ifdef CONFIG_SLUB_STATS
 	unsigned stat[NR_SLUB_STAT_ITEMS];
 #endif
@@ -103,6 +103,15 @@ extern void smp_cpus_done(unsigned int max_cpus);
 void smp_call_function(smp_call_func_t func, void *info, int wait);
 void smp_call_function_many(const struct cpumask *mask,
 			    smp_call_func_t func, void *info, bool wait);
+int smp_call_function_many_async(const struct cpumask *mask,
+				 call_single_data_t __percpu *csd);
+
+/*
+ * Coalesce the IPIs of the asynchronous cross calls issued between
+ * begin and end into at most one IPI per destination CPU.
+ */
+void smp_call_ipi_batch_begin(void);
+void smp_call_ipi_batch_end(void);
 
 int smp_call_function_any(const struct cpumask *mask,
 			  smp_call_func_t func, void *info, int wait);
@@ -153,6 +162,14 @@ static inline void smp_send_reschedule(int cpu) { }
 #define smp_prepare_boot_cpu()			do {} while (0)
 #define smp_call_function_many(mask, func, info, wait) \
 			(up_smp_call_function(func, info))
+static inline int
+smp_call_function_many_async(const struct cpumask *mask,
+			     call_single_data_t __percpu *csd)
+{
+	return 0;
+}
+static inline void smp_call_ipi_batch_begin(void) { }
+static inline void smp_call_ipi_batch_end(void) { }
 static inline void call_function_init(void) { }
 
 static inline int
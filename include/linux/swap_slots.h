@@ -6,7 +6,7 @@
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
 
-#define SWAP_SLOTS_CACHE_SIZE			SWAP_BATCH
+#define SWAP_SLOTS_CACHE_SIZE			(2*SWAP_BATCH)
 #define THRESHOLD_ACTIVATE_SWAP_SLOTS_CACHE	(5*SWAP_SLOTS_CACHE_SIZE)
 #define THRESHOLD_DEACTIVATE_SWAP_SLOTS_CACHE	(2*SWAP_SLOTS_CACHE_SIZE)
 
@@ -25,6 +25,7 @@ void disable_swap_slots_cache_lock(void);
 void reenable_swap_slots_cache_unlock(void);
 int enable_swap_slots_cache(void);
 int free_swap_slot(swp_entry_t entry);
+void kick_swap_slots_cache_drain(void);
 
 extern bool swap_slot_cache_enabled;
 
@@ -13,8 +13,12 @@
 #include <linux/slab.h>
 
 #ifdef CONFIG_TASKSTATS
+/* upper bound for the taskstats_exit_batch_size sysctl */
+#define TASKSTATS_EXIT_BATCH_MAX	32
+
 extern struct kmem_cache *taskstats_cache;
 extern struct mutex taskstats_exit_mutex;
+extern int taskstats_exit_batch_size;
 
 static inline void taskstats_tgid_free(struct signal_struct *sig)
 {
@@ -288,6 +288,13 @@ struct tcp_sock {
 	u32	max_packets_out;  /* max packets_out in last window */
 	u32	max_packets_seq;  /* right edge of max_packets_out flight */
 
+	/* Cached result of tcp_tso_segs(), valid while the shifted pacing
+	 * rate and mss it was derived from are unchanged.
+	 */
+	u32	tso_segs_cached;
+	u32	tso_mss_cached;
+	unsigned long tso_rate_cached; /* sk_pacing_rate >> sk_pacing_shift */
+
 	u16	urg_data;	/* Saved octet of OOB data and control flags */
 	u8	ecn_flags;	/* ECN status bits.			*/
 	u8	keepalive_probes; /* num of allowed keep alive probes	*/
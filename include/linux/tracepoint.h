@@ -186,12 +186,20 @@ static inline struct tracepoint *tracepoint_ptr_deref(tracepoint_ptr_t *p)
 									\
 		it_func_ptr = rcu_dereference_raw((tp)->funcs);		\
 									\
+		/*							\
+		 * A single attached probe is by far the common case,	\
+		 * so call it straight away and only fall into the	\
+		 * iteration when a second array entry exists.		\
+		 */							\
 		if (it_func_ptr) {					\
-			do {						\
+			it_func = (it_func_ptr)->func;			\
+			__data = (it_func_ptr)->data;			\
+			((void(*)(proto))(it_func))(args);		\
+			while (unlikely((++it_func_ptr)->func)) {	\
 				it_func = (it_func_ptr)->func;		\
 				__data = (it_func_ptr)->data;		\
 				((void(*)(proto))(it_func))(args);	\
-			} while ((++it_func_ptr)->func);		\
+			}						\
 		}							\
 									\
 		if (rcuidle) {						\
@@ -129,6 +129,27 @@ struct rcu_work {
 	struct workqueue_struct *wq;
 };
 
+/**
+ * enum wq_affn_scope - types of worker CPU affinity scopes
+ * @WQ_AFFN_CPU: one pod per CPU
+ * @WQ_AFFN_SMT: one pod per SMT sibling group
+ * @WQ_AFFN_CACHE: one pod per last-level cache domain
+ * @WQ_AFFN_NUMA: one pod per NUMA node
+ * @WQ_AFFN_SYSTEM: one pod spanning the whole system
+ *
+ * Scopes which the running kernel has no topology information for fall
+ * back to the next wider scope.
+ */
+enum wq_affn_scope {
+	WQ_AFFN_CPU,
+	WQ_AFFN_SMT,
+	WQ_AFFN_CACHE,
+	WQ_AFFN_NUMA,
+	WQ_AFFN_SYSTEM,
+
+	WQ_AFFN_NR_TYPES,
+};
+
 /**
  * struct workqueue_attrs - A struct for workqueue attributes.
  *
@@ -145,6 +166,17 @@ struct workqueue_attrs {
 	 */
 	cpumask_var_t cpumask;
 
+	/**
+	 * @affn_scope: unbound CPU affinity scope
+	 *
+	 * Work items queued on an unbound workqueue are executed within the
+	 * CPU pod of the queueing CPU; @affn_scope selects the topology
+	 * level pods are built from.  Like ``no_numa`` below, this isn't a
+	 * property of a worker_pool and doesn't participate in pool hash
+	 * calculations or equality comparisons.
+	 */
+	enum wq_affn_scope affn_scope;
+
 	/**
 	 * @no_numa: disable NUMA affinity
 	 *
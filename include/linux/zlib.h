@@ -197,6 +197,26 @@ extern int zlib_deflate_dfltcc_enabled (void);
    otherwise 0.
 */
 
+/* Effort classes returned by zlib_deflate_effort() */
+#define Z_EFFORT_STORE 0
+#define Z_EFFORT_FAST  1
+#define Z_EFFORT_DEEP  2
+
+extern int zlib_deflate_effort (const unsigned char *data, unsigned int len);
+/*
+   Estimates from a cheap entropy sample of the buffer how much deflate
+   effort the data deserves: Z_EFFORT_STORE for data that is unlikely to
+   compress at all, Z_EFFORT_FAST for data where a fast level (1-3)
+   captures most of the win, Z_EFFORT_DEEP for data worth the caller's
+   configured level.  Every decision is counted, see
+   zlib_deflate_effort_stats().
+*/
+
+extern void zlib_deflate_effort_stats (unsigned long long stats[3]);
+/*
+   Copies the running decision counters out, indexed by effort class.
+*/
+
 /* 
 extern int deflateInit (z_streamp strm, int level);
 
@@ -16,6 +16,7 @@
 #include <linux/bitops.h>
 #include <linux/pm_qos.h>
 #include <linux/refcount.h>
+#include <linux/ktime.h>
 
 #define snd_pcm_substream_chip(substream) ((substream)->private_data)
 #define snd_pcm_chip(pcm) ((pcm)->private_data)
@@ -464,6 +465,9 @@ struct snd_pcm_substream {
 	struct list_head link_list;	/* linked list member */
 	struct snd_pcm_group self_group;	/* fake group for non linked substream (with substream lock inside) */
 	struct snd_pcm_group *group;		/* pointer to current group */
+	/* -- period sweep -- */
+	struct list_head sweep_list;	/* entry in the global sweep timer list */
+	ktime_t sweep_interval;		/* period time for the sweep timer */
 	/* -- assigned files -- */
 	int ref_count;
 	atomic_t mmap_count;
@@ -1062,6 +1066,8 @@ void snd_pcm_set_sync(struct snd_pcm_substream *substream);
 int snd_pcm_lib_ioctl(struct snd_pcm_substream *substream,
 		      unsigned int cmd, void *arg);                      
 void snd_pcm_period_elapsed(struct snd_pcm_substream *substream);
+void snd_pcm_sweep_start(struct snd_pcm_substream *substream);
+void snd_pcm_sweep_stop(struct snd_pcm_substream *substream);
 snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
 				     void *buf, bool interleaved,
 				     snd_pcm_uframes_t frames, bool in_kernel);
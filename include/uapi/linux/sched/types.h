@@ -10,6 +10,7 @@ struct sched_param {
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
 #define SCHED_ATTR_SIZE_VER1	56	/* add: util_{min,max} */
+#define SCHED_ATTR_SIZE_VER2	60	/* add: latency_nice */
 
 /*
  * Extended scheduling parameters data structure.
@@ -96,6 +97,16 @@ struct sched_param {
  * on a CPU with a capacity big enough to fit the specified value.
  * A task with a max utilization value smaller than 1024 is more likely
  * scheduled on a CPU with no more capacity than the specified value.
+ *
+ * Latency tolerance of a task can be specified through:
+ *
+ *  @sched_latency_nice	task's latency_nice value
+ *
+ * The latency_nice of a task can take any value in the range
+ * [MIN_LATENCY_NICE..MAX_LATENCY_NICE]. A lower value means the task is
+ * sensitive to wakeup latency; a higher value means it tolerates being
+ * delayed in favour of other tasks. It is a hint to the scheduler and
+ * provides no bandwidth or placement guarantee.
  */
 struct sched_attr {
 	__u32 size;
@@ -118,6 +129,9 @@ struct sched_attr {
 	__u32 sched_util_min;
 	__u32 sched_util_max;
 
+	/* Latency hints */
+	__s32 sched_latency_nice;
+
 };
 
 #endif /* _UAPI_LINUX_SCHED_TYPES_H */
@@ -51,6 +51,7 @@ struct shmid_ds {
 /* Bits 9 & 10 are IPC_CREAT and IPC_EXCL */
 #define SHM_HUGETLB	04000	/* segment will use huge TLB pages */
 #define SHM_NORESERVE	010000	/* don't check for reservations */
+#define SHM_HUGEPAGE	020000	/* back with transparent huge pages */
 
 /*
  * Huge page size encoding when SHM_HUGETLB is specified, and a huge page
@@ -79,6 +80,7 @@ struct shmid_ds {
 #define	SHM_RND		020000	/* round attach address to SHMLBA boundary */
 #define	SHM_REMAP	040000	/* take-over region on attach */
 #define	SHM_EXEC	0100000	/* execution access */
+#define	SHM_PREFAULT	0200000	/* populate the whole mapping at attach */
 
 /* super user shmctl commands */
 #define SHM_LOCK 	11
@@ -34,10 +34,18 @@
  */
 
 
-#define TASKSTATS_VERSION	10
+#define TASKSTATS_VERSION	11
 #define TS_COMM_LEN		32	/* should be >= TASK_COMM_LEN
 					 * in linux/sched.h */
 
+/*
+ * Layout of the delay histograms below: bucket 0 counts delays shorter
+ * than 2^TASKSTATS_HIST_SHIFT ns, bucket i delays shorter than
+ * 2^(TASKSTATS_HIST_SHIFT + i) ns, and the last bucket is open ended.
+ */
+#define TASKSTATS_HIST_SHIFT	10
+#define TASKSTATS_HIST_BUCKETS	20
+
 struct taskstats {
 
 	/* The version number of this struct. This field is always set to
@@ -172,6 +180,12 @@ struct taskstats {
 
 	/* v10: 64-bit btime to avoid overflow */
 	__u64	ac_btime64;		/* 64-bit begin time */
+
+	/* v11: log2 delay histograms, see TASKSTATS_HIST_SHIFT above */
+	__u64	blkio_delay_hist[TASKSTATS_HIST_BUCKETS];
+	__u64	swapin_delay_hist[TASKSTATS_HIST_BUCKETS];
+	__u64	freepages_delay_hist[TASKSTATS_HIST_BUCKETS];
+	__u64	thrashing_delay_hist[TASKSTATS_HIST_BUCKETS];
 };
 
 
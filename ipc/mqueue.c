@@ -63,6 +63,14 @@ struct posix_msg_tree_node {
 	int			priority;
 };
 
+/*
+ * Priorities below this bound use a direct-indexed list per priority
+ * instead of the rbtree: O(1) send/receive with no node allocation at
+ * all.  Most real queues use a handful of small fixed priorities, the
+ * rbtree only has to cope with the tail up to MQ_PRIO_MAX.
+ */
+#define MQ_PRIO_DIRECT	64
+
 /*
  * Locking:
  *
@@ -138,6 +146,9 @@ struct mqueue_inode_info {
 	struct rb_root msg_tree;
 	struct rb_node *msg_tree_rightmost;
 	struct posix_msg_tree_node *node_cache;
+	/* messages with a priority below MQ_PRIO_DIRECT */
+	struct list_head direct_msgs[MQ_PRIO_DIRECT];
+	DECLARE_BITMAP(direct_bitmap, MQ_PRIO_DIRECT);
 	struct mq_attr attr;
 
 	struct sigevent notify;
@@ -195,6 +206,14 @@ static int msg_insert(struct msg_msg *msg, struct mqueue_inode_info *info)
 	struct posix_msg_tree_node *leaf;
 	bool rightmost = true;
 
+	if (msg->m_type < MQ_PRIO_DIRECT) {
+		__set_bit(msg->m_type, info->direct_bitmap);
+		info->attr.mq_curmsgs++;
+		info->qsize += msg->m_ts;
+		list_add_tail(&msg->m_list, &info->direct_msgs[msg->m_type]);
+		return 0;
+	}
+
 	p = &info->msg_tree.rb_node;
 	while (*p) {
 		parent = *p;
@@ -252,15 +271,27 @@ static inline struct msg_msg *msg_get(struct mqueue_inode_info *info)
 	struct rb_node *parent = NULL;
 	struct posix_msg_tree_node *leaf;
 	struct msg_msg *msg;
+	int prio;
 
 try_again:
 	/*
 	 * During insert, low priorities go to the left and high to the
 	 * right.  On receive, we want the highest priorities first, so
-	 * walk all the way to the right.
+	 * walk all the way to the right.  The tree only holds priorities
+	 * from MQ_PRIO_DIRECT upwards, so anything in it beats the
+	 * direct-indexed lists.
 	 */
 	parent = info->msg_tree_rightmost;
 	if (!parent) {
+		prio = find_last_bit(info->direct_bitmap, MQ_PRIO_DIRECT);
+		if (prio < MQ_PRIO_DIRECT) {
+			msg = list_first_entry(&info->direct_msgs[prio],
+					       struct msg_msg, m_list);
+			list_del(&msg->m_list);
+			if (list_empty(&info->direct_msgs[prio]))
+				__clear_bit(prio, info->direct_bitmap);
+			goto got_msg;
+		}
 		if (info->attr.mq_curmsgs) {
 			pr_warn_once("Inconsistency in POSIX message queue, "
 				     "no tree element, but supposedly messages "
@@ -284,6 +315,7 @@ try_again:
 			msg_tree_erase(leaf, info);
 		}
 	}
+got_msg:
 	info->attr.mq_curmsgs--;
 	info->qsize -= msg->m_ts;
 	return msg;
@@ -310,6 +342,7 @@ static struct inode *mqueue_get_inode(struct super_block *sb,
 	if (S_ISREG(mode)) {
 		struct mqueue_inode_info *info;
 		unsigned long mq_bytes, mq_treesize;
+		int i;
 
 		inode->i_fop = &mqueue_file_operations;
 		inode->i_size = FILENT_SIZE;
@@ -326,6 +359,9 @@ static struct inode *mqueue_get_inode(struct super_block *sb,
 		info->msg_tree = RB_ROOT;
 		info->msg_tree_rightmost = NULL;
 		info->node_cache = NULL;
+		for (i = 0; i < MQ_PRIO_DIRECT; i++)
+			INIT_LIST_HEAD(&info->direct_msgs[i]);
+		bitmap_zero(info->direct_bitmap, MQ_PRIO_DIRECT);
 		memset(&info->attr, 0, sizeof(info->attr));
 		info->attr.mq_maxmsg = min(ipc_ns->mq_msg_max,
 					   ipc_ns->mq_msg_default);
@@ -834,21 +834,53 @@ static inline int check_restart(struct sem_array *sma, struct sem_queue *q)
 	return 0;
 }
 
+/**
+ * sem_queue_intersects - does a sleeping operation touch a modified semaphore?
+ * @q: sleeping operation
+ * @sops: operations that modified the array, may be NULL
+ * @nsops: number of operations
+ *
+ * A sleeping operation on the global queues can only have become runnable
+ * if it shares at least one semaphore with the operations that were just
+ * applied.  NULL @sops means the modified semaphores are not known, then
+ * every operation must be assumed affected.
+ */
+static int sem_queue_intersects(struct sem_queue *q, struct sembuf *sops,
+				int nsops)
+{
+	int i, j;
+
+	if (!sops)
+		return 1;
+
+	for (i = 0; i < nsops; i++) {
+		for (j = 0; j < q->nsops; j++) {
+			if (sops[i].sem_num == q->sops[j].sem_num)
+				return 1;
+		}
+	}
+	return 0;
+}
+
 /**
  * wake_const_ops - wake up non-alter tasks
  * @sma: semaphore array.
  * @semnum: semaphore that was modified.
+ * @sops: operations that modified the array, may be NULL.
+ * @nsops: number of operations.
  * @wake_q: lockless wake-queue head.
  *
  * wake_const_ops must be called after a semaphore in a semaphore array
  * was set to 0. If complex const operations are pending, wake_const_ops must
  * be called with semnum = -1, as well as with the number of each modified
- * semaphore.
+ * semaphore.  @sops restricts the global queue scan to the operations that
+ * name a modified semaphore, the others cannot have become runnable.
  * The tasks that must be woken up are added to @wake_q. The return code
  * is stored in q->pid.
  * The function returns 1 if at least one operation was completed successfully.
  */
 static int wake_const_ops(struct sem_array *sma, int semnum,
+			  struct sembuf *sops, int nsops,
 			  struct wake_q_head *wake_q)
 {
 	struct sem_queue *q, *tmp;
@@ -861,7 +893,12 @@ static int wake_const_ops(struct sem_array *sma, int semnum,
 		pending_list = &sma->sems[semnum].pending_const;
 
 	list_for_each_entry_safe(q, tmp, pending_list, list) {
-		int error = perform_atomic_semop(sma, q);
+		int error;
+
+		if (semnum == -1 && !sem_queue_intersects(q, sops, nsops))
+			continue;
+
+		error = perform_atomic_semop(sma, q);
 
 		if (error > 0)
 			continue;
@@ -901,7 +938,9 @@ static int do_smart_wakeup_zero(struct sem_array *sma, struct sembuf *sops,
 
 			if (sma->sems[num].semval == 0) {
 				got_zero = 1;
-				semop_completed |= wake_const_ops(sma, num, wake_q);
+				semop_completed |= wake_const_ops(sma, num,
+								  NULL, 0,
+								  wake_q);
 			}
 		}
 	} else {
@@ -912,7 +951,9 @@ static int do_smart_wakeup_zero(struct sem_array *sma, struct sembuf *sops,
 		for (i = 0; i < sma->sem_nsems; i++) {
 			if (sma->sems[i].semval == 0) {
 				got_zero = 1;
-				semop_completed |= wake_const_ops(sma, i, wake_q);
+				semop_completed |= wake_const_ops(sma, i,
+								  NULL, 0,
+								  wake_q);
 			}
 		}
 	}
@@ -921,7 +962,7 @@ static int do_smart_wakeup_zero(struct sem_array *sma, struct sembuf *sops,
 	 * then check the global queue, too.
 	 */
 	if (got_zero)
-		semop_completed |= wake_const_ops(sma, -1, wake_q);
+		semop_completed |= wake_const_ops(sma, -1, sops, nsops, wake_q);
 
 	return semop_completed;
 }
@@ -931,19 +972,24 @@ static int do_smart_wakeup_zero(struct sem_array *sma, struct sembuf *sops,
  * update_queue - look for tasks that can be completed.
  * @sma: semaphore array.
  * @semnum: semaphore that was modified.
+ * @sops: operations that modified the array, may be NULL.
+ * @nsops: number of operations.
  * @wake_q: lockless wake-queue head.
  *
  * update_queue must be called after a semaphore in a semaphore array
  * was modified. If multiple semaphores were modified, update_queue must
  * be called with semnum = -1, as well as with the number of each modified
- * semaphore.
+ * semaphore.  @sops restricts the global queue scan to the operations
+ * that name a modified semaphore, the others cannot have become runnable.
  * The tasks that must be woken up are added to @wake_q. The return code
  * is stored in q->pid.
  * The function internally checks if const operations can now succeed.
  *
  * The function return 1 if at least one semop was completed successfully.
  */
-static int update_queue(struct sem_array *sma, int semnum, struct wake_q_head *wake_q)
+static int update_queue(struct sem_array *sma, int semnum,
+			struct sembuf *sops, int nsops,
+			struct wake_q_head *wake_q)
 {
 	struct sem_queue *q, *tmp;
 	struct list_head *pending_list;
@@ -968,6 +1014,9 @@ again:
 		if (semnum != -1 && sma->sems[semnum].semval == 0)
 			break;
 
+		if (semnum == -1 && !sem_queue_intersects(q, sops, nsops))
+			continue;
+
 		error = perform_atomic_semop(sma, q);
 
 		/* Does q->sleeper still need to sleep? */
@@ -985,8 +1034,14 @@ again:
 		}
 
 		wake_up_sem_queue_prepare(q, error, wake_q);
-		if (restart)
+		if (restart) {
+			/*
+			 * The wakeup above modified semaphores beyond the
+			 * ones in @sops, so the filter no longer applies.
+			 */
+			sops = NULL;
 			goto again;
+		}
 	}
 	return semop_completed;
 }
@@ -1032,7 +1087,7 @@ static void do_smart_update(struct sem_array *sma, struct sembuf *sops, int nsop
 
 	if (!list_empty(&sma->pending_alter)) {
 		/* semaphore array uses the global queue - just process it. */
-		otime |= update_queue(sma, -1, wake_q);
+		otime |= update_queue(sma, -1, sops, nsops, wake_q);
 	} else {
 		if (!sops) {
 			/*
@@ -1040,7 +1095,8 @@ static void do_smart_update(struct sem_array *sma, struct sembuf *sops, int nsop
 			 * known. Check all.
 			 */
 			for (i = 0; i < sma->sem_nsems; i++)
-				otime |= update_queue(sma, i, wake_q);
+				otime |= update_queue(sma, i, NULL, 0,
+						      wake_q);
 		} else {
 			/*
 			 * Check the semaphores that were increased:
@@ -1054,7 +1110,8 @@ static void do_smart_update(struct sem_array *sma, struct sembuf *sops, int nsop
 			for (i = 0; i < nsops; i++) {
 				if (sops[i].sem_op > 0) {
 					otime |= update_queue(sma,
-							      sops[i].sem_num, wake_q);
+							      sops[i].sem_num,
+							      NULL, 0, wake_q);
 				}
 			}
 		}
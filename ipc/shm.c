@@ -33,6 +33,7 @@
 #include <linux/file.h>
 #include <linux/mman.h>
 #include <linux/shmem_fs.h>
+#include <linux/khugepaged.h>
 #include <linux/security.h>
 #include <linux/syscalls.h>
 #include <linux/audit.h>
@@ -625,6 +626,8 @@ static int newseg(struct ipc_namespace *ns, struct ipc_params *params)
 
 	shp->shm_perm.key = key;
 	shp->shm_perm.mode = (shmflg & S_IRWXUGO);
+	if ((shmflg & SHM_HUGEPAGE) && !(shmflg & SHM_HUGETLB))
+		shp->shm_perm.mode |= SHM_HUGEPAGE;
 	shp->mlock_user = NULL;
 
 	shp->shm_perm.security = NULL;
@@ -1430,6 +1433,7 @@ long do_shmat(int shmid, char __user *shmaddr, int shmflg,
 	struct shm_file_data *sfd;
 	int f_flags;
 	unsigned long populate = 0;
+	bool use_thp;
 
 	err = -EINVAL;
 	if (shmid < 0)
@@ -1458,6 +1462,13 @@ long do_shmat(int shmid, char __user *shmaddr, int shmflg,
 	} else if ((shmflg & SHM_REMAP))
 		goto out;
 
+	/*
+	 * Fault the whole segment in before returning, in a single batched
+	 * page-table walk, rather than 4K at a time as it is touched.
+	 */
+	if (shmflg & SHM_PREFAULT)
+		flags |= MAP_POPULATE;
+
 	if (shmflg & SHM_RDONLY) {
 		prot = PROT_READ;
 		acc_mode = S_IRUGO;
@@ -1513,6 +1524,7 @@ long do_shmat(int shmid, char __user *shmaddr, int shmflg,
 	base = get_file(shp->shm_file);
 	shp->shm_nattch++;
 	size = i_size_read(file_inode(base));
+	use_thp = shp->shm_perm.mode & SHM_HUGEPAGE;
 	ipc_unlock_object(&shp->shm_perm);
 	rcu_read_unlock();
 
@@ -1563,6 +1575,20 @@ long do_shmat(int shmid, char __user *shmaddr, int shmflg,
 	err = 0;
 	if (IS_ERR_VALUE(addr))
 		err = (long)addr;
+	else if (use_thp) {
+		/*
+		 * Segments created with SHM_HUGEPAGE behave as if every
+		 * attacher had done madvise(MADV_HUGEPAGE): shmem may then
+		 * allocate huge pages at fault time (subject to
+		 * shmem_enabled) and khugepaged may collapse the mapping.
+		 */
+		struct vm_area_struct *vma = find_vma(current->mm, addr);
+
+		if (vma && vma->vm_start == addr) {
+			vma->vm_flags |= VM_HUGEPAGE;
+			khugepaged_enter(vma, vma->vm_flags);
+		}
+	}
 invalid:
 	up_write(&current->mm->mmap_sem);
 	if (populate)
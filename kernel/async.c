@@ -67,17 +67,35 @@ static DEFINE_SPINLOCK(async_lock);
 struct async_entry {
 	struct list_head	domain_list;
 	struct list_head	global_list;
+	struct list_head	throttled_list;
 	struct work_struct	work;
 	async_cookie_t		cookie;
 	async_func_t		func;
 	void			*data;
 	struct async_domain	*domain;
+	int			node;
+	/* dependency tracking, all under async_lock */
+	struct list_head	dependents;	/* edges to waiting entries */
+	unsigned int		nr_deps;	/* unfinished prerequisites */
+	u64			dep_path_ns;	/* longest chain feeding us */
+	unsigned int		dep_path_len;
+};
+
+/* one prerequisite -> dependent edge, lives on the parent's list */
+struct async_dep_edge {
+	struct list_head	node;
+	struct async_entry	*child;
 };
 
 static DECLARE_WAIT_QUEUE_HEAD(async_done);
 
 static atomic_t entry_count;
 
+/* longest completed dependency chain, for the boot-time report */
+static u64 async_crit_path_ns;
+static unsigned int async_crit_path_len;
+static async_func_t async_crit_path_func;
+
 static async_cookie_t lowest_in_progress(struct async_domain *domain)
 {
 	struct async_entry *first = NULL;
@@ -103,6 +121,39 @@ static async_cookie_t lowest_in_progress(struct async_domain *domain)
 	return ret;
 }
 
+/*
+ * Hand an entry whose prerequisites have all completed to the workqueue,
+ * unless its domain is at its concurrency limit, in which case it waits
+ * on the domain's throttled list.  Called under async_lock.
+ */
+static void async_queue_entry(struct async_entry *entry)
+{
+	struct async_domain *domain = entry->domain;
+
+	if (domain->max_active && domain->nr_active >= domain->max_active) {
+		list_add_tail(&entry->throttled_list, &domain->throttled);
+		return;
+	}
+	domain->nr_active++;
+	queue_work_node(entry->node, system_unbound_wq, &entry->work);
+}
+
+/* Fill freed-up execution slots from the throttled list, under async_lock. */
+static void async_unthrottle_domain(struct async_domain *domain)
+{
+	while (!list_empty(&domain->throttled) &&
+	       (!domain->max_active ||
+		domain->nr_active < domain->max_active)) {
+		struct async_entry *entry;
+
+		entry = list_first_entry(&domain->throttled,
+					 struct async_entry, throttled_list);
+		list_del_init(&entry->throttled_list);
+		domain->nr_active++;
+		queue_work_node(entry->node, system_unbound_wq, &entry->work);
+	}
+}
+
 /*
  * pick the first pending entry and run it
  */
@@ -110,111 +161,267 @@ static void async_run_entry_fn(struct work_struct *work)
 {
 	struct async_entry *entry =
 		container_of(work, struct async_entry, work);
+	struct async_dep_edge *edge, *tmp;
 	unsigned long flags;
-	ktime_t uninitialized_var(calltime), delta, rettime;
+	unsigned int path_len;
+	u64 calltime, path_ns;
 
 	/* 1) run (and print duration) */
-	if (initcall_debug && system_state < SYSTEM_RUNNING) {
+	if (initcall_debug && system_state < SYSTEM_RUNNING)
 		pr_debug("calling  %lli_%pS @ %i\n",
 			(long long)entry->cookie,
 			entry->func, task_pid_nr(current));
-		calltime = ktime_get();
-	}
+	calltime = ktime_get_ns();
 	entry->func(entry->data, entry->cookie);
-	if (initcall_debug && system_state < SYSTEM_RUNNING) {
-		rettime = ktime_get();
-		delta = ktime_sub(rettime, calltime);
+	path_ns = entry->dep_path_ns + (ktime_get_ns() - calltime);
+	path_len = entry->dep_path_len + 1;
+	if (initcall_debug && system_state < SYSTEM_RUNNING)
 		pr_debug("initcall %lli_%pS returned 0 after %lld usecs\n",
 			(long long)entry->cookie,
 			entry->func,
-			(long long)ktime_to_ns(delta) >> 10);
-	}
+			(long long)(path_ns - entry->dep_path_ns) >> 10);
 
 	/* 2) remove self from the pending queues */
 	spin_lock_irqsave(&async_lock, flags);
 	list_del_init(&entry->domain_list);
 	list_del_init(&entry->global_list);
 
-	/* 3) free the entry */
+	entry->domain->nr_active--;
+
+	/* 3) kick off entries that were waiting on us */
+	list_for_each_entry_safe(edge, tmp, &entry->dependents, node) {
+		struct async_entry *child = edge->child;
+
+		if (path_ns > child->dep_path_ns) {
+			child->dep_path_ns = path_ns;
+			child->dep_path_len = path_len;
+		}
+		list_del(&edge->node);
+		kfree(edge);
+		if (!--child->nr_deps)
+			async_queue_entry(child);
+	}
+	async_unthrottle_domain(entry->domain);
+
+	/* 4) remember the longest chain seen so far */
+	if (path_ns > async_crit_path_ns) {
+		async_crit_path_ns = path_ns;
+		async_crit_path_len = path_len;
+		async_crit_path_func = entry->func;
+	}
+
+	/* 5) free the entry */
 	kfree(entry);
 	atomic_dec(&entry_count);
 
 	spin_unlock_irqrestore(&async_lock, flags);
 
-	/* 4) wake up any waiters */
+	/* 6) wake up any waiters */
 	wake_up(&async_done);
 }
 
 /**
- * async_schedule_node_domain - NUMA specific version of async_schedule_domain
+ * async_schedule_dep_node_domain - schedule a function behind prerequisites
  * @func: function to execute asynchronously
  * @data: data pointer to pass to the function
  * @node: NUMA node that we want to schedule this on or close to
  * @domain: the domain
+ * @deps: cookies of @domain entries that must complete before @func runs,
+ *        may be NULL when @nr_deps is 0
+ * @nr_deps: number of entries in @deps
  *
- * Returns an async_cookie_t that may be used for checkpointing later.
- * @domain may be used in the async_synchronize_*_domain() functions to
- * wait within a certain synchronization domain rather than globally.
- *
- * Note: This function may be called from atomic or non-atomic contexts.
+ * Like async_schedule_node_domain(), but @func does not start executing
+ * before every call named in @deps has completed.  Cookies of already
+ * completed calls are fine, so callers don't have to track completion
+ * themselves; cookies must come from the same @domain.  Independent
+ * calls still run fully parallel - the graph only orders what the
+ * caller explicitly connects, unlike async_synchronize_cookie() which
+ * waits for everything scheduled earlier.
  *
- * The node requested will be honored on a best effort basis. If the node
- * has no CPUs associated with it then the work is distributed among all
- * available CPUs.
+ * In out-of-memory situations the call degrades to waiting for the
+ * prerequisites and running @func synchronously.
  */
-async_cookie_t async_schedule_node_domain(async_func_t func, void *data,
-					  int node, struct async_domain *domain)
+async_cookie_t async_schedule_dep_node_domain(async_func_t func, void *data,
+					      int node,
+					      struct async_domain *domain,
+					      const async_cookie_t *deps,
+					      unsigned int nr_deps)
 {
 	struct async_entry *entry;
+	struct async_dep_edge *edge;
+	LIST_HEAD(edges);
 	unsigned long flags;
 	async_cookie_t newcookie;
+	unsigned int i;
 
 	/* allow irq-off callers */
 	entry = kzalloc(sizeof(struct async_entry), GFP_ATOMIC);
+	for (i = 0; entry && i < nr_deps; i++) {
+		edge = kzalloc(sizeof(*edge), GFP_ATOMIC);
+		if (!edge) {
+			kfree(entry);
+			entry = NULL;
+			break;
+		}
+		list_add(&edge->node, &edges);
+	}
 
 	/*
 	 * If we're out of memory or if there's too much work
 	 * pending already, we execute synchronously.
 	 */
 	if (!entry || atomic_read(&entry_count) > MAX_WORK) {
-		kfree(entry);
+		struct async_dep_edge *etmp;
+
+		list_for_each_entry_safe(edge, etmp, &edges, node) {
+			list_del(&edge->node);
+			kfree(edge);
+		}
 		spin_lock_irqsave(&async_lock, flags);
 		newcookie = next_cookie++;
 		spin_unlock_irqrestore(&async_lock, flags);
 
-		/* low on memory.. run synchronously */
+		/* low on memory.. wait for the prerequisites and run */
+		for (i = 0; i < nr_deps; i++)
+			async_synchronize_cookie_domain(deps[i] + 1, domain);
 		func(data, newcookie);
 		return newcookie;
 	}
 	INIT_LIST_HEAD(&entry->domain_list);
 	INIT_LIST_HEAD(&entry->global_list);
+	INIT_LIST_HEAD(&entry->throttled_list);
+	INIT_LIST_HEAD(&entry->dependents);
 	INIT_WORK(&entry->work, async_run_entry_fn);
 	entry->func = func;
 	entry->data = data;
 	entry->domain = domain;
+	entry->node = node;
 
 	spin_lock_irqsave(&async_lock, flags);
 
 	/* allocate cookie and queue */
 	newcookie = entry->cookie = next_cookie++;
 
+	/*
+	 * Hook up the dependency edges.  The pending list is ordered by
+	 * cookie, so the walk can stop early; a prerequisite that is not
+	 * on it anymore has completed and needs no edge.  Chains running
+	 * through already completed prerequisites don't contribute to
+	 * the critical path accounting.
+	 */
+	for (i = 0; i < nr_deps; i++) {
+		struct async_entry *parent;
+
+		if (WARN_ON_ONCE(deps[i] >= newcookie))
+			continue;
+		list_for_each_entry(parent, &domain->pending, domain_list) {
+			if (parent->cookie > deps[i])
+				break;
+			if (parent->cookie == deps[i]) {
+				edge = list_first_entry(&edges,
+						struct async_dep_edge, node);
+				list_del(&edge->node);
+				edge->child = entry;
+				list_add_tail(&edge->node,
+					      &parent->dependents);
+				entry->nr_deps++;
+				break;
+			}
+		}
+	}
+
 	list_add_tail(&entry->domain_list, &domain->pending);
 	if (domain->registered)
 		list_add_tail(&entry->global_list, &async_global_pending);
 
 	atomic_inc(&entry_count);
+
+	if (!entry->nr_deps)
+		async_queue_entry(entry);
+
 	spin_unlock_irqrestore(&async_lock, flags);
 
+	/* free the edges that resolved to completed prerequisites */
+	while (!list_empty(&edges)) {
+		edge = list_first_entry(&edges, struct async_dep_edge, node);
+		list_del(&edge->node);
+		kfree(edge);
+	}
+
 	/* mark that this task has queued an async job, used by module init */
 	current->flags |= PF_USED_ASYNC;
 
-	/* schedule for execution */
-	queue_work_node(node, system_unbound_wq, &entry->work);
-
 	return newcookie;
 }
+EXPORT_SYMBOL_GPL(async_schedule_dep_node_domain);
+
+/**
+ * async_schedule_dep - schedule a function behind explicit prerequisites
+ * @func: function to execute asynchronously
+ * @data: data pointer to pass to the function
+ * @deps: cookies of calls that must complete before @func runs
+ * @nr_deps: number of entries in @deps
+ *
+ * async_schedule_dep_node_domain() on the default domain without NUMA
+ * preference.
+ */
+async_cookie_t async_schedule_dep(async_func_t func, void *data,
+				  const async_cookie_t *deps,
+				  unsigned int nr_deps)
+{
+	return async_schedule_dep_node_domain(func, data, NUMA_NO_NODE,
+					      &async_dfl_domain, deps,
+					      nr_deps);
+}
+EXPORT_SYMBOL_GPL(async_schedule_dep);
+
+/**
+ * async_schedule_node_domain - NUMA specific version of async_schedule_domain
+ * @func: function to execute asynchronously
+ * @data: data pointer to pass to the function
+ * @node: NUMA node that we want to schedule this on or close to
+ * @domain: the domain
+ *
+ * Returns an async_cookie_t that may be used for checkpointing later.
+ * @domain may be used in the async_synchronize_*_domain() functions to
+ * wait within a certain synchronization domain rather than globally.
+ *
+ * Note: This function may be called from atomic or non-atomic contexts.
+ *
+ * The node requested will be honored on a best effort basis. If the node
+ * has no CPUs associated with it then the work is distributed among all
+ * available CPUs.
+ */
+async_cookie_t async_schedule_node_domain(async_func_t func, void *data,
+					  int node, struct async_domain *domain)
+{
+	return async_schedule_dep_node_domain(func, data, node, domain,
+					      NULL, 0);
+}
 EXPORT_SYMBOL_GPL(async_schedule_node_domain);
 
+/**
+ * async_domain_set_max_active - limit the concurrency of an async domain
+ * @domain: the domain
+ * @max_active: maximum number of entries executing at once, 0 removes
+ *              the limit
+ *
+ * Entries over the limit are started in scheduling order as running
+ * ones complete.  Raising the limit kicks off throttled entries
+ * immediately; lowering it does not stop anything already executing.
+ */
+void async_domain_set_max_active(struct async_domain *domain,
+				 unsigned int max_active)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&async_lock, flags);
+	domain->max_active = max_active;
+	async_unthrottle_domain(domain);
+	spin_unlock_irqrestore(&async_lock, flags);
+}
+EXPORT_SYMBOL_GPL(async_domain_set_max_active);
+
 /**
  * async_schedule_node - NUMA specific version of async_schedule
  * @func: function to execute asynchronously
@@ -332,3 +539,22 @@ bool current_is_async(void)
 	return worker && worker->current_func == async_run_entry_fn;
 }
 EXPORT_SYMBOL_GPL(current_is_async);
+
+/*
+ * Report the longest dependency chain once boot-time probing has
+ * settled; that chain bounds how much more parallelism can buy, so it
+ * points at where splitting work or adding edges would actually help.
+ */
+static int __init async_report_critical_path(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&async_lock, flags);
+	if (async_crit_path_ns)
+		pr_info("async: longest dependency chain %llu usecs over %u calls, ending in %ps\n",
+			async_crit_path_ns / NSEC_PER_USEC,
+			async_crit_path_len, async_crit_path_func);
+	spin_unlock_irqrestore(&async_lock, flags);
+	return 0;
+}
+late_initcall_sync(async_report_critical_path);
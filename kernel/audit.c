@@ -141,8 +141,25 @@ struct list_head audit_inode_hash[AUDIT_INODE_BUCKETS];
 
 static struct kmem_cache *audit_buffer_cache;
 
-/* queue msgs to send via kauditd_task */
-static struct sk_buff_head audit_queue;
+/* queue msgs to send via kauditd_task
+ *
+ * Records are staged per-cpu so that audit_log_end() never contends on
+ * one global queue lock: producers only ever touch their local queue.
+ * Each record is stamped with a ticket from audit_queue_seq while the
+ * queue lock is held, which keeps every staging queue sorted and lets
+ * kauditd merge them back into a single, globally ordered send batch.
+ * audit_backlog_count replaces skb_queue_len() on the old global queue
+ * for backlog accounting; it covers the staged records plus the batch
+ * kauditd is currently sending. */
+static DEFINE_PER_CPU(struct sk_buff_head, audit_queue);
+static atomic_t audit_queue_seq = ATOMIC_INIT(0);
+static atomic_t audit_backlog_count = ATOMIC_INIT(0);
+/* cumulative time (jiffies) generators spent throttled on the backlog */
+static atomic_t audit_backlog_wait_time_actual = ATOMIC_INIT(0);
+
+/* record ordering ticket; the skb control buffer is scratch space until
+ * the record is handed to the netlink layer */
+#define audit_skb_seq(skb)	(*(u32 *)((skb)->cb))
 /* queue msgs due to temporary unicast send problems */
 static struct sk_buff_head audit_retry_queue;
 /* queue msgs waiting for new auditd connection */
@@ -799,6 +816,56 @@ static void kauditd_send_multicast_skb(struct sk_buff *skb)
 	nlmsg_multicast(sock, copy, 0, AUDIT_NLGRP_READLOG, GFP_KERNEL);
 }
 
+/* compare record ordering tickets, wraparound safe */
+static inline bool audit_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+/**
+ * kauditd_drain_queues - Merge the per-cpu staging queues into one batch
+ * @batch: the destination queue
+ *
+ * Description:
+ * Splice every cpu's staging queue and merge the records into @batch in
+ * ticket order.  Each staging queue is sorted by construction, so this is
+ * a plain k-way list merge.  Only kauditd calls this and @batch is
+ * private to it, so no locking is needed beyond the per-queue locks taken
+ * for the splice.
+ */
+static void kauditd_drain_queues(struct sk_buff_head *batch)
+{
+	struct sk_buff_head spliced;
+	struct sk_buff *skb, *pos;
+	unsigned long flags;
+	int cpu;
+
+	__skb_queue_head_init(&spliced);
+	for_each_possible_cpu(cpu) {
+		struct sk_buff_head *queue = &per_cpu(audit_queue, cpu);
+
+		spin_lock_irqsave(&queue->lock, flags);
+		skb_queue_splice_tail_init(queue, &spliced);
+		spin_unlock_irqrestore(&queue->lock, flags);
+
+		while ((skb = __skb_dequeue(&spliced))) {
+			/* common case: everything so far is older */
+			pos = skb_peek_tail(batch);
+			if (!pos || audit_seq_before(audit_skb_seq(pos),
+						     audit_skb_seq(skb))) {
+				__skb_queue_tail(batch, skb);
+				continue;
+			}
+			skb_queue_walk(batch, pos) {
+				if (audit_seq_before(audit_skb_seq(skb),
+						     audit_skb_seq(pos)))
+					break;
+			}
+			__skb_queue_before(batch, pos, skb);
+		}
+	}
+}
+
 /**
  * kauditd_thread - Worker thread to send audit records to userspace
  * @dummy: unused
@@ -807,12 +874,15 @@ static int kauditd_thread(void *dummy)
 {
 	int rc;
 	u32 portid = 0;
+	unsigned int batch_len;
 	struct net *net = NULL;
 	struct sock *sk = NULL;
 	struct auditd_connection *ac;
+	struct sk_buff_head batch;
 
 #define UNICAST_RETRIES 5
 
+	skb_queue_head_init(&batch);
 	set_freezable();
 	while (!kthread_should_stop()) {
 		/* NOTE: see the lock comments in auditd_send_unicast_skb() */
@@ -848,14 +918,20 @@ static int kauditd_thread(void *dummy)
 		}
 
 main_queue:
-		/* process the main queue - do the multicast send and attempt
-		 * unicast, dump failed record sends to the retry queue; if
-		 * sk == NULL due to previous failures we will just do the
-		 * multicast send and move the record to the hold queue */
-		rc = kauditd_send_queue(sk, portid, &audit_queue, 1,
+		/* merge the staging queues and process the batch - do the
+		 * multicast send and attempt unicast, dump failed record
+		 * sends to the retry queue; if sk == NULL due to previous
+		 * failures we will just do the multicast send and move the
+		 * record to the hold queue.  The batch is always drained
+		 * completely, so the backlog count can drop by its length
+		 * in one go once the records have been dealt with. */
+		kauditd_drain_queues(&batch);
+		batch_len = skb_queue_len(&batch);
+		rc = kauditd_send_queue(sk, portid, &batch, 1,
 					kauditd_send_multicast_skb,
 					(sk ?
 					 kauditd_retry_skb : kauditd_hold_skb));
+		atomic_sub(batch_len, &audit_backlog_count);
 		if (ac && rc < 0)
 			auditd_reset(ac);
 		sk = NULL;
@@ -874,7 +950,7 @@ main_queue:
 		 *       do the multicast send and rotate records from the
 		 *       main queue to the retry/hold queues */
 		wait_event_freezable(kauditd_wait,
-				     (skb_queue_len(&audit_queue) ? 1 : 0));
+				     (atomic_read(&audit_backlog_count) ? 1 : 0));
 	}
 
 	return 0;
@@ -1201,9 +1277,10 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 		s.rate_limit		= audit_rate_limit;
 		s.backlog_limit		= audit_backlog_limit;
 		s.lost			= atomic_read(&audit_lost);
-		s.backlog		= skb_queue_len(&audit_queue);
+		s.backlog		= atomic_read(&audit_backlog_count);
 		s.feature_bitmap	= AUDIT_FEATURE_BITMAP_ALL;
 		s.backlog_wait_time	= audit_backlog_wait_time;
+		s.backlog_wait_time_actual = atomic_read(&audit_backlog_wait_time_actual);
 		audit_send_reply(skb, seq, AUDIT_GET, 0, 0, &s, sizeof(s));
 		break;
 	}
@@ -1301,6 +1378,14 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 			if (err < 0)
 				return err;
 		}
+		if (s.mask & AUDIT_STATUS_BACKLOG_WAIT_TIME_ACTUAL) {
+			if (sizeof(s) > (size_t)nlh->nlmsg_len)
+				return -EINVAL;
+			/* the cumulative wait time can only be reset */
+			if (s.backlog_wait_time_actual != 0)
+				return -EINVAL;
+			atomic_set(&audit_backlog_wait_time_actual, 0);
+		}
 		if (s.mask == AUDIT_STATUS_LOST) {
 			u32 lost = atomic_xchg(&audit_lost, 0);
 
@@ -1587,7 +1672,8 @@ static int __init audit_init(void)
 					       sizeof(struct audit_buffer),
 					       0, SLAB_PANIC, NULL);
 
-	skb_queue_head_init(&audit_queue);
+	for_each_possible_cpu(i)
+		skb_queue_head_init(&per_cpu(audit_queue, i));
 	skb_queue_head_init(&audit_retry_queue);
 	skb_queue_head_init(&audit_hold_queue);
 
@@ -1771,24 +1857,27 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 		long stime = audit_backlog_wait_time;
 
 		while (audit_backlog_limit &&
-		       (skb_queue_len(&audit_queue) > audit_backlog_limit)) {
+		       (atomic_read(&audit_backlog_count) > audit_backlog_limit)) {
 			/* wake kauditd to try and flush the queue */
 			wake_up_interruptible(&kauditd_wait);
 
 			/* sleep if we are allowed and we haven't exhausted our
 			 * backlog wait limit */
 			if (gfpflags_allow_blocking(gfp_mask) && (stime > 0)) {
+				long rtime = stime;
 				DECLARE_WAITQUEUE(wait, current);
 
 				add_wait_queue_exclusive(&audit_backlog_wait,
 							 &wait);
 				set_current_state(TASK_UNINTERRUPTIBLE);
-				stime = schedule_timeout(stime);
+				stime = schedule_timeout(rtime);
+				atomic_add(rtime - stime,
+					   &audit_backlog_wait_time_actual);
 				remove_wait_queue(&audit_backlog_wait, &wait);
 			} else {
 				if (audit_rate_check() && printk_ratelimit())
 					pr_warn("audit_backlog=%d > audit_backlog_limit=%d\n",
-						skb_queue_len(&audit_queue),
+						atomic_read(&audit_backlog_count),
 						audit_backlog_limit);
 				audit_log_lost("backlog limit exceeded");
 				return NULL;
@@ -2312,6 +2401,9 @@ void audit_log_end(struct audit_buffer *ab)
 		return;
 
 	if (audit_rate_check()) {
+		struct sk_buff_head *queue;
+		unsigned long flags;
+
 		skb = ab->skb;
 		ab->skb = NULL;
 
@@ -2320,9 +2412,22 @@ void audit_log_end(struct audit_buffer *ab)
 		nlh = nlmsg_hdr(skb);
 		nlh->nlmsg_len = skb->len - NLMSG_HDRLEN;
 
-		/* queue the netlink packet and poke the kauditd thread */
-		skb_queue_tail(&audit_queue, skb);
-		wake_up_interruptible(&kauditd_wait);
+		/* stamp and stage the record on the local cpu queue; the
+		 * ticket is taken inside the queue lock so each staging
+		 * queue stays sorted for the merge in kauditd */
+		queue = &get_cpu_var(audit_queue);
+		spin_lock_irqsave(&queue->lock, flags);
+		audit_skb_seq(skb) = atomic_inc_return(&audit_queue_seq);
+		__skb_queue_tail(queue, skb);
+		spin_unlock_irqrestore(&queue->lock, flags);
+		put_cpu_var(audit_queue);
+
+		/* poke the kauditd thread, but only if it is idle; the
+		 * wq_has_sleeper() barrier pairs with the wait_event in
+		 * kauditd_thread(), which rechecks the backlog count */
+		atomic_inc(&audit_backlog_count);
+		if (wq_has_sleeper(&kauditd_wait))
+			wake_up_interruptible(&kauditd_wait);
 	} else
 		audit_log_lost("rate limit exceeded");
 
@@ -22,6 +22,30 @@
 DEFINE_STATIC_KEY_FALSE(cgroup_bpf_enabled_key);
 EXPORT_SYMBOL(cgroup_bpf_enabled_key);
 
+/* All effective-array invocations funnel through this dispatcher, so
+ * that on retpoline kernels the attached programs are entered with
+ * direct calls instead of a speculation-safe indirect call per
+ * program.  Programs are registered on attach and unregistered on
+ * detach/release; anything beyond the dispatcher's capacity simply
+ * keeps taking the indirect-call fallback inside the image.
+ */
+DEFINE_BPF_DISPATCHER(bpf_dispatcher_cgroup)
+
+#define bpf_prog_run_cgroup(prog, ctx)					\
+	__BPF_PROG_RUN(prog, ctx,					\
+		       BPF_DISPATCHER_FUNC(bpf_dispatcher_cgroup))
+
+#define bpf_prog_run_cgroup_save_cb(prog, skb)				\
+	__BPF_PROG_RUN_SAVE_CB(prog, skb,				\
+			       BPF_DISPATCHER_FUNC(bpf_dispatcher_cgroup))
+
+static void cgroup_bpf_dispatcher_change(struct bpf_prog *from,
+					 struct bpf_prog *to)
+{
+	bpf_dispatcher_change_prog(BPF_DISPATCHER_PTR(bpf_dispatcher_cgroup),
+				   from, to);
+}
+
 void cgroup_bpf_offline(struct cgroup *cgrp)
 {
 	cgroup_get(cgrp);
@@ -49,6 +73,7 @@ static void cgroup_bpf_release(struct work_struct *work)
 
 		list_for_each_entry_safe(pl, tmp, progs, node) {
 			list_del(&pl->node);
+			cgroup_bpf_dispatcher_change(pl->prog, NULL);
 			bpf_prog_put(pl->prog);
 			for_each_cgroup_storage_type(stype) {
 				bpf_cgroup_storage_unlink(pl->storage[stype]);
@@ -382,6 +407,7 @@ int __cgroup_bpf_attach(struct cgroup *cgrp, struct bpf_prog *prog,
 		goto cleanup;
 
 	static_branch_inc(&cgroup_bpf_enabled_key);
+	cgroup_bpf_dispatcher_change(old_prog, prog);
 	for_each_cgroup_storage_type(stype) {
 		if (!old_storage[stype])
 			continue;
@@ -479,6 +505,7 @@ int __cgroup_bpf_detach(struct cgroup *cgrp, struct bpf_prog *prog,
 		/* last program was detached, reset flags to zero */
 		cgrp->bpf.flags[type] = 0;
 
+	cgroup_bpf_dispatcher_change(old_prog, NULL);
 	bpf_prog_put(old_prog);
 	static_branch_dec(&cgroup_bpf_enabled_key);
 	return 0;
@@ -654,10 +681,11 @@ int __cgroup_bpf_run_filter_skb(struct sock *sk,
 
 	if (type == BPF_CGROUP_INET_EGRESS) {
 		ret = BPF_PROG_CGROUP_INET_EGRESS_RUN_ARRAY(
-			cgrp->bpf.effective[type], skb, __bpf_prog_run_save_cb);
+			cgrp->bpf.effective[type], skb,
+			bpf_prog_run_cgroup_save_cb);
 	} else {
 		ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], skb,
-					  __bpf_prog_run_save_cb);
+					  bpf_prog_run_cgroup_save_cb);
 		ret = (ret == 1 ? 0 : -EPERM);
 	}
 	bpf_restore_data_end(skb, saved_data_end);
@@ -687,7 +715,7 @@ int __cgroup_bpf_run_filter_sk(struct sock *sk,
 	struct cgroup *cgrp = sock_cgroup_ptr(&sk->sk_cgrp_data);
 	int ret;
 
-	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], sk, BPF_PROG_RUN);
+	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], sk, bpf_prog_run_cgroup);
 	return ret == 1 ? 0 : -EPERM;
 }
 EXPORT_SYMBOL(__cgroup_bpf_run_filter_sk);
@@ -731,7 +759,7 @@ int __cgroup_bpf_run_filter_sock_addr(struct sock *sk,
 	}
 
 	cgrp = sock_cgroup_ptr(&sk->sk_cgrp_data);
-	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], &ctx, BPF_PROG_RUN);
+	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], &ctx, bpf_prog_run_cgroup);
 
 	return ret == 1 ? 0 : -EPERM;
 }
@@ -761,7 +789,7 @@ int __cgroup_bpf_run_filter_sock_ops(struct sock *sk,
 	int ret;
 
 	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], sock_ops,
-				 BPF_PROG_RUN);
+				 bpf_prog_run_cgroup);
 	return ret == 1 ? 0 : -EPERM;
 }
 EXPORT_SYMBOL(__cgroup_bpf_run_filter_sock_ops);
@@ -780,7 +808,7 @@ int __cgroup_bpf_check_dev_permission(short dev_type, u32 major, u32 minor,
 	rcu_read_lock();
 	cgrp = task_dfl_cgroup(current);
 	allow = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], &ctx,
-				   BPF_PROG_RUN);
+				   bpf_prog_run_cgroup);
 	rcu_read_unlock();
 
 	return !allow;
@@ -938,7 +966,7 @@ int __cgroup_bpf_run_filter_sysctl(struct ctl_table_header *head,
 
 	rcu_read_lock();
 	cgrp = task_dfl_cgroup(current);
-	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], &ctx, BPF_PROG_RUN);
+	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[type], &ctx, bpf_prog_run_cgroup);
 	rcu_read_unlock();
 
 	kfree(ctx.cur_val);
@@ -1027,7 +1055,7 @@ int __cgroup_bpf_run_filter_setsockopt(struct sock *sk, int *level,
 
 	lock_sock(sk);
 	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[BPF_CGROUP_SETSOCKOPT],
-				 &ctx, BPF_PROG_RUN);
+				 &ctx, bpf_prog_run_cgroup);
 	release_sock(sk);
 
 	if (!ret) {
@@ -1111,7 +1139,7 @@ int __cgroup_bpf_run_filter_getsockopt(struct sock *sk, int level,
 
 	lock_sock(sk);
 	ret = BPF_PROG_RUN_ARRAY(cgrp->bpf.effective[BPF_CGROUP_GETSOCKOPT],
-				 &ctx, BPF_PROG_RUN);
+				 &ctx, bpf_prog_run_cgroup);
 	release_sock(sk);
 
 	if (!ret) {
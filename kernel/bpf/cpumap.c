@@ -253,6 +253,7 @@ static int cpu_map_kthread_run(void *data)
 		void *frames[CPUMAP_BATCH];
 		void *skbs[CPUMAP_BATCH];
 		gfp_t gfp = __GFP_ZERO | GFP_ATOMIC;
+		LIST_HEAD(list);
 		int i, n, m;
 
 		/* Release CPU reschedule checks */
@@ -291,29 +292,30 @@ static int cpu_map_kthread_run(void *data)
 		if (unlikely(m == 0)) {
 			for (i = 0; i < n; i++)
 				skbs[i] = NULL; /* effect: xdp_return_frame */
-			drops = n;
 		}
 
 		local_bh_disable();
 		for (i = 0; i < n; i++) {
 			struct xdp_frame *xdpf = frames[i];
 			struct sk_buff *skb = skbs[i];
-			int ret;
 
 			skb = cpu_map_build_skb(rcpu, xdpf, skb);
 			if (!skb) {
 				xdp_return_frame(xdpf);
+				drops++;
 				continue;
 			}
 
-			/* Inject into network stack */
-			ret = netif_receive_skb_core(skb);
-			if (ret == NET_RX_DROP)
-				drops++;
+			list_add_tail(&skb->list, &list);
 		}
 		/* Feedback loop via tracepoint */
 		trace_xdp_cpumap_kthread(rcpu->map_id, n, drops, sched);
 
+		/* Inject the whole batch into the network stack at once, so
+		 * it can ride the listified receive path down to ip_rcv.
+		 */
+		netif_receive_skb_list(&list);
+
 		local_bh_enable(); /* resched point, may call do_softirq() */
 	}
 	__set_current_state(TASK_RUNNING);
@@ -1283,15 +1283,20 @@ int generic_map_delete_batch(struct bpf_map *map,
 	return err;
 }
 
+/* number of elements whose keys and values are copied from user space in
+ * one go, to amortize the uaccess cost over the batch
+ */
+#define MAP_UPDATE_CHUNK 64
+
 int generic_map_update_batch(struct bpf_map *map,
 			     const union bpf_attr *attr,
 			     union bpf_attr __user *uattr)
 {
 	void __user *values = u64_to_user_ptr(attr->batch.values);
 	void __user *keys = u64_to_user_ptr(attr->batch.keys);
-	u32 value_size, cp, max_count;
+	u32 value_size, cp, chunk, max_count;
+	void *key_buf = NULL, *value_buf = NULL;
 	int ufd = attr->map_fd;
-	void *key, *value;
 	struct fd f;
 	int err = 0;
 
@@ -1310,35 +1315,47 @@ int generic_map_update_batch(struct bpf_map *map,
 	if (!max_count)
 		return 0;
 
-	key = kmalloc(map->key_size, GFP_USER | __GFP_NOWARN);
-	if (!key)
-		return -ENOMEM;
+	chunk = min_t(u32, max_count, MAP_UPDATE_CHUNK);
 
-	value = kmalloc(value_size, GFP_USER | __GFP_NOWARN);
-	if (!value) {
-		kfree(key);
-		return -ENOMEM;
+	key_buf = kvmalloc_array(chunk, map->key_size,
+				 GFP_USER | __GFP_NOWARN);
+	value_buf = kvmalloc_array(chunk, value_size,
+				   GFP_USER | __GFP_NOWARN);
+	if (!key_buf || !value_buf) {
+		err = -ENOMEM;
+		goto out;
 	}
 
-	for (cp = 0; cp < max_count; cp++) {
+	cp = 0;
+	while (cp < max_count) {
+		u32 n = min_t(u32, chunk, max_count - cp);
+		u32 i;
+
 		err = -EFAULT;
-		if (copy_from_user(key, keys + cp * map->key_size,
-		    map->key_size) ||
-		    copy_from_user(value, values + cp * value_size, value_size))
+		if (copy_from_user(key_buf, keys + cp * map->key_size,
+				   (size_t)n * map->key_size) ||
+		    copy_from_user(value_buf, values + cp * value_size,
+				   (size_t)n * value_size))
 			break;
 
-		err = bpf_map_update_value(map, f, key, value,
-					   attr->batch.elem_flags);
-
+		for (i = 0; i < n; i++) {
+			err = bpf_map_update_value(map, f,
+						   key_buf + i * map->key_size,
+						   value_buf + i * value_size,
+						   attr->batch.elem_flags);
+			if (err)
+				break;
+			cp++;
+		}
 		if (err)
 			break;
 	}
 
 	if (copy_to_user(&uattr->batch.count, &cp, sizeof(cp)))
 		err = -EFAULT;
-
-	kfree(value);
-	kfree(key);
+out:
+	kvfree(value_buf);
+	kvfree(key_buf);
 	return err;
 }
 
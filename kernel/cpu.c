@@ -556,7 +556,11 @@ static int bringup_cpu(unsigned int cpu)
 	 */
 	irq_lock_sparse();
 
-	/* Arch-specific enabling code. */
+	/*
+	 * Arch-specific enabling code. If parallel bringup is enabled the
+	 * AP was already kicked alive in the CPUHP_BP_KICK_AP state and
+	 * __cpu_up() merely waits for it to report in.
+	 */
 	ret = __cpu_up(cpu, idle);
 	irq_unlock_sparse();
 	if (ret)
@@ -564,6 +568,42 @@ static int bringup_cpu(unsigned int cpu)
 	return bringup_wait_for_ap(cpu);
 }
 
+/* Set once an architecture has opted in via arch_cpuhp_init_parallel_bringup() */
+static bool cpuhp_parallel_enabled;
+
+static bool __initdata cpuhp_parallel_bringup = true;
+
+static int __init parallel_bringup_parse_param(char *arg)
+{
+	return kstrtobool(arg, &cpuhp_parallel_bringup);
+}
+early_param("cpuhp.parallel", parallel_bringup_parse_param);
+
+/*
+ * An architecture which can split its startup sequence into a non-waiting
+ * "kick the AP alive" part and a waiting part overrides this to perform
+ * whatever one-time setup the split needs and returns true. Once it has
+ * done so, __cpu_up() must not kick the AP again; it only waits for the
+ * AP which was started from CPUHP_BP_KICK_AP.
+ */
+bool __weak arch_cpuhp_init_parallel_bringup(void)
+{
+	return false;
+}
+
+int __weak arch_cpuhp_kick_ap_alive(unsigned int cpu, struct task_struct *tidle)
+{
+	return -ENOSYS;
+}
+
+static int cpuhp_kick_ap_alive(unsigned int cpu)
+{
+	if (!cpuhp_parallel_enabled)
+		return 0;
+
+	return arch_cpuhp_kick_ap_alive(cpu, idle_thread_get(cpu));
+}
+
 /*
  * Hotplug state machine related functions
  */
@@ -1209,6 +1249,65 @@ int cpu_up(unsigned int cpu)
 }
 EXPORT_SYMBOL_GPL(cpu_up);
 
+/*
+ * Parallel bringup of the non-boot CPUs. Instead of kicking each AP and
+ * waiting for it to run all the way up to CPUHP_ONLINE before touching the
+ * next one, first walk all present CPUs and run their states up to
+ * CPUHP_BP_KICK_AP, which starts the AP but does not wait for it. The APs
+ * then do their expensive self-initialization concurrently while the
+ * second walk brings each of them the rest of the way up.
+ */
+static bool __init cpuhp_bringup_cpus_parallel(unsigned int ncpus)
+{
+	unsigned int cpu, kicked = 0;
+
+	if (!cpuhp_parallel_bringup)
+		return false;
+
+	if (!arch_cpuhp_init_parallel_bringup())
+		return false;
+
+	cpuhp_parallel_enabled = true;
+
+	/* Phase 1: kick the APs alive */
+	for_each_present_cpu(cpu) {
+		if (cpu_online(cpu))
+			continue;
+		if (num_online_cpus() + kicked >= ncpus)
+			break;
+		if (!do_cpu_up(cpu, CPUHP_BP_KICK_AP))
+			kicked++;
+	}
+
+	/* Phase 2: bring every kicked AP up to CPUHP_ONLINE */
+	for_each_present_cpu(cpu) {
+		struct cpuhp_cpu_state *st = per_cpu_ptr(&cpuhp_state, cpu);
+
+		if (st->state != CPUHP_BP_KICK_AP)
+			continue;
+		do_cpu_up(cpu, CPUHP_ONLINE);
+	}
+	return true;
+}
+
+void __init bringup_nonboot_cpus(unsigned int setup_max_cpus)
+{
+	unsigned int cpu;
+
+	if (!setup_max_cpus)
+		return;
+
+	if (cpuhp_bringup_cpus_parallel(setup_max_cpus))
+		return;
+
+	for_each_present_cpu(cpu) {
+		if (num_online_cpus() >= setup_max_cpus)
+			break;
+		if (!cpu_online(cpu))
+			cpu_up(cpu);
+	}
+}
+
 #ifdef CONFIG_PM_SLEEP_SMP
 static cpumask_var_t frozen_cpus;
 
@@ -1430,6 +1529,16 @@ static struct cpuhp_step cpuhp_hp_states[] = {
 		.startup.single		= timers_prepare_cpu,
 		.teardown.single	= timers_dead_cpu,
 	},
+	/*
+	 * Kicks the AP alive without waiting for it. A no-op unless the
+	 * architecture enabled parallel bringup.
+	 */
+	[CPUHP_BP_KICK_AP] = {
+		.name			= "cpu:kick_ap",
+		.startup.single		= cpuhp_kick_ap_alive,
+		.teardown.single	= NULL,
+		.cant_stop		= true,
+	},
 	/* Kicks the plugged cpu into life */
 	[CPUHP_BRINGUP_CPU] = {
 		.name			= "cpu:bringup",
@@ -38,12 +38,18 @@ void __delayacct_tsk_init(struct task_struct *tsk)
 		raw_spin_lock_init(&tsk->delays->lock);
 }
 
+static int delayacct_hist_bucket(s64 ns)
+{
+	return min_t(int, fls64(ns >> TASKSTATS_HIST_SHIFT),
+		     TASKSTATS_HIST_BUCKETS - 1);
+}
+
 /*
  * Finish delay accounting for a statistic using its timestamps (@start),
- * accumalator (@total) and @count
+ * accumalator (@total), @count and log2 histogram (@hist)
  */
 static void delayacct_end(raw_spinlock_t *lock, u64 *start, u64 *total,
-			  u32 *count)
+			  u32 *count, u32 *hist)
 {
 	s64 ns = ktime_get_ns() - *start;
 	unsigned long flags;
@@ -52,6 +58,7 @@ static void delayacct_end(raw_spinlock_t *lock, u64 *start, u64 *total,
 		raw_spin_lock_irqsave(lock, flags);
 		*total += ns;
 		(*count)++;
+		hist[delayacct_hist_bucket(ns)]++;
 		raw_spin_unlock_irqrestore(lock, flags);
 	}
 }
@@ -70,16 +77,19 @@ void __delayacct_blkio_end(struct task_struct *p)
 	struct task_delay_info *delays = p->delays;
 	u64 *total;
 	u32 *count;
+	u32 *hist;
 
 	if (p->delays->flags & DELAYACCT_PF_SWAPIN) {
 		total = &delays->swapin_delay;
 		count = &delays->swapin_count;
+		hist = delays->swapin_hist;
 	} else {
 		total = &delays->blkio_delay;
 		count = &delays->blkio_count;
+		hist = delays->blkio_hist;
 	}
 
-	delayacct_end(&delays->lock, &delays->blkio_start, total, count);
+	delayacct_end(&delays->lock, &delays->blkio_start, total, count, hist);
 }
 
 int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
@@ -88,6 +98,7 @@ int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 	unsigned long long t2, t3;
 	unsigned long flags, t1;
 	s64 tmp;
+	int i;
 
 	task_cputime(tsk, &utime, &stime);
 	tmp = (s64)d->cpu_run_real_total;
@@ -132,6 +143,12 @@ int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 	d->swapin_count += tsk->delays->swapin_count;
 	d->freepages_count += tsk->delays->freepages_count;
 	d->thrashing_count += tsk->delays->thrashing_count;
+	for (i = 0; i < TASKSTATS_HIST_BUCKETS; i++) {
+		d->blkio_delay_hist[i] += tsk->delays->blkio_hist[i];
+		d->swapin_delay_hist[i] += tsk->delays->swapin_hist[i];
+		d->freepages_delay_hist[i] += tsk->delays->freepages_hist[i];
+		d->thrashing_delay_hist[i] += tsk->delays->thrashing_hist[i];
+	}
 	raw_spin_unlock_irqrestore(&tsk->delays->lock, flags);
 
 	return 0;
@@ -160,7 +177,8 @@ void __delayacct_freepages_end(void)
 		&current->delays->lock,
 		&current->delays->freepages_start,
 		&current->delays->freepages_delay,
-		&current->delays->freepages_count);
+		&current->delays->freepages_count,
+		current->delays->freepages_hist);
 }
 
 void __delayacct_thrashing_start(void)
@@ -173,5 +191,6 @@ void __delayacct_thrashing_end(void)
 	delayacct_end(&current->delays->lock,
 		      &current->delays->thrashing_start,
 		      &current->delays->thrashing_delay,
-		      &current->delays->thrashing_count);
+		      &current->delays->thrashing_count,
+		      current->delays->thrashing_hist);
 }
@@ -162,6 +162,7 @@ static void __exit_signal(struct task_struct *tsk)
 	 * doing sigqueue_free() if we have SIGQUEUE_PREALLOC signals.
 	 */
 	flush_sigqueue(&tsk->pending);
+	exit_task_sigqueue_cache(tsk);
 	tsk->sighand = NULL;
 	spin_unlock(&sighand->siglock);
 
@@ -56,6 +56,7 @@
 #include <linux/futex.h>
 #include <linux/compat.h>
 #include <linux/kthread.h>
+#include <linux/workqueue.h>
 #include <linux/task_io_accounting_ops.h>
 #include <linux/rcupdate.h>
 #include <linux/ptrace.h>
@@ -478,12 +479,113 @@ void free_task(struct task_struct *tsk)
 EXPORT_SYMBOL(free_task);
 
 #ifdef CONFIG_MMU
+/*
+ * For large address spaces the page table copy dominates fork() and is
+ * trivially parallel: the child is not running yet, both mmap_sems are
+ * held for writing, and disjoint PMD-aligned ranges never touch the
+ * same page table page (upper level allocations are serialized by
+ * mm->page_table_lock, rss counters are atomic).  dup_mmap() therefore
+ * fans the copies out to the unbound workqueue in DUP_MMAP_CHUNK_SIZE
+ * chunks once the parent's RSS makes the fan-out worthwhile, and waits
+ * for all of them before dropping the locks.  The VMA duplication
+ * itself stays serial; anon_vma_fork() and the i_mmap insertions order
+ * against each other and are a small fraction of the cost.
+ */
+#define DUP_MMAP_CHUNK_SIZE	(1UL << 30)
+#define DUP_MMAP_ASYNC_MIN_RSS	(DUP_MMAP_CHUNK_SIZE >> PAGE_SHIFT)
+
+struct dup_mmap_ctl {
+	struct mm_struct	*mm;
+	struct mm_struct	*oldmm;
+	struct list_head	works;
+	atomic_t		error;
+	bool			async;
+};
+
+struct dup_mmap_work {
+	struct work_struct	work;
+	struct list_head	entry;
+	struct dup_mmap_ctl	*ctl;
+	struct vm_area_struct	*vma;
+	unsigned long		addr;
+	unsigned long		end;
+};
+
+static void dup_mmap_copy_workfn(struct work_struct *work)
+{
+	struct dup_mmap_work *w = container_of(work, struct dup_mmap_work,
+					       work);
+	struct dup_mmap_ctl *ctl = w->ctl;
+	int ret;
+
+	ret = copy_page_range(ctl->mm, ctl->oldmm, w->vma, w->addr, w->end);
+	if (ret)
+		atomic_cmpxchg(&ctl->error, 0, ret);
+}
+
+static int dup_mmap_queue_copy(struct dup_mmap_ctl *ctl,
+			       struct vm_area_struct *mpnt)
+{
+	unsigned long addr = mpnt->vm_start;
+	bool splittable = !is_vm_hugetlb_page(mpnt) &&
+			  !(mpnt->vm_flags & (VM_PFNMAP | VM_MIXEDMAP));
+
+	BUILD_BUG_ON(DUP_MMAP_CHUNK_SIZE % PMD_SIZE);
+
+	if (!ctl->async)
+		return copy_page_range(ctl->mm, ctl->oldmm, mpnt,
+				       mpnt->vm_start, mpnt->vm_end);
+
+	/* Matches the fault-will-fill-them check in copy_page_range(). */
+	if (splittable && !mpnt->anon_vma)
+		return 0;
+
+	do {
+		unsigned long end = mpnt->vm_end;
+		struct dup_mmap_work *w;
+
+		if (splittable)
+			end = min(end, ALIGN(addr + 1, DUP_MMAP_CHUNK_SIZE));
+
+		w = kmalloc(sizeof(*w), GFP_KERNEL);
+		if (!w) {
+			/* Degrade to copying the remainder synchronously. */
+			return copy_page_range(ctl->mm, ctl->oldmm, mpnt,
+					       addr, mpnt->vm_end);
+		}
+
+		INIT_WORK(&w->work, dup_mmap_copy_workfn);
+		w->ctl = ctl;
+		w->vma = mpnt;
+		w->addr = addr;
+		w->end = end;
+		list_add_tail(&w->entry, &ctl->works);
+		queue_work(system_unbound_wq, &w->work);
+		addr = end;
+	} while (addr < mpnt->vm_end);
+
+	return 0;
+}
+
+static int dup_mmap_wait_copies(struct dup_mmap_ctl *ctl)
+{
+	struct dup_mmap_work *w, *tmp;
+
+	list_for_each_entry_safe(w, tmp, &ctl->works, entry) {
+		flush_work(&w->work);
+		list_del(&w->entry);
+		kfree(w);
+	}
+	return atomic_read(&ctl->error);
+}
+
 static __latent_entropy int dup_mmap(struct mm_struct *mm,
 					struct mm_struct *oldmm)
 {
 	struct vm_area_struct *mpnt, *tmp, *prev, **pprev;
 	struct rb_node **rb_link, *rb_parent;
-	int retval;
+	struct dup_mmap_ctl ctl;
+	int retval, copy_retval;
 	unsigned long charge;
 	LIST_HEAD(uf);
 
@@ -510,6 +612,14 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	rb_link = &mm->mm_rb.rb_node;
 	rb_parent = NULL;
 	pprev = &mm->mmap;
+
+	ctl.mm = mm;
+	ctl.oldmm = oldmm;
+	INIT_LIST_HEAD(&ctl.works);
+	atomic_set(&ctl.error, 0);
+	ctl.async = num_online_cpus() > 1 &&
+		    get_mm_rss(oldmm) >= DUP_MMAP_ASYNC_MIN_RSS;
+
 	retval = ksm_fork(mm, oldmm);
 	if (retval)
 		goto out;
@@ -601,7 +711,7 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 
 		mm->map_count++;
 		if (!(tmp->vm_flags & VM_WIPEONFORK))
-			retval = copy_page_range(mm, oldmm, mpnt);
+			retval = dup_mmap_queue_copy(&ctl, mpnt);
 
 		if (tmp->vm_ops && tmp->vm_ops->open)
 			tmp->vm_ops->open(tmp);
@@ -612,6 +722,13 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	/* a new mm has just been created */
 	retval = arch_dup_mmap(oldmm, mm);
 out:
+	/*
+	 * Wait for the fanned out page table copies no matter how we got
+	 * here; the workers reference both mms and the source VMAs.
+	 */
+	copy_retval = dup_mmap_wait_copies(&ctl);
+	if (!retval)
+		retval = copy_retval;
 	up_write(&mm->mmap_sem);
 	flush_tlb_mm(oldmm);
 	up_write(&oldmm->mmap_sem);
@@ -695,6 +812,7 @@ void __mmdrop(struct mm_struct *mm)
 	mmu_notifier_subscriptions_destroy(mm);
 	check_mm(mm);
 	put_user_ns(mm->user_ns);
+	futex_hash_free(mm);
 	free_mm(mm);
 }
 EXPORT_SYMBOL_GPL(__mmdrop);
@@ -1029,6 +1147,10 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 	init_tlb_flush_pending(mm);
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !USE_SPLIT_PMD_PTLOCKS
 	mm->pmd_huge_pte = NULL;
+#endif
+#ifdef CONFIG_FUTEX
+	/* The private futex hash is not inherited over fork(). */
+	mm->futex_phash = NULL;
 #endif
 	mm_init_uprobes_state(mm);
 
@@ -1973,6 +2095,7 @@ static __latent_entropy struct task_struct *copy_process(
 	spin_lock_init(&p->alloc_lock);
 
 	init_sigpending(&p->pending);
+	p->sigqueue_cache = NULL;
 
 	p->utime = p->stime = p->gtime = 0;
 #ifdef CONFIG_ARCH_HAS_SCALED_CPUTIME
@@ -2173,6 +2296,7 @@ static __latent_entropy struct task_struct *copy_process(
 	p->pdeath_signal = 0;
 	INIT_LIST_HEAD(&p->thread_group);
 	p->task_works = NULL;
+	init_llist_head(&p->fput_list);
 
 	cgroup_threadgroup_change_begin(current);
 	/*
@@ -51,11 +51,13 @@
 #include <linux/sched/rt.h>
 #include <linux/sched/wake_q.h>
 #include <linux/sched/mm.h>
+#include <linux/sched/signal.h>
 #include <linux/hugetlb.h>
 #include <linux/freezer.h>
 #include <linux/memblock.h>
 #include <linux/fault-inject.h>
 #include <linux/refcount.h>
+#include <linux/prctl.h>
 
 #include <asm/futex.h>
 
@@ -268,6 +270,18 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+/*
+ * Optional per-process hash for private futexes, installed via
+ * prctl(PR_FUTEX_HASH).  The table is allocated while the process is
+ * still single threaded and is never resized or replaced afterwards, so
+ * hash_futex() can dereference it without taking a reference; it is
+ * freed together with the mm, when no waiter can reference it anymore.
+ */
+struct futex_private_hash {
+	unsigned int		hash_mask;
+	struct futex_hash_bucket queues[];
+};
+
 
 /*
  * Fault injections for futexes.
@@ -377,17 +391,27 @@ static inline int hb_waiters_pending(struct futex_hash_bucket *hb)
 }
 
 /**
- * hash_futex - Return the hash bucket in the global hash
+ * hash_futex - Return the hash bucket
  * @key:	Pointer to the futex key for which the hash is calculated
  *
- * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * We hash on the keys returned from get_futex_key (see below).  Private
+ * futexes of a process which installed a private hash via
+ * prctl(PR_FUTEX_HASH) are hashed into that table, everything else goes
+ * to the global hash.
  */
 static struct futex_hash_bucket *hash_futex(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
 
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED)) &&
+	    current->mm) {
+		struct futex_private_hash *fph = current->mm->futex_phash;
+
+		if (fph)
+			return &fph->queues[hash & fph->hash_mask];
+	}
+
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
@@ -4169,6 +4193,78 @@ static void __init futex_detect_cmpxchg(void)
 #endif
 }
 
+/**
+ * futex_hash_free - Free the private futex hash of a process
+ * @mm:	mm_struct to operate on
+ *
+ * Called from __mmdrop().  At this point no task can reference the mm
+ * anymore, so no futex_q can sit in one of the private buckets either.
+ */
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+
+static long futex_hash_allocate(unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph;
+	unsigned long i;
+
+	if (slots < 2 || slots > futex_hashsize || !is_power_of_2(slots))
+		return -EINVAL;
+
+	if (mm->futex_phash)
+		return -EBUSY;
+
+	/*
+	 * Installing the hash while other threads of the process can have
+	 * futex_qs enqueued in the global hash would lose their wakeups.
+	 * Requiring a single threaded process avoids that, and makes the
+	 * pointer visible to all threads created afterwards without
+	 * further synchronization, courtesy of the clone() happens-before.
+	 */
+	if (!current_is_single_threaded())
+		return -EBUSY;
+
+	/*
+	 * Unlike the global hash, which is interleaved across all nodes,
+	 * the private one is allocated on the node the process runs on so
+	 * that the bucket locks stay node local.
+	 */
+	fph = kvzalloc_node(struct_size(fph, queues, slots), GFP_KERNEL,
+			    numa_node_id());
+	if (!fph)
+		return -ENOMEM;
+
+	fph->hash_mask = slots - 1;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+	}
+	mm->futex_phash = fph;
+
+	return 0;
+}
+
+long futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	struct futex_private_hash *fph;
+
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		return futex_hash_allocate(arg3);
+	case PR_FUTEX_HASH_GET_SLOTS:
+		if (arg3)
+			return -EINVAL;
+		fph = current->mm->futex_phash;
+		return fph ? fph->hash_mask + 1 : 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static int __init futex_init(void)
 {
 	unsigned int futex_shift;
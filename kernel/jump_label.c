@@ -217,6 +217,90 @@ void static_key_disable(struct static_key *key)
 }
 EXPORT_SYMBOL_GPL(static_key_disable);
 
+#ifdef HAVE_JUMP_LABEL_BATCH
+/*
+ * When set, __jump_label_update() leaves queued transforms unapplied so
+ * that static_key_update_batch() can patch the sites of several keys in
+ * one transaction.  Protected by jump_label_mutex.
+ */
+static bool jump_label_defer_apply;
+#endif
+
+/**
+ * static_key_update_batch - enable/disable several static keys at once
+ * @updates: array describing the wanted state of each key
+ * @count: number of elements in @updates
+ *
+ * Equivalent to calling static_key_enable() or static_key_disable() for
+ * each element, but on architectures with HAVE_JUMP_LABEL_BATCH all
+ * branch sites are queued up and patched in a single text-poke
+ * transaction, so the serialization cost is paid once per batch rather
+ * than once per key.
+ *
+ * The batch is not atomic as seen from other CPUs: keys are flipped in
+ * array order and a concurrently running CPU can observe any prefix of
+ * the batch applied.  Each key should appear at most once in @updates.
+ */
+void static_key_update_batch(struct static_key_update *updates, int count)
+{
+	int i;
+
+	cpus_read_lock();
+	jump_label_lock();
+
+#ifdef HAVE_JUMP_LABEL_BATCH
+	jump_label_defer_apply = true;
+#endif
+
+	for (i = 0; i < count; i++) {
+		struct static_key *key = updates[i].key;
+
+		STATIC_KEY_CHECK_USE(key);
+
+		if (updates[i].enable) {
+			if (atomic_read(&key->enabled) > 0) {
+				WARN_ON_ONCE(atomic_read(&key->enabled) != 1);
+				continue;
+			}
+			/*
+			 * As in static_key_slow_inc(), the negative value
+			 * sends concurrent static_key_slow_inc() calls down
+			 * the slow path, where they serialize against the
+			 * batch on jump_label_mutex.
+			 */
+			atomic_set(&key->enabled, -1);
+			jump_label_update(key);
+		} else {
+			if (atomic_read(&key->enabled) != 1) {
+				WARN_ON_ONCE(atomic_read(&key->enabled) != 0);
+				continue;
+			}
+			if (atomic_cmpxchg(&key->enabled, 1, 0))
+				jump_label_update(key);
+		}
+	}
+
+#ifdef HAVE_JUMP_LABEL_BATCH
+	jump_label_defer_apply = false;
+	arch_jump_label_transform_apply();
+#endif
+
+	/*
+	 * Only mark keys enabled once their sites have actually been
+	 * patched; see static_key_enable_cpuslocked().
+	 */
+	for (i = 0; i < count; i++) {
+		struct static_key *key = updates[i].key;
+
+		if (updates[i].enable && atomic_read(&key->enabled) == -1)
+			atomic_set_release(&key->enabled, 1);
+	}
+
+	jump_label_unlock();
+	cpus_read_unlock();
+}
+EXPORT_SYMBOL_GPL(static_key_update_batch);
+
 static bool static_key_slow_try_dec(struct static_key *key)
 {
 	int val;
@@ -446,7 +530,8 @@ static void __jump_label_update(struct static_key *key,
 			BUG_ON(!arch_jump_label_transform_queue(entry, jump_label_type(entry)));
 		}
 	}
-	arch_jump_label_transform_apply();
+	if (!jump_label_defer_apply)
+		arch_jump_label_transform_apply();
 }
 #endif
 
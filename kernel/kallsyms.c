@@ -25,6 +25,8 @@
 #include <linux/filter.h>
 #include <linux/ftrace.h>
 #include <linux/compiler.h>
+#include <linux/sort.h>
+#include <linux/mm.h>
 
 /*
  * These will be re-linked against their real values
@@ -160,23 +162,168 @@ static unsigned long kallsyms_sym_address(int idx)
 	return kallsyms_relative_base - 1 - kallsyms_offsets[idx];
 }
 
-/* Lookup the address for this symbol. Returns 0 if not found. */
-unsigned long kallsyms_lookup_name(const char *name)
+/*
+ * Index over the compressed name table sorted by expanded name, built
+ * once at boot.  It turns name lookups from a linear scan over every
+ * symbol into a binary search, which matters for tooling that attaches
+ * hundreds of probes in a row.  Costs two u32s per symbol; lookups fall
+ * back to the linear scan until the index is up (or for good if its
+ * allocation failed).
+ */
+static u32 *kallsyms_name_index;	/* symbol numbers sorted by name */
+static u32 *kallsyms_name_offsets;	/* name table offset per symbol */
+
+static int kallsyms_cmp_symbol_name(const void *a, const void *b)
 {
-	char namebuf[KSYM_NAME_LEN];
+	static char name_a[KSYM_NAME_LEN], name_b[KSYM_NAME_LEN];
+
+	kallsyms_expand_symbol(kallsyms_name_offsets[*(const u32 *)a],
+			       name_a, ARRAY_SIZE(name_a));
+	kallsyms_expand_symbol(kallsyms_name_offsets[*(const u32 *)b],
+			       name_b, ARRAY_SIZE(name_b));
+	return strcmp(name_a, name_b);
+}
+
+static int __init kallsyms_build_name_index(void)
+{
+	u32 *index, *offsets;
 	unsigned long i;
 	unsigned int off;
 
+	index = kvmalloc_array(kallsyms_num_syms, sizeof(*index), GFP_KERNEL);
+	offsets = kvmalloc_array(kallsyms_num_syms, sizeof(*offsets),
+				 GFP_KERNEL);
+	if (!index || !offsets) {
+		kvfree(index);
+		kvfree(offsets);
+		return 0;	/* the linear fallback keeps working */
+	}
+
 	for (i = 0, off = 0; i < kallsyms_num_syms; i++) {
-		off = kallsyms_expand_symbol(off, namebuf, ARRAY_SIZE(namebuf));
+		index[i] = i;
+		offsets[i] = off;
+		off += kallsyms_names[off] + 1;
+	}
+	kallsyms_name_offsets = offsets;
+	sort(index, kallsyms_num_syms, sizeof(*index),
+	     kallsyms_cmp_symbol_name, NULL);
+
+	/* Pairs with the smp_load_acquire()s in the lookup functions. */
+	smp_store_release(&kallsyms_name_index, index);
+	return 0;
+}
+postcore_initcall(kallsyms_build_name_index);
 
-		if (strcmp(namebuf, name) == 0)
-			return kallsyms_sym_address(i);
+/*
+ * Binary search over the sorted name index.  For duplicate symbol names
+ * an arbitrary instance wins, where the linear scan picked the one
+ * first in address order; neither tells the caller which instance it
+ * got, so callers that care use kallsyms_on_each_symbol().
+ */
+static unsigned long kallsyms_lookup_name_indexed(const u32 *index,
+						  const char *name)
+{
+	char namebuf[KSYM_NAME_LEN];
+	unsigned long lo = 0, hi = kallsyms_num_syms;
+
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		int cmp;
+
+		kallsyms_expand_symbol(kallsyms_name_offsets[index[mid]],
+				       namebuf, ARRAY_SIZE(namebuf));
+		cmp = strcmp(namebuf, name);
+		if (!cmp)
+			return kallsyms_sym_address(index[mid]);
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return 0;
+}
+
+/* Lookup the address for this symbol. Returns 0 if not found. */
+unsigned long kallsyms_lookup_name(const char *name)
+{
+	const u32 *index = smp_load_acquire(&kallsyms_name_index);
+	char namebuf[KSYM_NAME_LEN];
+	unsigned long i, addr;
+	unsigned int off;
+
+	if (index) {
+		addr = kallsyms_lookup_name_indexed(index, name);
+		if (addr)
+			return addr;
+	} else {
+		for (i = 0, off = 0; i < kallsyms_num_syms; i++) {
+			off = kallsyms_expand_symbol(off, namebuf,
+						     ARRAY_SIZE(namebuf));
+
+			if (strcmp(namebuf, name) == 0)
+				return kallsyms_sym_address(i);
+		}
 	}
 	return module_kallsyms_lookup_name(name);
 }
 EXPORT_SYMBOL_GPL(kallsyms_lookup_name);
 
+/**
+ * kallsyms_lookup_names - Resolve a batch of symbol names in one go
+ * @names:	array of @cnt symbol names
+ * @cnt:	number of entries in @names and @addrs
+ * @addrs:	resolved addresses, 0 for names that were not found
+ *
+ * Lets probe and BPF loaders resolve their whole symbol set without
+ * paying one table walk per name: with the name index every entry is a
+ * binary search, without it all names are matched during a single scan
+ * over the table.  Module symbols are resolved for whatever is left.
+ *
+ * Return: the number of names that resolved.
+ */
+unsigned int kallsyms_lookup_names(const char * const *names,
+				   unsigned int cnt, unsigned long *addrs)
+{
+	const u32 *index = smp_load_acquire(&kallsyms_name_index);
+	unsigned int j, found = 0;
+
+	memset(addrs, 0, cnt * sizeof(*addrs));
+
+	if (index) {
+		for (j = 0; j < cnt; j++)
+			addrs[j] = kallsyms_lookup_name_indexed(index,
+								names[j]);
+	} else {
+		char namebuf[KSYM_NAME_LEN];
+		unsigned int off, matched = 0;
+		unsigned long i;
+
+		for (i = 0, off = 0; i < kallsyms_num_syms && matched < cnt;
+		     i++) {
+			off = kallsyms_expand_symbol(off, namebuf,
+						     ARRAY_SIZE(namebuf));
+
+			for (j = 0; j < cnt; j++) {
+				if (!addrs[j] &&
+				    strcmp(namebuf, names[j]) == 0) {
+					addrs[j] = kallsyms_sym_address(i);
+					matched++;
+					break;
+				}
+			}
+		}
+	}
+
+	for (j = 0; j < cnt; j++) {
+		if (!addrs[j])
+			addrs[j] = module_kallsyms_lookup_name(names[j]);
+		if (addrs[j])
+			found++;
+	}
+	return found;
+}
+EXPORT_SYMBOL_GPL(kallsyms_lookup_names);
+
 int kallsyms_on_each_symbol(int (*fn)(void *, const char *, struct module *,
 				      unsigned long),
 			    void *data)
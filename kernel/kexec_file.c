@@ -26,10 +26,30 @@
 #include <linux/kernel.h>
 #include <linux/syscalls.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include "kexec_internal.h"
 
 static int kexec_calculate_store_digests(struct kimage *image);
 
+/*
+ * Digest calculation walks every segment, so on large images it is as
+ * expensive as loading them.  Run it on the unbound workqueue so it can
+ * overlap with the segment loads in kexec_file_load().
+ */
+struct kexec_digest_work {
+	struct work_struct work;
+	struct kimage *image;
+	int ret;
+};
+
+static void kexec_digest_work_fn(struct work_struct *work)
+{
+	struct kexec_digest_work *dw =
+		container_of(work, struct kexec_digest_work, work);
+
+	dw->ret = kexec_calculate_store_digests(dw->image);
+}
+
 /*
  * Currently this is the only default function that is exported as some
  * architectures need it to do additional handlings.
@@ -371,7 +391,8 @@ SYSCALL_DEFINE5(kexec_file_load, int, kernel_fd, int, initrd_fd,
 		unsigned long, cmdline_len, const char __user *, cmdline_ptr,
 		unsigned long, flags)
 {
-	int ret = 0, i;
+	int ret = 0, i, purgatory_idx = -1;
+	struct kexec_digest_work dw;
 	struct kimage **dest_image, *image;
 
 	/* We only trust the superuser with rebooting the system. */
@@ -422,9 +443,16 @@ SYSCALL_DEFINE5(kexec_file_load, int, kernel_fd, int, initrd_fd,
 	if (ret)
 		goto out;
 
-	ret = kexec_calculate_store_digests(image);
-	if (ret)
-		goto out;
+	/*
+	 * Compute the digests while the segments are being loaded.  The
+	 * purgatory segment is held back until the worker has finished:
+	 * kexec_calculate_store_digests() stores the region digests into
+	 * the purgatory buffer, which loading that segment copies out.
+	 */
+	dw.image = image;
+	dw.ret = 0;
+	INIT_WORK_ONSTACK(&dw.work, kexec_digest_work_fn);
+	queue_work(system_unbound_wq, &dw.work);
 
 	for (i = 0; i < image->nr_segments; i++) {
 		struct kexec_segment *ksegment;
@@ -434,7 +462,27 @@ SYSCALL_DEFINE5(kexec_file_load, int, kernel_fd, int, initrd_fd,
 			 i, ksegment->buf, ksegment->bufsz, ksegment->mem,
 			 ksegment->memsz);
 
+		if (image->purgatory_info.purgatory_buf &&
+		    ksegment->kbuf == image->purgatory_info.purgatory_buf) {
+			purgatory_idx = i;
+			continue;
+		}
+
 		ret = kimage_load_segment(image, &image->segment[i]);
+		if (ret)
+			break;
+	}
+
+	/* Join the digest worker before loading purgatory or bailing out. */
+	flush_work(&dw.work);
+	destroy_work_on_stack(&dw.work);
+	if (!ret)
+		ret = dw.ret;
+	if (ret)
+		goto out;
+
+	if (purgatory_idx >= 0) {
+		ret = kimage_load_segment(image, &image->segment[purgatory_idx]);
 		if (ret)
 			goto out;
 	}
@@ -276,6 +276,9 @@ static int subbuf_start_default_callback (struct rchan_buf *buf,
 					  void *prev_subbuf,
 					  size_t prev_padding)
 {
+	if (buf->chan->overwrite)
+		return 1;
+
 	if (relay_buf_full(buf))
 		return 0;
 
@@ -362,6 +365,7 @@ static void __relay_reset(struct rchan_buf *buf, unsigned int init)
 
 	buf->subbufs_produced = 0;
 	buf->subbufs_consumed = 0;
+	buf->subbufs_notified = 0;
 	buf->bytes_consumed = 0;
 	buf->finalized = 0;
 	buf->data = buf->start;
@@ -589,6 +593,7 @@ struct rchan *relay_open(const char *base_filename,
 	chan->version = RELAYFS_CHANNEL_VERSION;
 	chan->n_subbufs = n_subbufs;
 	chan->subbuf_size = subbuf_size;
+	chan->wakeup_interval = 1;
 	chan->alloc_size = PAGE_ALIGN(subbuf_size * n_subbufs);
 	chan->parent = parent;
 	chan->private_data = private_data;
@@ -623,6 +628,50 @@ free_bufs:
 }
 EXPORT_SYMBOL_GPL(relay_open);
 
+/**
+ *	relay_set_overwrite - switch a channel to flight-recorder mode
+ *	@chan: the channel
+ *	@overwrite: non-zero to enable overwrite mode
+ *
+ *	In overwrite mode the default subbuf_start() callback keeps logging
+ *	when the ring is full: the buffer wraps and the oldest sub-buffer is
+ *	reclaimed, so the newest data always wins and the producer is never
+ *	throttled by a slow or absent reader.  Readers are expected to mmap
+ *	the buffer and use relay_snapshot() to extract data; they need not
+ *	call relay_subbufs_consumed().
+ *
+ *	Has no effect if the client supplied its own subbuf_start() callback.
+ *	Should be set before any data is logged to the channel.
+ */
+void relay_set_overwrite(struct rchan *chan, int overwrite)
+{
+	if (!chan)
+		return;
+
+	chan->overwrite = overwrite;
+}
+EXPORT_SYMBOL_GPL(relay_set_overwrite);
+
+/**
+ *	relay_set_wakeup_interval - batch reader notification
+ *	@chan: the channel
+ *	@n_subbufs: number of sub-buffers to produce per reader wakeup
+ *
+ *	By default readers waiting on a channel buffer are woken every time
+ *	a sub-buffer is switched out.  Raising the interval amortizes the
+ *	wakeup cost over @n_subbufs switches, at the price of readers seeing
+ *	completed data later.  The interval is clamped to the sub-buffer
+ *	count of the channel.
+ */
+void relay_set_wakeup_interval(struct rchan *chan, size_t n_subbufs)
+{
+	if (!chan || !n_subbufs)
+		return;
+
+	chan->wakeup_interval = min(n_subbufs, chan->n_subbufs);
+}
+EXPORT_SYMBOL_GPL(relay_set_wakeup_interval);
+
 struct rchan_percpu_buf_dispatcher {
 	struct rchan_buf *buf;
 	struct dentry *dentry;
@@ -755,6 +804,12 @@ size_t relay_switch_subbuf(struct rchan_buf *buf, size_t length)
 		buf->prev_padding = buf->chan->subbuf_size - buf->offset;
 		old_subbuf = buf->subbufs_produced % buf->chan->n_subbufs;
 		buf->padding[old_subbuf] = buf->prev_padding;
+		/*
+		 * Order the sub-buffer contents and its padding count
+		 * before the subbufs_produced update; pairs with the read
+		 * barrier in relay_snapshot().
+		 */
+		smp_wmb();
 		buf->subbufs_produced++;
 		if (buf->dentry)
 			d_inode(buf->dentry)->i_size +=
@@ -764,7 +819,10 @@ size_t relay_switch_subbuf(struct rchan_buf *buf, size_t length)
 			buf->early_bytes += buf->chan->subbuf_size -
 					    buf->padding[old_subbuf];
 		smp_mb();
-		if (waitqueue_active(&buf->read_wait)) {
+		if (buf->subbufs_produced - buf->subbufs_notified >=
+			    buf->chan->wakeup_interval &&
+		    waitqueue_active(&buf->read_wait)) {
+			buf->subbufs_notified = buf->subbufs_produced;
 			/*
 			 * Calling wake_up_interruptible() from here
 			 * will deadlock if we happen to be logging
@@ -830,6 +888,62 @@ void relay_subbufs_consumed(struct rchan *chan,
 }
 EXPORT_SYMBOL_GPL(relay_subbufs_consumed);
 
+/**
+ *	relay_snapshot - bounds of intact data in an overwrite-mode buffer
+ *	@chan: the channel
+ *	@cpu: the cpu associated with the channel buffer to snapshot
+ *	@first: out param - sequence number of oldest intact sub-buffer
+ *	@last: out param - sequence number of newest complete sub-buffer
+ *
+ *	Returns the number of sub-buffers in the window, 0 if none.
+ *
+ *	In overwrite mode the producer wraps without waiting for readers,
+ *	so a reader mapping the buffer can only rely on sub-buffers the
+ *	producer has completed and not yet started to reuse.  The window
+ *	returned covers sequence numbers [@first, @last]; the sub-buffer
+ *	currently being written is excluded, as is the slot it is wrapping
+ *	onto.  Sub-buffer N lives at offset (N % n_subbufs) * subbuf_size
+ *	in the mapping, with buf->padding[N % n_subbufs] unused bytes at
+ *	its end.
+ *
+ *	The producer is never stopped, so an extraction is only known to
+ *	be consistent in hindsight: copy the window out, call
+ *	relay_snapshot() again, and discard any sub-buffer whose sequence
+ *	number has fallen below the new @first - the producer reused its
+ *	slot in the meantime.  The read barrier below pairs with the write
+ *	barrier in relay_switch_subbuf() ordering sub-buffer data before
+ *	the subbufs_produced update.
+ */
+size_t relay_snapshot(struct rchan *chan, unsigned int cpu,
+		      size_t *first, size_t *last)
+{
+	struct rchan_buf *buf;
+	size_t produced, n;
+
+	if (!chan || cpu >= NR_CPUS)
+		return 0;
+
+	buf = *per_cpu_ptr(chan->buf, cpu);
+	if (!buf)
+		return 0;
+
+	produced = READ_ONCE(buf->subbufs_produced);
+	smp_rmb();
+
+	if (!produced)
+		return 0;
+
+	n = min(produced, chan->n_subbufs - 1);
+	if (!n)
+		return 0;
+
+	*first = produced - n;
+	*last = produced - 1;
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(relay_snapshot);
+
 /**
  *	relay_close - close the channel
  *	@chan: the channel
@@ -5,6 +5,11 @@
  *  Global CPU deadline management
  *
  *  Author: Juri Lelli <j.lelli@sssup.it>
+ *
+ *  The heap is sharded in blocks of CPUDL_SHARD_CPUS consecutive CPU ids
+ *  so that deadline updates on different clusters do not serialize on a
+ *  single lock. Each shard publishes its maximum into cp->tops, which
+ *  cpudl_find() merges locklessly.
  */
 #include "sched.h"
 
@@ -23,14 +28,14 @@ static inline int right_child(int i)
 	return (i << 1) + 2;
 }
 
-static void cpudl_heapify_down(struct cpudl *cp, int idx)
+static void cpudl_heapify_down(struct cpudl_shard *sh, int idx)
 {
 	int l, r, largest;
 
-	int orig_cpu = cp->elements[idx].cpu;
-	u64 orig_dl = cp->elements[idx].dl;
+	int orig_cpu = sh->elements[idx].cpu;
+	u64 orig_dl = sh->elements[idx].dl;
 
-	if (left_child(idx) >= cp->size)
+	if (left_child(idx) >= sh->size)
 		return;
 
 	/* adapted from lib/prio_heap.c */
@@ -42,68 +47,80 @@ static void cpudl_heapify_down(struct cpudl *cp, int idx)
 		largest = idx;
 		largest_dl = orig_dl;
 
-		if ((l < cp->size) && dl_time_before(orig_dl,
-						cp->elements[l].dl)) {
+		if ((l < sh->size) && dl_time_before(orig_dl,
+						sh->elements[l].dl)) {
 			largest = l;
-			largest_dl = cp->elements[l].dl;
+			largest_dl = sh->elements[l].dl;
 		}
-		if ((r < cp->size) && dl_time_before(largest_dl,
-						cp->elements[r].dl))
+		if ((r < sh->size) && dl_time_before(largest_dl,
+						sh->elements[r].dl))
 			largest = r;
 
 		if (largest == idx)
 			break;
 
 		/* pull largest child onto idx */
-		cp->elements[idx].cpu = cp->elements[largest].cpu;
-		cp->elements[idx].dl = cp->elements[largest].dl;
-		cp->elements[cp->elements[idx].cpu].idx = idx;
+		sh->elements[idx].cpu = sh->elements[largest].cpu;
+		sh->elements[idx].dl = sh->elements[largest].dl;
+		sh->elements[sh->elements[idx].cpu - sh->cpu_first].idx = idx;
 		idx = largest;
 	}
 	/* actual push down of saved original values orig_* */
-	cp->elements[idx].cpu = orig_cpu;
-	cp->elements[idx].dl = orig_dl;
-	cp->elements[cp->elements[idx].cpu].idx = idx;
+	sh->elements[idx].cpu = orig_cpu;
+	sh->elements[idx].dl = orig_dl;
+	sh->elements[orig_cpu - sh->cpu_first].idx = idx;
 }
 
-static void cpudl_heapify_up(struct cpudl *cp, int idx)
+static void cpudl_heapify_up(struct cpudl_shard *sh, int idx)
 {
 	int p;
 
-	int orig_cpu = cp->elements[idx].cpu;
-	u64 orig_dl = cp->elements[idx].dl;
+	int orig_cpu = sh->elements[idx].cpu;
+	u64 orig_dl = sh->elements[idx].dl;
 
 	if (idx == 0)
 		return;
 
 	do {
 		p = parent(idx);
-		if (dl_time_before(orig_dl, cp->elements[p].dl))
+		if (dl_time_before(orig_dl, sh->elements[p].dl))
 			break;
 		/* pull parent onto idx */
-		cp->elements[idx].cpu = cp->elements[p].cpu;
-		cp->elements[idx].dl = cp->elements[p].dl;
-		cp->elements[cp->elements[idx].cpu].idx = idx;
+		sh->elements[idx].cpu = sh->elements[p].cpu;
+		sh->elements[idx].dl = sh->elements[p].dl;
+		sh->elements[sh->elements[idx].cpu - sh->cpu_first].idx = idx;
 		idx = p;
 	} while (idx != 0);
 	/* actual push up of saved original values orig_* */
-	cp->elements[idx].cpu = orig_cpu;
-	cp->elements[idx].dl = orig_dl;
-	cp->elements[cp->elements[idx].cpu].idx = idx;
+	sh->elements[idx].cpu = orig_cpu;
+	sh->elements[idx].dl = orig_dl;
+	sh->elements[orig_cpu - sh->cpu_first].idx = idx;
 }
 
-static void cpudl_heapify(struct cpudl *cp, int idx)
+static void cpudl_heapify(struct cpudl_shard *sh, int idx)
 {
-	if (idx > 0 && dl_time_before(cp->elements[parent(idx)].dl,
-				cp->elements[idx].dl))
-		cpudl_heapify_up(cp, idx);
+	if (idx > 0 && dl_time_before(sh->elements[parent(idx)].dl,
+				sh->elements[idx].dl))
+		cpudl_heapify_up(sh, idx);
 	else
-		cpudl_heapify_down(cp, idx);
+		cpudl_heapify_down(sh, idx);
 }
 
-static inline int cpudl_maximum(struct cpudl *cp)
+/*
+ * Republish the shard maximum after a heap change, for the lockless
+ * merge in cpudl_find(). Readers tolerate a torn cpu/dl pair the same
+ * way they used to tolerate reading elements[0] without the lock.
+ */
+static void cpudl_publish_maximum(struct cpudl *cp, int shard)
 {
-	return cp->elements[0].cpu;
+	struct cpudl_shard *sh = &cp->shards[shard];
+
+	if (sh->size) {
+		WRITE_ONCE(cp->tops[shard].dl, sh->elements[0].dl);
+		WRITE_ONCE(cp->tops[shard].cpu, sh->elements[0].cpu);
+	} else {
+		WRITE_ONCE(cp->tops[shard].cpu, -1);
+	}
 }
 
 /*
@@ -123,12 +140,33 @@ int cpudl_find(struct cpudl *cp, struct task_struct *p,
 	    cpumask_and(later_mask, cp->free_cpus, p->cpus_ptr)) {
 		return 1;
 	} else {
-		int best_cpu = cpudl_maximum(cp);
+		int best_cpu = -1;
+		u64 best_dl = 0;
+		int i;
+
+		/*
+		 * Merge the per-shard maxima. Only shards whose maximum
+		 * CPU is actually allowed for @p take part, so a busy
+		 * cluster outside the affinity mask no longer hides a
+		 * suitable CPU elsewhere.
+		 */
+		for (i = 0; i < cp->nr_shards; i++) {
+			int cpu = READ_ONCE(cp->tops[i].cpu);
+			u64 dl = READ_ONCE(cp->tops[i].dl);
+
+			if (cpu == -1 || !cpumask_test_cpu(cpu, p->cpus_ptr))
+				continue;
+
+			if (best_cpu == -1 || dl_time_before(best_dl, dl)) {
+				best_cpu = cpu;
+				best_dl = dl;
+			}
+		}
 
 		WARN_ON(best_cpu != -1 && !cpu_present(best_cpu));
 
-		if (cpumask_test_cpu(best_cpu, p->cpus_ptr) &&
-		    dl_time_before(dl_se->deadline, cp->elements[0].dl)) {
+		if (best_cpu != -1 &&
+		    dl_time_before(dl_se->deadline, best_dl)) {
 			if (later_mask)
 				cpumask_set_cpu(best_cpu, later_mask);
 
@@ -149,14 +187,16 @@ int cpudl_find(struct cpudl *cp, struct task_struct *p,
  */
 void cpudl_clear(struct cpudl *cp, int cpu)
 {
+	int shard = cpu / CPUDL_SHARD_CPUS;
+	struct cpudl_shard *sh = &cp->shards[shard];
 	int old_idx, new_cpu;
 	unsigned long flags;
 
 	WARN_ON(!cpu_present(cpu));
 
-	raw_spin_lock_irqsave(&cp->lock, flags);
+	raw_spin_lock_irqsave(&sh->lock, flags);
 
-	old_idx = cp->elements[cpu].idx;
+	old_idx = sh->elements[cpu - sh->cpu_first].idx;
 	if (old_idx == IDX_INVALID) {
 		/*
 		 * Nothing to remove if old_idx was invalid.
@@ -164,17 +204,18 @@ void cpudl_clear(struct cpudl *cp, int cpu)
 		 * called for a CPU without -dl tasks running.
 		 */
 	} else {
-		new_cpu = cp->elements[cp->size - 1].cpu;
-		cp->elements[old_idx].dl = cp->elements[cp->size - 1].dl;
-		cp->elements[old_idx].cpu = new_cpu;
-		cp->size--;
-		cp->elements[new_cpu].idx = old_idx;
-		cp->elements[cpu].idx = IDX_INVALID;
-		cpudl_heapify(cp, old_idx);
+		new_cpu = sh->elements[sh->size - 1].cpu;
+		sh->elements[old_idx].dl = sh->elements[sh->size - 1].dl;
+		sh->elements[old_idx].cpu = new_cpu;
+		sh->size--;
+		sh->elements[new_cpu - sh->cpu_first].idx = old_idx;
+		sh->elements[cpu - sh->cpu_first].idx = IDX_INVALID;
+		cpudl_heapify(sh, old_idx);
 
 		cpumask_set_cpu(cpu, cp->free_cpus);
+		cpudl_publish_maximum(cp, shard);
 	}
-	raw_spin_unlock_irqrestore(&cp->lock, flags);
+	raw_spin_unlock_irqrestore(&sh->lock, flags);
 }
 
 /*
@@ -189,28 +230,31 @@ void cpudl_clear(struct cpudl *cp, int cpu)
  */
 void cpudl_set(struct cpudl *cp, int cpu, u64 dl)
 {
+	int shard = cpu / CPUDL_SHARD_CPUS;
+	struct cpudl_shard *sh = &cp->shards[shard];
 	int old_idx;
 	unsigned long flags;
 
 	WARN_ON(!cpu_present(cpu));
 
-	raw_spin_lock_irqsave(&cp->lock, flags);
+	raw_spin_lock_irqsave(&sh->lock, flags);
 
-	old_idx = cp->elements[cpu].idx;
+	old_idx = sh->elements[cpu - sh->cpu_first].idx;
 	if (old_idx == IDX_INVALID) {
-		int new_idx = cp->size++;
+		int new_idx = sh->size++;
 
-		cp->elements[new_idx].dl = dl;
-		cp->elements[new_idx].cpu = cpu;
-		cp->elements[cpu].idx = new_idx;
-		cpudl_heapify_up(cp, new_idx);
+		sh->elements[new_idx].dl = dl;
+		sh->elements[new_idx].cpu = cpu;
+		sh->elements[cpu - sh->cpu_first].idx = new_idx;
+		cpudl_heapify_up(sh, new_idx);
 		cpumask_clear_cpu(cpu, cp->free_cpus);
 	} else {
-		cp->elements[old_idx].dl = dl;
-		cpudl_heapify(cp, old_idx);
+		sh->elements[old_idx].dl = dl;
+		cpudl_heapify(sh, old_idx);
 	}
+	cpudl_publish_maximum(cp, shard);
 
-	raw_spin_unlock_irqrestore(&cp->lock, flags);
+	raw_spin_unlock_irqrestore(&sh->lock, flags);
 }
 
 /*
@@ -239,26 +283,50 @@ void cpudl_clear_freecpu(struct cpudl *cp, int cpu)
  */
 int cpudl_init(struct cpudl *cp)
 {
-	int i;
+	int i, j;
 
-	raw_spin_lock_init(&cp->lock);
-	cp->size = 0;
+	cp->nr_shards = DIV_ROUND_UP(nr_cpu_ids, CPUDL_SHARD_CPUS);
 
-	cp->elements = kcalloc(nr_cpu_ids,
-			       sizeof(struct cpudl_item),
-			       GFP_KERNEL);
-	if (!cp->elements)
+	cp->shards = kcalloc(cp->nr_shards, sizeof(struct cpudl_shard),
+			     GFP_KERNEL);
+	if (!cp->shards)
 		return -ENOMEM;
 
-	if (!zalloc_cpumask_var(&cp->free_cpus, GFP_KERNEL)) {
-		kfree(cp->elements);
-		return -ENOMEM;
+	cp->tops = kcalloc(cp->nr_shards, sizeof(struct cpudl_item),
+			   GFP_KERNEL);
+	if (!cp->tops)
+		goto free_shards;
+
+	for (i = 0; i < cp->nr_shards; i++) {
+		struct cpudl_shard *sh = &cp->shards[i];
+
+		raw_spin_lock_init(&sh->lock);
+		sh->size = 0;
+		sh->cpu_first = i * CPUDL_SHARD_CPUS;
+		sh->elements = kcalloc(CPUDL_SHARD_CPUS,
+				       sizeof(struct cpudl_item),
+				       GFP_KERNEL);
+		if (!sh->elements)
+			goto free_elements;
+
+		for (j = 0; j < CPUDL_SHARD_CPUS; j++)
+			sh->elements[j].idx = IDX_INVALID;
+
+		cp->tops[i].cpu = -1;
 	}
 
-	for_each_possible_cpu(i)
-		cp->elements[i].idx = IDX_INVALID;
+	if (!zalloc_cpumask_var(&cp->free_cpus, GFP_KERNEL))
+		goto free_elements;
 
 	return 0;
+
+free_elements:
+	for (i = 0; i < cp->nr_shards; i++)
+		kfree(cp->shards[i].elements);
+	kfree(cp->tops);
+free_shards:
+	kfree(cp->shards);
+	return -ENOMEM;
 }
 
 /*
@@ -267,6 +335,11 @@ int cpudl_init(struct cpudl *cp)
  */
 void cpudl_cleanup(struct cpudl *cp)
 {
+	int i;
+
 	free_cpumask_var(cp->free_cpus);
-	kfree(cp->elements);
+	for (i = 0; i < cp->nr_shards; i++)
+		kfree(cp->shards[i].elements);
+	kfree(cp->tops);
+	kfree(cp->shards);
 }
@@ -2,19 +2,34 @@
 
 #define IDX_INVALID		-1
 
+/*
+ * CPUs covered by one heap shard. CPU ids inside a physical cluster are
+ * contiguous, so fixed blocks of consecutive ids approximate clusters
+ * well enough to split the update traffic.
+ */
+#define CPUDL_SHARD_CPUS	16
+
 struct cpudl_item {
 	u64			dl;
 	int			cpu;
 	int			idx;
 };
 
-struct cpudl {
+struct cpudl_shard {
 	raw_spinlock_t		lock;
 	int			size;
-	cpumask_var_t		free_cpus;
+	int			cpu_first;	/* first CPU id covered */
 	struct cpudl_item	*elements;
 };
 
+struct cpudl {
+	int			nr_shards;
+	cpumask_var_t		free_cpus;
+	struct cpudl_shard	*shards;
+	/* Per-shard maxima, merged locklessly by cpudl_find() */
+	struct cpudl_item	*tops;
+};
+
 #ifdef CONFIG_SMP
 int  cpudl_find(struct cpudl *cp, struct task_struct *p, struct cpumask *later_mask);
 void cpudl_set(struct cpudl *cp, int cpu, u64 dl);
@@ -53,6 +53,9 @@ struct sugov_cpu {
 	unsigned int		iowait_boost;
 	u64			last_update;
 
+	/* Last published utilization, for shared policies */
+	unsigned long		util;
+
 	unsigned long		bw_dl;
 	unsigned long		max;
 
@@ -506,10 +509,22 @@ static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
 	for_each_cpu(j, policy->cpus) {
 		struct sugov_cpu *j_sg_cpu = &per_cpu(sugov_cpu, j);
 		unsigned long j_util, j_max;
+		s64 delta_ns;
+
+		/*
+		 * Only the published values are read here; the remote CPU
+		 * owns its sugov_cpu state and updates it under its own
+		 * rq->lock. A CPU that has not published for over a tick
+		 * has been idle long enough for its contribution to have
+		 * decayed, so skip it rather than feed stale utilization
+		 * into the maximum.
+		 */
+		delta_ns = time - READ_ONCE(j_sg_cpu->last_update);
+		if (j_sg_cpu != sg_cpu && delta_ns > TICK_NSEC)
+			continue;
 
-		j_util = sugov_get_util(j_sg_cpu);
-		j_max = j_sg_cpu->max;
-		j_util = sugov_iowait_apply(j_sg_cpu, time, j_util, j_max);
+		j_util = READ_ONCE(j_sg_cpu->util);
+		j_max = READ_ONCE(j_sg_cpu->max);
 
 		if (j_util * max > j_max * util) {
 			util = j_util;
@@ -525,15 +540,36 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 {
 	struct sugov_cpu *sg_cpu = container_of(hook, struct sugov_cpu, update_util);
 	struct sugov_policy *sg_policy = sg_cpu->sg_policy;
+	unsigned long util;
 	unsigned int next_f;
 
-	raw_spin_lock(&sg_policy->update_lock);
-
 	sugov_iowait_boost(sg_cpu, time, flags);
 	sg_cpu->last_update = time;
 
+	/*
+	 * Publish this CPU's request without taking the update lock. We
+	 * run under this CPU's rq->lock, so the per-CPU state is fully
+	 * serialized; remote CPUs only ever read the published values.
+	 * The iowait boost now also decays here, on the owning CPU,
+	 * instead of being walked from the aggregation loop.
+	 */
+	util = sugov_get_util(sg_cpu);
+	util = sugov_iowait_apply(sg_cpu, time, util, sg_cpu->max);
+	WRITE_ONCE(sg_cpu->util, util);
+
 	ignore_dl_rate_limit(sg_cpu, sg_policy);
 
+	if (!sugov_should_update_freq(sg_policy, time))
+		return;
+
+	/*
+	 * One CPU per rate_limit window performs the frequency decision.
+	 * If the lock is contended, another CPU is already on it and
+	 * there is nothing useful left to wait for.
+	 */
+	if (!raw_spin_trylock(&sg_policy->update_lock))
+		return;
+
 	if (sugov_should_update_freq(sg_policy, time)) {
 		next_f = sugov_next_freq_shared(sg_cpu, time);
 
@@ -5869,6 +5869,10 @@ static inline int select_idle_smt(struct task_struct *p, int target)
 static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int target)
 {
 	struct cpumask *cpus = this_cpu_cpumask_var_ptr(select_idle_mask);
+	struct sched_domain_shared *sd_share;
+#ifdef CONFIG_SCHED_CLUSTER
+	struct sched_domain *sd_cls;
+#endif
 	struct sched_domain *this_sd;
 	u64 avg_cost, avg_idle;
 	u64 time, cost;
@@ -5890,7 +5894,15 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 	if (sched_feat(SIS_AVG_CPU) && avg_idle < avg_cost)
 		return -1;
 
-	if (sched_feat(SIS_PROP)) {
+	if (sched_feat(SIS_UTIL)) {
+		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
+		if (sd_share) {
+			/* because !--nr is the condition to stop scan */
+			nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
+			if (nr == 1)
+				return -1;
+		}
+	} else if (sched_feat(SIS_PROP)) {
 		u64 span_avg = sd->span_weight * avg_idle;
 		if (span_avg > 4*avg_cost)
 			nr = div_u64(span_avg, avg_cost);
@@ -5898,10 +5910,43 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 			nr = 4;
 	}
 
+	/*
+	 * Bias the scan depth by the waking task's latency_nice: a latency
+	 * sensitive task is worth searching more of the LLC for an idle CPU,
+	 * a latency tolerant one can make do with a shallower scan.
+	 */
+	if (nr != INT_MAX) {
+		if (p->latency_nice < 0 && nr < sd->span_weight)
+			nr += (sd->span_weight - nr) * -p->latency_nice / 20;
+		else if (p->latency_nice > 0)
+			nr -= nr * p->latency_nice / 20;
+		if (nr < 1)
+			nr = 1;
+	}
+
 	time = cpu_clock(this);
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
 
+#ifdef CONFIG_SCHED_CLUSTER
+	/*
+	 * CPUs in the same cluster share the L2, so prefer an idle one of
+	 * those before scanning the rest of the LLC.
+	 */
+	sd_cls = rcu_dereference(per_cpu(sd_cluster, target));
+	if (sd_cls) {
+		for_each_cpu_wrap(cpu, sched_domain_span(sd_cls), target) {
+			if (!cpumask_test_cpu(cpu, cpus))
+				continue;
+			if (!--nr)
+				return -1;
+			if (available_idle_cpu(cpu) || sched_idle_cpu(cpu))
+				goto found;
+		}
+		cpumask_andnot(cpus, cpus, sched_domain_span(sd_cls));
+	}
+#endif
+
 	for_each_cpu_wrap(cpu, cpus, target) {
 		if (!--nr)
 			return -1;
@@ -5909,6 +5954,9 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 			break;
 	}
 
+#ifdef CONFIG_SCHED_CLUSTER
+found:
+#endif
 	time = cpu_clock(this) - time;
 	cost = this_sd->avg_scan_cost;
 	delta = (s64)(time - cost) / 8;
@@ -6555,6 +6603,16 @@ static unsigned long wakeup_gran(struct sched_entity *se)
 	 * This is especially important for buddies when the leftmost
 	 * task is higher priority than the buddy.
 	 */
+
+	/*
+	 * Scale the granularity by the waking task's latency_nice: a
+	 * latency sensitive waker (-20) preempts almost immediately while
+	 * a latency tolerant one (+19) has to build up nearly twice the
+	 * usual vruntime lead before it is allowed to preempt.
+	 */
+	if (entity_is_task(se))
+		gran = gran * (20 + task_of(se)->latency_nice) / 20;
+
 	return calc_delta_fair(gran, se);
 }
 
@@ -8050,12 +8108,41 @@ static inline void update_sg_lb_stats(struct lb_env *env,
 				      struct sg_lb_stats *sgs,
 				      int *sg_status)
 {
+	struct sched_group_capacity *sgc = group->sgc;
 	int i, nr_running, local_group;
+	int status = 0;
 
 	memset(sgs, 0, sizeof(*sgs));
 
 	local_group = cpumask_test_cpu(env->dst_cpu, sched_group_span(group));
 
+	/*
+	 * Newly-idle balancing fires far more often than the periodic
+	 * (tick time) balance that keeps these aggregates up to date.
+	 * Reuse the cached group walk for remote groups while it is
+	 * fresh, instead of touching every CPU of every group again.
+	 * Slightly stale or torn aggregates only cost us a sub-optimal
+	 * pull decision; the next periodic balance walks for real.
+	 */
+	if (!local_group && env->idle == CPU_NEWLY_IDLE &&
+	    !(env->flags & LBF_NOHZ_STATS) &&
+	    time_before(jiffies, READ_ONCE(sgc->stats_expiry)) &&
+	    cpumask_subset(sched_group_span(group), env->cpus)) {
+		sgs->group_load = READ_ONCE(sgc->cached_group_load);
+		sgs->group_util = READ_ONCE(sgc->cached_group_util);
+		sgs->sum_nr_running = READ_ONCE(sgc->cached_sum_nr_running);
+		sgs->sum_h_nr_running = READ_ONCE(sgc->cached_sum_h_nr_running);
+		sgs->idle_cpus = READ_ONCE(sgc->cached_idle_cpus);
+		sgs->group_misfit_task_load = READ_ONCE(sgc->cached_misfit_load);
+#ifdef CONFIG_NUMA_BALANCING
+		sgs->nr_numa_running = READ_ONCE(sgc->cached_nr_numa_running);
+		sgs->nr_preferred_running =
+			READ_ONCE(sgc->cached_nr_preferred_running);
+#endif
+		*sg_status |= READ_ONCE(sgc->cached_sg_status);
+		goto aggregate;
+	}
+
 	for_each_cpu_and(i, sched_group_span(group), env->cpus) {
 		struct rq *rq = cpu_rq(i);
 
@@ -8070,10 +8157,10 @@ static inline void update_sg_lb_stats(struct lb_env *env,
 		sgs->sum_nr_running += nr_running;
 
 		if (nr_running > 1)
-			*sg_status |= SG_OVERLOAD;
+			status |= SG_OVERLOAD;
 
 		if (cpu_overutilized(i))
-			*sg_status |= SG_OVERUTILIZED;
+			status |= SG_OVERUTILIZED;
 
 #ifdef CONFIG_NUMA_BALANCING
 		sgs->nr_numa_running += rq->nr_numa_running;
@@ -8095,10 +8182,31 @@ static inline void update_sg_lb_stats(struct lb_env *env,
 		if (env->sd->flags & SD_ASYM_CPUCAPACITY &&
 		    sgs->group_misfit_task_load < rq->misfit_task_load) {
 			sgs->group_misfit_task_load = rq->misfit_task_load;
-			*sg_status |= SG_OVERLOAD;
+			status |= SG_OVERLOAD;
 		}
 	}
 
+	*sg_status |= status;
+
+	/* Refresh the cached walk for the next newly-idle attempts */
+	if (!local_group &&
+	    cpumask_subset(sched_group_span(group), env->cpus)) {
+		WRITE_ONCE(sgc->cached_group_load, sgs->group_load);
+		WRITE_ONCE(sgc->cached_group_util, sgs->group_util);
+		WRITE_ONCE(sgc->cached_sum_nr_running, sgs->sum_nr_running);
+		WRITE_ONCE(sgc->cached_sum_h_nr_running, sgs->sum_h_nr_running);
+		WRITE_ONCE(sgc->cached_idle_cpus, sgs->idle_cpus);
+		WRITE_ONCE(sgc->cached_misfit_load, sgs->group_misfit_task_load);
+#ifdef CONFIG_NUMA_BALANCING
+		WRITE_ONCE(sgc->cached_nr_numa_running, sgs->nr_numa_running);
+		WRITE_ONCE(sgc->cached_nr_preferred_running,
+			   sgs->nr_preferred_running);
+#endif
+		WRITE_ONCE(sgc->cached_sg_status, status);
+		WRITE_ONCE(sgc->stats_expiry, jiffies + 1);
+	}
+
+aggregate:
 	/* Check if dst CPU is idle and preferred to this group */
 	if (env->sd->flags & SD_ASYM_PACKING &&
 	    env->idle != CPU_NOT_IDLE &&
@@ -8575,12 +8683,81 @@ find_idlest_group(struct sched_domain *sd, struct task_struct *p,
  * @sds: variable to hold the statistics for this sched_domain.
  */
 
+static void update_idle_cpu_scan(struct lb_env *env, unsigned long sum_util)
+{
+	struct sched_domain_shared *sd_share;
+	int llc_weight, pct;
+	u64 x, y, tmp;
+
+	/*
+	 * Update the number of CPUs to scan in LLC domain, which could
+	 * be used as a hint in select_idle_cpu(). The update of sd_share
+	 * could be expensive because it is within a shared cache line.
+	 * So the write of this hint only occurs during periodic load
+	 * balancing, rather than CPU_NEWLY_IDLE, because CPU_NEWLY_IDLE
+	 * can fire way more frequently than the former.
+	 */
+	if (!sched_feat(SIS_UTIL) || env->idle == CPU_NEWLY_IDLE)
+		return;
+
+	llc_weight = per_cpu(sd_llc_size, env->dst_cpu);
+	if (env->sd->span_weight != llc_weight)
+		return;
+
+	sd_share = rcu_dereference(per_cpu(sd_llc_shared, env->dst_cpu));
+	if (!sd_share)
+		return;
+
+	/*
+	 * The number of CPUs to search drops as sum_util increases, when
+	 * sum_util hits 85% or above, the scan stops.
+	 * The reason to choose 85% as the threshold is because this is the
+	 * imbalance_pct(117) when a LLC sched group is overloaded.
+	 *
+	 * let y = SCHED_CAPACITY_SCALE - p * x^2                       [1]
+	 * and y'= y / SCHED_CAPACITY_SCALE
+	 *
+	 * x is the ratio of sum_util compared to the CPU capacity:
+	 * x = sum_util / (llc_weight * SCHED_CAPACITY_SCALE)
+	 * y' is the ratio of CPUs to be scanned in the LLC domain,
+	 * and the number of CPUs to scan is calculated by:
+	 *
+	 * nr_scan = llc_weight * y'                                    [2]
+	 *
+	 * When x hits the threshold of overloaded, AKA, when
+	 * x = 100 / pct, y drops to 0. According to [1],
+	 * p should be SCHED_CAPACITY_SCALE * pct^2 / 10000
+	 *
+	 * Scale x by SCHED_CAPACITY_SCALE:
+	 * x' = sum_util / llc_weight;                                  [3]
+	 *
+	 * and finally [1] becomes:
+	 * y = SCHED_CAPACITY_SCALE -
+	 *     x'^2 * pct^2 / (10000 * SCHED_CAPACITY_SCALE)            [4]
+	 */
+	x = sum_util;
+	do_div(x, llc_weight);
+
+	pct = env->sd->imbalance_pct;
+	tmp = x * x * pct * pct;
+	do_div(tmp, 10000 * SCHED_CAPACITY_SCALE);
+	tmp = min_t(u64, tmp, SCHED_CAPACITY_SCALE);
+	y = SCHED_CAPACITY_SCALE - tmp;
+
+	/* Scale y to the number of CPUs in the LLC domain */
+	y *= llc_weight;
+	do_div(y, SCHED_CAPACITY_SCALE);
+	if ((int)y != sd_share->nr_idle_scan)
+		WRITE_ONCE(sd_share->nr_idle_scan, (int)y);
+}
+
 static inline void update_sd_lb_stats(struct lb_env *env, struct sd_lb_stats *sds)
 {
 	struct sched_domain *child = env->sd->child;
 	struct sched_group *sg = env->sd->groups;
 	struct sg_lb_stats *local = &sds->local_stat;
 	struct sg_lb_stats tmp_sgs;
+	unsigned long sum_util = 0;
 	int sg_status = 0;
 
 #ifdef CONFIG_NO_HZ_COMMON
@@ -8618,6 +8795,7 @@ next_group:
 		sds->total_load += sgs->group_load;
 		sds->total_capacity += sgs->group_capacity;
 
+		sum_util += sgs->group_util;
 		sg = sg->next;
 	} while (sg != env->sd->groups);
 
@@ -8651,6 +8829,8 @@ next_group:
 		WRITE_ONCE(rd->overutilized, SG_OVERUTILIZED);
 		trace_sched_overutilized_tp(rd, SG_OVERUTILIZED);
 	}
+
+	update_idle_cpu_scan(env, sum_util);
 }
 
 /**
@@ -10080,6 +10260,197 @@ abort:
 	return ret;
 }
 
+/*
+ * Offload engine for the nohz idle balance. Walking all nohz idle CPUs
+ * from the softirq of the kicked CPU can take milliseconds on a large
+ * machine and starves other softirqs there, so the softirq only forwards
+ * its kick flags to a per-node thread which does the walk in process
+ * context, bounded by a time budget per pass.
+ */
+struct nohz_balancer {
+	struct task_struct	*thread;
+	atomic_t		flags;
+	int			node;
+};
+
+static struct nohz_balancer *nohz_balancers;
+
+/* Maximum time one balancer pass may spend before it yields and re-arms */
+#define NOHZ_BALANCERD_BUDGET	msecs_to_jiffies(2)
+
+/*
+ * Per-node flavour of _nohz_idle_balance(): walk the nohz idle CPUs of
+ * one node only. Unlike the softirq path there is no "this" CPU to
+ * special case - the kicked CPU has gone back to idle by the time we
+ * run and is picked up by the regular walk.
+ */
+static void nohz_balancerd_balance(struct nohz_balancer *nb, unsigned int flags)
+{
+	/* Earliest time when we have to do rebalance again */
+	unsigned long now = jiffies;
+	unsigned long next_balance = now + 60*HZ;
+	unsigned long deadline = now + NOHZ_BALANCERD_BUDGET;
+	bool has_blocked_load = false;
+	int update_next_balance = 0;
+	int balance_cpu;
+	struct rq *rq;
+
+	/* See the comment in _nohz_idle_balance() about this protocol. */
+	WRITE_ONCE(nohz.has_blocked, 0);
+	smp_mb();
+
+	for_each_cpu_and(balance_cpu, nohz.idle_cpus_mask,
+			 cpumask_of_node(nb->node)) {
+		if (!idle_cpu(balance_cpu))
+			continue;
+
+		/*
+		 * Budget exhausted: re-arm ourselves and let the fair
+		 * class schedule us again for the remainder.
+		 */
+		if (time_after(jiffies, deadline)) {
+			atomic_or(flags, &nb->flags);
+			has_blocked_load = true;
+			break;
+		}
+
+		rq = cpu_rq(balance_cpu);
+
+		has_blocked_load |= update_nohz_stats(rq, true);
+
+		/*
+		 * If time for next balance is due,
+		 * do the balance.
+		 */
+		if (time_after_eq(jiffies, rq->next_balance)) {
+			struct rq_flags rf;
+
+			rq_lock_irqsave(rq, &rf);
+			update_rq_clock(rq);
+			rq_unlock_irqrestore(rq, &rf);
+
+			if (flags & NOHZ_BALANCE_KICK) {
+				/*
+				 * load_balance() scribbles in this CPU's
+				 * load_balance_mask scratch cpumask; every
+				 * other caller runs with BHs off, so keep
+				 * SCHED_SOFTIRQ from rewriting the mask
+				 * under us mid-iteration.
+				 */
+				local_bh_disable();
+				rebalance_domains(rq, CPU_IDLE);
+				local_bh_enable();
+			}
+		}
+
+		if (time_after(next_balance, rq->next_balance)) {
+			next_balance = rq->next_balance;
+			update_next_balance = 1;
+		}
+
+		cond_resched();
+	}
+
+	WRITE_ONCE(nohz.next_blocked,
+		now + msecs_to_jiffies(LOAD_AVG_PERIOD));
+
+	/* There is still blocked load, enable periodic update */
+	if (has_blocked_load)
+		WRITE_ONCE(nohz.has_blocked, 1);
+
+	if (likely(update_next_balance))
+		nohz.next_balance = next_balance;
+}
+
+static int nohz_balancerd(void *data)
+{
+	struct nohz_balancer *nb = data;
+
+	for (;;) {
+		unsigned int flags;
+
+		set_current_state(TASK_IDLE);
+		flags = atomic_xchg(&nb->flags, 0);
+		if (!flags) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		nohz_balancerd_balance(nb, flags);
+	}
+
+	return 0;
+}
+
+/*
+ * Forward the kick flags to the balancer thread of every node that has
+ * nohz idle CPUs. Returns false if some node is not covered by a thread
+ * yet (early boot, or thread creation failed), in which case the caller
+ * must fall back to the synchronous walk.
+ */
+static bool nohz_balancerd_kick(unsigned int flags)
+{
+	bool covered = true;
+	int node;
+
+	if (!nohz_balancers)
+		return false;
+
+	for_each_online_node(node) {
+		struct nohz_balancer *nb = &nohz_balancers[node];
+
+		if (!cpumask_intersects(nohz.idle_cpus_mask,
+					cpumask_of_node(node)))
+			continue;
+
+		if (!nb->thread) {
+			covered = false;
+			continue;
+		}
+
+		atomic_or(flags, &nb->flags);
+		wake_up_process(nb->thread);
+	}
+
+	return covered;
+}
+
+static int __init nohz_balancerd_init(void)
+{
+	int node;
+
+	nohz_balancers = kcalloc(nr_node_ids, sizeof(*nohz_balancers),
+				 GFP_KERNEL);
+	if (!nohz_balancers)
+		return -ENOMEM;
+
+	for_each_online_node(node) {
+		struct nohz_balancer *nb = &nohz_balancers[node];
+		struct task_struct *t;
+
+		nb->node = node;
+
+		if (cpumask_empty(cpumask_of_node(node)))
+			continue;
+
+		t = kthread_create_on_node(nohz_balancerd, nb, node,
+					   "nohz_balancerd/%d", node);
+		if (IS_ERR(t)) {
+			pr_warn("nohz: balancer thread for node %d failed (%ld), using softirq walk\n",
+				node, PTR_ERR(t));
+			continue;
+		}
+
+		set_cpus_allowed_ptr(t, cpumask_of_node(node));
+		nb->thread = t;
+		wake_up_process(t);
+	}
+
+	return 0;
+}
+early_initcall(nohz_balancerd_init);
+
 /*
  * In CONFIG_NO_HZ_COMMON case, the idle balance kickee will do the
  * rebalancing for all the cpus for whom scheduler ticks are stopped.
@@ -10102,7 +10473,13 @@ static bool nohz_idle_balance(struct rq *this_rq, enum cpu_idle_type idle)
 	if (!(flags & NOHZ_KICK_MASK))
 		return false;
 
-	_nohz_idle_balance(this_rq, flags, idle);
+	/*
+	 * Hand the walk over the idle CPUs off to the per-node balancer
+	 * threads, keeping this softirq cheap. Fall back to the
+	 * synchronous walk until the threads are up.
+	 */
+	if (!nohz_balancerd_kick(flags))
+		_nohz_idle_balance(this_rq, flags, idle);
 
 	return true;
 }
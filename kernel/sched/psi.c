@@ -159,6 +159,14 @@ __setup("psi=", setup_psi);
 
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
+
+/*
+ * How long after the last read of a group's pressure files its
+ * averaging window is kept alive. Past that, the periodic avgs_work
+ * stops for the group; only the raw per-cpu stall times keep
+ * accumulating, and the next reader re-materializes the window.
+ */
+#define PSI_AVGS_GRACE	(16*PSI_FREQ)
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
 #define EXP_60s		1981		/* 1/exp(2s/60s) */
 #define EXP_300s	2034		/* 1/exp(2s/300s) */
@@ -188,6 +196,8 @@ static void group_init(struct psi_group *group)
 	group->avg_last_update = sched_clock();
 	group->avg_next_update = group->avg_last_update + psi_period;
 	INIT_DELAYED_WORK(&group->avgs_work, psi_avgs_work);
+	/* No window until somebody reads or polls this group */
+	group->avg_last_read = jiffies - PSI_AVGS_GRACE;
 	mutex_init(&group->avgs_lock);
 	/* Init trigger-related members */
 	atomic_set(&group->poll_scheduled, 0);
@@ -407,6 +417,18 @@ static u64 update_averages(struct psi_group *group, u64 now)
 	return avg_next_update;
 }
 
+/*
+ * Whether anybody has shown interest in this group's averages
+ * recently. Groups nobody reads don't pay for the periodic
+ * aggregation; their totals keep accumulating per-cpu and the next
+ * reader catches the averages up in one go.
+ */
+static bool psi_avgs_wanted(struct psi_group *group)
+{
+	return time_before(jiffies,
+			   READ_ONCE(group->avg_last_read) + PSI_AVGS_GRACE);
+}
+
 static void psi_avgs_work(struct work_struct *work)
 {
 	struct delayed_work *dwork;
@@ -434,7 +456,7 @@ static void psi_avgs_work(struct work_struct *work)
 	if (now >= group->avg_next_update)
 		group->avg_next_update = update_averages(group, now);
 
-	if (nonidle) {
+	if (nonidle && psi_avgs_wanted(group)) {
 		schedule_delayed_work(dwork, nsecs_to_jiffies(
 				group->avg_next_update - now) + 1);
 	}
@@ -783,7 +805,8 @@ void psi_task_change(struct task_struct *task, int clear, int set)
 		if (state_mask & group->poll_states)
 			psi_schedule_poll_work(group, 1);
 
-		if (wake_clock && !delayed_work_pending(&group->avgs_work))
+		if (wake_clock && psi_avgs_wanted(group) &&
+		    !delayed_work_pending(&group->avgs_work))
 			schedule_delayed_work(&group->avgs_work, PSI_FREQ);
 	}
 }
@@ -948,9 +971,13 @@ int psi_show(struct seq_file *m, struct psi_group *group, enum psi_res res)
 	/* Update averages before reporting them */
 	mutex_lock(&group->avgs_lock);
 	now = sched_clock();
+	WRITE_ONCE(group->avg_last_read, jiffies);
 	collect_percpu_times(group, PSI_AVGS, NULL);
 	if (now >= group->avg_next_update)
 		group->avg_next_update = update_averages(group, now);
+	/* Keep the window running for a while for follow-up reads */
+	if (!delayed_work_pending(&group->avgs_work))
+		schedule_delayed_work(&group->avgs_work, PSI_FREQ);
 	mutex_unlock(&group->avgs_lock);
 
 	for (full = 0; full < 2 - (res == PSI_CPU); full++) {
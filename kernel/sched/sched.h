@@ -1381,6 +1381,7 @@ static inline struct sched_domain *lowest_flag_domain(int cpu, int flag)
 }
 
 DECLARE_PER_CPU(struct sched_domain __rcu *, sd_llc);
+DECLARE_PER_CPU(struct sched_domain __rcu *, sd_cluster);
 DECLARE_PER_CPU(int, sd_llc_size);
 DECLARE_PER_CPU(int, sd_llc_id);
 DECLARE_PER_CPU(struct sched_domain_shared __rcu *, sd_llc_shared);
@@ -1401,6 +1402,26 @@ struct sched_group_capacity {
 	unsigned long		next_update;
 	int			imbalance;		/* XXX unrelated to capacity but shared group state */
 
+	/*
+	 * Load-balance statistics of the last full group walk, reused by
+	 * newly-idle balance attempts while they are fresh (see
+	 * update_sg_lb_stats()).  Individual fields are written with
+	 * WRITE_ONCE() but are not updated atomically as a set; readers
+	 * may observe aggregates from two different walks.
+	 */
+	unsigned long		stats_expiry;
+	unsigned long		cached_group_load;
+	unsigned long		cached_group_util;
+	unsigned long		cached_misfit_load;
+	unsigned int		cached_sum_nr_running;
+	unsigned int		cached_sum_h_nr_running;
+	unsigned int		cached_idle_cpus;
+	int			cached_sg_status;
+#ifdef CONFIG_NUMA_BALANCING
+	unsigned int		cached_nr_numa_running;
+	unsigned int		cached_nr_preferred_running;
+#endif
+
 #ifdef CONFIG_SCHED_DEBUG
 	int			id;
 #endif
@@ -1651,6 +1672,7 @@ static inline int task_on_rq_migrating(struct task_struct *p)
 #define WF_SYNC			0x01		/* Waker goes to sleep after wakeup */
 #define WF_FORK			0x02		/* Child wakeup after fork */
 #define WF_MIGRATED		0x4		/* Internal use, task got migrated */
+#define WF_ON_CPU		0x08		/* Wakee is on_cpu */
 
 /*
  * To aid in avoiding the subversion of "niceness" due to uneven distribution
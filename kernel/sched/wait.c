@@ -126,6 +126,47 @@ static void __wake_up_common_lock(struct wait_queue_head *wq_head, unsigned int
 	} while (bookmark.flags & WQ_FLAG_BOOKMARK);
 }
 
+/**
+ * wake_up_nr_batch - detach up to @nr exclusive waiters and wake them unlocked
+ * @wq_head: the waitqueue
+ * @nr: how many exclusive waiters to wake
+ *
+ * Removes the waiters from the queue under the lock, but issues the actual
+ * wakeups from a private wake_q with the lock already dropped, so a large
+ * herd does not keep the waitqueue lock held for the whole walk.
+ *
+ * Because the entries are detached here rather than by their wakeup
+ * callback, this is only valid for waitqueues whose waiters use the
+ * autoremove style (prepare_to_wait_exclusive() + default wake semantics)
+ * and re-check their condition after waking. Waiters relying on a custom
+ * wakeup function or on staying queued across wakeups (wait_woken()) must
+ * keep using wake_up_nr().
+ */
+void wake_up_nr_batch(struct wait_queue_head *wq_head, int nr)
+{
+	wait_queue_entry_t *curr, *next;
+	unsigned long flags;
+	DEFINE_WAKE_Q(wake_q);
+
+	spin_lock_irqsave(&wq_head->lock, flags);
+	list_for_each_entry_safe(curr, next, &wq_head->head, entry) {
+		unsigned int entry_flags = curr->flags;
+
+		if (entry_flags & WQ_FLAG_BOOKMARK)
+			continue;
+
+		list_del_init(&curr->entry);
+		wake_q_add(&wake_q, curr->private);
+
+		if ((entry_flags & WQ_FLAG_EXCLUSIVE) && !--nr)
+			break;
+	}
+	spin_unlock_irqrestore(&wq_head->lock, flags);
+
+	wake_up_q(&wake_q);
+}
+EXPORT_SYMBOL_GPL(wake_up_nr_batch);
+
 /**
  * __wake_up - wake up threads blocked on a waitqueue.
  * @wq_head: the waitqueue
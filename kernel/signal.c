@@ -20,6 +20,7 @@
 #include <linux/sched/task.h>
 #include <linux/sched/task_stack.h>
 #include <linux/sched/cputime.h>
+#include <linux/sched/wake_q.h>
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/proc_fs.h>
@@ -431,7 +432,17 @@ __sigqueue_alloc(int sig, struct task_struct *t, gfp_t flags, int override_rlimi
 	rcu_read_unlock();
 
 	if (override_rlimit || likely(sigpending <= task_rlimit(t, RLIMIT_SIGPENDING))) {
-		q = kmem_cache_alloc(sigqueue_cachep, flags);
+		/*
+		 * The per-task cache is only ever touched by the owning
+		 * task and only from task context, which makes it safe
+		 * without atomics; interrupt context goes to the slab.
+		 */
+		if (in_task() && current->sigqueue_cache) {
+			q = current->sigqueue_cache;
+			current->sigqueue_cache = NULL;
+		} else {
+			q = kmem_cache_alloc(sigqueue_cachep, flags);
+		}
 	} else {
 		print_dropped_signal(sig);
 	}
@@ -454,7 +465,27 @@ static void __sigqueue_free(struct sigqueue *q)
 		return;
 	if (atomic_dec_and_test(&q->user->sigpending))
 		free_uid(q->user);
-	kmem_cache_free(sigqueue_cachep, q);
+
+	/*
+	 * Recycle into the freeing task's cache so that signal-heavy
+	 * workloads (periodic timers...) skip the allocator on the next
+	 * send.  See __sigqueue_alloc() for why this is lockless.
+	 */
+	if (in_task() && !current->sigqueue_cache)
+		current->sigqueue_cache = q;
+	else
+		kmem_cache_free(sigqueue_cachep, q);
+}
+
+/* Called from release_task() when @tsk can no longer touch its cache. */
+void exit_task_sigqueue_cache(struct task_struct *tsk)
+{
+	struct sigqueue *q = tsk->sigqueue_cache;
+
+	if (q) {
+		tsk->sigqueue_cache = NULL;
+		kmem_cache_free(sigqueue_cachep, q);
+	}
 }
 
 void flush_sigqueue(struct sigpending *queue)
@@ -986,7 +1017,50 @@ static inline bool wants_signal(int sig, struct task_struct *p)
 	return task_curr(p) || !signal_pending(p);
 }
 
-static void complete_signal(int sig, struct task_struct *p, enum pid_type type)
+/*
+ * Queue a signal wakeup on @wake_q so the caller can replay it after
+ * dropping ->siglock.  TIF_SIGPENDING is still set here, under the lock;
+ * only the wakeup itself is deferred.
+ *
+ * If the task is already on another wake queue we cannot defer: that
+ * queue will wake it with TASK_NORMAL, which does not cover the stopped
+ * and traced states a fatal signal must break out of.  Fall back to the
+ * synchronous wakeup in that case.
+ */
+static void signal_wake_up_q_add(struct wake_q_head *wake_q,
+				 struct task_struct *t)
+{
+	set_tsk_thread_flag(t, TIF_SIGPENDING);
+	if (__wake_q_add(wake_q, t))
+		get_task_struct(t);
+	else
+		signal_wake_up(t, 1);
+}
+
+/*
+ * Replay the wakeups deferred by signal_wake_up_q_add().  This is the
+ * second half of signal_wake_up(t, 1): wake with a state mask including
+ * TASK_WAKEKILL, and kick the CPU if the task is running in user mode.
+ */
+static void signal_wake_up_q(struct wake_q_head *wake_q)
+{
+	struct wake_q_node *node = wake_q->first;
+
+	while (node != WAKE_Q_TAIL) {
+		struct task_struct *t;
+
+		t = container_of(node, struct task_struct, wake_q);
+		node = node->next;
+		t->wake_q.next = NULL;
+
+		if (!wake_up_state(t, TASK_INTERRUPTIBLE | TASK_WAKEKILL))
+			kick_process(t);
+		put_task_struct(t);
+	}
+}
+
+static void complete_signal(int sig, struct task_struct *p, enum pid_type type,
+			    struct wake_q_head *wake_q)
 {
 	struct signal_struct *signal = p->signal;
 	struct task_struct *t;
@@ -1048,7 +1122,10 @@ static void complete_signal(int sig, struct task_struct *p, enum pid_type type)
 			do {
 				task_clear_jobctl_pending(t, JOBCTL_PENDING_MASK);
 				sigaddset(&t->pending.signal, SIGKILL);
-				signal_wake_up(t, 1);
+				if (wake_q)
+					signal_wake_up_q_add(wake_q, t);
+				else
+					signal_wake_up(t, 1);
 			} while_each_thread(p, t);
 			return;
 		}
@@ -1068,7 +1145,7 @@ static inline bool legacy_queue(struct sigpending *signals, int sig)
 }
 
 static int __send_signal(int sig, struct kernel_siginfo *info, struct task_struct *t,
-			enum pid_type type, bool force)
+			enum pid_type type, bool force, struct wake_q_head *wake_q)
 {
 	struct sigpending *pending;
 	struct sigqueue *q;
@@ -1177,7 +1254,7 @@ out_set:
 		}
 	}
 
-	complete_signal(sig, t, type);
+	complete_signal(sig, t, type, wake_q);
 ret:
 	trace_signal_generate(sig, info, t, type != PIDTYPE_PID, result);
 	return ret;
@@ -1206,7 +1283,7 @@ static inline bool has_si_pid_and_uid(struct kernel_siginfo *info)
 }
 
 static int send_signal(int sig, struct kernel_siginfo *info, struct task_struct *t,
-			enum pid_type type)
+			enum pid_type type, struct wake_q_head *wake_q)
 {
 	/* Should SIGKILL or SIGSTOP be received by a pid namespace init? */
 	bool force = false;
@@ -1238,7 +1315,7 @@ static int send_signal(int sig, struct kernel_siginfo *info, struct task_struct
 			force = true;
 		}
 	}
-	return __send_signal(sig, info, t, type, force);
+	return __send_signal(sig, info, t, type, force, wake_q);
 }
 
 static void print_fatal_signal(int signr)
@@ -1277,7 +1354,7 @@ __setup("print-fatal-signals=", setup_print_fatal_signals);
 int
 __group_send_sig_info(int sig, struct kernel_siginfo *info, struct task_struct *p)
 {
-	return send_signal(sig, info, p, PIDTYPE_TGID);
+	return send_signal(sig, info, p, PIDTYPE_TGID, NULL);
 }
 
 int do_send_sig_info(int sig, struct kernel_siginfo *info, struct task_struct *p,
@@ -1285,10 +1362,12 @@ int do_send_sig_info(int sig, struct kernel_siginfo *info, struct task_struct *p
 {
 	unsigned long flags;
 	int ret = -ESRCH;
+	DEFINE_WAKE_Q(wake_q);
 
 	if (lock_task_sighand(p, &flags)) {
-		ret = send_signal(sig, info, p, type);
+		ret = send_signal(sig, info, p, type, &wake_q);
 		unlock_task_sighand(p, &flags);
+		signal_wake_up_q(&wake_q);
 	}
 
 	return ret;
@@ -1312,6 +1391,7 @@ force_sig_info_to_task(struct kernel_siginfo *info, struct task_struct *t)
 	int ret, blocked, ignored;
 	struct k_sigaction *action;
 	int sig = info->si_signo;
+	DEFINE_WAKE_Q(wake_q);
 
 	spin_lock_irqsave(&t->sighand->siglock, flags);
 	action = &t->sighand->action[sig-1];
@@ -1330,8 +1410,9 @@ force_sig_info_to_task(struct kernel_siginfo *info, struct task_struct *t)
 	 */
 	if (action->sa.sa_handler == SIG_DFL && !t->ptrace)
 		t->signal->flags &= ~SIGNAL_UNKILLABLE;
-	ret = send_signal(sig, info, t, PIDTYPE_PID);
+	ret = send_signal(sig, info, t, PIDTYPE_PID, &wake_q);
 	spin_unlock_irqrestore(&t->sighand->siglock, flags);
+	signal_wake_up_q(&wake_q);
 
 	return ret;
 }
@@ -1535,7 +1616,8 @@ int kill_pid_usb_asyncio(int sig, int errno, sigval_t addr,
 
 	if (sig) {
 		if (lock_task_sighand(p, &flags)) {
-			ret = __send_signal(sig, &info, p, PIDTYPE_TGID, false);
+			ret = __send_signal(sig, &info, p, PIDTYPE_TGID, false,
+					    NULL);
 			unlock_task_sighand(p, &flags);
 		} else
 			ret = -ESRCH;
@@ -1850,6 +1932,7 @@ int send_sigqueue(struct sigqueue *q, struct pid *pid, enum pid_type type)
 	struct task_struct *t;
 	unsigned long flags;
 	int ret, result;
+	DEFINE_WAKE_Q(wake_q);
 
 	BUG_ON(!(q->flags & SIGQUEUE_PREALLOC));
 
@@ -1881,11 +1964,12 @@ int send_sigqueue(struct sigqueue *q, struct pid *pid, enum pid_type type)
 	pending = (type != PIDTYPE_PID) ? &t->signal->shared_pending : &t->pending;
 	list_add_tail(&q->list, &pending->list);
 	sigaddset(&pending->signal, sig);
-	complete_signal(sig, t, type);
+	complete_signal(sig, t, type, &wake_q);
 	result = TRACE_SIGNAL_DELIVERED;
 out:
 	trace_signal_generate(sig, &q->info, t, type != PIDTYPE_PID, result);
 	unlock_task_sighand(t, &flags);
+	signal_wake_up_q(&wake_q);
 ret:
 	rcu_read_unlock();
 	return ret;
@@ -1998,7 +2082,8 @@ bool do_notify_parent(struct task_struct *tsk, int sig)
 	 * parent's namespaces.
 	 */
 	if (valid_signal(sig) && sig)
-		__send_signal(sig, &info, tsk->parent, PIDTYPE_TGID, false);
+		__send_signal(sig, &info, tsk->parent, PIDTYPE_TGID, false,
+			      NULL);
 	__wake_up_parent(tsk, tsk->parent);
 	spin_unlock_irqrestore(&psig->siglock, flags);
 
@@ -2520,7 +2605,7 @@ static int ptrace_signal(int signr, kernel_siginfo_t *info)
 
 	/* If the (new) signal is now blocked, requeue it.  */
 	if (sigismember(&current->blocked, signr)) {
-		send_signal(signr, info, current, PIDTYPE_PID);
+		send_signal(signr, info, current, PIDTYPE_PID, NULL);
 		signr = 0;
 	}
 
@@ -4613,7 +4698,7 @@ void kdb_send_sig(struct task_struct *t, int sig)
 			   "the deadlock.\n");
 		return;
 	}
-	ret = send_signal(sig, SEND_SIG_PRIV, t, PIDTYPE_PID);
+	ret = send_signal(sig, SEND_SIG_PRIV, t, PIDTYPE_PID, NULL);
 	spin_unlock(&t->sighand->siglock);
 	if (ret)
 		kdb_printf("Fail to deliver Signal %d to process %d.\n",
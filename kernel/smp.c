@@ -32,6 +32,9 @@ struct call_function_data {
 	call_single_data_t	__percpu *csd;
 	cpumask_var_t		cpumask;
 	cpumask_var_t		cpumask_ipi;
+	/* IPIs deferred by smp_call_ipi_batch_begin() on this CPU */
+	cpumask_var_t		cpumask_batch;
+	unsigned int		batch_depth;
 };
 
 static DEFINE_PER_CPU_ALIGNED(struct call_function_data, cfd_data);
@@ -52,10 +55,17 @@ int smpcfd_prepare_cpu(unsigned int cpu)
 		free_cpumask_var(cfd->cpumask);
 		return -ENOMEM;
 	}
+	if (!zalloc_cpumask_var_node(&cfd->cpumask_batch, GFP_KERNEL,
+				     cpu_to_node(cpu))) {
+		free_cpumask_var(cfd->cpumask);
+		free_cpumask_var(cfd->cpumask_ipi);
+		return -ENOMEM;
+	}
 	cfd->csd = alloc_percpu(call_single_data_t);
 	if (!cfd->csd) {
 		free_cpumask_var(cfd->cpumask);
 		free_cpumask_var(cfd->cpumask_ipi);
+		free_cpumask_var(cfd->cpumask_batch);
 		return -ENOMEM;
 	}
 
@@ -68,6 +78,7 @@ int smpcfd_dead_cpu(unsigned int cpu)
 
 	free_cpumask_var(cfd->cpumask);
 	free_cpumask_var(cfd->cpumask_ipi);
+	free_cpumask_var(cfd->cpumask_batch);
 	free_percpu(cfd->csd);
 	return 0;
 }
@@ -134,6 +145,87 @@ static __always_inline void csd_unlock(call_single_data_t *csd)
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(call_single_data_t, csd_data);
 
+/*
+ * Send the call-function IPIs for @mask, unless an IPI batch is open on
+ * this CPU, in which case the destinations are only accumulated and the
+ * merged IPIs go out at smp_call_ipi_batch_end().  Callers must have
+ * preemption disabled.
+ */
+static void send_call_function_ipi_mask(const struct cpumask *mask)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (cfd->batch_depth) {
+		cpumask_or(cfd->cpumask_batch, cfd->cpumask_batch, mask);
+		return;
+	}
+	arch_send_call_function_ipi_mask(mask);
+}
+
+static void send_call_function_single_ipi(int cpu)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (cfd->batch_depth) {
+		__cpumask_set_cpu(cpu, cfd->cpumask_batch);
+		return;
+	}
+	arch_send_call_function_single_ipi(cpu);
+}
+
+/*
+ * Synchronous callers can't sit on a deferred IPI - kick out whatever
+ * the batch has accumulated so far before they start waiting.  The
+ * batched IPIs and the one the waiter needs still go out merged.
+ */
+static void smp_call_ipi_batch_flush(void)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (cfd->batch_depth && !cpumask_empty(cfd->cpumask_batch)) {
+		arch_send_call_function_ipi_mask(cfd->cpumask_batch);
+		cpumask_clear(cfd->cpumask_batch);
+	}
+}
+
+/**
+ * smp_call_ipi_batch_begin - open an IPI coalescing window on this CPU
+ *
+ * Until the matching smp_call_ipi_batch_end(), asynchronous cross calls
+ * issued by this CPU only queue their csd entries; the IPIs for all
+ * destinations are merged and sent once when the outermost batch is
+ * closed, so several back to back smp_call_function_many() invocations
+ * targeting overlapping masks cost one IPI per destination CPU.
+ * Synchronous calls inside a batch flush it and are not deferred.
+ *
+ * Disables preemption; batches nest.
+ */
+void smp_call_ipi_batch_begin(void)
+{
+	preempt_disable();
+	this_cpu_ptr(&cfd_data)->batch_depth++;
+}
+EXPORT_SYMBOL_GPL(smp_call_ipi_batch_begin);
+
+/**
+ * smp_call_ipi_batch_end - close an IPI coalescing window
+ *
+ * Sends the merged IPIs accumulated since smp_call_ipi_batch_begin()
+ * and re-enables preemption.
+ */
+void smp_call_ipi_batch_end(void)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (!WARN_ON_ONCE(!cfd->batch_depth) && !--cfd->batch_depth &&
+	    !cpumask_empty(cfd->cpumask_batch)) {
+		arch_send_call_function_ipi_mask(cfd->cpumask_batch);
+		cpumask_clear(cfd->cpumask_batch);
+	}
+	preempt_enable();
+}
+EXPORT_SYMBOL_GPL(smp_call_ipi_batch_end);
+
 /*
  * Insert a previously allocated call_single_data_t element
  * for execution on the given CPU. data must already have
@@ -177,7 +269,7 @@ static int generic_exec_single(int cpu, call_single_data_t *csd,
 	 * equipped to do the right thing...
 	 */
 	if (llist_add(&csd->llist, &per_cpu(call_single_queue, cpu)))
-		arch_send_call_function_single_ipi(cpu);
+		send_call_function_single_ipi(cpu);
 
 	return 0;
 }
@@ -307,8 +399,10 @@ int smp_call_function_single(int cpu, smp_call_func_t func, void *info,
 
 	err = generic_exec_single(cpu, csd, func, info);
 
-	if (wait)
+	if (wait) {
+		smp_call_ipi_batch_flush();
 		csd_lock_wait(csd);
+	}
 
 	put_cpu();
 
@@ -466,9 +560,10 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 	}
 
 	/* Send a message to all CPUs in the map */
-	arch_send_call_function_ipi_mask(cfd->cpumask_ipi);
+	send_call_function_ipi_mask(cfd->cpumask_ipi);
 
 	if (wait) {
+		smp_call_ipi_batch_flush();
 		for_each_cpu(cpu, cfd->cpumask) {
 			call_single_data_t *csd;
 
@@ -499,6 +594,62 @@ void smp_call_function_many(const struct cpumask *mask,
 }
 EXPORT_SYMBOL(smp_call_function_many);
 
+/**
+ * smp_call_function_many_async(): Run an asynchronous function on a set
+ *				   of other CPUs.
+ * @mask: The set of cpus to run on (only runs on online subset, the
+ *        current CPU is ignored).
+ * @csd: Pre-allocated per-cpu data structures, with ->func and ->info
+ *       set up by the caller for every CPU in @mask.
+ *
+ * Like smp_call_function_single_async() but for a whole mask: all csd
+ * entries are queued first and at most one IPI is sent per destination,
+ * none at all to CPUs that already have callbacks pending.  Returns
+ * without waiting; combined with smp_call_ipi_batch_begin() the IPIs
+ * can additionally be merged with those of other cross calls.
+ *
+ * The caller owns the csds and is responsible for serializing their
+ * reuse.  A csd whose CSD_FLAG_LOCK bit has cleared has completed, so
+ * completion of the whole batch can be checked with a single pass over
+ * the array instead of one wait per call.
+ */
+int smp_call_function_many_async(const struct cpumask *mask,
+				 call_single_data_t __percpu *csd)
+{
+	struct call_function_data *cfd;
+	int cpu, this_cpu;
+
+	/* Same context rules as smp_call_function_many_cond(). */
+	WARN_ON_ONCE(!in_task());
+
+	preempt_disable();
+	this_cpu = smp_processor_id();
+	cfd = this_cpu_ptr(&cfd_data);
+
+	cpumask_and(cfd->cpumask, mask, cpu_online_mask);
+	__cpumask_clear_cpu(this_cpu, cfd->cpumask);
+
+	cpumask_clear(cfd->cpumask_ipi);
+	for_each_cpu(cpu, cfd->cpumask) {
+		call_single_data_t *c = per_cpu_ptr(csd, cpu);
+
+		/* The caller failed to serialize reuse of the csd. */
+		if (WARN_ON_ONCE(c->flags & CSD_FLAG_LOCK))
+			csd_lock_wait(c);
+		c->flags = CSD_FLAG_LOCK;
+		smp_wmb();
+
+		if (llist_add(&c->llist, &per_cpu(call_single_queue, cpu)))
+			__cpumask_set_cpu(cpu, cfd->cpumask_ipi);
+	}
+
+	send_call_function_ipi_mask(cfd->cpumask_ipi);
+	preempt_enable();
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(smp_call_function_many_async);
+
 /**
  * smp_call_function(): Run a function on all other CPUs.
  * @func: The function to run. This must be fast and non-blocking.
@@ -589,20 +740,13 @@ void __init setup_nr_cpu_ids(void)
 void __init smp_init(void)
 {
 	int num_nodes, num_cpus;
-	unsigned int cpu;
 
 	idle_threads_init();
 	cpuhp_threads_init();
 
 	pr_info("Bringing up secondary CPUs ...\n");
 
-	/* FIXME: This should be done in userspace --RR */
-	for_each_present_cpu(cpu) {
-		if (num_online_cpus() >= setup_max_cpus)
-			break;
-		if (!cpu_online(cpu))
-			cpu_up(cpu);
-	}
+	bringup_nonboot_cpus(setup_max_cpus);
 
 	num_nodes = num_online_nodes();
 	num_cpus  = num_online_cpus();
@@ -25,6 +25,7 @@
 #include <linux/smpboot.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
+#include <linux/sched/clock.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/irq.h>
@@ -92,6 +93,81 @@ static bool ksoftirqd_running(unsigned long pending)
 		!__kthread_should_park(tsk);
 }
 
+/*
+ * Softirq vectors which are offloaded to a dedicated per-CPU thread once
+ * inline processing exhausts its time budget.  These are the vectors
+ * which generate load heavy enough to starve whichever task the
+ * interrupt happened to land on; routing the overflow to threads lets
+ * the scheduler place and throttle them like any other runnable task.
+ */
+static const unsigned int vector_threads[] = {
+	NET_TX_SOFTIRQ,
+	NET_RX_SOFTIRQ,
+	BLOCK_SOFTIRQ,
+};
+#define NR_VECTOR_THREADS	ARRAY_SIZE(vector_threads)
+#define SOFTIRQ_THREADED_MASK	((1 << NET_TX_SOFTIRQ) |	\
+				 (1 << NET_RX_SOFTIRQ) |	\
+				 (1 << BLOCK_SOFTIRQ))
+
+static DEFINE_PER_CPU(struct task_struct *, vector_softirqd[NR_VECTOR_THREADS]);
+static DEFINE_PER_CPU(__u32, vector_softirqd_pending);
+
+/*
+ * Move the threaded vectors in @pending from the softirq pending mask to
+ * their per-vector threads and wake them.  Vectors whose thread isn't up
+ * yet are left in the pending mask for ksoftirqd.  Interrupts must be
+ * disabled.
+ *
+ * Return: the vectors which were handed over to a thread.
+ */
+static __u32 wakeup_vector_softirqds(__u32 pending)
+{
+	__u32 routed = 0;
+	int i;
+
+	for (i = 0; i < NR_VECTOR_THREADS; i++) {
+		__u32 bit = 1 << vector_threads[i];
+		struct task_struct *tsk;
+
+		if (!(pending & bit))
+			continue;
+
+		tsk = __this_cpu_read(vector_softirqd[i]);
+		if (!tsk)
+			continue;
+
+		set_softirq_pending(local_softirq_pending() & ~bit);
+		__this_cpu_or(vector_softirqd_pending, bit);
+		routed |= bit;
+		if (tsk->state != TASK_RUNNING)
+			wake_up_process(tsk);
+	}
+
+	return routed;
+}
+
+/*
+ * Vectors already backlogged on their thread stay there; fold their
+ * newly raised bits back into the thread's backlog instead of processing
+ * them inline.  This plays the same role for the per-vector threads as
+ * ksoftirqd_running() does for ksoftirqd - without it the inline path
+ * would keep starving the CPU which the thread offload is meant to
+ * relieve.  Interrupts must be disabled.
+ */
+static __u32 softirq_defer_backlogged(__u32 pending)
+{
+	__u32 backlogged = pending & SOFTIRQ_THREADED_MASK &
+			   __this_cpu_read(vector_softirqd_pending);
+
+	if (backlogged) {
+		pending &= ~backlogged;
+		set_softirq_pending(pending);
+	}
+
+	return pending;
+}
+
 /*
  * preempt_count and SOFTIRQ_OFFSET usage:
  * - preempt_count is changed by SOFTIRQ_OFFSET on entering or leaving
@@ -199,18 +275,22 @@ EXPORT_SYMBOL(__local_bh_enable_ip);
 
 /*
  * We restart softirq processing for at most MAX_SOFTIRQ_RESTART times,
- * but break the loop if need_resched() is set or after 2 ms.
- * The MAX_SOFTIRQ_TIME provides a nice upper bound in most cases, but in
- * certain cases, such as stop_machine(), jiffies may cease to
- * increment and so we need the MAX_SOFTIRQ_RESTART limit as
- * well to make sure we eventually return from this method.
+ * but break the loop if need_resched() is set or once the inline time
+ * budget is spent.  The budget provides a nice upper bound in most
+ * cases, but sched_clock() may cease to advance in certain cases, such
+ * as stop_machine() on a jiffies based implementation, so we need the
+ * MAX_SOFTIRQ_RESTART limit as well to make sure we eventually return
+ * from this method.
  *
  * These limits have been established via experimentation.
  * The two things to balance is latency against fairness -
  * we want to handle softirqs as soon as possible, but they
  * should not be able to lock up the box.
+ *
+ * The budget is tunable through /proc/sys/kernel/softirq_inline_budget_us;
+ * the default matches the traditional hard-coded 2ms.
  */
-#define MAX_SOFTIRQ_TIME  msecs_to_jiffies(2)
+unsigned int __read_mostly softirq_inline_budget_us = 2000;
 #define MAX_SOFTIRQ_RESTART 10
 
 #ifdef CONFIG_TRACE_IRQFLAGS
@@ -248,7 +328,7 @@ static inline void lockdep_softirq_end(bool in_hardirq) { }
 
 asmlinkage __visible void __softirq_entry __do_softirq(void)
 {
-	unsigned long end = jiffies + MAX_SOFTIRQ_TIME;
+	u64 end = local_clock() + softirq_inline_budget_us * NSEC_PER_USEC;
 	unsigned long old_flags = current->flags;
 	int max_restart = MAX_SOFTIRQ_RESTART;
 	struct softirq_action *h;
@@ -263,7 +343,7 @@ asmlinkage __visible void __softirq_entry __do_softirq(void)
 	 */
 	current->flags &= ~PF_MEMALLOC;
 
-	pending = local_softirq_pending();
+	pending = softirq_defer_backlogged(local_softirq_pending());
 	account_irq_enter_time(current);
 
 	__local_bh_disable_ip(_RET_IP_, SOFTIRQ_OFFSET);
@@ -305,13 +385,16 @@ restart:
 		rcu_softirq_qs();
 	local_irq_disable();
 
-	pending = local_softirq_pending();
+	pending = softirq_defer_backlogged(local_softirq_pending());
 	if (pending) {
-		if (time_before(jiffies, end) && !need_resched() &&
+		if (local_clock() < end && !need_resched() &&
 		    --max_restart)
 			goto restart;
 
-		wakeup_softirqd();
+		if (pending & SOFTIRQ_THREADED_MASK)
+			pending &= ~wakeup_vector_softirqds(pending);
+		if (pending)
+			wakeup_softirqd();
 	}
 
 	lockdep_softirq_end(in_hardirq);
@@ -608,6 +691,67 @@ static void run_ksoftirqd(unsigned int cpu)
 	local_irq_enable();
 }
 
+/*
+ * Process the single vector queued for the per-vector thread of @idx.
+ * This mirrors one iteration of the __do_softirq() loop; anything the
+ * handler raises is routed back to the threads or to ksoftirqd before
+ * softirq context is left.
+ */
+static void run_vector_softirqd(unsigned int idx)
+{
+	unsigned int vec_nr = vector_threads[idx];
+	struct softirq_action *h = softirq_vec + vec_nr;
+	unsigned long old_flags = current->flags;
+	int prev_count;
+	__u32 pending;
+
+	local_irq_disable();
+	if (!(__this_cpu_read(vector_softirqd_pending) & (1 << vec_nr))) {
+		local_irq_enable();
+		return;
+	}
+	__this_cpu_and(vector_softirqd_pending, ~(1 << vec_nr));
+
+	/* see the comment in __do_softirq() */
+	current->flags &= ~PF_MEMALLOC;
+
+	account_irq_enter_time(current);
+	__local_bh_disable_ip(_RET_IP_, SOFTIRQ_OFFSET);
+	lockdep_softirq_enter();
+	local_irq_enable();
+
+	prev_count = preempt_count();
+
+	kstat_incr_softirqs_this_cpu(vec_nr);
+
+	trace_softirq_entry(vec_nr);
+	h->action(h);
+	trace_softirq_exit(vec_nr);
+	if (unlikely(prev_count != preempt_count())) {
+		pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
+		       vec_nr, softirq_to_name[vec_nr], h->action,
+		       prev_count, preempt_count());
+		preempt_count_set(prev_count);
+	}
+
+	rcu_softirq_qs();
+	local_irq_disable();
+
+	pending = local_softirq_pending();
+	if (pending & SOFTIRQ_THREADED_MASK)
+		pending &= ~wakeup_vector_softirqds(pending);
+	if (pending)
+		wakeup_softirqd();
+
+	lockdep_softirq_exit();
+	account_irq_exit_time(current);
+	__local_bh_enable(SOFTIRQ_OFFSET);
+	WARN_ON_ONCE(in_interrupt());
+	current_restore_flags(old_flags, PF_MEMALLOC);
+	local_irq_enable();
+	cond_resched();
+}
+
 #ifdef CONFIG_HOTPLUG_CPU
 /*
  * tasklet_kill_immediate is called to remove a tasklet which can already be
@@ -677,11 +821,35 @@ static struct smp_hotplug_thread softirq_threads = {
 	.thread_comm		= "ksoftirqd/%u",
 };
 
+#define DEFINE_VECTOR_SOFTIRQD(name, idx, comm)				\
+static int name##_softirqd_should_run(unsigned int cpu)			\
+{									\
+	return __this_cpu_read(vector_softirqd_pending) &		\
+	       (1 << vector_threads[idx]);				\
+}									\
+static void name##_softirqd_fn(unsigned int cpu)			\
+{									\
+	run_vector_softirqd(idx);					\
+}									\
+static struct smp_hotplug_thread name##_softirq_threads = {		\
+	.store			= &vector_softirqd[idx],		\
+	.thread_should_run	= name##_softirqd_should_run,		\
+	.thread_fn		= name##_softirqd_fn,			\
+	.thread_comm		= comm,					\
+}
+
+DEFINE_VECTOR_SOFTIRQD(net_tx, 0, "ktxirqd/%u");
+DEFINE_VECTOR_SOFTIRQD(net_rx, 1, "krxirqd/%u");
+DEFINE_VECTOR_SOFTIRQD(block, 2, "kblkirqd/%u");
+
 static __init int spawn_ksoftirqd(void)
 {
 	cpuhp_setup_state_nocalls(CPUHP_SOFTIRQ_DEAD, "softirq:dead", NULL,
 				  takeover_tasklets);
 	BUG_ON(smpboot_register_percpu_thread(&softirq_threads));
+	BUG_ON(smpboot_register_percpu_thread(&net_tx_softirq_threads));
+	BUG_ON(smpboot_register_percpu_thread(&net_rx_softirq_threads));
+	BUG_ON(smpboot_register_percpu_thread(&block_softirq_threads));
 
 	return 0;
 }
@@ -65,9 +65,11 @@
 #include <linux/sched/sysctl.h>
 #include <linux/sched/coredump.h>
 #include <linux/kexec.h>
+#include <linux/taskstats_kern.h>
 #include <linux/bpf.h>
 #include <linux/mount.h>
 #include <linux/userfaultfd_k.h>
+#include <linux/interrupt.h>
 
 #include "../lib/kstrtox.h"
 
@@ -105,6 +107,9 @@
 
 /* External variables not in a header file. */
 extern int suid_dumpable;
+#ifdef CONFIG_BINFMT_ELF
+extern int elf_exec_prefault;
+#endif
 #ifdef CONFIG_COREDUMP
 extern int core_uses_pid;
 extern char core_pattern[];
@@ -132,6 +137,9 @@ static unsigned long one_ul = 1;
 static unsigned long long_max = LONG_MAX;
 static int one_hundred = 100;
 static int one_thousand = 1000;
+#ifdef CONFIG_TASKSTATS
+static int taskstats_batch_max = TASKSTATS_EXIT_BATCH_MAX;
+#endif
 #ifdef CONFIG_PRINTK
 static int ten_thousand = 10000;
 #endif
@@ -1097,6 +1105,17 @@ static struct ctl_table kern_table[] = {
 		.proc_handler	= proc_dointvec,
 	},
 #endif
+#ifdef CONFIG_TASKSTATS
+	{
+		.procname	= "taskstats_exit_batch_size",
+		.data		= &taskstats_exit_batch_size,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &taskstats_batch_max,
+	},
+#endif
 #ifdef CONFIG_DETECT_HUNG_TASK
 	{
 		.procname	= "hung_task_panic",
@@ -1240,6 +1259,13 @@ static struct ctl_table kern_table[] = {
 		.extra2		= SYSCTL_ONE,
 	},
 #endif
+	{
+		.procname	= "softirq_inline_budget_us",
+		.data		= &softirq_inline_budget_us,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	},
 #ifdef CONFIG_BPF_SYSCALL
 	{
 		.procname	= "unprivileged_bpf_disabled",
@@ -1380,6 +1406,15 @@ static struct ctl_table vm_table[] = {
 		.mode		= 0644,
 		.proc_handler	= dirty_writeback_centisecs_handler,
 	},
+	{
+		.procname	= "writeback_flushers",
+		.data		= &writeback_nr_flushers,
+		.maxlen		= sizeof(writeback_nr_flushers),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &four,
+	},
 	{
 		.procname	= "dirty_expire_centisecs",
 		.data		= &dirty_expire_interval,
@@ -1405,6 +1440,15 @@ static struct ctl_table vm_table[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= &one_hundred,
 	},
+	{
+		.procname	= "multigen_aging",
+		.data		= &vm_multigen_aging,
+		.maxlen		= sizeof(vm_multigen_aging),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 #ifdef CONFIG_HUGETLB_PAGE
 	{
 		.procname	= "nr_hugepages",
@@ -1470,6 +1514,15 @@ static struct ctl_table vm_table[] = {
 		.mode		= 0200,
 		.proc_handler	= sysctl_compaction_handler,
 	},
+	{
+		.procname	= "compaction_proactiveness",
+		.data		= &sysctl_compaction_proactiveness,
+		.maxlen		= sizeof(sysctl_compaction_proactiveness),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= &one_hundred,
+	},
 	{
 		.procname	= "extfrag_threshold",
 		.data		= &sysctl_extfrag_threshold,
@@ -1782,6 +1835,13 @@ static struct ctl_table fs_table[] = {
 		.mode		= 0444,
 		.proc_handler	= proc_nr_dentry,
 	},
+	{
+		.procname	= "negative-dentry-limit",
+		.data		= &sysctl_neg_dentry_limit,
+		.maxlen		= sizeof(sysctl_neg_dentry_limit),
+		.mode		= 0644,
+		.proc_handler	= proc_doulongvec_minmax,
+	},
 	{
 		.procname	= "overflowuid",
 		.data		= &fs_overflowuid,
@@ -1910,6 +1970,17 @@ static struct ctl_table fs_table[] = {
 		.mode		= 0555,
 		.child		= sysctl_mount_point,
 	},
+#endif
+#ifdef CONFIG_BINFMT_ELF
+	{
+		.procname	= "elf-exec-prefault",
+		.data		= &elf_exec_prefault,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 #endif
 	{
 		.procname	= "pipe-max-size",
@@ -1918,6 +1989,13 @@ static struct ctl_table fs_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dopipe_max_size,
 	},
+	{
+		.procname	= "pipe-default-size",
+		.data		= &pipe_default_size,
+		.maxlen		= sizeof(pipe_default_size),
+		.mode		= 0644,
+		.proc_handler	= proc_dopipe_max_size,
+	},
 	{
 		.procname	= "pipe-user-pages-hard",
 		.data		= &pipe_user_pages_hard,
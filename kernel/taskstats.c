@@ -60,6 +60,34 @@ struct listener_list {
 };
 static DEFINE_PER_CPU(struct listener_list, listener_array);
 
+/*
+ * Exit records may be batched: instead of one netlink message per
+ * exiting task, up to taskstats_exit_batch_size records are staged
+ * per cpu and sent in a single message, either when the batch fills
+ * up or when the delayed flush fires.  A batch size of 1 (the
+ * default) preserves the traditional one-message-per-exit behaviour.
+ */
+#define TASKSTATS_EXIT_BATCH_DELAY	(HZ / 10)
+
+int taskstats_exit_batch_size __read_mostly = 1;
+
+struct taskstats_exit_rec {
+	u32 pid;
+	u32 tgid;
+	int has_tgid;
+	struct taskstats pid_stats;
+	struct taskstats tgid_stats;
+};
+
+struct taskstats_exit_batch {
+	struct mutex lock;
+	int cpu;
+	unsigned int nr;
+	struct taskstats_exit_rec *recs;
+	struct delayed_work flush_work;
+};
+static DEFINE_PER_CPU(struct taskstats_exit_batch, exit_batch);
+
 enum actions {
 	REGISTER,
 	DEREGISTER,
@@ -583,6 +611,104 @@ static struct taskstats *taskstats_tgid_alloc(struct task_struct *tsk)
 	return stats;
 }
 
+/* deliver all records staged on @batch's cpu; batch->lock held */
+static void taskstats_exit_flush(struct taskstats_exit_batch *batch)
+{
+	struct taskstats *stats;
+	struct sk_buff *rep_skb;
+	size_t size = 0;
+	unsigned int i;
+	int rc;
+
+	if (!batch->nr)
+		return;
+
+	for (i = 0; i < batch->nr; i++)
+		size += taskstats_packet_size() *
+			(batch->recs[i].has_tgid ? 2 : 1);
+
+	rc = prepare_reply(NULL, TASKSTATS_CMD_NEW, &rep_skb, size);
+	if (rc < 0)
+		goto out;
+
+	for (i = 0; i < batch->nr; i++) {
+		struct taskstats_exit_rec *rec = &batch->recs[i];
+
+		stats = mk_reply(rep_skb, TASKSTATS_TYPE_PID, rec->pid);
+		if (!stats)
+			goto err;
+		memcpy(stats, &rec->pid_stats, sizeof(*stats));
+
+		if (!rec->has_tgid)
+			continue;
+		stats = mk_reply(rep_skb, TASKSTATS_TYPE_TGID, rec->tgid);
+		if (!stats)
+			goto err;
+		memcpy(stats, &rec->tgid_stats, sizeof(*stats));
+	}
+
+	send_cpu_listeners(rep_skb, &per_cpu(listener_array, batch->cpu));
+	goto out;
+err:
+	nlmsg_free(rep_skb);
+out:
+	batch->nr = 0;
+}
+
+static void taskstats_exit_flush_work(struct work_struct *work)
+{
+	struct taskstats_exit_batch *batch =
+		container_of(to_delayed_work(work),
+			     struct taskstats_exit_batch, flush_work);
+
+	mutex_lock(&batch->lock);
+	taskstats_exit_flush(batch);
+	mutex_unlock(&batch->lock);
+}
+
+/*
+ * Stage one exit record for batched delivery.  Returns false if
+ * batching is disabled or the staging buffer cannot be allocated, in
+ * which case the caller sends its own message as before.
+ */
+static bool taskstats_exit_batched(struct task_struct *tsk, int group_dead,
+				   int is_thread_group,
+				   struct taskstats_exit_batch *batch)
+{
+	int batch_size = READ_ONCE(taskstats_exit_batch_size);
+	struct taskstats_exit_rec *rec;
+
+	if (batch_size <= 1)
+		return false;
+
+	mutex_lock(&batch->lock);
+	if (!batch->recs)
+		batch->recs = kmalloc_array(TASKSTATS_EXIT_BATCH_MAX,
+					    sizeof(*batch->recs), GFP_KERNEL);
+	if (!batch->recs) {
+		mutex_unlock(&batch->lock);
+		return false;
+	}
+
+	rec = &batch->recs[batch->nr++];
+	rec->pid = task_pid_nr_ns(tsk, &init_pid_ns);
+	fill_stats(&init_user_ns, &init_pid_ns, tsk, &rec->pid_stats);
+	rec->has_tgid = is_thread_group && group_dead;
+	if (rec->has_tgid) {
+		rec->tgid = task_tgid_nr_ns(tsk, &init_pid_ns);
+		memcpy(&rec->tgid_stats, tsk->signal->stats,
+		       sizeof(rec->tgid_stats));
+	}
+
+	if (batch->nr == 1)
+		schedule_delayed_work(&batch->flush_work,
+				      TASKSTATS_EXIT_BATCH_DELAY);
+	if (batch->nr >= min_t(int, batch_size, TASKSTATS_EXIT_BATCH_MAX))
+		taskstats_exit_flush(batch);
+	mutex_unlock(&batch->lock);
+	return true;
+}
+
 /* Send pid data out on exit */
 void taskstats_exit(struct task_struct *tsk, int group_dead)
 {
@@ -613,6 +739,10 @@ void taskstats_exit(struct task_struct *tsk, int group_dead)
 	if (list_empty(&listeners->list))
 		return;
 
+	if (taskstats_exit_batched(tsk, group_dead, is_thread_group,
+				   raw_cpu_ptr(&exit_batch)))
+		return;
+
 	rc = prepare_reply(NULL, TASKSTATS_CMD_NEW, &rep_skb, size);
 	if (rc < 0)
 		return;
@@ -701,6 +831,10 @@ void __init taskstats_init_early(void)
 	for_each_possible_cpu(i) {
 		INIT_LIST_HEAD(&(per_cpu(listener_array, i).list));
 		init_rwsem(&(per_cpu(listener_array, i).sem));
+		mutex_init(&(per_cpu(exit_batch, i).lock));
+		per_cpu(exit_batch, i).cpu = i;
+		INIT_DELAYED_WORK(&(per_cpu(exit_batch, i).flush_work),
+				  taskstats_exit_flush_work);
 	}
 }
 
@@ -46,6 +46,7 @@
 #include <linux/hashtable.h>
 #include <linux/rculist.h>
 #include <linux/nodemask.h>
+#include <linux/topology.h>
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
 #include <linux/sched/isolation.h>
@@ -276,7 +277,7 @@ struct workqueue_struct {
 	/* hot fields used during command issue, aligned to cacheline */
 	unsigned int		flags ____cacheline_aligned; /* WQ: WQ_* flags */
 	struct pool_workqueue __percpu *cpu_pwqs; /* I: per-cpu pwqs */
-	struct pool_workqueue __rcu *numa_pwq_tbl[]; /* PWR: unbound pwqs indexed by node */
+	struct pool_workqueue __rcu *pod_pwq_tbl[]; /* PWR: unbound pwqs indexed by CPU */
 };
 
 static struct kmem_cache *pwq_cache;
@@ -295,8 +296,8 @@ static bool wq_online;			/* can kworkers be created yet? */
 
 static bool wq_numa_enabled;		/* unbound NUMA affinity enabled */
 
-/* buf for wq_update_unbound_numa_attrs(), protected by CPU hotplug exclusion */
-static struct workqueue_attrs *wq_update_unbound_numa_attrs_buf;
+/* buf for wq_update_unbound_pod(), protected by CPU hotplug exclusion */
+static struct workqueue_attrs *wq_update_pod_attrs_buf;
 
 static DEFINE_MUTEX(wq_pool_mutex);	/* protects pools and workqueues list */
 static DEFINE_MUTEX(wq_pool_attach_mutex); /* protects worker attach/detach */
@@ -544,32 +545,23 @@ static int worker_pool_assign_id(struct worker_pool *pool)
 }
 
 /**
- * unbound_pwq_by_node - return the unbound pool_workqueue for the given node
+ * unbound_pwq_by_cpu - return the unbound pool_workqueue for the given CPU
  * @wq: the target workqueue
- * @node: the node ID
+ * @cpu: the CPU
  *
  * This must be called with any of wq_pool_mutex, wq->mutex or RCU
  * read locked.
  * If the pwq needs to be used beyond the locking in effect, the caller is
  * responsible for guaranteeing that the pwq stays online.
  *
- * Return: The unbound pool_workqueue for @node.
+ * Return: The unbound pool_workqueue serving @cpu's affinity scope pod.
  */
-static struct pool_workqueue *unbound_pwq_by_node(struct workqueue_struct *wq,
-						  int node)
+static struct pool_workqueue *unbound_pwq_by_cpu(struct workqueue_struct *wq,
+						 int cpu)
 {
 	assert_rcu_or_wq_mutex_or_pool_mutex(wq);
 
-	/*
-	 * XXX: @node can be NUMA_NO_NODE if CPU goes offline while a
-	 * delayed item is pending.  The plan is to keep CPU -> NODE
-	 * mapping valid and stable across CPU on/offlines.  Once that
-	 * happens, this workaround can be removed.
-	 */
-	if (unlikely(node == NUMA_NO_NODE))
-		return wq->dfl_pwq;
-
-	return rcu_dereference_raw(wq->numa_pwq_tbl[node]);
+	return rcu_dereference_raw(wq->pod_pwq_tbl[cpu]);
 }
 
 static unsigned int work_color_to_flags(int color)
@@ -1415,7 +1407,7 @@ retry:
 	if (wq->flags & WQ_UNBOUND) {
 		if (req_cpu == WORK_CPU_UNBOUND)
 			cpu = wq_select_unbound_cpu(raw_smp_processor_id());
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_cpu(wq, cpu);
 	} else {
 		if (req_cpu == WORK_CPU_UNBOUND)
 			cpu = raw_smp_processor_id();
@@ -1450,7 +1442,7 @@ retry:
 	 * pwq is determined and locked.  For unbound pools, we could have
 	 * raced with pwq release and it could already be dead.  If its
 	 * refcnt is zero, repeat pwq selection.  Note that pwqs never die
-	 * without another pwq replacing it in the numa_pwq_tbl or while
+	 * without another pwq replacing it in the pod_pwq_tbl or while
 	 * work items are executing on it, so the retrying is guaranteed to
 	 * make forward-progress.
 	 */
@@ -3358,6 +3350,7 @@ struct workqueue_attrs *alloc_workqueue_attrs(void)
 	if (!alloc_cpumask_var(&attrs->cpumask, GFP_KERNEL))
 		goto fail;
 
+	attrs->affn_scope = WQ_AFFN_NUMA;
 	cpumask_copy(attrs->cpumask, cpu_possible_mask);
 	return attrs;
 fail:
@@ -3372,9 +3365,11 @@ static void copy_workqueue_attrs(struct workqueue_attrs *to,
 	cpumask_copy(to->cpumask, from->cpumask);
 	/*
 	 * Unlike hash and equality test, this function doesn't ignore
-	 * ->no_numa as it is used for both pool and wq attrs.  Instead,
-	 * get_unbound_pool() explicitly clears ->no_numa after copying.
+	 * ->affn_scope and ->no_numa as it is used for both pool and wq
+	 * attrs.  Instead, get_unbound_pool() explicitly resets them after
+	 * copying.
 	 */
+	to->affn_scope = from->affn_scope;
 	to->no_numa = from->no_numa;
 }
 
@@ -3616,9 +3611,10 @@ static struct worker_pool *get_unbound_pool(const struct workqueue_attrs *attrs)
 	pool->node = target_node;
 
 	/*
-	 * no_numa isn't a worker_pool attribute, always clear it.  See
-	 * 'struct workqueue_attrs' comments for detail.
+	 * affn_scope and no_numa aren't worker_pool attributes, always
+	 * reset them.  See 'struct workqueue_attrs' comments for detail.
 	 */
+	pool->attrs->affn_scope = WQ_AFFN_NUMA;
 	pool->attrs->no_numa = false;
 
 	if (worker_pool_assign_id(pool) < 0)
@@ -3790,44 +3786,88 @@ static struct pool_workqueue *alloc_unbound_pwq(struct workqueue_struct *wq,
 	return pwq;
 }
 
+/* the effective affinity scope of @attrs, with ->no_numa taken into account */
+static enum wq_affn_scope wqattrs_pod_scope(const struct workqueue_attrs *attrs)
+{
+	return attrs->no_numa ? WQ_AFFN_SYSTEM : attrs->affn_scope;
+}
+
+/*
+ * Return the cpumask of the affinity scope pod @cpu belongs to under
+ * @scope.  Scopes which the running kernel has no topology information
+ * for fall back to the next wider one; a scope which degenerates to the
+ * whole machine returns cpu_possible_mask, which callers treat the same
+ * as %WQ_AFFN_SYSTEM.
+ */
+static const struct cpumask *wq_pod_cpumask(enum wq_affn_scope scope, int cpu)
+{
+	switch (scope) {
+	case WQ_AFFN_CPU:
+		return cpumask_of(cpu);
+	case WQ_AFFN_SMT:
+		return topology_sibling_cpumask(cpu);
+	case WQ_AFFN_CACHE:
+#ifdef CONFIG_SCHED_MC
+		return cpu_coregroup_mask(cpu);
+#endif
+		/* fall through */
+	case WQ_AFFN_NUMA:
+		if (wq_numa_enabled)
+			return wq_numa_possible_cpumask[cpu_to_node(cpu)];
+		/* fall through */
+	default:
+		return cpu_possible_mask;
+	}
+}
+
 /**
- * wq_calc_node_cpumask - calculate a wq_attrs' cpumask for the specified node
+ * wq_calc_pod_cpumask - calculate a wq_attrs' cpumask for @cpu's pod
  * @attrs: the wq_attrs of the default pwq of the target workqueue
- * @node: the target NUMA node
+ * @scope: the affinity scope to build pods from
+ * @cpu: the target CPU
  * @cpu_going_down: if >= 0, the CPU to consider as offline
  * @cpumask: outarg, the resulting cpumask
  *
- * Calculate the cpumask a workqueue with @attrs should use on @node.  If
- * @cpu_going_down is >= 0, that cpu is considered offline during
- * calculation.  The result is stored in @cpumask.
+ * Calculate the cpumask a workqueue with @attrs should use for the pod
+ * that @cpu belongs to under @scope.  If @cpu_going_down is >= 0, that
+ * cpu is considered offline during calculation.  The result is stored in
+ * @cpumask.
  *
- * If NUMA affinity is not enabled, @attrs->cpumask is always used.  If
- * enabled and @node has online CPUs requested by @attrs, the returned
- * cpumask is the intersection of the possible CPUs of @node and
+ * If the scope spans the whole machine, @attrs->cpumask is always used.
+ * Otherwise, if @cpu's pod has online CPUs requested by @attrs, the
+ * returned cpumask is the intersection of the pod's CPUs and
  * @attrs->cpumask.
  *
- * The caller is responsible for ensuring that the cpumask of @node stays
- * stable.
+ * The caller is responsible for ensuring that the pod membership of @cpu
+ * stays stable.
  *
  * Return: %true if the resulting @cpumask is different from @attrs->cpumask,
  * %false if equal.
  */
-static bool wq_calc_node_cpumask(const struct workqueue_attrs *attrs, int node,
-				 int cpu_going_down, cpumask_t *cpumask)
+static bool wq_calc_pod_cpumask(const struct workqueue_attrs *attrs,
+				enum wq_affn_scope scope, int cpu,
+				int cpu_going_down, cpumask_t *cpumask)
 {
-	if (!wq_numa_enabled || attrs->no_numa)
+	const struct cpumask *pod_mask;
+
+	if (scope == WQ_AFFN_SYSTEM)
+		goto use_dfl;
+
+	pod_mask = wq_pod_cpumask(scope, cpu);
+	if (pod_mask == cpu_possible_mask)
 		goto use_dfl;
 
-	/* does @node have any online CPUs @attrs wants? */
-	cpumask_and(cpumask, cpumask_of_node(node), attrs->cpumask);
+	/* does @cpu's pod have any online CPUs @attrs wants? */
+	cpumask_and(cpumask, pod_mask, attrs->cpumask);
+	cpumask_and(cpumask, cpumask, cpu_online_mask);
 	if (cpu_going_down >= 0)
 		cpumask_clear_cpu(cpu_going_down, cpumask);
 
 	if (cpumask_empty(cpumask))
 		goto use_dfl;
 
-	/* yeap, return possible CPUs in @node that @attrs wants */
-	cpumask_and(cpumask, attrs->cpumask, wq_numa_possible_cpumask[node]);
+	/* yeap, return the pod's CPUs that @attrs wants */
+	cpumask_and(cpumask, attrs->cpumask, pod_mask);
 
 	if (cpumask_empty(cpumask)) {
 		pr_warn_once("WARNING: workqueue cpumask: online intersect > "
@@ -3842,10 +3882,10 @@ use_dfl:
 	return false;
 }
 
-/* install @pwq into @wq's numa_pwq_tbl[] for @node and return the old pwq */
-static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
-						   int node,
-						   struct pool_workqueue *pwq)
+/* install @pwq into @wq's pod_pwq_tbl[] for @cpu and return the old pwq */
+static struct pool_workqueue *pod_pwq_tbl_install(struct workqueue_struct *wq,
+						  int cpu,
+						  struct pool_workqueue *pwq)
 {
 	struct pool_workqueue *old_pwq;
 
@@ -3855,8 +3895,8 @@ static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
 	/* link_pwq() can handle duplicate calls */
 	link_pwq(pwq);
 
-	old_pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-	rcu_assign_pointer(wq->numa_pwq_tbl[node], pwq);
+	old_pwq = rcu_access_pointer(wq->pod_pwq_tbl[cpu]);
+	rcu_assign_pointer(wq->pod_pwq_tbl[cpu], pwq);
 	return old_pwq;
 }
 
@@ -3873,10 +3913,10 @@ struct apply_wqattrs_ctx {
 static void apply_wqattrs_cleanup(struct apply_wqattrs_ctx *ctx)
 {
 	if (ctx) {
-		int node;
+		int cpu;
 
-		for_each_node(node)
-			put_pwq_unlocked(ctx->pwq_tbl[node]);
+		for_each_possible_cpu(cpu)
+			put_pwq_unlocked(ctx->pwq_tbl[cpu]);
 		put_pwq_unlocked(ctx->dfl_pwq);
 
 		free_workqueue_attrs(ctx->attrs);
@@ -3892,11 +3932,11 @@ apply_wqattrs_prepare(struct workqueue_struct *wq,
 {
 	struct apply_wqattrs_ctx *ctx;
 	struct workqueue_attrs *new_attrs, *tmp_attrs;
-	int node;
+	int cpu, tcpu;
 
 	lockdep_assert_held(&wq_pool_mutex);
 
-	ctx = kzalloc(struct_size(ctx, pwq_tbl, nr_node_ids), GFP_KERNEL);
+	ctx = kzalloc(struct_size(ctx, pwq_tbl, nr_cpu_ids), GFP_KERNEL);
 
 	new_attrs = alloc_workqueue_attrs();
 	tmp_attrs = alloc_workqueue_attrs();
@@ -3929,14 +3969,28 @@ apply_wqattrs_prepare(struct workqueue_struct *wq,
 	if (!ctx->dfl_pwq)
 		goto out_free;
 
-	for_each_node(node) {
-		if (wq_calc_node_cpumask(new_attrs, node, -1, tmp_attrs->cpumask)) {
-			ctx->pwq_tbl[node] = alloc_unbound_pwq(wq, tmp_attrs);
-			if (!ctx->pwq_tbl[node])
+	for_each_possible_cpu(cpu) {
+		if (wq_calc_pod_cpumask(new_attrs, wqattrs_pod_scope(new_attrs),
+					cpu, -1, tmp_attrs->cpumask)) {
+			/*
+			 * All CPUs of a pod calculate the same cpumask.
+			 * Share the pwq created for the first one.
+			 */
+			tcpu = cpumask_first(tmp_attrs->cpumask);
+			if (tcpu < cpu && ctx->pwq_tbl[tcpu] &&
+			    cpumask_equal(tmp_attrs->cpumask,
+					  ctx->pwq_tbl[tcpu]->pool->attrs->cpumask)) {
+				ctx->pwq_tbl[tcpu]->refcnt++;
+				ctx->pwq_tbl[cpu] = ctx->pwq_tbl[tcpu];
+				continue;
+			}
+
+			ctx->pwq_tbl[cpu] = alloc_unbound_pwq(wq, tmp_attrs);
+			if (!ctx->pwq_tbl[cpu])
 				goto out_free;
 		} else {
 			ctx->dfl_pwq->refcnt++;
-			ctx->pwq_tbl[node] = ctx->dfl_pwq;
+			ctx->pwq_tbl[cpu] = ctx->dfl_pwq;
 		}
 	}
 
@@ -3959,7 +4013,7 @@ out_free:
 /* set attrs and install prepared pwqs, @ctx points to old pwqs on return */
 static void apply_wqattrs_commit(struct apply_wqattrs_ctx *ctx)
 {
-	int node;
+	int cpu;
 
 	/* all pwqs have been created successfully, let's install'em */
 	mutex_lock(&ctx->wq->mutex);
@@ -3967,9 +4021,9 @@ static void apply_wqattrs_commit(struct apply_wqattrs_ctx *ctx)
 	copy_workqueue_attrs(ctx->wq->unbound_attrs, ctx->attrs);
 
 	/* save the previous pwq and install the new one */
-	for_each_node(node)
-		ctx->pwq_tbl[node] = numa_pwq_tbl_install(ctx->wq, node,
-							  ctx->pwq_tbl[node]);
+	for_each_possible_cpu(cpu)
+		ctx->pwq_tbl[cpu] = pod_pwq_tbl_install(ctx->wq, cpu,
+							ctx->pwq_tbl[cpu]);
 
 	/* @dfl_pwq might not have been used, ensure it's linked */
 	link_pwq(ctx->dfl_pwq);
@@ -4024,12 +4078,13 @@ static int apply_workqueue_attrs_locked(struct workqueue_struct *wq,
  * @wq: the target workqueue
  * @attrs: the workqueue_attrs to apply, allocated with alloc_workqueue_attrs()
  *
- * Apply @attrs to an unbound workqueue @wq.  Unless disabled, on NUMA
- * machines, this function maps a separate pwq to each NUMA node with
- * possibles CPUs in @attrs->cpumask so that work items are affine to the
- * NUMA node it was issued on.  Older pwqs are released as in-flight work
- * items finish.  Note that a work item which repeatedly requeues itself
- * back-to-back will stay on its current pwq.
+ * Apply @attrs to an unbound workqueue @wq.  Unless disabled, this
+ * function maps a separate pwq to each CPU pod of the affinity scope
+ * selected by @attrs->affn_scope with possible CPUs in @attrs->cpumask so
+ * that work items are affine to the pod they were issued on.  Older pwqs
+ * are released as in-flight work items finish.  Note that a work item
+ * which repeatedly requeues itself back-to-back will stay on its current
+ * pwq.
  *
  * Performs GFP_KERNEL allocations.
  *
@@ -4051,53 +4106,26 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	return ret;
 }
 
-/**
- * wq_update_unbound_numa - update NUMA affinity of a wq for CPU hot[un]plug
- * @wq: the target workqueue
- * @cpu: the CPU coming up or going down
- * @online: whether @cpu is coming up or going down
- *
- * This function is to be called from %CPU_DOWN_PREPARE, %CPU_ONLINE and
- * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update NUMA affinity of
- * @wq accordingly.
- *
- * If NUMA affinity can't be adjusted due to memory allocation failure, it
- * falls back to @wq->dfl_pwq which may not be optimal but is always
- * correct.
- *
- * Note that when the last allowed CPU of a NUMA node goes offline for a
- * workqueue with a cpumask spanning multiple nodes, the workers which were
- * already executing the work items for the workqueue will lose their CPU
- * affinity and may execute on any CPU.  This is similar to how per-cpu
- * workqueues behave on CPU_DOWN.  If a workqueue user wants strict
- * affinity, it's the user's responsibility to flush the work item from
- * CPU_DOWN_PREPARE.
- */
-static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
-				   bool online)
+/* update @cpu's pod_pwq_tbl[] slot of @wq, considering @cpu_off offline */
+static void wq_update_unbound_pod(struct workqueue_struct *wq, int cpu,
+				  int cpu_off)
 {
-	int node = cpu_to_node(cpu);
-	int cpu_off = online ? -1 : cpu;
 	struct pool_workqueue *old_pwq = NULL, *pwq;
 	struct workqueue_attrs *target_attrs;
 	cpumask_t *cpumask;
 
 	lockdep_assert_held(&wq_pool_mutex);
 
-	if (!wq_numa_enabled || !(wq->flags & WQ_UNBOUND) ||
-	    wq->unbound_attrs->no_numa)
-		return;
-
 	/*
 	 * We don't wanna alloc/free wq_attrs for each wq for each CPU.
 	 * Let's use a preallocated one.  The following buf is protected by
 	 * CPU hotplug exclusion.
 	 */
-	target_attrs = wq_update_unbound_numa_attrs_buf;
+	target_attrs = wq_update_pod_attrs_buf;
 	cpumask = target_attrs->cpumask;
 
 	copy_workqueue_attrs(target_attrs, wq->unbound_attrs);
-	pwq = unbound_pwq_by_node(wq, node);
+	pwq = unbound_pwq_by_cpu(wq, cpu);
 
 	/*
 	 * Let's determine what needs to be done.  If the target cpumask is
@@ -4105,7 +4133,9 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	 * and create a new one if they don't match.  If the target cpumask
 	 * equals the default pwq's, the default pwq should be used.
 	 */
-	if (wq_calc_node_cpumask(wq->dfl_pwq->pool->attrs, node, cpu_off, cpumask)) {
+	if (wq_calc_pod_cpumask(wq->dfl_pwq->pool->attrs,
+				wqattrs_pod_scope(wq->unbound_attrs), cpu,
+				cpu_off, cpumask)) {
 		if (cpumask_equal(cpumask, pwq->pool->attrs->cpumask))
 			return;
 	} else {
@@ -4115,14 +4145,14 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	/* create a new pwq */
 	pwq = alloc_unbound_pwq(wq, target_attrs);
 	if (!pwq) {
-		pr_warn("workqueue: allocation failed while updating NUMA affinity of \"%s\"\n",
+		pr_warn("workqueue: allocation failed while updating pod affinity of \"%s\"\n",
 			wq->name);
 		goto use_dfl_pwq;
 	}
 
 	/* Install the new pwq. */
 	mutex_lock(&wq->mutex);
-	old_pwq = numa_pwq_tbl_install(wq, node, pwq);
+	old_pwq = pod_pwq_tbl_install(wq, cpu, pwq);
 	goto out_unlock;
 
 use_dfl_pwq:
@@ -4130,12 +4160,64 @@ use_dfl_pwq:
 	spin_lock_irq(&wq->dfl_pwq->pool->lock);
 	get_pwq(wq->dfl_pwq);
 	spin_unlock_irq(&wq->dfl_pwq->pool->lock);
-	old_pwq = numa_pwq_tbl_install(wq, node, wq->dfl_pwq);
+	old_pwq = pod_pwq_tbl_install(wq, cpu, wq->dfl_pwq);
 out_unlock:
 	mutex_unlock(&wq->mutex);
 	put_pwq_unlocked(old_pwq);
 }
 
+/**
+ * wq_update_unbound_pods - update pod affinity of a wq for CPU hot[un]plug
+ * @wq: the target workqueue
+ * @cpu: the CPU coming up or going down
+ * @online: whether @cpu is coming up or going down
+ *
+ * This function is to be called from %CPU_DOWN_PREPARE, %CPU_ONLINE and
+ * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update the pod
+ * affinity of @wq accordingly.  Besides @cpu's own pod_pwq_tbl[] slot,
+ * the slots of its online pod siblings are refreshed too as the pods of
+ * topology based scopes (SMT, cache) grow and shrink with @cpu.
+ *
+ * If pod affinity can't be adjusted due to memory allocation failure, it
+ * falls back to @wq->dfl_pwq which may not be optimal but is always
+ * correct.
+ *
+ * Note that when the last allowed CPU of a pod goes offline for a
+ * workqueue with a cpumask spanning multiple pods, the workers which were
+ * already executing the work items for the workqueue will lose their CPU
+ * affinity and may execute on any CPU.  This is similar to how per-cpu
+ * workqueues behave on CPU_DOWN.  If a workqueue user wants strict
+ * affinity, it's the user's responsibility to flush the work item from
+ * CPU_DOWN_PREPARE.
+ */
+static void wq_update_unbound_pods(struct workqueue_struct *wq, int cpu,
+				   bool online)
+{
+	int cpu_off = online ? -1 : cpu;
+	const struct cpumask *pod_mask;
+	enum wq_affn_scope scope;
+	int tcpu;
+
+	lockdep_assert_held(&wq_pool_mutex);
+
+	if (!(wq->flags & WQ_UNBOUND))
+		return;
+
+	scope = wqattrs_pod_scope(wq->unbound_attrs);
+	if (scope == WQ_AFFN_SYSTEM)
+		return;
+
+	pod_mask = wq_pod_cpumask(scope, cpu);
+	if (pod_mask == cpu_possible_mask)
+		return;
+
+	for_each_cpu_and(tcpu, pod_mask, cpu_online_mask) {
+		if (tcpu != cpu)
+			wq_update_unbound_pod(wq, tcpu, cpu_off);
+	}
+	wq_update_unbound_pod(wq, cpu, cpu_off);
+}
+
 static int alloc_and_link_pwqs(struct workqueue_struct *wq)
 {
 	bool highpri = wq->flags & WQ_HIGHPRI;
@@ -4231,7 +4313,7 @@ struct workqueue_struct *alloc_workqueue(const char *fmt,
 
 	/*
 	 * Unbound && max_active == 1 used to imply ordered, which is no
-	 * longer the case on NUMA machines due to per-node pools.  While
+	 * longer the case on machines with multiple CPU pods.  While
 	 * alloc_ordered_workqueue() is the right way to create an ordered
 	 * workqueue, keep the previous behavior to avoid subtle breakages
 	 * on NUMA.
@@ -4245,7 +4327,7 @@ struct workqueue_struct *alloc_workqueue(const char *fmt,
 
 	/* allocate wq and format name */
 	if (flags & WQ_UNBOUND)
-		tbl_size = nr_node_ids * sizeof(wq->numa_pwq_tbl[0]);
+		tbl_size = nr_cpu_ids * sizeof(wq->pod_pwq_tbl[0]);
 
 	wq = kzalloc(sizeof(*wq) + tbl_size, GFP_KERNEL);
 	if (!wq)
@@ -4342,7 +4424,7 @@ static bool pwq_busy(struct pool_workqueue *pwq)
 void destroy_workqueue(struct workqueue_struct *wq)
 {
 	struct pool_workqueue *pwq;
-	int node;
+	int cpu;
 
 	/*
 	 * Remove it from sysfs first so that sanity check failure doesn't
@@ -4408,12 +4490,12 @@ void destroy_workqueue(struct workqueue_struct *wq)
 	} else {
 		/*
 		 * We're the sole accessor of @wq at this point.  Directly
-		 * access numa_pwq_tbl[] and dfl_pwq to put the base refs.
+		 * access pod_pwq_tbl[] and dfl_pwq to put the base refs.
 		 * @wq will be freed when the last pwq is released.
 		 */
-		for_each_node(node) {
-			pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-			RCU_INIT_POINTER(wq->numa_pwq_tbl[node], NULL);
+		for_each_possible_cpu(cpu) {
+			pwq = rcu_access_pointer(wq->pod_pwq_tbl[cpu]);
+			RCU_INIT_POINTER(wq->pod_pwq_tbl[cpu], NULL);
 			put_pwq_unlocked(pwq);
 		}
 
@@ -4523,7 +4605,7 @@ bool workqueue_congested(int cpu, struct workqueue_struct *wq)
 	if (!(wq->flags & WQ_UNBOUND))
 		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
 	else
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_cpu(wq, cpu);
 
 	ret = !list_empty(&pwq->delayed_works);
 	preempt_enable();
@@ -5048,9 +5130,9 @@ int workqueue_online_cpu(unsigned int cpu)
 		mutex_unlock(&wq_pool_attach_mutex);
 	}
 
-	/* update NUMA affinity of unbound workqueues */
+	/* update pod affinity of unbound workqueues */
 	list_for_each_entry(wq, &workqueues, list)
-		wq_update_unbound_numa(wq, cpu, true);
+		wq_update_unbound_pods(wq, cpu, true);
 
 	mutex_unlock(&wq_pool_mutex);
 	return 0;
@@ -5066,10 +5148,10 @@ int workqueue_offline_cpu(unsigned int cpu)
 
 	unbind_workers(cpu);
 
-	/* update NUMA affinity of unbound workqueues */
+	/* update pod affinity of unbound workqueues */
 	mutex_lock(&wq_pool_mutex);
 	list_for_each_entry(wq, &workqueues, list)
-		wq_update_unbound_numa(wq, cpu, false);
+		wq_update_unbound_pods(wq, cpu, false);
 	mutex_unlock(&wq_pool_mutex);
 
 	return 0;
@@ -5400,14 +5482,14 @@ static ssize_t wq_pool_ids_show(struct device *dev,
 {
 	struct workqueue_struct *wq = dev_to_wq(dev);
 	const char *delim = "";
-	int node, written = 0;
+	int cpu, written = 0;
 
 	get_online_cpus();
 	rcu_read_lock();
-	for_each_node(node) {
+	for_each_possible_cpu(cpu) {
 		written += scnprintf(buf + written, PAGE_SIZE - written,
-				     "%s%d:%d", delim, node,
-				     unbound_pwq_by_node(wq, node)->pool->id);
+				     "%s%d:%d", delim, cpu,
+				     unbound_pwq_by_cpu(wq, cpu)->pool->id);
 		delim = " ";
 	}
 	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
@@ -5507,6 +5589,57 @@ out_unlock:
 	return ret ?: count;
 }
 
+static const char *wq_affn_names[WQ_AFFN_NR_TYPES] = {
+	[WQ_AFFN_CPU]		= "cpu",
+	[WQ_AFFN_SMT]		= "smt",
+	[WQ_AFFN_CACHE]		= "cache",
+	[WQ_AFFN_NUMA]		= "numa",
+	[WQ_AFFN_SYSTEM]	= "system",
+};
+
+static ssize_t wq_affn_scope_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int written;
+
+	mutex_lock(&wq->mutex);
+	written = scnprintf(buf, PAGE_SIZE, "%s\n",
+			    wq_affn_names[wq->unbound_attrs->affn_scope]);
+	mutex_unlock(&wq->mutex);
+
+	return written;
+}
+
+static ssize_t wq_affn_scope_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	struct workqueue_attrs *attrs;
+	int affn, ret = -ENOMEM;
+
+	apply_wqattrs_lock();
+
+	attrs = wq_sysfs_prep_attrs(wq);
+	if (!attrs)
+		goto out_unlock;
+
+	ret = -EINVAL;
+	for (affn = 0; affn < WQ_AFFN_NR_TYPES; affn++) {
+		if (sysfs_streq(buf, wq_affn_names[affn])) {
+			attrs->affn_scope = affn;
+			ret = apply_workqueue_attrs_locked(wq, attrs);
+			break;
+		}
+	}
+
+out_unlock:
+	apply_wqattrs_unlock();
+	free_workqueue_attrs(attrs);
+	return ret ?: count;
+}
+
 static ssize_t wq_numa_show(struct device *dev, struct device_attribute *attr,
 			    char *buf)
 {
@@ -5550,6 +5683,7 @@ static struct device_attribute wq_sysfs_unbound_attrs[] = {
 	__ATTR(pool_ids, 0444, wq_pool_ids_show, NULL),
 	__ATTR(nice, 0644, wq_nice_show, wq_nice_store),
 	__ATTR(cpumask, 0644, wq_cpumask_show, wq_cpumask_store),
+	__ATTR(affinity_scope, 0644, wq_affn_scope_show, wq_affn_scope_store),
 	__ATTR(numa, 0644, wq_numa_show, wq_numa_store),
 	__ATTR_NULL,
 };
@@ -5859,9 +5993,6 @@ static void __init wq_numa_init(void)
 		return;
 	}
 
-	wq_update_unbound_numa_attrs_buf = alloc_workqueue_attrs();
-	BUG_ON(!wq_update_unbound_numa_attrs_buf);
-
 	/*
 	 * We want masks of possible CPUs of each node which isn't readily
 	 * available.  Build one from cpu_to_node() which should have been
@@ -5993,6 +6124,9 @@ int __init workqueue_init(void)
 	 *
 	 * Also, while iterating workqueues, create rescuers if requested.
 	 */
+	wq_update_pod_attrs_buf = alloc_workqueue_attrs();
+	BUG_ON(!wq_update_pod_attrs_buf);
+
 	wq_numa_init();
 
 	mutex_lock(&wq_pool_mutex);
@@ -6004,7 +6138,7 @@ int __init workqueue_init(void)
 	}
 
 	list_for_each_entry(wq, &workqueues, list) {
-		wq_update_unbound_numa(wq, smp_processor_id(), true);
+		wq_update_unbound_pods(wq, smp_processor_id(), true);
 		WARN(init_rescuer(wq),
 		     "workqueue: failed to create early rescuer for %s",
 		     wq->name);
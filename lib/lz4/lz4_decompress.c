@@ -87,6 +87,11 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	BYTE * const oend = op + outputSize;
 	BYTE *cpy;
 
+	unsigned int token;
+	size_t length;
+	const BYTE *match;
+	size_t offset;
+
 	const BYTE * const dictEnd = (const BYTE *)dictStart + dictSize;
 	static const unsigned int inc32table[8] = {0, 1, 2, 1, 0, 4, 4, 4};
 	static const int dec64table[8] = {0, 0, 0, -1, -4, 1, 2, 3};
@@ -117,14 +122,162 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	if ((endOnInput) && unlikely(srcSize == 0))
 		return -1;
 
+#if LZ4_FAST_DEC_LOOP
+	/*
+	 * Fast loop : decode sequences with wide (16/32 byte) copies as
+	 * long as there is FASTLOOP_SAFE_DISTANCE of room left in the
+	 * output.  Any sequence coming close to either buffer end bails
+	 * out into the byte-exact main loop below, which re-applies all
+	 * the end-of-block checks, so the fast loop never needs to be
+	 * precise about the tail.
+	 */
+	if ((endOnInput) && (oend - op) >= FASTLOOP_SAFE_DISTANCE) {
+	    while (1) {
+		/* we can always wildcopy FASTLOOP_SAFE_DISTANCE here */
+		assert(oend - op >= FASTLOOP_SAFE_DISTANCE);
+		assert(ip < iend);
+
+		token = *ip++;
+		length = token>>ML_BITS;
+
+		/* decode literal length */
+		if (length == RUN_MASK) {
+			unsigned int s;
+
+			if (unlikely(ip >= iend - RUN_MASK)) {
+				/* overflow detection */
+				goto _output_error;
+			}
+			do {
+				s = *ip++;
+				length += s;
+			} while (likely(ip < iend - RUN_MASK) & (s == 255));
+
+			if ((safeDecode)
+			    && unlikely((uptrval)(op) +
+					length < (uptrval)(op))) {
+				/* overflow detection */
+				goto _output_error;
+			}
+			if ((safeDecode)
+			    && unlikely((uptrval)(ip) +
+					length < (uptrval)(ip))) {
+				/* overflow detection */
+				goto _output_error;
+			}
+
+			/* copy literals */
+			cpy = op + length;
+			if ((cpy > oend - 32) || (ip + length > iend - 32))
+				goto safe_literal_copy;
+			/* may overwrite up to 31 bytes beyond cpy */
+			LZ4_wildCopy32(op, ip, cpy);
+			ip += length;
+			op = cpy;
+		} else {
+			cpy = op + length;
+			/*
+			 * The output room is covered by the loop
+			 * invariant, only the input needs checking:
+			 * up to 14 literals, 2 offset bytes and the
+			 * next token must still be readable.
+			 */
+			if (ip > iend - (16 + 1))
+				goto safe_literal_copy;
+			/*
+			 * Literals are at most 14 bytes here, but a
+			 * fixed-size copy compiles to two register
+			 * moves instead of a memcpy call.
+			 */
+			memcpy(op, ip, 16);
+			ip += length;
+			op = cpy;
+		}
+
+		/* get offset */
+		offset = LZ4_readLE16(ip);
+		ip += 2;
+		match = op - offset;
+		assert(match <= op);
+
+		/* get matchlength */
+		length = token & ML_MASK;
+
+		if (length == ML_MASK) {
+			unsigned int s;
+
+			if ((checkOffset) &&
+			    (unlikely(match + dictSize < lowPrefix))) {
+				/* Error : offset outside buffers */
+				goto _output_error;
+			}
+			do {
+				s = *ip++;
+
+				if (ip > iend - LASTLITERALS)
+					goto _output_error;
+
+				length += s;
+			} while (s == 255);
+
+			if ((safeDecode)
+				&& unlikely(
+					(uptrval)(op) + length < (uptrval)op)) {
+				/* overflow detection */
+				goto _output_error;
+			}
+
+			length += MINMATCH;
+			if (op + length >= oend - FASTLOOP_SAFE_DISTANCE)
+				goto safe_match_copy;
+		} else {
+			length += MINMATCH;
+			if (op + length >= oend - FASTLOOP_SAFE_DISTANCE)
+				goto safe_match_copy;
+
+			/* fastpath: no overlap, no dictionary crossing */
+			if ((dict == withPrefix64k) || (match >= lowPrefix)) {
+				if (offset >= 8) {
+					memcpy(op, match, 8);
+					memcpy(op + 8, match + 8, 8);
+					memcpy(op + 16, match + 16, 2);
+					op += length;
+					continue;
+				}
+			}
+		}
+
+		if ((checkOffset) && (unlikely(match + dictSize < lowPrefix))) {
+			/* Error : offset outside buffers */
+			goto _output_error;
+		}
+
+		/*
+		 * Matches reaching into the external dictionary are rare
+		 * enough not to earn a wide-copy variant: finish the block
+		 * in the byte-exact loop.
+		 */
+		if ((dict == usingExtDict) && (match < lowPrefix))
+			goto safe_match_copy;
+
+		/* copy match within block */
+		cpy = op + length;
+
+		assert((op <= oend) && (oend - op >= 32));
+		if (unlikely(offset < 16))
+			LZ4_memcpy_using_offset(op, match, cpy, offset);
+		else
+			LZ4_wildCopy32(op, match, cpy);
+
+		op = cpy; /* wildcopy correction */
+	    }
+	}
+#endif
+
 	/* Main Loop : decode sequences */
 	while (1) {
-		size_t length;
-		const BYTE *match;
-		size_t offset;
-
 		/* get literal length */
-		unsigned int const token = *ip++;
+		token = *ip++;
 		length = token>>ML_BITS;
 
 		/* ip < iend before the increment */
@@ -216,6 +369,9 @@ static FORCE_INLINE int LZ4_decompress_generic(
 
 		/* copy literals */
 		cpy = op + length;
+#if LZ4_FAST_DEC_LOOP
+safe_literal_copy:
+#endif
 		LZ4_STATIC_ASSERT(MFLIMIT >= WILDCOPYLENGTH);
 
 		if (((endOnInput) && ((cpy > oend - MFLIMIT)
@@ -283,23 +439,6 @@ static FORCE_INLINE int LZ4_decompress_generic(
 		length = token & ML_MASK;
 
 _copy_match:
-		if ((checkOffset) && (unlikely(match + dictSize < lowPrefix))) {
-			/* Error : offset outside buffers */
-			goto _output_error;
-		}
-
-		/* costs ~1%; silence an msan warning when offset == 0 */
-		/*
-		 * note : when partialDecoding, there is no guarantee that
-		 * at least 4 bytes remain available in output buffer
-		 */
-		if (!partialDecoding) {
-			assert(oend > op);
-			assert(oend - op >= 4);
-
-			LZ4_write32(op, (U32)offset);
-		}
-
 		if (length == ML_MASK) {
 			unsigned int s;
 
@@ -322,6 +461,26 @@ _copy_match:
 
 		length += MINMATCH;
 
+#if LZ4_FAST_DEC_LOOP
+safe_match_copy:
+#endif
+		if ((checkOffset) && (unlikely(match + dictSize < lowPrefix))) {
+			/* Error : offset outside buffers */
+			goto _output_error;
+		}
+
+		/* costs ~1%; silence an msan warning when offset == 0 */
+		/*
+		 * note : when partialDecoding, there is no guarantee that
+		 * at least 4 bytes remain available in output buffer
+		 */
+		if (!partialDecoding) {
+			assert(oend > op);
+			assert(oend - op >= 4);
+
+			LZ4_write32(op, (U32)offset);
+		}
+
 		/* match starting within external dictionary */
 		if ((dict == usingExtDict) && (match < lowPrefix)) {
 			if (unlikely(op + length > oend - LASTLITERALS)) {
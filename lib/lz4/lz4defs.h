@@ -75,6 +75,24 @@ typedef uintptr_t uptrval;
 #define WILDCOPYLENGTH 8
 #define LASTLITERALS 5
 #define MFLIMIT (WILDCOPYLENGTH + MINMATCH)
+
+/*
+ * The wide-copy decompression loop below needs this much room between
+ * op and oend; once closer to the end, decoding drops back to the
+ * byte-exact safe loop.
+ */
+#define FASTLOOP_SAFE_DISTANCE 64
+
+/*
+ * Wide copies pay off where an unaligned register load/store is cheap
+ * and registers are plentiful; that is the 64-bit targets we care
+ * about (x86-64, arm64).  32-bit targets keep the old 8-byte loop.
+ */
+#if LZ4_ARCH64
+#define LZ4_FAST_DEC_LOOP 1
+#else
+#define LZ4_FAST_DEC_LOOP 0
+#endif
 /*
  * ensure it's possible to write 2 x wildcopyLength
  * without overflowing output buffer
@@ -170,6 +188,91 @@ static FORCE_INLINE void LZ4_wildCopy(void *dstPtr,
 	} while (d < e);
 }
 
+/*
+ * 32-byte variant for the decompression fast loop,
+ * may overwrite up to 31 bytes beyond dstEnd
+ */
+static FORCE_INLINE void LZ4_wildCopy32(void *dstPtr,
+	const void *srcPtr, void *dstEnd)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE *const e = (BYTE *)dstEnd;
+
+	do {
+		LZ4_copy8(d, s);
+		LZ4_copy8(d + 8, s + 8);
+		LZ4_copy8(d + 16, s + 16);
+		LZ4_copy8(d + 24, s + 24);
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
+static FORCE_INLINE void LZ4_memcpy_using_offset_base(BYTE *dstPtr,
+	const BYTE *srcPtr, BYTE *dstEnd, const size_t offset)
+{
+	static const unsigned int inc32table[8] = {0, 1, 2, 1, 0, 4, 4, 4};
+	static const int dec64table[8] = {0, 0, 0, -1, -4, 1, 2, 3};
+
+	if (offset < 8) {
+		/* silence an msan warning when offset == 0 */
+		LZ4_write32(dstPtr, 0);
+		dstPtr[0] = srcPtr[0];
+		dstPtr[1] = srcPtr[1];
+		dstPtr[2] = srcPtr[2];
+		dstPtr[3] = srcPtr[3];
+		srcPtr += inc32table[offset];
+		memcpy(dstPtr + 4, srcPtr, 4);
+		srcPtr -= dec64table[offset];
+		dstPtr += 8;
+	} else {
+		LZ4_copy8(dstPtr, srcPtr);
+		dstPtr += 8;
+		srcPtr += 8;
+	}
+
+	LZ4_wildCopy(dstPtr, srcPtr, dstEnd);
+}
+
+/*
+ * Overlapping match copy for the decompression fast loop: the repeating
+ * offsets 1, 2, 4 and 8 are turned into an 8-byte pattern store, the
+ * rest goes through a staggered copy.  Presumes:
+ * - dstEnd >= dstPtr + MINMATCH
+ * - there are at least 8 bytes available to write after dstEnd
+ */
+static FORCE_INLINE void LZ4_memcpy_using_offset(BYTE *dstPtr,
+	const BYTE *srcPtr, BYTE *dstEnd, const size_t offset)
+{
+	BYTE v[8];
+
+	switch (offset) {
+	case 1:
+		memset(v, *srcPtr, 8);
+		break;
+	case 2:
+		memcpy(v, srcPtr, 2);
+		memcpy(&v[2], srcPtr, 2);
+		memcpy(&v[4], &v[0], 4);
+		break;
+	case 4:
+		memcpy(v, srcPtr, 4);
+		memcpy(&v[4], srcPtr, 4);
+		break;
+	default:
+		LZ4_memcpy_using_offset_base(dstPtr, srcPtr, dstEnd, offset);
+		return;
+	}
+
+	memcpy(dstPtr, v, 8);
+	dstPtr += 8;
+	while (dstPtr < dstEnd) {
+		memcpy(dstPtr, v, 8);
+		dstPtr += 8;
+	}
+}
+
 static FORCE_INLINE unsigned int LZ4_NbCommonBytes(register size_t val)
 {
 #if LZ4_LITTLE_ENDIAN
@@ -96,6 +96,35 @@ EXPORT_SYMBOL_GPL(raid6_2data_recov);
 void (*raid6_datap_recov)(int, size_t, int, void **);
 EXPORT_SYMBOL_GPL(raid6_datap_recov);
 
+/* winner of raid6_choose_recov(), for the batch entry points below */
+static const struct raid6_recov_calls *raid6_recov_best;
+
+void raid6_2data_recov_batch(int disks, size_t bytes, int faila, int failb,
+			     void ***ptrs, int nr_stripes)
+{
+	int i;
+
+	if (raid6_recov_best && raid6_recov_best->data2_batch) {
+		raid6_recov_best->data2_batch(disks, bytes, faila, failb,
+					      ptrs, nr_stripes);
+		return;
+	}
+
+	for (i = 0; i < nr_stripes; i++)
+		raid6_2data_recov(disks, bytes, faila, failb, ptrs[i]);
+}
+EXPORT_SYMBOL_GPL(raid6_2data_recov_batch);
+
+void raid6_datap_recov_batch(int disks, size_t bytes, int faila,
+			     void ***ptrs, int nr_stripes)
+{
+	int i;
+
+	for (i = 0; i < nr_stripes; i++)
+		raid6_datap_recov(disks, bytes, faila, ptrs[i]);
+}
+EXPORT_SYMBOL_GPL(raid6_datap_recov_batch);
+
 const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #ifdef CONFIG_AS_AVX512
 	&raid6_recov_avx512,
@@ -127,19 +156,56 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #define RAID6_TEST_DISKS	8
 #define RAID6_TEST_DISKS_ORDER	3
 
-static inline const struct raid6_recov_calls *raid6_choose_recov(void)
+static inline const struct raid6_recov_calls *raid6_choose_recov(
+	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
 {
+	/* recover the last two data disks of the test stripe */
+	const int faila = disks - 4, failb = disks - 3;
+	unsigned long perf, bestperf, j0, j1;
 	const struct raid6_recov_calls *const *algo;
 	const struct raid6_recov_calls *best;
 
-	for (best = NULL, algo = raid6_recov_algos; *algo; algo++)
-		if (!best || (*algo)->priority > best->priority)
-			if (!(*algo)->valid || (*algo)->valid())
+	for (bestperf = 0, best = NULL, algo = raid6_recov_algos; *algo; algo++) {
+		if ((*algo)->valid && !(*algo)->valid())
+			continue;
+
+		if (!IS_ENABLED(CONFIG_RAID6_PQ_BENCHMARK)) {
+			if (!best || (*algo)->priority > best->priority)
 				best = *algo;
+			continue;
+		}
+
+		/*
+		 * Must run after raid6_choose_gen(): recovery
+		 * regenerates the syndrome through raid6_call.
+		 */
+		perf = 0;
+
+		preempt_disable();
+		j0 = jiffies;
+		while ((j1 = jiffies) == j0)
+			cpu_relax();
+		while (time_before(jiffies,
+				    j1 + (1<<RAID6_TIME_JIFFIES_LG2))) {
+			(*algo)->data2(disks, PAGE_SIZE, faila, failb, *dptrs);
+			perf++;
+		}
+		preempt_enable();
+
+		pr_info("raid6: %-8s rec() %5ld MB/s\n", (*algo)->name,
+			(perf * HZ * (disks-2)) >>
+			(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2));
+
+		if (perf > bestperf) {
+			bestperf = perf;
+			best = *algo;
+		}
+	}
 
 	if (best) {
 		raid6_2data_recov = best->data2;
 		raid6_datap_recov = best->datap;
+		raid6_recov_best = best;
 
 		pr_info("raid6: using %s recovery algorithm\n", best->name);
 	} else
@@ -271,7 +337,7 @@ int __init raid6_select_algo(void)
 	gen_best = raid6_choose_gen(&dptrs, disks);
 
 	/* select raid recover functions */
-	rec_best = raid6_choose_recov();
+	rec_best = raid6_choose_recov(&dptrs, disks);
 
 	free_pages((unsigned long)disk_ptr, RAID6_TEST_DISKS_ORDER);
 
@@ -15,42 +15,12 @@ static int raid6_has_avx2(void)
 		boot_cpu_has(X86_FEATURE_AVX);
 }
 
-static void raid6_2data_recov_avx2(int disks, size_t bytes, int faila,
-		int failb, void **ptrs)
+/* multiply/xor pass over one stripe; the caller owns the FPU section */
+static void raid6_2data_mul_avx2(size_t bytes, u8 *p, u8 *q, u8 *dp, u8 *dq,
+		const u8 *pbmul, const u8 *qmul)
 {
-	u8 *p, *q, *dp, *dq;
-	const u8 *pbmul;	/* P multiplier table for B data */
-	const u8 *qmul;		/* Q multiplier table (for both) */
 	const u8 x0f = 0x0f;
 
-	p = (u8 *)ptrs[disks-2];
-	q = (u8 *)ptrs[disks-1];
-
-	/* Compute syndrome with zero for the missing data pages
-	   Use the dead data pages as temporary storage for
-	   delta p and delta q */
-	dp = (u8 *)ptrs[faila];
-	ptrs[faila] = (void *)raid6_empty_zero_page;
-	ptrs[disks-2] = dp;
-	dq = (u8 *)ptrs[failb];
-	ptrs[failb] = (void *)raid6_empty_zero_page;
-	ptrs[disks-1] = dq;
-
-	raid6_call.gen_syndrome(disks, bytes, ptrs);
-
-	/* Restore pointer table */
-	ptrs[faila]   = dp;
-	ptrs[failb]   = dq;
-	ptrs[disks-2] = p;
-	ptrs[disks-1] = q;
-
-	/* Now, pick the proper data tables */
-	pbmul = raid6_vgfmul[raid6_gfexi[failb-faila]];
-	qmul  = raid6_vgfmul[raid6_gfinv[raid6_gfexp[faila] ^
-		raid6_gfexp[failb]]];
-
-	kernel_fpu_begin();
-
 	/* ymm0 = x0f[16] */
 	asm volatile("vpbroadcastb %0, %%ymm7" : : "m" (x0f));
 
@@ -181,7 +151,92 @@ static void raid6_2data_recov_avx2(int disks, size_t bytes, int faila,
 		dq += 32;
 #endif
 	}
+}
+
+static void raid6_2data_recov_avx2(int disks, size_t bytes, int faila,
+		int failb, void **ptrs)
+{
+	u8 *p, *q, *dp, *dq;
+	const u8 *pbmul;	/* P multiplier table for B data */
+	const u8 *qmul;		/* Q multiplier table (for both) */
 
+	p = (u8 *)ptrs[disks-2];
+	q = (u8 *)ptrs[disks-1];
+
+	/* Compute syndrome with zero for the missing data pages
+	   Use the dead data pages as temporary storage for
+	   delta p and delta q */
+	dp = (u8 *)ptrs[faila];
+	ptrs[faila] = (void *)raid6_empty_zero_page;
+	ptrs[disks-2] = dp;
+	dq = (u8 *)ptrs[failb];
+	ptrs[failb] = (void *)raid6_empty_zero_page;
+	ptrs[disks-1] = dq;
+
+	raid6_call.gen_syndrome(disks, bytes, ptrs);
+
+	/* Restore pointer table */
+	ptrs[faila]   = dp;
+	ptrs[failb]   = dq;
+	ptrs[disks-2] = p;
+	ptrs[disks-1] = q;
+
+	/* Now, pick the proper data tables */
+	pbmul = raid6_vgfmul[raid6_gfexi[failb-faila]];
+	qmul  = raid6_vgfmul[raid6_gfinv[raid6_gfexp[faila] ^
+		raid6_gfexp[failb]]];
+
+	kernel_fpu_begin();
+	raid6_2data_mul_avx2(bytes, p, q, dp, dq, pbmul, qmul);
+	kernel_fpu_end();
+}
+
+static void raid6_2data_recov_batch_avx2(int disks, size_t bytes, int faila,
+		int failb, void ***ptrs, int nr_stripes)
+{
+	const u8 *pbmul;	/* P multiplier table for B data */
+	const u8 *qmul;		/* Q multiplier table (for both) */
+	int i;
+
+	/*
+	 * First pass: delta syndromes for the whole batch.
+	 * gen_syndrome() takes its own FPU section per stripe, so it
+	 * cannot run inside the one taken for the multiply pass below.
+	 */
+	for (i = 0; i < nr_stripes; i++) {
+		void **sptrs = ptrs[i];
+		void *p = sptrs[disks-2];
+		void *q = sptrs[disks-1];
+		void *dp = sptrs[faila];
+		void *dq = sptrs[failb];
+
+		sptrs[faila] = (void *)raid6_empty_zero_page;
+		sptrs[disks-2] = dp;
+		sptrs[failb] = (void *)raid6_empty_zero_page;
+		sptrs[disks-1] = dq;
+
+		raid6_call.gen_syndrome(disks, bytes, sptrs);
+
+		sptrs[faila]   = dp;
+		sptrs[failb]   = dq;
+		sptrs[disks-2] = p;
+		sptrs[disks-1] = q;
+	}
+
+	pbmul = raid6_vgfmul[raid6_gfexi[failb-faila]];
+	qmul  = raid6_vgfmul[raid6_gfinv[raid6_gfexp[faila] ^
+		raid6_gfexp[failb]]];
+
+	/* Second pass: one FPU section for the whole batch */
+	kernel_fpu_begin();
+	for (i = 0; i < nr_stripes; i++) {
+		void **sptrs = ptrs[i];
+
+		raid6_2data_mul_avx2(bytes, (u8 *)sptrs[disks-2],
+				     (u8 *)sptrs[disks-1],
+				     (u8 *)sptrs[faila],
+				     (u8 *)sptrs[failb], pbmul, qmul);
+	}
 	kernel_fpu_end();
 }
 
@@ -305,6 +360,7 @@ static void raid6_datap_recov_avx2(int disks, size_t bytes, int faila,
 const struct raid6_recov_calls raid6_recov_avx2 = {
 	.data2 = raid6_2data_recov_avx2,
 	.datap = raid6_datap_recov_avx2,
+	.data2_batch = raid6_2data_recov_batch_avx2,
 	.valid = raid6_has_avx2,
 #ifdef CONFIG_X86_64
 	.name = "avx2x2",
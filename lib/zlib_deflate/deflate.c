@@ -49,6 +49,9 @@
  */
 
 #include <linux/module.h>
+#include <linux/atomic.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 #include <linux/zutil.h>
 #include "defutil.h"
 
@@ -1144,3 +1147,86 @@ int zlib_deflate_dfltcc_enabled(void)
 {
 	return DEFLATE_DFLTCC_ENABLED();
 }
+
+/* effort classifier sampling parameters */
+#define Z_EFFORT_CHUNK		16
+#define Z_EFFORT_MAX_SAMPLE	4096
+
+/* entropy thresholds in percent of the 8 bits/byte maximum */
+#define Z_EFFORT_ENTROPY_FAST	65
+#define Z_EFFORT_ENTROPY_STORE	85
+
+static atomic64_t zlib_effort_decisions[3];
+
+/* ilog2 with two extra bits of precision: ilog2(n^4) = 4*log2(n) */
+static u32 zlib_ilog2_w(u64 n)
+{
+	return ilog2(n * n * n * n);
+}
+
+int zlib_deflate_effort(const unsigned char *data, unsigned int len)
+{
+	u16 counts[256];
+	u64 entropy_sum = 0;
+	unsigned int sampled = 0;
+	unsigned int entropy, step, i, j;
+	int effort;
+
+	if (len < 2 * Z_EFFORT_CHUNK) {
+		atomic64_inc(&zlib_effort_decisions[Z_EFFORT_DEEP]);
+		return Z_EFFORT_DEEP;
+	}
+
+	memset(counts, 0, sizeof(counts));
+
+	/*
+	 * Sample up to Z_EFFORT_MAX_SAMPLE bytes in Z_EFFORT_CHUNK sized
+	 * pieces spread evenly across the buffer, so a block with a
+	 * compressible head and an incompressible tail (or vice versa)
+	 * is judged on both.
+	 */
+	step = len / (Z_EFFORT_MAX_SAMPLE / Z_EFFORT_CHUNK);
+	if (step < Z_EFFORT_CHUNK)
+		step = Z_EFFORT_CHUNK;
+
+	for (i = 0;
+	     i + Z_EFFORT_CHUNK <= len && sampled < Z_EFFORT_MAX_SAMPLE;
+	     i += step) {
+		for (j = 0; j < Z_EFFORT_CHUNK; j++)
+			counts[data[i + j]]++;
+		sampled += Z_EFFORT_CHUNK;
+	}
+
+	for (i = 0; i < 256; i++)
+		if (counts[i])
+			entropy_sum += (u64)counts[i] *
+				       zlib_ilog2_w(counts[i]);
+
+	/*
+	 * Shannon entropy sum(c/n * log2(n/c)) over the byte counts,
+	 * scaled to a percentage of the 8 bits/byte maximum.  The
+	 * quarter-bit precision of zlib_ilog2_w() is plenty for a
+	 * three-way decision.
+	 */
+	entropy = div64_u64(((u64)sampled * zlib_ilog2_w(sampled) -
+			     entropy_sum) * 100,
+			    (u64)sampled * 8 * 4);
+
+	if (entropy >= Z_EFFORT_ENTROPY_STORE)
+		effort = Z_EFFORT_STORE;
+	else if (entropy >= Z_EFFORT_ENTROPY_FAST)
+		effort = Z_EFFORT_FAST;
+	else
+		effort = Z_EFFORT_DEEP;
+
+	atomic64_inc(&zlib_effort_decisions[effort]);
+	return effort;
+}
+
+void zlib_deflate_effort_stats(unsigned long long stats[3])
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+		stats[i] = atomic64_read(&zlib_effort_decisions[i]);
+}
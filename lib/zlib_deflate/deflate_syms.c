@@ -17,4 +17,6 @@ EXPORT_SYMBOL(zlib_deflate);
 EXPORT_SYMBOL(zlib_deflateInit2);
 EXPORT_SYMBOL(zlib_deflateEnd);
 EXPORT_SYMBOL(zlib_deflateReset);
+EXPORT_SYMBOL(zlib_deflate_effort);
+EXPORT_SYMBOL(zlib_deflate_effort_stats);
 MODULE_LICENSE("GPL");
@@ -307,6 +307,10 @@ static int wb_init(struct bdi_writeback *wb, struct backing_dev_info *bdi,
 	spin_lock_init(&wb->work_lock);
 	INIT_LIST_HEAD(&wb->work_list);
 	INIT_DELAYED_WORK(&wb->dwork, wb_workfn);
+	for (i = 0; i < WB_MAX_AUX_FLUSHERS; i++) {
+		INIT_WORK(&wb->aux_flushers[i].work, wb_aux_workfn);
+		wb->aux_flushers[i].wb = wb;
+	}
 	wb->dirty_sleep = jiffies;
 
 	wb->congested = wb_congested_get_create(bdi, blkcg_id, gfp);
@@ -346,6 +350,8 @@ static void cgwb_remove_from_bdi_list(struct bdi_writeback *wb);
  */
 static void wb_shutdown(struct bdi_writeback *wb)
 {
+	int i;
+
 	/* Make sure nobody queues further work */
 	spin_lock_bh(&wb->work_lock);
 	if (!test_and_clear_bit(WB_registered, &wb->state)) {
@@ -358,10 +364,14 @@ static void wb_shutdown(struct bdi_writeback *wb)
 	/*
 	 * Drain work list and shutdown the delayed_work.  !WB_registered
 	 * tells wb_workfn() that @wb is dying and its work_list needs to
-	 * be drained no matter what.
+	 * be drained no matter what.  The auxiliary flushers are only
+	 * kicked while WB_registered is set, so after the flush above no
+	 * new ones can show up and a sync cancel is enough.
 	 */
 	mod_delayed_work(bdi_wq, &wb->dwork, 0);
 	flush_delayed_work(&wb->dwork);
+	for (i = 0; i < WB_MAX_AUX_FLUSHERS; i++)
+		cancel_work_sync(&wb->aux_flushers[i].work);
 	WARN_ON(!list_empty(&wb->work_list));
 }
 
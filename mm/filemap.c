@@ -1968,6 +1968,9 @@ static void shrink_readahead_size_eio(struct file *filp,
 	ra->ra_pages /= 4;
 }
 
+/* Pages looked up and copied out per batch in the buffered read fast path */
+#define FILEMAP_READ_BATCH	16
+
 /**
  * generic_file_buffered_read - generic file read routine
  * @iocb:	the iocb to read
@@ -2016,6 +2019,83 @@ static ssize_t generic_file_buffered_read(struct kiocb *iocb,
 		unsigned long nr, ret;
 
 		cond_resched();
+
+		/*
+		 * Fast path: gang-look up a run of contiguous uptodate
+		 * pages and copy them out in one pass, instead of paying
+		 * one xarray walk and refcount pair per 4K page.  The
+		 * first page that needs readahead or readpage work drops
+		 * us into the single-page slow path below.
+		 */
+		if (last_index - index > 1) {
+			struct page *pages[FILEMAP_READ_BATCH];
+			unsigned int nr_pages, i;
+			bool short_copy = false;
+
+			nr_pages = min_t(unsigned long, last_index - index,
+					 FILEMAP_READ_BATCH);
+			nr_pages = find_get_pages_contig(mapping, index,
+							 nr_pages, pages);
+			for (i = 0; i < nr_pages; i++) {
+				page = pages[i];
+
+				if (!PageUptodate(page) || PageReadahead(page))
+					break;
+
+				/*
+				 * i_size must be checked after the page is
+				 * known to be uptodate, same as the slow
+				 * path below.
+				 */
+				isize = i_size_read(inode);
+				end_index = (isize - 1) >> PAGE_SHIFT;
+				if (unlikely(!isize || index > end_index))
+					break;
+
+				nr = PAGE_SIZE;
+				if (index == end_index) {
+					nr = ((isize - 1) & ~PAGE_MASK) + 1;
+					if (nr <= offset)
+						break;
+				}
+				nr = nr - offset;
+
+				if (mapping_writably_mapped(mapping))
+					flush_dcache_page(page);
+
+				if (prev_index != index || offset != prev_offset)
+					mark_page_accessed(page);
+				prev_index = index;
+
+				ret = copy_page_to_iter(page, offset, nr, iter);
+				offset += ret;
+				index += offset >> PAGE_SHIFT;
+				offset &= ~PAGE_MASK;
+				prev_offset = offset;
+				written += ret;
+
+				put_page(page);
+				if (ret < nr) {
+					short_copy = true;
+					i++;
+					break;
+				}
+				if (!iov_iter_count(iter)) {
+					i++;
+					break;
+				}
+			}
+			/* Release whatever the batch did not consume */
+			for (; i < nr_pages; i++)
+				put_page(pages[i]);
+
+			if (short_copy) {
+				error = -EFAULT;
+				goto out;
+			}
+			if (!iov_iter_count(iter))
+				goto out;
+		}
 find_page:
 		if (fatal_signal_pending(current)) {
 			error = -EINTR;
@@ -894,19 +894,43 @@ retry:
 			goto out;
 		}
 		if (pages) {
-			pages[i] = page;
-			flush_anon_page(vma, page, start);
-			flush_dcache_page(page);
-			ctx.page_mask = 0;
+			unsigned int j;
+
+			/*
+			 * The page was grabbed as a whole huge page, so
+			 * record all of its subpages covering the rest of
+			 * the range instead of re-walking the page table
+			 * for each of them.  One reference is held on the
+			 * head page already; take the remainder in a
+			 * single operation.
+			 */
+			page_increm = 1 + (~(start >> PAGE_SHIFT) &
+					   ctx.page_mask);
+			if (page_increm > nr_pages)
+				page_increm = nr_pages;
+			if (page_increm > 1)
+				page_ref_add(compound_head(page),
+					     page_increm - 1);
+
+			for (j = 0; j < page_increm; j++) {
+				struct page *subpage = page + j;
+
+				pages[i + j] = subpage;
+				flush_anon_page(vma, subpage,
+						start + j * PAGE_SIZE);
+				flush_dcache_page(subpage);
+			}
 		}
 next_page:
-		if (vmas) {
-			vmas[i] = vma;
-			ctx.page_mask = 0;
-		}
 		page_increm = 1 + (~(start >> PAGE_SHIFT) & ctx.page_mask);
 		if (page_increm > nr_pages)
 			page_increm = nr_pages;
+		if (vmas) {
+			unsigned int j;
+
+			for (j = 0; j < page_increm; j++)
+				vmas[i + j] = vma;
+		}
 		i += page_increm;
 		start += page_increm * PAGE_SIZE;
 		nr_pages -= page_increm;
@@ -28,6 +28,7 @@
 #include <linux/jhash.h>
 #include <linux/numa.h>
 #include <linux/llist.h>
+#include <linux/workqueue.h>
 
 #include <asm/page.h>
 #include <asm/pgtable.h>
@@ -1431,6 +1432,80 @@ static int alloc_pool_huge_page(struct hstate *h, nodemask_t *nodes_allowed,
 	return 1;
 }
 
+struct pool_alloc_work {
+	struct work_struct work;
+	struct hstate *h;
+	nodemask_t *nodes_allowed;
+	nodemask_t *node_alloc_noretry;
+	unsigned long nr_pages;
+	int nid;
+};
+
+static void alloc_pool_huge_pages_workfn(struct work_struct *work)
+{
+	struct pool_alloc_work *apw = container_of(work,
+					struct pool_alloc_work, work);
+	struct hstate *h = apw->h;
+	gfp_t gfp_mask = htlb_alloc_mask(h) | __GFP_THISNODE;
+	unsigned long i;
+
+	for (i = 0; i < apw->nr_pages; i++) {
+		struct page *page;
+
+		page = alloc_fresh_huge_page(h, gfp_mask, apw->nid,
+					     apw->nodes_allowed,
+					     apw->node_alloc_noretry);
+		if (!page)
+			break;
+		put_page(page); /* free it into the hugepage allocator */
+		cond_resched();
+	}
+}
+
+/*
+ * Grow the pool by fanning the allocation out to one worker per allowed
+ * node.  Each worker allocates an even share of the shortfall on its own
+ * node; whatever a node cannot satisfy is left for the caller's serial
+ * loop, which also handles cross-node fallback.  Called without
+ * hugetlb_lock, may sleep.
+ */
+static void alloc_pool_huge_pages_parallel(struct hstate *h,
+		unsigned long delta, nodemask_t *nodes_allowed,
+		nodemask_t *node_alloc_noretry)
+{
+	int nr_nodes = nodes_weight(*nodes_allowed);
+	struct pool_alloc_work *works;
+	unsigned long quota, rem;
+	int node, i = 0;
+
+	works = kcalloc(nr_nodes, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return;
+
+	quota = delta / nr_nodes;
+	rem = delta % nr_nodes;
+	for_each_node_mask(node, *nodes_allowed) {
+		struct pool_alloc_work *apw = &works[i++];
+
+		apw->h = h;
+		apw->nid = node;
+		apw->nodes_allowed = nodes_allowed;
+		apw->node_alloc_noretry = node_alloc_noretry;
+		apw->nr_pages = quota;
+		if (rem) {
+			apw->nr_pages++;
+			rem--;
+		}
+		INIT_WORK(&apw->work, alloc_pool_huge_pages_workfn);
+		queue_work_node(node, system_unbound_wq, &apw->work);
+	}
+
+	for (i = 0; i < nr_nodes; i++)
+		flush_work(&works[i].work);
+
+	kfree(works);
+}
+
 /*
  * Free huge page from pool from next node to free.
  * Attempt to keep persistent huge pages more or less
@@ -2372,6 +2447,23 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 			break;
 	}
 
+	/*
+	 * Fan the bulk of a large multi-node increase out to a worker per
+	 * node.  The serial loop below picks up whatever the workers could
+	 * not allocate and keeps the existing signal check.
+	 */
+	if (count > persistent_huge_pages(h)) {
+		unsigned long delta = count - persistent_huge_pages(h);
+		int nr_nodes = nodes_weight(*nodes_allowed);
+
+		if (nr_nodes > 1 && delta >= (unsigned long)nr_nodes) {
+			spin_unlock(&hugetlb_lock);
+			alloc_pool_huge_pages_parallel(h, delta, nodes_allowed,
+						       node_alloc_noretry);
+			spin_lock(&hugetlb_lock);
+		}
+	}
+
 	while (count > persistent_huge_pages(h)) {
 		/*
 		 * If this allocation races such that we no longer need the
@@ -2430,9 +2522,94 @@ out:
 	return 0;
 }
 
+/*
+ * Like destroy_compound_gigantic_page(), but leave the tail page reference
+ * counts at zero: the pages are immediately re-prepped as smaller compound
+ * pages rather than returned to the buddy allocator.
+ */
+static void destroy_compound_huge_page_for_demote(struct page *page,
+						unsigned int order)
+{
+	int i;
+	int nr_pages = 1 << order;
+	struct page *p = page + 1;
+
+	atomic_set(compound_mapcount_ptr(page), 0);
+	for (i = 1; i < nr_pages; i++, p = mem_map_next(p, page, i))
+		clear_compound_head(p);
+
+	set_compound_order(page, 0);
+	__ClearPageHead(page);
+}
+
+static void demote_free_huge_page(struct hstate *h, struct page *page)
+{
+	int i, nid = page_to_nid(page);
+	struct hstate *target_hstate;
+
+	target_hstate = size_to_hstate(PAGE_SIZE << h->demote_order);
+
+	list_del(&page->lru);
+	h->free_huge_pages--;
+	h->free_huge_pages_node[nid]--;
+	h->nr_huge_pages--;
+	h->nr_huge_pages_node[nid]--;
+
+	spin_unlock(&hugetlb_lock);
+
+	set_compound_page_dtor(page, NULL_COMPOUND_DTOR);
+	destroy_compound_huge_page_for_demote(page, huge_page_order(h));
+
+	/*
+	 * The memory is carved into target sized pages in place; each of
+	 * them takes the same path into the pool as a freshly allocated
+	 * huge page.
+	 */
+	for (i = 0; i < pages_per_huge_page(h);
+				i += pages_per_huge_page(target_hstate)) {
+		struct page *subpage = page + i;
+
+		if (hstate_is_gigantic(target_hstate))
+			prep_compound_gigantic_page(subpage,
+						    target_hstate->order);
+		else
+			prep_compound_page(subpage, target_hstate->order);
+		set_page_private(subpage, 0);
+		set_page_refcounted(subpage);
+		prep_new_huge_page(target_hstate, subpage, nid);
+		put_page(subpage); /* free it into the hugepage allocator */
+	}
+
+	spin_lock(&hugetlb_lock);
+}
+
+/*
+ * Demote one free huge page to h->demote_order sized pages.
+ * Called with hugetlb_lock held; may drop and reacquire it.
+ */
+static int demote_pool_huge_page(struct hstate *h, nodemask_t *nodes_allowed)
+{
+	int nr_nodes, node;
+	struct page *page;
+
+	for_each_node_mask_to_free(h, nr_nodes, node, nodes_allowed) {
+		list_for_each_entry(page, &h->hugepage_freelists[node], lru) {
+			if (PageHWPoison(page))
+				continue;
+			demote_free_huge_page(h, page);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 #define HSTATE_ATTR_RO(_name) \
 	static struct kobj_attribute _name##_attr = __ATTR_RO(_name)
 
+#define HSTATE_ATTR_WO(_name) \
+	static struct kobj_attribute _name##_attr = __ATTR_WO(_name)
+
 #define HSTATE_ATTR(_name) \
 	static struct kobj_attribute _name##_attr = \
 		__ATTR(_name, 0644, _name##_show, _name##_store)
@@ -2627,6 +2804,68 @@ static ssize_t surplus_hugepages_show(struct kobject *kobj,
 }
 HSTATE_ATTR_RO(surplus_hugepages);
 
+static ssize_t demote_size_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+
+	return sprintf(buf, "%lukB\n",
+			(unsigned long)(PAGE_SIZE << h->demote_order) / 1024);
+}
+HSTATE_ATTR_RO(demote_size);
+
+static ssize_t demote_store(struct kobject *kobj,
+	       struct kobj_attribute *attr, const char *buf, size_t len)
+{
+	unsigned long nr_demote;
+	long nr_available;
+	nodemask_t nodes_allowed, *n_mask;
+	struct hstate *h;
+	int err;
+	int nid;
+
+	err = kstrtoul(buf, 10, &nr_demote);
+	if (err)
+		return err;
+	h = kobj_to_hstate(kobj, &nid);
+
+	/* demote_order is only set if there is a smaller hstate */
+	if (!h->demote_order)
+		return -EINVAL;
+
+	if (nid != NUMA_NO_NODE) {
+		init_nodemask_of_node(&nodes_allowed, nid);
+		n_mask = &nodes_allowed;
+	} else {
+		n_mask = &node_states[N_MEMORY];
+	}
+
+	spin_lock(&hugetlb_lock);
+	while (nr_demote) {
+		/*
+		 * Leave enough pages in the pool to satisfy existing
+		 * reservations.
+		 */
+		if (nid != NUMA_NO_NODE)
+			nr_available = h->free_huge_pages_node[nid];
+		else
+			nr_available = h->free_huge_pages;
+		nr_available -= h->resv_huge_pages;
+		if (nr_available <= 0)
+			break;
+
+		if (!demote_pool_huge_page(h, n_mask))
+			break;
+		nr_demote--;
+
+		cond_resched_lock(&hugetlb_lock);
+	}
+	spin_unlock(&hugetlb_lock);
+
+	return len;
+}
+HSTATE_ATTR_WO(demote);
+
 static struct attribute *hstate_attrs[] = {
 	&nr_hugepages_attr.attr,
 	&nr_overcommit_hugepages_attr.attr,
@@ -2643,6 +2882,16 @@ static const struct attribute_group hstate_attr_group = {
 	.attrs = hstate_attrs,
 };
 
+static struct attribute *hstate_demote_attrs[] = {
+	&demote_size_attr.attr,
+	&demote_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group hstate_demote_attr_group = {
+	.attrs = hstate_demote_attrs,
+};
+
 static int hugetlb_sysfs_add_hstate(struct hstate *h, struct kobject *parent,
 				    struct kobject **hstate_kobjs,
 				    const struct attribute_group *hstate_attr_group)
@@ -2655,10 +2904,19 @@ static int hugetlb_sysfs_add_hstate(struct hstate *h, struct kobject *parent,
 		return -ENOMEM;
 
 	retval = sysfs_create_group(hstate_kobjs[hi], hstate_attr_group);
-	if (retval)
+	if (retval) {
 		kobject_put(hstate_kobjs[hi]);
+		return retval;
+	}
 
-	return retval;
+	if (h->demote_order) {
+		if (sysfs_create_group(hstate_kobjs[hi],
+					&hstate_demote_attr_group))
+			pr_warn("HugeTLB unable to create demote interfaces for %s\n",
+				h->name);
+	}
+
+	return 0;
 }
 
 static void __init hugetlb_sysfs_init(void)
@@ -2877,7 +3135,7 @@ void __init hugetlb_bad_size(void)
 
 void __init hugetlb_add_hstate(unsigned int order)
 {
-	struct hstate *h;
+	struct hstate *h, *h2, *h3;
 	unsigned long i;
 
 	if (size_to_hstate(PAGE_SIZE << order)) {
@@ -2899,6 +3157,20 @@ void __init hugetlb_add_hstate(unsigned int order)
 	snprintf(h->name, HSTATE_NAME_LEN, "hugepages-%lukB",
 					huge_page_size(h)/1024);
 
+	/*
+	 * demote_order is the order of the next smaller hstate, or zero if
+	 * there is none.  Recompute it for every hstate as they are not
+	 * necessarily added in size order.
+	 */
+	for_each_hstate(h2) {
+		h2->demote_order = 0;
+		for_each_hstate(h3) {
+			if (h3->order < h2->order &&
+			    h3->order > h2->demote_order)
+				h2->demote_order = h3->order;
+		}
+	}
+
 	parsed_hstate = h;
 }
 
@@ -1237,6 +1237,65 @@ out:
 	return ret;
 }
 
+/*
+ * madvise(MADV_COLLAPSE): synchronously collapse an anonymous range into
+ * huge pages with the khugepaged machinery, instead of waiting for the
+ * background scanner to get around to it.  Target pages are allocated
+ * NUMA-aware through khugepaged_find_target_node(), same as the lazy
+ * path.
+ *
+ * Caller holds mmap_sem for read.  Collapse attempts drop and re-take
+ * it, so *prev is set to NULL to make the madvise() loop re-look up the
+ * vma afterwards.
+ */
+int madvise_collapse(struct vm_area_struct *vma, struct vm_area_struct **prev,
+		     unsigned long start, unsigned long end)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	struct page *hpage = NULL;
+	unsigned long hstart, hend, addr;
+	bool wait = false;
+
+	*prev = NULL;
+
+	/* Only anonymous mappings are supported */
+	if (vma->vm_file || vma->vm_ops)
+		return -EINVAL;
+	if (!hugepage_vma_check(vma, vma->vm_flags | VM_HUGEPAGE))
+		return -EINVAL;
+
+	hstart = (start + ~HPAGE_PMD_MASK) & HPAGE_PMD_MASK;
+	hend = end & HPAGE_PMD_MASK;
+
+	for (addr = hstart; addr < hend; addr += HPAGE_PMD_SIZE) {
+		int result;
+
+		cond_resched();
+
+		/* Don't stall on allocation failure under mmap_sem */
+		if (!khugepaged_prealloc_page(&hpage, &wait))
+			break;
+
+		/*
+		 * A collapse attempt returns with mmap_sem dropped and
+		 * re-taken, so the vma must be revalidated every round.
+		 */
+		result = hugepage_vma_revalidate(mm, addr, &vma);
+		if (result == SCAN_ANY_PROCESS || result == SCAN_VMA_NULL)
+			break;
+		if (result)
+			continue;
+
+		if (khugepaged_scan_pmd(mm, vma, addr, &hpage))
+			down_read(&mm->mmap_sem);
+	}
+
+	if (!IS_ERR_OR_NULL(hpage))
+		put_page(hpage);
+
+	return 0;
+}
+
 static void collect_mm_slot(struct mm_slot *mm_slot)
 {
 	struct mm_struct *mm = mm_slot->mm;
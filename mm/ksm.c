@@ -124,12 +124,23 @@ struct mm_slot {
 	struct mm_struct *mm;
 };
 
+/*
+ * Number of mergeable pages gathered under a single mmap_sem hold before
+ * they are handed out one by one for merging.  Acquiring mmap_sem for
+ * every scanned page is what used to dominate ksmd on busy hosts.
+ */
+#define KSM_SCAN_BATCH	16
+
 /**
  * struct ksm_scan - cursor for scanning
  * @mm_slot: the current mm_slot we are scanning
  * @address: the next address inside that to be scanned
  * @rmap_list: link to the next rmap to be scanned in the rmap_list
  * @seqnr: count of completed full scans (needed when removing unstable node)
+ * @batch_rmap_items: rmap_items gathered under one mmap_sem acquisition
+ * @batch_pages: the referenced pages belonging to @batch_rmap_items
+ * @batch_count: number of gathered entries
+ * @batch_index: next entry to hand out to the merger
  *
  * There is only the one ksm_scan instance of this cursor structure.
  */
@@ -138,6 +149,10 @@ struct ksm_scan {
 	unsigned long address;
 	struct rmap_item **rmap_list;
 	unsigned long seqnr;
+	struct rmap_item *batch_rmap_items[KSM_SCAN_BATCH];
+	struct page *batch_pages[KSM_SCAN_BATCH];
+	unsigned int batch_count;
+	unsigned int batch_index;
 };
 
 /**
@@ -961,6 +976,19 @@ static int remove_all_stable_nodes(void)
 	return err;
 }
 
+/*
+ * Drop a gathered scan batch that has not been fully handed out.  Must be
+ * called under ksm_thread_mutex before tearing down rmap_items that the
+ * batch may still reference.
+ */
+static void ksm_scan_drop_batch(void)
+{
+	while (ksm_scan.batch_index < ksm_scan.batch_count)
+		put_page(ksm_scan.batch_pages[ksm_scan.batch_index++]);
+	ksm_scan.batch_index = 0;
+	ksm_scan.batch_count = 0;
+}
+
 static int unmerge_and_remove_all_rmap_items(void)
 {
 	struct mm_slot *mm_slot;
@@ -968,6 +996,8 @@ static int unmerge_and_remove_all_rmap_items(void)
 	struct vm_area_struct *vma;
 	int err = 0;
 
+	ksm_scan_drop_batch();
+
 	spin_lock(&ksm_mmlist_lock);
 	ksm_scan.mm_slot = list_entry(ksm_mm_head.mm_list.next,
 						struct mm_slot, mm_list);
@@ -2229,6 +2259,14 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 	struct rmap_item *rmap_item;
 	int nid;
 
+	if (ksm_scan.batch_index < ksm_scan.batch_count) {
+dequeue:
+		*page = ksm_scan.batch_pages[ksm_scan.batch_index];
+		return ksm_scan.batch_rmap_items[ksm_scan.batch_index++];
+	}
+	ksm_scan.batch_index = 0;
+	ksm_scan.batch_count = 0;
+
 	if (list_empty(&ksm_mm_head.mm_list))
 		return NULL;
 
@@ -2313,14 +2351,30 @@ next_mm:
 				flush_dcache_page(*page);
 				rmap_item = get_next_rmap_item(slot,
 					ksm_scan.rmap_list, ksm_scan.address);
-				if (rmap_item) {
-					ksm_scan.rmap_list =
-							&rmap_item->rmap_list;
-					ksm_scan.address += PAGE_SIZE;
-				} else
+				if (!rmap_item) {
 					put_page(*page);
+					up_read(&mm->mmap_sem);
+					if (ksm_scan.batch_count)
+						goto dequeue;
+					return NULL;
+				}
+				ksm_scan.rmap_list = &rmap_item->rmap_list;
+				ksm_scan.address += PAGE_SIZE;
+				ksm_scan.batch_rmap_items[
+					ksm_scan.batch_count] = rmap_item;
+				ksm_scan.batch_pages[
+					ksm_scan.batch_count] = *page;
+				/*
+				 * Keep gathering under this single mmap_sem
+				 * hold until the batch is full, then hand
+				 * the entries out one by one.
+				 */
+				if (++ksm_scan.batch_count < KSM_SCAN_BATCH) {
+					cond_resched();
+					continue;
+				}
 				up_read(&mm->mmap_sem);
-				return rmap_item;
+				goto dequeue;
 			}
 			put_page(*page);
 			ksm_scan.address += PAGE_SIZE;
@@ -2328,6 +2382,17 @@ next_mm:
 		}
 	}
 
+	if (ksm_scan.batch_count) {
+		/*
+		 * This mm is done but a partial batch was gathered: hand it
+		 * out first.  The end-of-mm bookkeeping below runs on the
+		 * next call, when the vma walk comes up empty again with no
+		 * batch pending.
+		 */
+		up_read(&mm->mmap_sem);
+		goto dequeue;
+	}
+
 	if (ksm_test_exit(mm)) {
 		ksm_scan.address = 0;
 		ksm_scan.rmap_list = &slot->rmap_list;
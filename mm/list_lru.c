@@ -8,12 +8,39 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/mm.h>
+#include <linux/hash.h>
 #include <linux/list_lru.h>
 #include <linux/slab.h>
 #include <linux/mutex.h>
 #include <linux/memcontrol.h>
 #include "slab.h"
 
+/*
+ * Each node's LRU is split into a number of shards, each with its own
+ * lock and lists, so that concurrent adds and removals spread over
+ * several locks instead of funnelling through one per-node spinlock.
+ * Objects are assigned to a shard by address, roughly one shard per
+ * cluster of LRU_SHARD_CPUS CPUs.  The shard count is a power of two,
+ * fixed at the first list_lru initialization.
+ */
+#define LRU_SHARD_CPUS	16
+#define LRU_MAX_SHARDS	8
+
+static unsigned int lru_shards __read_mostly = 1;
+
+static inline struct list_lru_node *lru_shard_first(struct list_lru *lru,
+						    int nid)
+{
+	return &lru->node[nid * lru_shards];
+}
+
+static inline struct list_lru_node *lru_shard_of(struct list_lru *lru,
+						 int nid, void *item)
+{
+	return lru_shard_first(lru, nid) +
+	       (hash_ptr(item, ilog2(LRU_MAX_SHARDS)) & (lru_shards - 1));
+}
+
 #ifdef CONFIG_MEMCG_KMEM
 static LIST_HEAD(list_lrus);
 static DEFINE_MUTEX(list_lrus_mutex);
@@ -125,7 +152,7 @@ list_lru_from_kmem(struct list_lru_node *nlru, void *ptr,
 bool list_lru_add(struct list_lru *lru, struct list_head *item)
 {
 	int nid = page_to_nid(virt_to_page(item));
-	struct list_lru_node *nlru = &lru->node[nid];
+	struct list_lru_node *nlru = lru_shard_of(lru, nid, item);
 	struct mem_cgroup *memcg;
 	struct list_lru_one *l;
 
@@ -149,7 +176,7 @@ EXPORT_SYMBOL_GPL(list_lru_add);
 bool list_lru_del(struct list_lru *lru, struct list_head *item)
 {
 	int nid = page_to_nid(virt_to_page(item));
-	struct list_lru_node *nlru = &lru->node[nid];
+	struct list_lru_node *nlru = lru_shard_of(lru, nid, item);
 	struct list_lru_one *l;
 
 	spin_lock(&nlru->lock);
@@ -184,25 +211,38 @@ EXPORT_SYMBOL_GPL(list_lru_isolate_move);
 unsigned long list_lru_count_one(struct list_lru *lru,
 				 int nid, struct mem_cgroup *memcg)
 {
-	struct list_lru_node *nlru = &lru->node[nid];
+	struct list_lru_node *nlru = lru_shard_first(lru, nid);
 	struct list_lru_one *l;
-	unsigned long count;
+	long count = 0;
+	int shard;
 
 	rcu_read_lock();
-	l = list_lru_from_memcg_idx(nlru, memcg_cache_id(memcg));
-	count = l->nr_items;
+	for (shard = 0; shard < lru_shards; shard++, nlru++) {
+		l = list_lru_from_memcg_idx(nlru, memcg_cache_id(memcg));
+		count += l->nr_items;
+	}
 	rcu_read_unlock();
 
+	if (unlikely(count < 0))
+		count = 0;
+
 	return count;
 }
 EXPORT_SYMBOL_GPL(list_lru_count_one);
 
 unsigned long list_lru_count_node(struct list_lru *lru, int nid)
 {
-	struct list_lru_node *nlru;
+	struct list_lru_node *nlru = lru_shard_first(lru, nid);
+	long count = 0;
+	int shard;
+
+	for (shard = 0; shard < lru_shards; shard++, nlru++)
+		count += nlru->nr_items;
 
-	nlru = &lru->node[nid];
-	return nlru->nr_items;
+	if (unlikely(count < 0))
+		count = 0;
+
+	return count;
 }
 EXPORT_SYMBOL_GPL(list_lru_count_node);
 
@@ -269,13 +309,19 @@ list_lru_walk_one(struct list_lru *lru, int nid, struct mem_cgroup *memcg,
 		  list_lru_walk_cb isolate, void *cb_arg,
 		  unsigned long *nr_to_walk)
 {
-	struct list_lru_node *nlru = &lru->node[nid];
-	unsigned long ret;
+	struct list_lru_node *nlru = lru_shard_first(lru, nid);
+	unsigned long ret = 0;
+	int shard;
 
-	spin_lock(&nlru->lock);
-	ret = __list_lru_walk_one(nlru, memcg_cache_id(memcg), isolate, cb_arg,
-				  nr_to_walk);
-	spin_unlock(&nlru->lock);
+	for (shard = 0; shard < lru_shards; shard++, nlru++) {
+		spin_lock(&nlru->lock);
+		ret += __list_lru_walk_one(nlru, memcg_cache_id(memcg),
+					   isolate, cb_arg, nr_to_walk);
+		spin_unlock(&nlru->lock);
+
+		if (!*nr_to_walk)
+			break;
+	}
 	return ret;
 }
 EXPORT_SYMBOL_GPL(list_lru_walk_one);
@@ -285,13 +331,19 @@ list_lru_walk_one_irq(struct list_lru *lru, int nid, struct mem_cgroup *memcg,
 		      list_lru_walk_cb isolate, void *cb_arg,
 		      unsigned long *nr_to_walk)
 {
-	struct list_lru_node *nlru = &lru->node[nid];
-	unsigned long ret;
+	struct list_lru_node *nlru = lru_shard_first(lru, nid);
+	unsigned long ret = 0;
+	int shard;
 
-	spin_lock_irq(&nlru->lock);
-	ret = __list_lru_walk_one(nlru, memcg_cache_id(memcg), isolate, cb_arg,
-				  nr_to_walk);
-	spin_unlock_irq(&nlru->lock);
+	for (shard = 0; shard < lru_shards; shard++, nlru++) {
+		spin_lock_irq(&nlru->lock);
+		ret += __list_lru_walk_one(nlru, memcg_cache_id(memcg),
+					   isolate, cb_arg, nr_to_walk);
+		spin_unlock_irq(&nlru->lock);
+
+		if (!*nr_to_walk)
+			break;
+	}
 	return ret;
 }
 
@@ -306,13 +358,21 @@ unsigned long list_lru_walk_node(struct list_lru *lru, int nid,
 				      nr_to_walk);
 	if (*nr_to_walk > 0 && list_lru_memcg_aware(lru)) {
 		for_each_memcg_cache_index(memcg_idx) {
-			struct list_lru_node *nlru = &lru->node[nid];
-
-			spin_lock(&nlru->lock);
-			isolated += __list_lru_walk_one(nlru, memcg_idx,
-							isolate, cb_arg,
-							nr_to_walk);
-			spin_unlock(&nlru->lock);
+			struct list_lru_node *nlru = lru_shard_first(lru, nid);
+			int shard;
+
+			for (shard = 0; shard < lru_shards; shard++, nlru++) {
+				spin_lock(&nlru->lock);
+				isolated += __list_lru_walk_one(nlru,
+								memcg_idx,
+								isolate,
+								cb_arg,
+								nr_to_walk);
+				spin_unlock(&nlru->lock);
+
+				if (*nr_to_walk <= 0)
+					break;
+			}
 
 			if (*nr_to_walk <= 0)
 				break;
@@ -447,6 +507,7 @@ static void memcg_cancel_update_list_lru_node(struct list_lru_node *nlru,
 
 static int memcg_init_list_lru(struct list_lru *lru, bool memcg_aware)
 {
+	int nr_nlrus = nr_node_ids * lru_shards;
 	int i;
 
 	lru->memcg_aware = memcg_aware;
@@ -454,7 +515,7 @@ static int memcg_init_list_lru(struct list_lru *lru, bool memcg_aware)
 	if (!memcg_aware)
 		return 0;
 
-	for_each_node(i) {
+	for (i = 0; i < nr_nlrus; i++) {
 		if (memcg_init_list_lru_node(&lru->node[i]))
 			goto fail;
 	}
@@ -470,24 +531,26 @@ fail:
 
 static void memcg_destroy_list_lru(struct list_lru *lru)
 {
+	int nr_nlrus = nr_node_ids * lru_shards;
 	int i;
 
 	if (!list_lru_memcg_aware(lru))
 		return;
 
-	for_each_node(i)
+	for (i = 0; i < nr_nlrus; i++)
 		memcg_destroy_list_lru_node(&lru->node[i]);
 }
 
 static int memcg_update_list_lru(struct list_lru *lru,
 				 int old_size, int new_size)
 {
+	int nr_nlrus = nr_node_ids * lru_shards;
 	int i;
 
 	if (!list_lru_memcg_aware(lru))
 		return 0;
 
-	for_each_node(i) {
+	for (i = 0; i < nr_nlrus; i++) {
 		if (memcg_update_list_lru_node(&lru->node[i],
 					       old_size, new_size))
 			goto fail;
@@ -507,12 +570,13 @@ fail:
 static void memcg_cancel_update_list_lru(struct list_lru *lru,
 					 int old_size, int new_size)
 {
+	int nr_nlrus = nr_node_ids * lru_shards;
 	int i;
 
 	if (!list_lru_memcg_aware(lru))
 		return;
 
-	for_each_node(i)
+	for (i = 0; i < nr_nlrus; i++)
 		memcg_cancel_update_list_lru_node(&lru->node[i],
 						  old_size, new_size);
 }
@@ -541,28 +605,35 @@ fail:
 static void memcg_drain_list_lru_node(struct list_lru *lru, int nid,
 				      int src_idx, struct mem_cgroup *dst_memcg)
 {
-	struct list_lru_node *nlru = &lru->node[nid];
+	struct list_lru_node *nlru = lru_shard_first(lru, nid);
 	int dst_idx = dst_memcg->kmemcg_id;
 	struct list_lru_one *src, *dst;
 	bool set;
+	int shard;
 
 	/*
+	 * Items stay on the shard they were hashed to, so each shard's
+	 * source list is spliced onto the same shard's destination list.
+	 *
 	 * Since list_lru_{add,del} may be called under an IRQ-safe lock,
 	 * we have to use IRQ-safe primitives here to avoid deadlock.
 	 */
-	spin_lock_irq(&nlru->lock);
+	for (shard = 0; shard < lru_shards; shard++, nlru++) {
+		spin_lock_irq(&nlru->lock);
 
-	src = list_lru_from_memcg_idx(nlru, src_idx);
-	dst = list_lru_from_memcg_idx(nlru, dst_idx);
+		src = list_lru_from_memcg_idx(nlru, src_idx);
+		dst = list_lru_from_memcg_idx(nlru, dst_idx);
 
-	list_splice_init(&src->list, &dst->list);
-	set = (!dst->nr_items && src->nr_items);
-	dst->nr_items += src->nr_items;
-	if (set)
-		memcg_set_shrinker_bit(dst_memcg, nid, lru_shrinker_id(lru));
-	src->nr_items = 0;
+		list_splice_init(&src->list, &dst->list);
+		set = (!dst->nr_items && src->nr_items);
+		dst->nr_items += src->nr_items;
+		if (set)
+			memcg_set_shrinker_bit(dst_memcg, nid,
+					       lru_shrinker_id(lru));
+		src->nr_items = 0;
 
-	spin_unlock_irq(&nlru->lock);
+		spin_unlock_irq(&nlru->lock);
+	}
 }
 
 static void memcg_drain_list_lru(struct list_lru *lru,
@@ -597,9 +668,24 @@ static void memcg_destroy_list_lru(struct list_lru *lru)
 }
 #endif /* CONFIG_MEMCG_KMEM */
 
+static void list_lru_shards_init(void)
+{
+	static bool done;
+
+	if (likely(done))
+		return;
+
+	lru_shards = clamp_t(unsigned int,
+			     roundup_pow_of_two(DIV_ROUND_UP(
+					num_possible_cpus(), LRU_SHARD_CPUS)),
+			     1, LRU_MAX_SHARDS);
+	done = true;
+}
+
 int __list_lru_init(struct list_lru *lru, bool memcg_aware,
 		    struct lock_class_key *key, struct shrinker *shrinker)
 {
+	int nr_nlrus;
 	int i;
 	int err = -ENOMEM;
 
@@ -611,11 +697,14 @@ int __list_lru_init(struct list_lru *lru, bool memcg_aware,
 #endif
 	memcg_get_cache_ids();
 
-	lru->node = kcalloc(nr_node_ids, sizeof(*lru->node), GFP_KERNEL);
+	list_lru_shards_init();
+	nr_nlrus = nr_node_ids * lru_shards;
+
+	lru->node = kcalloc(nr_nlrus, sizeof(*lru->node), GFP_KERNEL);
 	if (!lru->node)
 		goto out;
 
-	for_each_node(i) {
+	for (i = 0; i < nr_nlrus; i++) {
 		spin_lock_init(&lru->node[i].lock);
 		if (key)
 			lockdep_set_class(&lru->node[i].lock, key);
@@ -673,6 +673,45 @@ mem_cgroup_largest_soft_limit_node(struct mem_cgroup_tree_per_node *mctz)
 	return mz;
 }
 
+/*
+ * Cgroups with pending statistics updates, per CPU.  A cgroup is queued
+ * the first time one of its percpu counters diverges from the flushed
+ * state and is taken off again once the flusher has folded the deltas
+ * into the atomic counters, so a flush only visits cgroups that were
+ * actually touched since the previous one.
+ */
+static DEFINE_PER_CPU(struct llist_head, memcg_updated_list);
+static atomic_t memcg_nr_updated_cgroups;
+static DEFINE_MUTEX(memcg_stats_flush_mutex);
+
+/* How long percpu deltas may age before the periodic flusher folds them */
+#define MEMCG_FLUSH_TIME	(2UL * HZ)
+
+static void memcg_stats_flush_func(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(memcg_stats_flush_work, memcg_stats_flush_func);
+
+static void memcg_mark_stats_updated(struct mem_cgroup *memcg)
+{
+	struct memcg_vmstats_percpu *statc;
+
+	/*
+	 * Pairs with the barrier in mem_cgroup_flush_updated_cpu(): either
+	 * the flusher sees the counter update we just made, or we see its
+	 * clearing of ->updated and requeue the cgroup.
+	 */
+	smp_mb();
+
+	if (__this_cpu_read(memcg->vmstats_percpu->updated))
+		return;
+	if (this_cpu_xchg(memcg->vmstats_percpu->updated, 1))
+		return;
+
+	statc = this_cpu_ptr(memcg->vmstats_percpu);
+	css_get(&memcg->css);
+	llist_add(&statc->updated_node, this_cpu_ptr(&memcg_updated_list));
+	atomic_inc(&memcg_nr_updated_cgroups);
+}
+
 /**
  * __mod_memcg_state - update cgroup memory statistics
  * @memcg: the memory cgroup
@@ -681,25 +720,11 @@ mem_cgroup_largest_soft_limit_node(struct mem_cgroup_tree_per_node *mctz)
  */
 void __mod_memcg_state(struct mem_cgroup *memcg, int idx, int val)
 {
-	long x;
-
 	if (mem_cgroup_disabled())
 		return;
 
-	x = val + __this_cpu_read(memcg->vmstats_percpu->stat[idx]);
-	if (unlikely(abs(x) > MEMCG_CHARGE_BATCH)) {
-		struct mem_cgroup *mi;
-
-		/*
-		 * Batch local counters to keep them in sync with
-		 * the hierarchical ones.
-		 */
-		__this_cpu_add(memcg->vmstats_local->stat[idx], x);
-		for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-			atomic_long_add(x, &mi->vmstats[idx]);
-		x = 0;
-	}
-	__this_cpu_write(memcg->vmstats_percpu->stat[idx], x);
+	__this_cpu_add(memcg->vmstats_percpu->stat[idx], val);
+	memcg_mark_stats_updated(memcg);
 }
 
 static struct mem_cgroup_per_node *
@@ -729,7 +754,6 @@ void __mod_lruvec_state(struct lruvec *lruvec, enum node_stat_item idx,
 	pg_data_t *pgdat = lruvec_pgdat(lruvec);
 	struct mem_cgroup_per_node *pn;
 	struct mem_cgroup *memcg;
-	long x;
 
 	/* Update node */
 	__mod_node_page_state(pgdat, idx, val);
@@ -740,21 +764,14 @@ void __mod_lruvec_state(struct lruvec *lruvec, enum node_stat_item idx,
 	pn = container_of(lruvec, struct mem_cgroup_per_node, lruvec);
 	memcg = pn->memcg;
 
-	/* Update memcg */
-	__mod_memcg_state(memcg, idx, val);
-
 	/* Update lruvec */
-	__this_cpu_add(pn->lruvec_stat_local->count[idx], val);
-
-	x = val + __this_cpu_read(pn->lruvec_stat_cpu->count[idx]);
-	if (unlikely(abs(x) > MEMCG_CHARGE_BATCH)) {
-		struct mem_cgroup_per_node *pi;
+	__this_cpu_add(pn->lruvec_stat_cpu->count[idx], val);
 
-		for (pi = pn; pi; pi = parent_nodeinfo(pi, pgdat->node_id))
-			atomic_long_add(x, &pi->lruvec_stat[idx]);
-		x = 0;
-	}
-	__this_cpu_write(pn->lruvec_stat_cpu->count[idx], x);
+	/*
+	 * Update memcg last: this queues the cgroup for flushing and
+	 * orders the lruvec delta above against the flusher.
+	 */
+	__mod_memcg_state(memcg, idx, val);
 }
 
 void __mod_lruvec_slab_state(void *p, enum node_stat_item idx, int val)
@@ -797,25 +814,11 @@ void mod_memcg_obj_state(void *p, int idx, int val)
 void __count_memcg_events(struct mem_cgroup *memcg, enum vm_event_item idx,
 			  unsigned long count)
 {
-	unsigned long x;
-
 	if (mem_cgroup_disabled())
 		return;
 
-	x = count + __this_cpu_read(memcg->vmstats_percpu->events[idx]);
-	if (unlikely(x > MEMCG_CHARGE_BATCH)) {
-		struct mem_cgroup *mi;
-
-		/*
-		 * Batch local counters to keep them in sync with
-		 * the hierarchical ones.
-		 */
-		__this_cpu_add(memcg->vmstats_local->events[idx], x);
-		for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-			atomic_long_add(x, &mi->vmevents[idx]);
-		x = 0;
-	}
-	__this_cpu_write(memcg->vmstats_percpu->events[idx], x);
+	__this_cpu_add(memcg->vmstats_percpu->events[idx], count);
+	memcg_mark_stats_updated(memcg);
 }
 
 static unsigned long memcg_events(struct mem_cgroup *memcg, int event)
@@ -825,12 +828,111 @@ static unsigned long memcg_events(struct mem_cgroup *memcg, int event)
 
 static unsigned long memcg_events_local(struct mem_cgroup *memcg, int event)
 {
-	long x = 0;
+	return atomic_long_read(&memcg->vmevents_local[event]);
+}
+
+/*
+ * Fold the percpu deltas accumulated on @cpu into the atomic counters of
+ * the cgroups that were updated there, and of their ancestors.  The percpu
+ * counters themselves are never written from here; deltas are taken
+ * against the snapshot recorded at the previous flush.
+ */
+static void mem_cgroup_flush_updated_cpu(int cpu)
+{
+	struct llist_node *node;
+	int nr_flushed = 0;
+
+	node = llist_del_all(&per_cpu(memcg_updated_list, cpu));
+
+	while (node) {
+		struct memcg_vmstats_percpu *statc =
+			container_of(node, struct memcg_vmstats_percpu,
+				     updated_node);
+		struct mem_cgroup *memcg = statc->memcg;
+		struct mem_cgroup *mi;
+		int i, nid;
+
+		node = node->next;
+
+		WRITE_ONCE(statc->updated, 0);
+		/* Pairs with the barrier in memcg_mark_stats_updated(). */
+		smp_mb();
+
+		for (i = 0; i < MEMCG_NR_STAT; i++) {
+			long x = READ_ONCE(statc->stat[i]) - statc->stat_prev[i];
+
+			if (!x)
+				continue;
+			statc->stat_prev[i] += x;
+			atomic_long_add(x, &memcg->vmstats_local[i]);
+			for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
+				atomic_long_add(x, &mi->vmstats[i]);
+		}
+
+		for (i = 0; i < NR_VM_EVENT_ITEMS; i++) {
+			unsigned long x = READ_ONCE(statc->events[i]) -
+					  statc->events_prev[i];
+
+			if (!x)
+				continue;
+			statc->events_prev[i] += x;
+			atomic_long_add(x, &memcg->vmevents_local[i]);
+			for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
+				atomic_long_add(x, &mi->vmevents[i]);
+		}
+
+		for_each_node(nid) {
+			struct mem_cgroup_per_node *pn =
+				mem_cgroup_nodeinfo(memcg, nid);
+			struct lruvec_stat *lstatc =
+				per_cpu_ptr(pn->lruvec_stat_cpu, cpu);
+
+			for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++) {
+				struct mem_cgroup_per_node *pi;
+				long x = READ_ONCE(lstatc->count[i]) -
+					 lstatc->count_prev[i];
+
+				if (!x)
+					continue;
+				lstatc->count_prev[i] += x;
+				atomic_long_add(x, &pn->lruvec_stat_local[i]);
+				for (pi = pn; pi;
+				     pi = parent_nodeinfo(pi, nid))
+					atomic_long_add(x, &pi->lruvec_stat[i]);
+			}
+		}
+
+		css_put(&memcg->css);
+		nr_flushed++;
+	}
+
+	if (nr_flushed)
+		atomic_sub(nr_flushed, &memcg_nr_updated_cgroups);
+}
+
+/*
+ * Fold all pending percpu deltas into the atomic counters.  The cost is
+ * proportional to the number of cgroups updated since the last flush,
+ * not to nr_cgroups * nr_cpus.
+ */
+static void mem_cgroup_flush_stats(void)
+{
 	int cpu;
 
+	if (!atomic_read(&memcg_nr_updated_cgroups))
+		return;
+
+	mutex_lock(&memcg_stats_flush_mutex);
 	for_each_possible_cpu(cpu)
-		x += per_cpu(memcg->vmstats_local->events[event], cpu);
-	return x;
+		mem_cgroup_flush_updated_cpu(cpu);
+	mutex_unlock(&memcg_stats_flush_mutex);
+}
+
+static void memcg_stats_flush_func(struct work_struct *work)
+{
+	mem_cgroup_flush_stats();
+	queue_delayed_work(system_unbound_wq, &memcg_stats_flush_work,
+			   MEMCG_FLUSH_TIME);
 }
 
 static void mem_cgroup_charge_statistics(struct mem_cgroup *memcg,
@@ -1370,6 +1472,8 @@ static char *memory_stat_format(struct mem_cgroup *memcg)
 	struct seq_buf s;
 	int i;
 
+	mem_cgroup_flush_stats();
+
 	seq_buf_init(&s, kmalloc(PAGE_SIZE, GFP_KERNEL), PAGE_SIZE);
 	if (!s.buffer)
 		return NULL;
@@ -2189,47 +2293,13 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 static int memcg_hotplug_cpu_dead(unsigned int cpu)
 {
 	struct memcg_stock_pcp *stock;
-	struct mem_cgroup *memcg, *mi;
 
 	stock = &per_cpu(memcg_stock, cpu);
 	drain_stock(stock);
 
-	for_each_mem_cgroup(memcg) {
-		int i;
-
-		for (i = 0; i < MEMCG_NR_STAT; i++) {
-			int nid;
-			long x;
-
-			x = this_cpu_xchg(memcg->vmstats_percpu->stat[i], 0);
-			if (x)
-				for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-					atomic_long_add(x, &memcg->vmstats[i]);
-
-			if (i >= NR_VM_NODE_STAT_ITEMS)
-				continue;
-
-			for_each_node(nid) {
-				struct mem_cgroup_per_node *pn;
-
-				pn = mem_cgroup_nodeinfo(memcg, nid);
-				x = this_cpu_xchg(pn->lruvec_stat_cpu->count[i], 0);
-				if (x)
-					do {
-						atomic_long_add(x, &pn->lruvec_stat[i]);
-					} while ((pn = parent_nodeinfo(pn, nid)));
-			}
-		}
-
-		for (i = 0; i < NR_VM_EVENT_ITEMS; i++) {
-			long x;
-
-			x = this_cpu_xchg(memcg->vmstats_percpu->events[i], 0);
-			if (x)
-				for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-					atomic_long_add(x, &memcg->vmevents[i]);
-		}
-	}
+	mutex_lock(&memcg_stats_flush_mutex);
+	mem_cgroup_flush_updated_cpu(cpu);
+	mutex_unlock(&memcg_stats_flush_mutex);
 
 	return 0;
 }
@@ -3316,6 +3386,8 @@ static u64 mem_cgroup_read_u64(struct cgroup_subsys_state *css,
 	struct mem_cgroup *memcg = mem_cgroup_from_css(css);
 	struct page_counter *counter;
 
+	mem_cgroup_flush_stats();
+
 	switch (MEMFILE_TYPE(cft->private)) {
 	case _MEM:
 		counter = &memcg->memory;
@@ -3353,57 +3425,6 @@ static u64 mem_cgroup_read_u64(struct cgroup_subsys_state *css,
 	}
 }
 
-static void memcg_flush_percpu_vmstats(struct mem_cgroup *memcg)
-{
-	unsigned long stat[MEMCG_NR_STAT] = {0};
-	struct mem_cgroup *mi;
-	int node, cpu, i;
-
-	for_each_online_cpu(cpu)
-		for (i = 0; i < MEMCG_NR_STAT; i++)
-			stat[i] += per_cpu(memcg->vmstats_percpu->stat[i], cpu);
-
-	for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-		for (i = 0; i < MEMCG_NR_STAT; i++)
-			atomic_long_add(stat[i], &mi->vmstats[i]);
-
-	for_each_node(node) {
-		struct mem_cgroup_per_node *pn = memcg->nodeinfo[node];
-		struct mem_cgroup_per_node *pi;
-
-		for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++)
-			stat[i] = 0;
-
-		for_each_online_cpu(cpu)
-			for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++)
-				stat[i] += per_cpu(
-					pn->lruvec_stat_cpu->count[i], cpu);
-
-		for (pi = pn; pi; pi = parent_nodeinfo(pi, node))
-			for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++)
-				atomic_long_add(stat[i], &pi->lruvec_stat[i]);
-	}
-}
-
-static void memcg_flush_percpu_vmevents(struct mem_cgroup *memcg)
-{
-	unsigned long events[NR_VM_EVENT_ITEMS];
-	struct mem_cgroup *mi;
-	int cpu, i;
-
-	for (i = 0; i < NR_VM_EVENT_ITEMS; i++)
-		events[i] = 0;
-
-	for_each_online_cpu(cpu)
-		for (i = 0; i < NR_VM_EVENT_ITEMS; i++)
-			events[i] += per_cpu(memcg->vmstats_percpu->events[i],
-					     cpu);
-
-	for (mi = memcg; mi; mi = parent_mem_cgroup(mi))
-		for (i = 0; i < NR_VM_EVENT_ITEMS; i++)
-			atomic_long_add(events[i], &mi->vmevents[i]);
-}
-
 #ifdef CONFIG_MEMCG_KMEM
 static int memcg_online_kmem(struct mem_cgroup *memcg)
 {
@@ -3726,6 +3747,8 @@ static int memcg_numa_stat_show(struct seq_file *m, void *v)
 	unsigned long nr;
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
 
+	mem_cgroup_flush_stats();
+
 	for (stat = stats; stat < stats + ARRAY_SIZE(stats); stat++) {
 		nr = mem_cgroup_nr_lru_pages(memcg, stat->lru_mask);
 		seq_printf(m, "%s=%lu", stat->name, nr);
@@ -3795,6 +3818,8 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 	struct mem_cgroup *mi;
 	unsigned int i;
 
+	mem_cgroup_flush_stats();
+
 	BUILD_BUG_ON(ARRAY_SIZE(memcg1_stat_names) != ARRAY_SIZE(memcg1_stats));
 
 	for (i = 0; i < ARRAY_SIZE(memcg1_stats); i++) {
@@ -4277,22 +4302,6 @@ struct wb_domain *mem_cgroup_wb_domain(struct bdi_writeback *wb)
 	return &memcg->cgwb_domain;
 }
 
-/*
- * idx can be of type enum memcg_stat_item or node_stat_item.
- * Keep in sync with memcg_exact_page().
- */
-static unsigned long memcg_exact_page_state(struct mem_cgroup *memcg, int idx)
-{
-	long x = atomic_long_read(&memcg->vmstats[idx]);
-	int cpu;
-
-	for_each_online_cpu(cpu)
-		x += per_cpu_ptr(memcg->vmstats_percpu, cpu)->stat[idx];
-	if (x < 0)
-		x = 0;
-	return x;
-}
-
 /**
  * mem_cgroup_wb_stats - retrieve writeback related stats from its memcg
  * @wb: bdi_writeback in question
@@ -4318,12 +4327,14 @@ void mem_cgroup_wb_stats(struct bdi_writeback *wb, unsigned long *pfilepages,
 	struct mem_cgroup *memcg = mem_cgroup_from_css(wb->memcg_css);
 	struct mem_cgroup *parent;
 
-	*pdirty = memcg_exact_page_state(memcg, NR_FILE_DIRTY);
+	mem_cgroup_flush_stats();
+
+	*pdirty = memcg_page_state(memcg, NR_FILE_DIRTY);
 
 	/* this should eventually include NR_UNSTABLE_NFS */
-	*pwriteback = memcg_exact_page_state(memcg, NR_WRITEBACK);
-	*pfilepages = memcg_exact_page_state(memcg, NR_INACTIVE_FILE) +
-			memcg_exact_page_state(memcg, NR_ACTIVE_FILE);
+	*pwriteback = memcg_page_state(memcg, NR_WRITEBACK);
+	*pfilepages = memcg_page_state(memcg, NR_INACTIVE_FILE) +
+			memcg_page_state(memcg, NR_ACTIVE_FILE);
 	*pheadroom = PAGE_COUNTER_MAX;
 
 	while ((parent = parent_mem_cgroup(memcg))) {
@@ -4914,15 +4925,8 @@ static int alloc_mem_cgroup_per_node_info(struct mem_cgroup *memcg, int node)
 	if (!pn)
 		return 1;
 
-	pn->lruvec_stat_local = alloc_percpu(struct lruvec_stat);
-	if (!pn->lruvec_stat_local) {
-		kfree(pn);
-		return 1;
-	}
-
 	pn->lruvec_stat_cpu = alloc_percpu(struct lruvec_stat);
 	if (!pn->lruvec_stat_cpu) {
-		free_percpu(pn->lruvec_stat_local);
 		kfree(pn);
 		return 1;
 	}
@@ -4944,7 +4948,6 @@ static void free_mem_cgroup_per_node_info(struct mem_cgroup *memcg, int node)
 		return;
 
 	free_percpu(pn->lruvec_stat_cpu);
-	free_percpu(pn->lruvec_stat_local);
 	kfree(pn);
 }
 
@@ -4955,7 +4958,6 @@ static void __mem_cgroup_free(struct mem_cgroup *memcg)
 	for_each_node(node)
 		free_mem_cgroup_per_node_info(memcg, node);
 	free_percpu(memcg->vmstats_percpu);
-	free_percpu(memcg->vmstats_local);
 	kfree(memcg);
 }
 
@@ -4963,11 +4965,10 @@ static void mem_cgroup_free(struct mem_cgroup *memcg)
 {
 	memcg_wb_domain_exit(memcg);
 	/*
-	 * Flush percpu vmstats and vmevents to guarantee the value correctness
+	 * Flush pending percpu deltas to guarantee the value correctness
 	 * on parent's and all ancestor levels.
 	 */
-	memcg_flush_percpu_vmstats(memcg);
-	memcg_flush_percpu_vmevents(memcg);
+	mem_cgroup_flush_stats();
 	__mem_cgroup_free(memcg);
 }
 
@@ -4975,7 +4976,7 @@ static struct mem_cgroup *mem_cgroup_alloc(void)
 {
 	struct mem_cgroup *memcg;
 	unsigned int size;
-	int node;
+	int node, cpu;
 	int __maybe_unused i;
 	long error = -ENOMEM;
 
@@ -4994,14 +4995,13 @@ static struct mem_cgroup *mem_cgroup_alloc(void)
 		goto fail;
 	}
 
-	memcg->vmstats_local = alloc_percpu(struct memcg_vmstats_percpu);
-	if (!memcg->vmstats_local)
-		goto fail;
-
 	memcg->vmstats_percpu = alloc_percpu(struct memcg_vmstats_percpu);
 	if (!memcg->vmstats_percpu)
 		goto fail;
 
+	for_each_possible_cpu(cpu)
+		per_cpu_ptr(memcg->vmstats_percpu, cpu)->memcg = memcg;
+
 	for_each_node(node)
 		if (alloc_mem_cgroup_per_node_info(memcg, node))
 			goto fail;
@@ -6889,6 +6889,9 @@ static int __init mem_cgroup_init(void)
 		soft_limit_tree.rb_tree_per_node[node] = rtpn;
 	}
 
+	queue_delayed_work(system_unbound_wq, &memcg_stats_flush_work,
+			   MEMCG_FLUSH_TIME);
+
 	return 0;
 }
 subsys_initcall(mem_cgroup_init);
@@ -150,6 +150,20 @@ static void *remove_element(mempool_t *pool)
  */
 void mempool_exit(mempool_t *pool)
 {
+	if (pool->cache) {
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			struct mempool_percpu_cache *cache =
+				per_cpu_ptr(pool->cache, cpu);
+
+			while (cache->nr)
+				pool->free(cache->elements[--cache->nr],
+					   pool->pool_data);
+		}
+		free_percpu(pool->cache);
+		pool->cache = NULL;
+	}
 	while (pool->curr_nr) {
 		void *element = remove_element(pool);
 		pool->free(element, pool->pool_data);
@@ -159,6 +173,31 @@ void mempool_exit(mempool_t *pool)
 }
 EXPORT_SYMBOL(mempool_exit);
 
+/**
+ * mempool_enable_percpu_cache - cache freed elements per CPU
+ * @pool:      pointer to an initialized memory pool
+ *
+ * Put a small per-CPU cache in front of @pool so that alloc/free pairs
+ * issued at high frequency can recycle elements without going through
+ * the underlying allocator or the shared reserve.  The cache only ever
+ * holds elements that mempool_free() would otherwise have handed back
+ * to free_fn(), so the min_nr forward-progress guarantee is unaffected.
+ *
+ * The cached elements are released by mempool_exit().  Failure to
+ * allocate the cache is not fatal; the pool simply keeps working
+ * without it.
+ *
+ * Return: %0 on success, -ENOMEM otherwise.
+ */
+int mempool_enable_percpu_cache(mempool_t *pool)
+{
+	pool->cache = alloc_percpu(struct mempool_percpu_cache);
+	if (!pool->cache)
+		return -ENOMEM;
+	return 0;
+}
+EXPORT_SYMBOL(mempool_enable_percpu_cache);
+
 /**
  * mempool_destroy - deallocate a memory pool
  * @pool:      pointer to the memory pool which was allocated via
@@ -186,6 +225,7 @@ int mempool_init_node(mempool_t *pool, int min_nr, mempool_alloc_t *alloc_fn,
 	pool->pool_data = pool_data;
 	pool->alloc	= alloc_fn;
 	pool->free	= free_fn;
+	pool->cache	= NULL;
 	init_waitqueue_head(&pool->wait);
 
 	pool->elements = kmalloc_array_node(min_nr, sizeof(void *),
@@ -388,6 +428,24 @@ void *mempool_alloc(mempool_t *pool, gfp_t gfp_mask)
 
 	gfp_temp = gfp_mask & ~(__GFP_DIRECT_RECLAIM|__GFP_IO);
 
+	/*
+	 * Elements recycled through the per-CPU cache skip the underlying
+	 * allocator entirely.  They are kept "live" while cached, so no
+	 * check_element()/kasan dance is needed here.
+	 */
+	if (pool->cache) {
+		struct mempool_percpu_cache *cache;
+
+		local_irq_save(flags);
+		cache = this_cpu_ptr(pool->cache);
+		if (cache->nr) {
+			element = cache->elements[--cache->nr];
+			local_irq_restore(flags);
+			return element;
+		}
+		local_irq_restore(flags);
+	}
+
 repeat_alloc:
 
 	element = pool->alloc(gfp_temp, pool->pool_data);
@@ -499,6 +557,26 @@ void mempool_free(void *element, mempool_t *pool)
 		}
 		spin_unlock_irqrestore(&pool->lock, flags);
 	}
+
+	/*
+	 * The shared reserve is full, so this element would go back to
+	 * free_fn().  Stash it in the per-CPU cache instead, if there is
+	 * one with room left.  Because only surplus elements end up here,
+	 * the refill-and-wake guarantee above is preserved.
+	 */
+	if (pool->cache) {
+		struct mempool_percpu_cache *cache;
+
+		local_irq_save(flags);
+		cache = this_cpu_ptr(pool->cache);
+		if (cache->nr < MEMPOOL_CACHE_SIZE) {
+			cache->elements[cache->nr++] = element;
+			local_irq_restore(flags);
+			return;
+		}
+		local_irq_restore(flags);
+	}
+
 	pool->free(element, pool->pool_data);
 }
 EXPORT_SYMBOL(mempool_free);
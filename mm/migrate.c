@@ -563,6 +563,85 @@ static void __copy_gigantic_page(struct page *dst, struct page *src,
 	}
 }
 
+/*
+ * Work item granularity for fanning a huge page copy out to other CPUs.
+ * 128 base pages is small enough that a THP still splits into several
+ * chunks, but large enough that the queueing overhead stays negligible
+ * against the copy itself.
+ */
+#define COPY_HUGE_CHUNK_PAGES	128
+
+struct copy_huge_chunk {
+	struct work_struct work;
+	struct page *dst;
+	struct page *src;
+	int nr_pages;
+};
+
+static void copy_huge_chunk_fn(struct work_struct *work)
+{
+	struct copy_huge_chunk *chunk =
+		container_of(work, struct copy_huge_chunk, work);
+	int i;
+
+	for (i = 0; i < chunk->nr_pages; i++) {
+		cond_resched();
+		copy_highpage(chunk->dst + i, chunk->src + i);
+	}
+}
+
+/*
+ * Copy a huge page using multiple CPUs, chunk by chunk, so that draining
+ * a node is not bound by the memory bandwidth of a single core.  The
+ * first chunk is copied by the caller while the rest runs on the unbound
+ * workqueue.  Returns false if the copy should be done serially instead,
+ * which keeps a fallback that cannot fail under memory pressure.
+ */
+static bool copy_huge_page_parallel(struct page *dst, struct page *src,
+				    int nr_pages)
+{
+	struct copy_huge_chunk *chunks;
+	int nr_chunks, base, rem, done, i;
+
+	nr_chunks = min(nr_pages / COPY_HUGE_CHUNK_PAGES,
+			num_online_cpus());
+	if (nr_chunks < 2)
+		return false;
+
+	chunks = kmalloc_array(nr_chunks, sizeof(*chunks),
+			       GFP_NOWAIT | __GFP_NOWARN);
+	if (!chunks)
+		return false;
+
+	base = nr_pages / nr_chunks;
+	rem = nr_pages % nr_chunks;
+	done = 0;
+
+	for (i = 0; i < nr_chunks; i++) {
+		struct copy_huge_chunk *chunk = &chunks[i];
+
+		chunk->dst = dst + done;
+		chunk->src = src + done;
+		chunk->nr_pages = base + (i < rem);
+		done += chunk->nr_pages;
+
+		if (i) {
+			INIT_WORK(&chunk->work, copy_huge_chunk_fn);
+			queue_work(system_unbound_wq, &chunk->work);
+		}
+	}
+	VM_BUG_ON(done != nr_pages);
+
+	/* Copy the first chunk ourselves instead of idling. */
+	copy_huge_chunk_fn(&chunks[0].work);
+
+	for (i = 1; i < nr_chunks; i++)
+		flush_work(&chunks[i].work);
+
+	kfree(chunks);
+	return true;
+}
+
 static void copy_huge_page(struct page *dst, struct page *src)
 {
 	int i;
@@ -583,6 +662,9 @@ static void copy_huge_page(struct page *dst, struct page *src)
 		nr_pages = hpage_nr_pages(src);
 	}
 
+	if (copy_huge_page_parallel(dst, src, nr_pages))
+		return;
+
 	for (i = 0; i < nr_pages; i++) {
 		cond_resched();
 		copy_highpage(dst + i, src + i);
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * mm micro-benchmark harness in the style of gup_benchmark: userspace
+ * sets up a mapping, the kernel times the core mm operation on it and
+ * reports ns/op through the same debugfs ioctl pattern.  The fault
+ * benchmark measures whatever the region is backed by (anonymous,
+ * file, THP), so one harness covers all of them.
+ */
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/mm_inline.h>
+#include <linux/migrate.h>
+#include <linux/swap.h>
+
+#include "internal.h"
+
+#define MM_BENCHMARK_FAULT	_IOWR('g', 16, struct mm_benchmark)
+#define MM_BENCHMARK_PROTECT	_IOWR('g', 17, struct mm_benchmark)
+#define MM_BENCHMARK_MIGRATE	_IOWR('g', 18, struct mm_benchmark)
+#define MM_BENCHMARK_LRU	_IOWR('g', 19, struct mm_benchmark)
+
+/* flags for MM_BENCHMARK_FAULT */
+#define MM_BENCHMARK_WRITE	1
+
+struct mm_benchmark {
+	__u64 delta_nsec;	/* total time of the timed section */
+	__u64 nsec_per_op;	/* delta_nsec / nr_ops */
+	__u64 addr;		/* start of the region, page aligned */
+	__u64 size;		/* size in bytes, page aligned */
+	__u64 nr_ops;		/* operations actually timed */
+	__u32 flags;
+	__u32 reserved;		/* must be zero */
+	__u64 expansion[8];	/* For future use */
+};
+
+/*
+ * Page fault throughput: fault in every page of the region through
+ * fixup_user_fault(), i.e. the same handle_mm_fault() path a real
+ * access takes, without the gup page-pinning overhead on top.
+ */
+static int mm_benchmark_fault(struct mm_benchmark *bench)
+{
+	struct mm_struct *mm = current->mm;
+	unsigned long addr, end = bench->addr + bench->size;
+	unsigned int fault_flags = 0;
+	ktime_t start_time, end_time;
+	bool unlocked = false;
+	int ret = 0;
+
+	if (bench->flags & MM_BENCHMARK_WRITE)
+		fault_flags |= FAULT_FLAG_WRITE;
+
+	down_read(&mm->mmap_sem);
+	start_time = ktime_get();
+	for (addr = bench->addr; addr < end; addr += PAGE_SIZE) {
+		ret = fixup_user_fault(current, mm, addr, fault_flags,
+				       &unlocked);
+		if (ret)
+			break;
+		bench->nr_ops++;
+	}
+	end_time = ktime_get();
+	up_read(&mm->mmap_sem);
+
+	bench->delta_nsec = ktime_to_ns(ktime_sub(end_time, start_time));
+	return ret;
+}
+
+/*
+ * Protection change batch cost: drop the write permission over the
+ * region and restore it, timing both change_protection() passes.  The
+ * vma flags are left untouched and the write lock is held throughout,
+ * so userspace never observes the intermediate state.  Restricted to
+ * private anonymous writable mappings to keep dirty accounting out of
+ * the picture.
+ */
+static int mm_benchmark_protect(struct mm_benchmark *bench)
+{
+	struct mm_struct *mm = current->mm;
+	unsigned long start = bench->addr, end = bench->addr + bench->size;
+	struct vm_area_struct *vma;
+	ktime_t start_time, end_time;
+	int ret = 0;
+
+	down_write(&mm->mmap_sem);
+	vma = find_vma(mm, start);
+	if (!vma || vma->vm_start > start || end > vma->vm_end) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+	if (!vma_is_anonymous(vma) || !(vma->vm_flags & VM_WRITE)) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	start_time = ktime_get();
+	bench->nr_ops = change_protection(vma, start, end,
+			vm_get_page_prot(vma->vm_flags & ~VM_WRITE), 0, 0);
+	bench->nr_ops += change_protection(vma, start, end,
+			vm_get_page_prot(vma->vm_flags), 0, 0);
+	end_time = ktime_get();
+
+	bench->delta_nsec = ktime_to_ns(ktime_sub(end_time, start_time));
+unlock:
+	up_write(&mm->mmap_sem);
+	return ret;
+}
+
+static struct page *mm_benchmark_alloc_dst(struct page *page,
+					   unsigned long private)
+{
+	return alloc_page(GFP_HIGHUSER_MOVABLE);
+}
+
+/*
+ * Pin the region and isolate its pages from the LRU the same way the
+ * move_pages() path does; compound pages are skipped.  Returns the
+ * number of pages on @pagelist.  The caller is responsible for the
+ * NR_ISOLATED accounting if the pages go to migrate_pages().
+ */
+static long mm_benchmark_isolate(struct mm_benchmark *bench,
+				 struct list_head *pagelist, bool account)
+{
+	unsigned long nr_pages = bench->size / PAGE_SIZE;
+	struct page **pages;
+	long nr, i, isolated = 0;
+
+	pages = kvcalloc(nr_pages, sizeof(void *), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	nr = get_user_pages_fast(bench->addr, nr_pages, FOLL_WRITE, pages);
+	if (nr <= 0) {
+		kvfree(pages);
+		return nr ? nr : -EFAULT;
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct page *page = pages[i];
+
+		if (!PageCompound(page) && !isolate_lru_page(page)) {
+			list_add_tail(&page->lru, pagelist);
+			if (account)
+				inc_node_page_state(page, NR_ISOLATED_ANON +
+						    page_is_file_cache(page));
+			isolated++;
+		}
+		put_page(page);
+	}
+	kvfree(pages);
+	return isolated;
+}
+
+/*
+ * Migration batch cost: migrate every page of the region to a freshly
+ * allocated destination, timing only the migrate_pages() call so the
+ * pinning and isolation setup is not part of the measurement.
+ */
+static int mm_benchmark_migrate(struct mm_benchmark *bench)
+{
+	ktime_t start_time, end_time;
+	LIST_HEAD(pagelist);
+	long isolated;
+	int err;
+
+	isolated = mm_benchmark_isolate(bench, &pagelist, true);
+	if (isolated < 0)
+		return isolated;
+	bench->nr_ops = isolated;
+
+	start_time = ktime_get();
+	err = migrate_pages(&pagelist, mm_benchmark_alloc_dst, NULL, 0,
+			    MIGRATE_SYNC, MR_SYSCALL);
+	end_time = ktime_get();
+	if (err)
+		putback_movable_pages(&pagelist);
+
+	bench->delta_nsec = ktime_to_ns(ktime_sub(end_time, start_time));
+	return err < 0 ? err : 0;
+}
+
+/*
+ * LRU manipulation rate: isolate each page from its LRU list and put
+ * it straight back, timing the round trip.  This exercises the lru
+ * lock and list handling that both reclaim and migration are built on.
+ */
+static int mm_benchmark_lru(struct mm_benchmark *bench)
+{
+	unsigned long nr_pages = bench->size / PAGE_SIZE;
+	struct page **pages;
+	ktime_t start_time, end_time;
+	long nr, i;
+
+	pages = kvcalloc(nr_pages, sizeof(void *), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	nr = get_user_pages_fast(bench->addr, nr_pages, FOLL_WRITE, pages);
+	if (nr <= 0) {
+		kvfree(pages);
+		return nr ? nr : -EFAULT;
+	}
+
+	start_time = ktime_get();
+	for (i = 0; i < nr; i++) {
+		struct page *page = pages[i];
+
+		if (!PageCompound(page) && !isolate_lru_page(page)) {
+			putback_lru_page(page);
+			bench->nr_ops++;
+		}
+	}
+	end_time = ktime_get();
+
+	for (i = 0; i < nr; i++)
+		put_page(pages[i]);
+	kvfree(pages);
+
+	bench->delta_nsec = ktime_to_ns(ktime_sub(end_time, start_time));
+	return 0;
+}
+
+static int __mm_benchmark_ioctl(unsigned int cmd, struct mm_benchmark *bench)
+{
+	int ret;
+
+	if (bench->reserved)
+		return -EINVAL;
+	if (!bench->size || bench->addr + bench->size < bench->addr)
+		return -EINVAL;
+	if ((bench->addr | bench->size) & ~PAGE_MASK)
+		return -EINVAL;
+
+	bench->delta_nsec = 0;
+	bench->nsec_per_op = 0;
+	bench->nr_ops = 0;
+
+	switch (cmd) {
+	case MM_BENCHMARK_FAULT:
+		ret = mm_benchmark_fault(bench);
+		break;
+	case MM_BENCHMARK_PROTECT:
+		ret = mm_benchmark_protect(bench);
+		break;
+	case MM_BENCHMARK_MIGRATE:
+		ret = mm_benchmark_migrate(bench);
+		break;
+	case MM_BENCHMARK_LRU:
+		ret = mm_benchmark_lru(bench);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (bench->nr_ops)
+		bench->nsec_per_op = div64_u64(bench->delta_nsec,
+					       bench->nr_ops);
+	return ret;
+}
+
+static long mm_benchmark_ioctl(struct file *filep, unsigned int cmd,
+		unsigned long arg)
+{
+	struct mm_benchmark bench;
+	int ret;
+
+	switch (cmd) {
+	case MM_BENCHMARK_FAULT:
+	case MM_BENCHMARK_PROTECT:
+	case MM_BENCHMARK_MIGRATE:
+	case MM_BENCHMARK_LRU:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (copy_from_user(&bench, (void __user *)arg, sizeof(bench)))
+		return -EFAULT;
+
+	ret = __mm_benchmark_ioctl(cmd, &bench);
+	if (ret)
+		return ret;
+
+	if (copy_to_user((void __user *)arg, &bench, sizeof(bench)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static const struct file_operations mm_benchmark_fops = {
+	.open = nonseekable_open,
+	.unlocked_ioctl = mm_benchmark_ioctl,
+};
+
+static int mm_benchmark_init(void)
+{
+	debugfs_create_file_unsafe("mm_benchmark", 0600, NULL, NULL,
+				   &mm_benchmark_fops);
+
+	return 0;
+}
+
+late_initcall(mm_benchmark_init);
@@ -1580,6 +1580,32 @@ static void balance_dirty_pages(struct bdi_writeback *wb,
 	bool strictlimit = bdi->capabilities & BDI_CAP_STRICTLIMIT;
 	unsigned long start_time = jiffies;
 
+	/*
+	 * Steady writers far below the dirty limits end up here on every
+	 * ratelimit expiry just to rediscover that they are in the freerun
+	 * region.  The limits move slowly compared to BANDWIDTH_INTERVAL,
+	 * so reuse the ceiling computed by a recent full pass and only
+	 * re-read the (cheap) dirty counters.  The cached ceiling is halved
+	 * so that a stale snapshot cannot let us overrun the real freerun
+	 * region.  The memcg domain has its own limits and its counters
+	 * need flushing, so cgroup writeback always takes the full path.
+	 */
+	if (!strictlimit && !mdtc &&
+	    time_before(start_time, READ_ONCE(wb->dirty_cache_time) +
+				    BANDWIDTH_INTERVAL)) {
+		unsigned long dirty = global_node_page_state(NR_FILE_DIRTY) +
+				global_node_page_state(NR_UNSTABLE_NFS) +
+				global_node_page_state(NR_WRITEBACK);
+
+		if (dirty <= READ_ONCE(wb->dirty_freerun_cache) / 2) {
+			current->dirty_paused_when = start_time;
+			current->nr_dirtied = 0;
+			current->nr_dirtied_pause = dirty_poll_interval(dirty,
+					READ_ONCE(wb->dirty_thresh_cache));
+			return;
+		}
+	}
+
 	for (;;) {
 		unsigned long now = jiffies;
 		unsigned long dirty, thresh, bg_thresh;
@@ -1661,6 +1687,15 @@ static void balance_dirty_pages(struct bdi_writeback *wb,
 			if (mdtc)
 				m_intv = dirty_poll_interval(m_dirty, m_thresh);
 			current->nr_dirtied_pause = min(intv, m_intv);
+
+			/* refresh the freerun snapshot for the fast path */
+			if (!strictlimit && !mdtc) {
+				WRITE_ONCE(wb->dirty_thresh_cache, thresh);
+				WRITE_ONCE(wb->dirty_freerun_cache,
+					   dirty_freerun_ceiling(thresh,
+								 bg_thresh));
+				WRITE_ONCE(wb->dirty_cache_time, now);
+			}
 			break;
 		}
 
@@ -48,6 +48,8 @@ struct pcpu_chunk {
 
 	void			*data;		/* chunk data */
 	bool			immutable;	/* no [de]population allowed */
+	bool			isolated;	/* isolated from active chunk
+						   slots, temporary */
 	int			start_offset;	/* the overlap with the previous
 						   region to have a page aligned
 						   base_addr */
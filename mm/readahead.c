@@ -21,6 +21,7 @@
 #include <linux/file.h>
 #include <linux/mm_inline.h>
 #include <linux/blk-cgroup.h>
+#include <linux/cpuset.h>
 #include <linux/fadvise.h>
 
 #include "internal.h"
@@ -160,10 +161,12 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 	struct page *page;
 	unsigned long end_index;	/* The last page we want to read */
 	LIST_HEAD(page_pool);
+	LIST_HEAD(page_batch);
 	int page_idx;
 	unsigned int nr_pages = 0;
 	loff_t isize = i_size_read(inode);
 	gfp_t gfp_mask = readahead_gfp_mask(mapping);
+	bool use_bulk = !cpuset_do_page_mem_spread();
 
 	if (isize == 0)
 		goto out;
@@ -193,9 +196,28 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 			continue;
 		}
 
-		page = __page_cache_alloc(gfp_mask);
-		if (!page)
-			break;
+		/*
+		 * Grab all the pages we will need with one trip into the
+		 * page allocator where possible.  The bulk allocator only
+		 * does node-local order-0 pages, so leave cpuset page
+		 * spreading to __page_cache_alloc().
+		 */
+		if (use_bulk && list_empty(&page_batch)) {
+			unsigned long nr_batch;
+
+			nr_batch = min_t(unsigned long, nr_to_read - page_idx,
+					 end_index - page_offset + 1);
+			alloc_pages_bulk_list(gfp_mask, nr_batch, &page_batch);
+		}
+
+		if (!list_empty(&page_batch)) {
+			page = list_first_entry(&page_batch, struct page, lru);
+			list_del(&page->lru);
+		} else {
+			page = __page_cache_alloc(gfp_mask);
+			if (!page)
+				break;
+		}
 		page->index = page_offset;
 		list_add(&page->lru, &page_pool);
 		if (page_idx == nr_to_read - lookahead_size)
@@ -211,6 +233,8 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 	if (nr_pages)
 		read_pages(mapping, filp, &page_pool, nr_pages, gfp_mask);
 	BUG_ON(!list_empty(&page_pool));
+	/* Give back whatever the bulk batch over-allocated */
+	put_pages_list(&page_batch);
 out:
 	return nr_pages;
 }
@@ -268,6 +292,30 @@ static unsigned long get_init_ra_size(unsigned long size, unsigned long max)
 	return newsize;
 }
 
+/*
+ * Feedback score bounds for the adaptive controller.  Hits - the stream
+ * consumed a window we speculated on - push the score up; standalone
+ * random reads push it down.  Past the streaming threshold windows jump
+ * straight to the maximum, past the random threshold speculation is
+ * shut off entirely.
+ */
+#define RA_SCORE_MAX		16
+#define RA_SCORE_MIN		(-16)
+#define RA_SCORE_STREAMING	8
+#define RA_SCORE_RANDOM		(-8)
+
+static void ra_account_hit(struct file_ra_state *ra)
+{
+	if (ra->ra_score < RA_SCORE_MAX)
+		ra->ra_score++;
+}
+
+static void ra_account_miss(struct file_ra_state *ra)
+{
+	if (ra->ra_score > RA_SCORE_MIN)
+		ra->ra_score--;
+}
+
 /*
  *  Get the previous window size, ramp it up, and
  *  return it as the new window size.
@@ -277,6 +325,9 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
 {
 	unsigned long cur = ra->size;
 
+	/* A proven streaming file can jump straight to the full window */
+	if (ra->ra_score >= RA_SCORE_STREAMING)
+		return max;
 	if (cur < max / 16)
 		return 4 * cur;
 	if (cur <= max / 2)
@@ -408,6 +459,7 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		ra_account_hit(ra);
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max_pages);
 		ra->async_size = ra->size;
@@ -430,6 +482,7 @@ ondemand_readahead(struct address_space *mapping,
 		if (!start || start - offset > max_pages)
 			return 0;
 
+		ra_account_hit(ra);
 		ra->start = start;
 		ra->size = start - offset;	/* old async_size */
 		ra->size += req_size;
@@ -464,6 +517,7 @@ ondemand_readahead(struct address_space *mapping,
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
 	 */
+	ra_account_miss(ra);
 	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
 
 initial_readahead:
@@ -471,6 +525,15 @@ initial_readahead:
 	ra->size = get_init_ra_size(req_size, max_pages);
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
 
+	/*
+	 * Files with a proven random access pattern get the request
+	 * itself and no speculation on top.
+	 */
+	if (ra->ra_score <= RA_SCORE_RANDOM) {
+		ra->size = min(req_size, max_pages);
+		ra->async_size = 0;
+	}
+
 readit:
 	/*
 	 * Will this read hit the readahead marker made by itself?
@@ -664,7 +664,34 @@ static void shmem_delete_from_page_cache(struct page *page, void *radswap)
 	struct address_space *mapping = page->mapping;
 	int error;
 
-	VM_BUG_ON_PAGE(PageCompound(page), page);
+	VM_BUG_ON_PAGE(PageTail(page), page);
+
+	if (PageTransHuge(page)) {
+		XA_STATE(xas, &mapping->i_pages, page->index);
+		swp_entry_t swap = radix_to_swp_entry(radswap);
+		unsigned long nr = compound_nr(page);
+		unsigned long i;
+
+		/*
+		 * Each slot gets its own swap entry so that the subpages
+		 * can be swapped back in independently.
+		 */
+		xas_lock_irq(&xas);
+		for (i = 0; i < nr; i++) {
+			VM_BUG_ON_PAGE(xas_load(&xas) != page, page);
+			xas_store(&xas, swp_to_radix_entry(swap));
+			swap.val++;
+			xas_next(&xas);
+		}
+		page->mapping = NULL;
+		mapping->nrpages -= nr;
+		__dec_node_page_state(page, NR_SHMEM_THPS);
+		__mod_node_page_state(page_pgdat(page), NR_FILE_PAGES, -nr);
+		__mod_node_page_state(page_pgdat(page), NR_SHMEM, -nr);
+		xas_unlock_irq(&xas);
+		page_ref_sub(page, nr);
+		return;
+	}
 
 	xa_lock_irq(&mapping->i_pages);
 	error = shmem_replace_entry(mapping, page->index, page, radswap);
@@ -1297,8 +1324,9 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 	struct inode *inode;
 	swp_entry_t swap;
 	pgoff_t index;
+	int nr_pages;
 
-	VM_BUG_ON_PAGE(PageCompound(page), page);
+	VM_BUG_ON_PAGE(PageTail(page), page);
 	BUG_ON(!PageLocked(page));
 	mapping = page->mapping;
 	index = page->index;
@@ -1333,6 +1361,12 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 	 * reactivate the page, and let shmem_fallocate() quit when too many.
 	 */
 	if (!PageUptodate(page)) {
+		/*
+		 * A huge page still under fallocation: split it so that the
+		 * undo bookkeeping below keeps working on the base page.
+		 */
+		if (PageTransHuge(page) && split_huge_page(page) < 0)
+			goto redirty;
 		if (inode->i_private) {
 			struct shmem_falloc *shmem_falloc;
 			spin_lock(&inode->i_lock);
@@ -1353,7 +1387,18 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 		SetPageUptodate(page);
 	}
 
+	/*
+	 * A huge page is written out as one unit if a whole swap cluster
+	 * can be had for it; otherwise fall back to splitting it and
+	 * swapping the base pages individually.
+	 */
 	swap = get_swap_page(page);
+	if (!swap.val && PageTransHuge(page)) {
+		if (split_huge_page(page) < 0)
+			goto redirty;
+		count_vm_event(THP_SWPOUT_FALLBACK);
+		swap = get_swap_page(page);
+	}
 	if (!swap.val)
 		goto redirty;
 
@@ -1371,12 +1416,13 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 
 	if (add_to_swap_cache(page, swap,
 			__GFP_HIGH | __GFP_NOMEMALLOC | __GFP_NOWARN) == 0) {
+		nr_pages = hpage_nr_pages(page);
 		spin_lock_irq(&info->lock);
 		shmem_recalc_inode(inode);
-		info->swapped++;
+		info->swapped += nr_pages;
 		spin_unlock_irq(&info->lock);
 
-		swap_shmem_alloc(swap);
+		swap_shmem_alloc(swap, nr_pages);
 		shmem_delete_from_page_cache(page, swp_to_radix_entry(swap));
 
 		mutex_unlock(&shmem_swaplist_mutex);
@@ -1618,6 +1664,38 @@ static int shmem_replace_page(struct page **pagep, gfp_t gfp,
 	return error;
 }
 
+/*
+ * The page to swap in is a subpage of a huge page that still sits in the
+ * swap cache, typically because its writeback has not finished or reclaim
+ * has not yet got around to freeing it.  A tail page cannot be inserted
+ * into the mapping on its own and the huge page cannot be split as it no
+ * longer has a mapping, so swap in by copying the data to a fresh page.
+ * Every slot of the huge page holds SWAP_HAS_CACHE, so the on-disk
+ * cluster cannot be reallocated under us while the copy is in flight.
+ */
+static int shmem_swapin_huge_subpage(struct page **pagep, gfp_t gfp,
+				     struct shmem_inode_info *info,
+				     pgoff_t index)
+{
+	struct page *oldpage = *pagep, *newpage;
+
+	newpage = shmem_alloc_page(gfp, info, index);
+	if (!newpage)
+		return -ENOMEM;
+
+	copy_highpage(newpage, oldpage);
+	flush_dcache_page(newpage);
+
+	__SetPageLocked(newpage);
+	__SetPageSwapBacked(newpage);
+	SetPageUptodate(newpage);
+
+	unlock_page(oldpage);
+	put_page(oldpage);
+	*pagep = newpage;
+	return 0;
+}
+
 /*
  * Swap in the page pointed to by *pagep.
  * Caller has to make sure that *pagep contains a valid swapped page.
@@ -1635,6 +1713,7 @@ static int shmem_swapin_page(struct inode *inode, pgoff_t index,
 	struct mem_cgroup *memcg;
 	struct page *page;
 	swp_entry_t swap;
+	bool copied = false;
 	int error;
 
 	VM_BUG_ON(!*pagep || !xa_is_value(*pagep));
@@ -1671,7 +1750,12 @@ static int shmem_swapin_page(struct inode *inode, pgoff_t index,
 	}
 	wait_on_page_writeback(page);
 
-	if (shmem_should_replace_page(page, gfp)) {
+	if (PageTransCompound(page)) {
+		error = shmem_swapin_huge_subpage(&page, gfp, info, index);
+		if (error)
+			goto failed;
+		copied = true;
+	} else if (shmem_should_replace_page(page, gfp)) {
 		error = shmem_replace_page(&page, gfp, info, index);
 		if (error)
 			goto failed;
@@ -1694,13 +1778,14 @@ static int shmem_swapin_page(struct inode *inode, pgoff_t index,
 		 */
 		if (error) {
 			mem_cgroup_cancel_charge(page, memcg, false);
-			delete_from_swap_cache(page);
+			if (!copied)
+				delete_from_swap_cache(page);
 		}
 	}
 	if (error)
 		goto failed;
 
-	mem_cgroup_commit_charge(page, memcg, true, false);
+	mem_cgroup_commit_charge(page, memcg, !copied, false);
 
 	spin_lock_irq(&info->lock);
 	info->swapped--;
@@ -1710,7 +1795,10 @@ static int shmem_swapin_page(struct inode *inode, pgoff_t index,
 	if (sgp == SGP_WRITE)
 		mark_page_accessed(page);
 
-	delete_from_swap_cache(page);
+	if (copied)
+		lru_cache_add_anon(page);
+	else
+		delete_from_swap_cache(page);
 	set_page_dirty(page);
 	swap_free(swap);
 
@@ -2326,6 +2326,8 @@ static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 	c->tid = next_tid(c->tid);
 }
 
+static void drain_remote_frees(struct kmem_cache *s, struct kmem_cache_cpu *c);
+
 /*
  * Flush cpu slab.
  *
@@ -2339,6 +2341,7 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 		flush_slab(s, c);
 
 	unfreeze_partials(s, c);
+	drain_remote_frees(s, c);
 }
 
 static void flush_cpu_slab(void *d)
@@ -2353,7 +2356,13 @@ static bool has_cpu_slab(int cpu, void *info)
 	struct kmem_cache *s = info;
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
-	return c->page || slub_percpu_partial(c);
+	if (c->page || slub_percpu_partial(c))
+		return true;
+#ifdef CONFIG_NUMA
+	if (c->nr_remote_free)
+		return true;
+#endif
+	return false;
 }
 
 static void flush_all(struct kmem_cache *s)
@@ -2966,6 +2975,86 @@ slab_empty:
 	discard_slab(s, page);
 }
 
+#ifdef CONFIG_NUMA
+/*
+ * Freeing an object that lives on another node's slab has to go through
+ * the __slab_free() slowpath and bounces the remote struct page cacheline
+ * on every call.  Queue such objects on a small per cpu list, threaded
+ * through their free pointers, and push them out in slab-grouped chunks
+ * so that a storm of cross-node kfrees (skb heads, dentries) costs one
+ * cmpxchg per slab instead of one per object.
+ */
+#define SLUB_REMOTE_FREE_BATCH	32
+
+/*
+ * Drain the per cpu queue of deferred remote frees.
+ *
+ * Interrupts must be disabled and @c must belong to this cpu or to one
+ * that is offline.
+ */
+static void drain_remote_frees(struct kmem_cache *s, struct kmem_cache_cpu *c)
+{
+	void *object = c->remote_free;
+
+	c->remote_free = NULL;
+	c->nr_remote_free = 0;
+
+	while (object) {
+		struct page *page = virt_to_head_page(object);
+		void *next = get_freepointer(s, object);
+		void *tail = object;
+		int cnt = 1;
+
+		/*
+		 * Consecutive objects from the same slab are handed to
+		 * __slab_free() as one detached freelist.
+		 */
+		while (next && virt_to_head_page(next) == page) {
+			tail = next;
+			cnt++;
+			next = get_freepointer(s, tail);
+		}
+
+		__slab_free(s, page, object, tail, cnt, _RET_IP_);
+		object = next;
+	}
+}
+
+static bool defer_remote_free(struct kmem_cache *s, struct page *page,
+			      void *object)
+{
+	struct kmem_cache_cpu *c;
+	unsigned long flags;
+
+	/* Debug caches want consistency checks done at free time */
+	if (kmem_cache_debug(s))
+		return false;
+
+	if (page_to_nid(page) == numa_mem_id())
+		return false;
+
+	local_irq_save(flags);
+	c = this_cpu_ptr(s->cpu_slab);
+	set_freepointer(s, object, c->remote_free);
+	c->remote_free = object;
+	if (++c->nr_remote_free >= SLUB_REMOTE_FREE_BATCH)
+		drain_remote_frees(s, c);
+	local_irq_restore(flags);
+
+	return true;
+}
+#else /* CONFIG_NUMA */
+static void drain_remote_frees(struct kmem_cache *s, struct kmem_cache_cpu *c)
+{
+}
+
+static inline bool defer_remote_free(struct kmem_cache *s, struct page *page,
+				     void *object)
+{
+	return false;
+}
+#endif /* CONFIG_NUMA */
+
 /*
  * Fastpath with forced inlining to produce a kfree and kmem_cache_free that
  * can perform fastpath freeing without additional function calls.
@@ -3018,9 +3107,11 @@ redo:
 			goto redo;
 		}
 		stat(s, FREE_FASTPATH);
-	} else
+	} else {
+		if (cnt == 1 && defer_remote_free(s, page, head))
+			return;
 		__slab_free(s, page, head, tail_obj, cnt, addr);
-
+	}
 }
 
 static __always_inline void slab_free(struct kmem_cache *s, struct page *page,
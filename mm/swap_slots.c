@@ -32,6 +32,7 @@
 #include <linux/cpumask.h>
 #include <linux/vmalloc.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 #include <linux/mm.h>
 
 static DEFINE_PER_CPU(struct swap_slots_cache, swp_slots);
@@ -66,6 +67,27 @@ static void reactivate_swap_slots_cache(void)
 	mutex_unlock(&swap_slots_cache_mutex);
 }
 
+static void drain_slots_cache_ret_workfn(struct work_struct *work)
+{
+	mutex_lock(&swap_slots_cache_mutex);
+	__drain_swap_slots_cache(SLOTS_CACHE_RET);
+	mutex_unlock(&swap_slots_cache_mutex);
+}
+
+static DECLARE_WORK(drain_slots_cache_ret_work, drain_slots_cache_ret_workfn);
+
+/*
+ * Called when a swap device has run out of free clusters.  The slots
+ * parked in the per cpu caches of returned slots are still marked in
+ * use in the global pool; flushing them back lets whole clusters
+ * coalesce and become available for allocation again.
+ */
+void kick_swap_slots_cache_drain(void)
+{
+	if (swap_slot_cache_initialized)
+		schedule_work(&drain_slots_cache_ret_work);
+}
+
 /* Must not be called with cpu hot plug lock */
 void disable_swap_slots_cache_lock(void)
 {
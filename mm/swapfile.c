@@ -265,6 +265,14 @@ static void discard_swap_cluster(struct swap_info_struct *si,
 #endif
 #define LATENCY_LIMIT		256
 
+/*
+ * Hold a few free clusters back from order-0 allocations so that huge page
+ * swapout does not have to fall back to splitting the moment the device
+ * becomes fragmented.  Order-0 allocations switch to filling holes in
+ * partially used clusters instead once only the reserve is left.
+ */
+#define SWAP_HUGE_CLUSTER_RESERVE	(IS_ENABLED(CONFIG_THP_SWAP) ? 4 : 0)
+
 static inline void cluster_set_flag(struct swap_cluster_info *info,
 	unsigned int flag)
 {
@@ -460,6 +468,7 @@ static void __free_cluster(struct swap_info_struct *si, unsigned long idx)
 
 	cluster_set_flag(ci + idx, CLUSTER_FLAG_FREE);
 	cluster_list_add_tail(&si->free_clusters, ci, idx);
+	si->free_cluster_nr++;
 }
 
 /*
@@ -505,7 +514,9 @@ static void alloc_cluster(struct swap_info_struct *si, unsigned long idx)
 	struct swap_cluster_info *ci = si->cluster_info;
 
 	VM_BUG_ON(cluster_list_first(&si->free_clusters) != idx);
+	VM_BUG_ON(!si->free_cluster_nr);
 	cluster_list_del_first(&si->free_clusters, ci);
+	si->free_cluster_nr--;
 	cluster_set_count_flag(ci + idx, 0, 0);
 }
 
@@ -607,7 +618,7 @@ static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 new_cluster:
 	cluster = this_cpu_ptr(si->percpu_cluster);
 	if (cluster_is_null(&cluster->index)) {
-		if (!cluster_list_empty(&si->free_clusters)) {
+		if (si->free_cluster_nr > SWAP_HUGE_CLUSTER_RESERVE) {
 			cluster->index = si->free_clusters.head;
 			cluster->next = cluster_next(&cluster->index) *
 					SWAPFILE_CLUSTER;
@@ -619,8 +630,17 @@ new_cluster:
 			swap_do_scheduled_discard(si);
 			*scan_base = *offset = si->cluster_next;
 			goto new_cluster;
-		} else
+		} else {
+			/*
+			 * Free clusters are exhausted (or held back for huge
+			 * page swapout).  Slots parked in the per-cpu return
+			 * caches may coalesce into whole free clusters, so
+			 * get them flushed back while we fall back to filling
+			 * holes in partially used clusters.
+			 */
+			kick_swap_slots_cache_drain();
 			return false;
+		}
 	}
 
 	found_free = false;
@@ -740,8 +760,8 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 	int latency_ration = LATENCY_LIMIT;
 	int n_ret = 0;
 
-	if (nr > SWAP_BATCH)
-		nr = SWAP_BATCH;
+	if (nr > SWAP_SLOTS_CACHE_SIZE)
+		nr = SWAP_SLOTS_CACHE_SIZE;
 
 	/*
 	 * We try to cluster swap pages by allocating them sequentially
@@ -1004,8 +1024,8 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 	if (avail_pgs <= 0)
 		goto noswap;
 
-	if (n_goal > SWAP_BATCH)
-		n_goal = SWAP_BATCH;
+	if (n_goal > SWAP_SLOTS_CACHE_SIZE)
+		n_goal = SWAP_SLOTS_CACHE_SIZE;
 
 	if (n_goal > avail_pgs)
 		n_goal = avail_pgs;
@@ -3025,6 +3045,7 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 
 	cluster_list_init(&p->free_clusters);
 	cluster_list_init(&p->discard_clusters);
+	p->free_cluster_nr = 0;
 
 	for (i = 0; i < swap_header->info.nr_badpages; i++) {
 		unsigned int page_nr = swap_header->info.badpages[i];
@@ -3083,6 +3104,7 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 			cluster_set_flag(&cluster_info[idx], CLUSTER_FLAG_FREE);
 			cluster_list_add_tail(&p->free_clusters, cluster_info,
 					      idx);
+			p->free_cluster_nr++;
 		}
 	}
 	return nr_extents;
@@ -3449,9 +3471,12 @@ out:
  * Help swapoff by noting that swap entry belongs to shmem/tmpfs
  * (in which case its reference count is never incremented).
  */
-void swap_shmem_alloc(swp_entry_t entry)
+void swap_shmem_alloc(swp_entry_t entry, int nr)
 {
-	__swap_duplicate(entry, SWAP_MAP_SHMEM);
+	while (nr--) {
+		__swap_duplicate(entry, SWAP_MAP_SHMEM);
+		entry.val++;
+	}
 }
 
 /*
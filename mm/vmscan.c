@@ -164,6 +164,16 @@ struct scan_control {
  * From 0 .. 100.  Higher means more swappy.
  */
 int vm_swappiness = 60;
+
+/*
+ * Multi-generational aging mode.  When enabled, anonymous pages must be
+ * referenced in two reclaim passes before activation, like file pages,
+ * and pages that already survived a full evict/refault cycle
+ * (PG_workingset) activate on their first observed reference.  Eviction
+ * order then follows observed access recency rather than the page's
+ * backing type.
+ */
+int vm_multigen_aging __read_mostly;
 /*
  * The total number of pages which are beyond the high watermark within all
  * zones.
@@ -996,7 +1006,7 @@ static enum page_references page_check_references(struct page *page,
 		return PAGEREF_RECLAIM;
 
 	if (referenced_ptes) {
-		if (PageSwapBacked(page))
+		if (PageSwapBacked(page) && !vm_multigen_aging)
 			return PAGEREF_ACTIVATE;
 		/*
 		 * All mapped pages start out with page table
@@ -1023,6 +1033,14 @@ static enum page_references page_check_references(struct page *page,
 		if (vm_flags & VM_EXEC)
 			return PAGEREF_ACTIVATE;
 
+		/*
+		 * A page that was evicted and refaulted has proven itself
+		 * across generations; in multi-generational aging mode it
+		 * does not need to be seen twice again.
+		 */
+		if (vm_multigen_aging && PageWorkingset(page))
+			return PAGEREF_ACTIVATE;
+
 		return PAGEREF_KEEP;
 	}
 
@@ -1273,8 +1291,16 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 				mapping = page_mapping(page);
 			}
 		} else if (unlikely(PageTransHuge(page))) {
-			/* Split file THP */
-			if (split_huge_page_to_list(page, page_list))
+			/*
+			 * Split file THP.  Shmem huge pages are left whole
+			 * when THP swap is available so that
+			 * shmem_writepage() can write them out as one swap
+			 * cluster; it splits the page itself if no cluster
+			 * can be allocated.
+			 */
+			if ((!IS_ENABLED(CONFIG_THP_SWAP) ||
+			     !PageSwapBacked(page)) &&
+			    split_huge_page_to_list(page, page_list))
 				goto keep_locked;
 		}
 
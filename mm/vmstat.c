@@ -167,6 +167,20 @@ EXPORT_SYMBOL(vm_zone_stat);
 EXPORT_SYMBOL(vm_numa_stat);
 EXPORT_SYMBOL(vm_node_stat);
 
+/*
+ * A cpu marks itself dirty whenever it modifies one of its vmstat
+ * differentials and clears the flag when folding them back into the
+ * global counters.  This lets the shepherd and on-demand readers find
+ * the cpus with pending deltas with a single flag read per cpu instead
+ * of scanning every zone's differentials of every cpu.
+ */
+static DEFINE_PER_CPU(bool, vmstat_dirty);
+
+static inline void vmstat_mark_dirty(void)
+{
+	this_cpu_write(vmstat_dirty, true);
+}
+
 #ifdef CONFIG_SMP
 
 int calculate_pressure_threshold(struct zone *zone)
@@ -196,6 +210,7 @@ int calculate_pressure_threshold(struct zone *zone)
 int calculate_normal_threshold(struct zone *zone)
 {
 	int threshold;
+	int nr_cpus;
 	int mem;	/* memory in 128 MB units */
 
 	/*
@@ -230,7 +245,19 @@ int calculate_normal_threshold(struct zone *zone)
 
 	mem = zone_managed_pages(zone) >> (27 - PAGE_SHIFT);
 
-	threshold = 2 * fls(num_online_cpus()) * (1 + fls(mem));
+	/*
+	 * Most updates of a zone's counters come from cpus on the zone's
+	 * own node, so scale with the node's cpu count rather than the
+	 * machine's.  This keeps the thresholds - and thus the staleness
+	 * seen by /proc/vmstat readers - from growing with the total cpu
+	 * count on large NUMA systems.  Nodes without cpus (where all
+	 * updates are remote) fall back to the global count.
+	 */
+	nr_cpus = cpumask_weight(cpumask_of_node(zone_to_nid(zone)));
+	if (!nr_cpus)
+		nr_cpus = num_online_cpus();
+
+	threshold = 2 * fls(nr_cpus) * (1 + fls(mem));
 
 	/*
 	 * Maximum threshold is 125
@@ -330,6 +357,7 @@ void __mod_zone_page_state(struct zone *zone, enum zone_stat_item item,
 		x = 0;
 	}
 	__this_cpu_write(*p, x);
+	vmstat_mark_dirty();
 }
 EXPORT_SYMBOL(__mod_zone_page_state);
 
@@ -350,6 +378,7 @@ void __mod_node_page_state(struct pglist_data *pgdat, enum node_stat_item item,
 		x = 0;
 	}
 	__this_cpu_write(*p, x);
+	vmstat_mark_dirty();
 }
 EXPORT_SYMBOL(__mod_node_page_state);
 
@@ -390,6 +419,7 @@ void __inc_zone_state(struct zone *zone, enum zone_stat_item item)
 		zone_page_state_add(v + overstep, zone, item);
 		__this_cpu_write(*p, -overstep);
 	}
+	vmstat_mark_dirty();
 }
 
 void __inc_node_state(struct pglist_data *pgdat, enum node_stat_item item)
@@ -406,6 +436,7 @@ void __inc_node_state(struct pglist_data *pgdat, enum node_stat_item item)
 		node_page_state_add(v + overstep, pgdat, item);
 		__this_cpu_write(*p, -overstep);
 	}
+	vmstat_mark_dirty();
 }
 
 void __inc_zone_page_state(struct page *page, enum zone_stat_item item)
@@ -434,6 +465,7 @@ void __dec_zone_state(struct zone *zone, enum zone_stat_item item)
 		zone_page_state_add(v - overstep, zone, item);
 		__this_cpu_write(*p, overstep);
 	}
+	vmstat_mark_dirty();
 }
 
 void __dec_node_state(struct pglist_data *pgdat, enum node_stat_item item)
@@ -450,6 +482,7 @@ void __dec_node_state(struct pglist_data *pgdat, enum node_stat_item item)
 		node_page_state_add(v - overstep, pgdat, item);
 		__this_cpu_write(*p, overstep);
 	}
+	vmstat_mark_dirty();
 }
 
 void __dec_zone_page_state(struct page *page, enum zone_stat_item item)
@@ -510,6 +543,7 @@ static inline void mod_zone_state(struct zone *zone,
 			n = -os;
 		}
 	} while (this_cpu_cmpxchg(*p, o, n) != o);
+	vmstat_mark_dirty();
 
 	if (z)
 		zone_page_state_add(z, zone, item);
@@ -567,6 +601,7 @@ static inline void mod_node_state(struct pglist_data *pgdat,
 			n = -os;
 		}
 	} while (this_cpu_cmpxchg(*p, o, n) != o);
+	vmstat_mark_dirty();
 
 	if (z)
 		node_page_state_add(z, pgdat, item);
@@ -754,6 +789,12 @@ static int refresh_cpu_vm_stats(bool do_pagesets)
 	int global_node_diff[NR_VM_NODE_STAT_ITEMS] = { 0, };
 	int changes = 0;
 
+	/*
+	 * Clear the dirty flag before folding so that updates racing
+	 * with the fold re-mark the cpu rather than getting lost.
+	 */
+	this_cpu_write(vmstat_dirty, false);
+
 	for_each_populated_zone(zone) {
 		struct per_cpu_pageset __percpu *p = zone->pageset;
 
@@ -855,6 +896,8 @@ void cpu_vm_stats_fold(int cpu)
 #endif
 	int global_node_diff[NR_VM_NODE_STAT_ITEMS] = { 0, };
 
+	per_cpu(vmstat_dirty, cpu) = false;
+
 	for_each_populated_zone(zone) {
 		struct per_cpu_pageset *p;
 
@@ -949,6 +992,7 @@ void __inc_numa_state(struct zone *zone,
 		zone_numa_state_add(v, zone, item);
 		__this_cpu_write(*p, 0);
 	}
+	vmstat_mark_dirty();
 }
 
 /*
@@ -1074,6 +1118,24 @@ static int __fragmentation_index(unsigned int order, struct contig_page_info *in
 	return 1000 - div_u64( (1000+(div_u64(info->free_pages * 1000ULL, requested))), info->free_blocks_total);
 }
 
+/*
+ * Calculates external fragmentation within a zone wrt the given order.
+ * It is defined as the percentage of pages found in blocks of size
+ * less than 1 << order. It returns values in range [0, 100].
+ */
+unsigned int extfrag_for_order(struct zone *zone, unsigned int order)
+{
+	struct contig_page_info info;
+
+	fill_contig_page_info(zone, order, &info);
+	if (info.free_pages == 0)
+		return 0;
+
+	return div_u64((info.free_pages -
+			(info.free_blocks_suitable << order)) * 100,
+			info.free_pages);
+}
+
 /* Same as __fragmentation index but allocs contig_page_info on stack */
 int fragmentation_index(struct zone *zone, unsigned int order)
 {
@@ -1745,6 +1807,40 @@ static void refresh_vm_stats(struct work_struct *work)
 	refresh_cpu_vm_stats(true);
 }
 
+/*
+ * Like schedule_on_each_cpu(refresh_vm_stats), but skips the cpus that
+ * have no pending differentials, so an on-demand refresh only disturbs
+ * the cpus that actually hold deltas.
+ */
+static int refresh_vm_stats_on_dirty_cpus(void)
+{
+	struct work_struct __percpu *works;
+	int cpu;
+
+	works = alloc_percpu(struct work_struct);
+	if (!works)
+		return -ENOMEM;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		struct work_struct *work = per_cpu_ptr(works, cpu);
+
+		if (!need_update(cpu))
+			continue;
+		INIT_WORK(work, refresh_vm_stats);
+		schedule_work_on(cpu, work);
+	}
+	for_each_online_cpu(cpu) {
+		struct work_struct *work = per_cpu_ptr(works, cpu);
+
+		if (work->func)
+			flush_work(work);
+	}
+	put_online_cpus();
+	free_percpu(works);
+	return 0;
+}
+
 int vmstat_refresh(struct ctl_table *table, int write,
 		   void __user *buffer, size_t *lenp, loff_t *ppos)
 {
@@ -1764,7 +1860,7 @@ int vmstat_refresh(struct ctl_table *table, int write,
 	 * transiently negative values, report an error here if any of
 	 * the stats is negative, so we know to go looking for imbalance.
 	 */
-	err = schedule_on_each_cpu(refresh_vm_stats);
+	err = refresh_vm_stats_on_dirty_cpus();
 	if (err)
 		return err;
 	for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++) {
@@ -1820,29 +1916,7 @@ static void vmstat_update(struct work_struct *w)
  */
 static bool need_update(int cpu)
 {
-	struct zone *zone;
-
-	for_each_populated_zone(zone) {
-		struct per_cpu_pageset *p = per_cpu_ptr(zone->pageset, cpu);
-
-		BUILD_BUG_ON(sizeof(p->vm_stat_diff[0]) != 1);
-#ifdef CONFIG_NUMA
-		BUILD_BUG_ON(sizeof(p->vm_numa_stat_diff[0]) != 2);
-#endif
-
-		/*
-		 * The fast way of checking if there are any vmstat diffs.
-		 */
-		if (memchr_inv(p->vm_stat_diff, 0, NR_VM_ZONE_STAT_ITEMS *
-			       sizeof(p->vm_stat_diff[0])))
-			return true;
-#ifdef CONFIG_NUMA
-		if (memchr_inv(p->vm_numa_stat_diff, 0, NR_VM_NUMA_STAT_ITEMS *
-			       sizeof(p->vm_numa_stat_diff[0])))
-			return true;
-#endif
-	}
-	return false;
+	return READ_ONCE(per_cpu(vmstat_dirty, cpu));
 }
 
 /*
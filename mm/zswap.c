@@ -177,17 +177,33 @@ struct zswap_header {
 };
 
 /*
- * The tree lock in the zswap_tree struct protects a few things:
- * - the rbtree
- * - the refcount field of each entry in the tree
+ * The shard lock protects a few things:
+ * - the rbtree of the shard
+ * - the refcount field of each entry in it
+ *
+ * Each swap tree is split into shards, indexed by the low bits of the
+ * swap offset, so concurrent stores and loads spread over several locks
+ * instead of serializing on one per swap device.
  */
-struct zswap_tree {
+#define ZSWAP_NR_SHARDS	16
+
+struct zswap_shard {
 	struct rb_root rbroot;
 	spinlock_t lock;
 };
 
+struct zswap_tree {
+	struct zswap_shard shards[ZSWAP_NR_SHARDS];
+};
+
 static struct zswap_tree *zswap_trees[MAX_SWAPFILES];
 
+static struct zswap_shard *zswap_tree_shard(struct zswap_tree *tree,
+					    pgoff_t offset)
+{
+	return &tree->shards[offset & (ZSWAP_NR_SHARDS - 1)];
+}
+
 /* RCU-protected iteration */
 static LIST_HEAD(zswap_pools);
 /* protects zswap_pools list modification */
@@ -352,28 +368,28 @@ static void zswap_free_entry(struct zswap_entry *entry)
 	zswap_update_total_size();
 }
 
-/* caller must hold the tree lock */
+/* caller must hold the shard lock */
 static void zswap_entry_get(struct zswap_entry *entry)
 {
 	entry->refcount++;
 }
 
-/* caller must hold the tree lock
+/* caller must hold the shard lock
 * remove from the tree and free it, if nobody reference the entry
 */
-static void zswap_entry_put(struct zswap_tree *tree,
+static void zswap_entry_put(struct zswap_shard *shard,
 			struct zswap_entry *entry)
 {
 	int refcount = --entry->refcount;
 
 	BUG_ON(refcount < 0);
 	if (refcount == 0) {
-		zswap_rb_erase(&tree->rbroot, entry);
+		zswap_rb_erase(&shard->rbroot, entry);
 		zswap_free_entry(entry);
 	}
 }
 
-/* caller must hold the tree lock */
+/* caller must hold the shard lock */
 static struct zswap_entry *zswap_entry_find_get(struct rb_root *root,
 				pgoff_t offset)
 {
@@ -872,7 +888,7 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 {
 	struct zswap_header *zhdr;
 	swp_entry_t swpentry;
-	struct zswap_tree *tree;
+	struct zswap_shard *shard;
 	pgoff_t offset;
 	struct zswap_entry *entry;
 	struct page *page;
@@ -887,19 +903,19 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	/* extract swpentry from data */
 	zhdr = zpool_map_handle(pool, handle, ZPOOL_MM_RO);
 	swpentry = zhdr->swpentry; /* here */
-	tree = zswap_trees[swp_type(swpentry)];
 	offset = swp_offset(swpentry);
+	shard = zswap_tree_shard(zswap_trees[swp_type(swpentry)], offset);
 
 	/* find and ref zswap entry */
-	spin_lock(&tree->lock);
-	entry = zswap_entry_find_get(&tree->rbroot, offset);
+	spin_lock(&shard->lock);
+	entry = zswap_entry_find_get(&shard->rbroot, offset);
 	if (!entry) {
 		/* entry was invalidated */
-		spin_unlock(&tree->lock);
+		spin_unlock(&shard->lock);
 		zpool_unmap_handle(pool, handle);
 		return 0;
 	}
-	spin_unlock(&tree->lock);
+	spin_unlock(&shard->lock);
 	BUG_ON(offset != entry->offset);
 
 	/* try to allocate swap cache page */
@@ -939,9 +955,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	put_page(page);
 	zswap_written_back_pages++;
 
-	spin_lock(&tree->lock);
+	spin_lock(&shard->lock);
 	/* drop local reference */
-	zswap_entry_put(tree, entry);
+	zswap_entry_put(shard, entry);
 
 	/*
 	* There are two possible situations for entry here:
@@ -950,9 +966,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	*     because invalidate happened during writeback
 	*  search the tree and free the entry if find entry
 	*/
-	if (entry == zswap_rb_search(&tree->rbroot, offset))
-		zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	if (entry == zswap_rb_search(&shard->rbroot, offset))
+		zswap_entry_put(shard, entry);
+	spin_unlock(&shard->lock);
 
 	goto end;
 
@@ -964,9 +980,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	* it it either okay to return !0
 	*/
 fail:
-	spin_lock(&tree->lock);
-	zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	spin_lock(&shard->lock);
+	zswap_entry_put(shard, entry);
+	spin_unlock(&shard->lock);
 
 end:
 	zpool_unmap_handle(pool, handle);
@@ -975,15 +991,23 @@ end:
 
 static int zswap_is_page_same_filled(void *ptr, unsigned long *value)
 {
-	unsigned int pos;
-	unsigned long *page;
+	unsigned long *page = (unsigned long *)ptr;
+	unsigned long val = page[0];
+	unsigned int pos, last = PAGE_SIZE / sizeof(*page) - 1;
 
-	page = (unsigned long *)ptr;
-	for (pos = 1; pos < PAGE_SIZE / sizeof(*page); pos++) {
-		if (page[pos] != page[0])
+	/*
+	 * Most pages that are not same-filled differ somewhere in their
+	 * tail, so probing the last and middle words first rejects them
+	 * without scanning the whole page.
+	 */
+	if (page[last] != val || page[last / 2] != val)
+		return 0;
+
+	for (pos = 1; pos < last; pos++) {
+		if (page[pos] != val)
 			return 0;
 	}
-	*value = page[0];
+	*value = val;
 	return 1;
 }
 
@@ -1004,6 +1028,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry, *dupentry;
+	struct zswap_shard *shard;
 	struct crypto_comp *tfm;
 	int ret;
 	unsigned int hlen, dlen = PAGE_SIZE;
@@ -1112,17 +1137,18 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 
 insert_entry:
 	/* map */
-	spin_lock(&tree->lock);
+	shard = zswap_tree_shard(tree, offset);
+	spin_lock(&shard->lock);
 	do {
-		ret = zswap_rb_insert(&tree->rbroot, entry, &dupentry);
+		ret = zswap_rb_insert(&shard->rbroot, entry, &dupentry);
 		if (ret == -EEXIST) {
 			zswap_duplicate_entry++;
 			/* remove from rbtree */
-			zswap_rb_erase(&tree->rbroot, dupentry);
-			zswap_entry_put(tree, dupentry);
+			zswap_rb_erase(&shard->rbroot, dupentry);
+			zswap_entry_put(shard, dupentry);
 		}
 	} while (ret == -EEXIST);
-	spin_unlock(&tree->lock);
+	spin_unlock(&shard->lock);
 
 	/* update stats */
 	atomic_inc(&zswap_stored_pages);
@@ -1146,7 +1172,7 @@ reject:
 static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 				struct page *page)
 {
-	struct zswap_tree *tree = zswap_trees[type];
+	struct zswap_shard *shard = zswap_tree_shard(zswap_trees[type], offset);
 	struct zswap_entry *entry;
 	struct crypto_comp *tfm;
 	u8 *src, *dst;
@@ -1154,14 +1180,14 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	int ret;
 
 	/* find */
-	spin_lock(&tree->lock);
-	entry = zswap_entry_find_get(&tree->rbroot, offset);
+	spin_lock(&shard->lock);
+	entry = zswap_entry_find_get(&shard->rbroot, offset);
 	if (!entry) {
 		/* entry was written back */
-		spin_unlock(&tree->lock);
+		spin_unlock(&shard->lock);
 		return -1;
 	}
-	spin_unlock(&tree->lock);
+	spin_unlock(&shard->lock);
 
 	if (!entry->length) {
 		dst = kmap_atomic(page);
@@ -1184,9 +1210,9 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	BUG_ON(ret);
 
 freeentry:
-	spin_lock(&tree->lock);
-	zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	spin_lock(&shard->lock);
+	zswap_entry_put(shard, entry);
+	spin_unlock(&shard->lock);
 
 	return 0;
 }
@@ -1194,25 +1220,25 @@ freeentry:
 /* frees an entry in zswap */
 static void zswap_frontswap_invalidate_page(unsigned type, pgoff_t offset)
 {
-	struct zswap_tree *tree = zswap_trees[type];
+	struct zswap_shard *shard = zswap_tree_shard(zswap_trees[type], offset);
 	struct zswap_entry *entry;
 
 	/* find */
-	spin_lock(&tree->lock);
-	entry = zswap_rb_search(&tree->rbroot, offset);
+	spin_lock(&shard->lock);
+	entry = zswap_rb_search(&shard->rbroot, offset);
 	if (!entry) {
 		/* entry was written back */
-		spin_unlock(&tree->lock);
+		spin_unlock(&shard->lock);
 		return;
 	}
 
 	/* remove from rbtree */
-	zswap_rb_erase(&tree->rbroot, entry);
+	zswap_rb_erase(&shard->rbroot, entry);
 
 	/* drop the initial reference from entry creation */
-	zswap_entry_put(tree, entry);
+	zswap_entry_put(shard, entry);
 
-	spin_unlock(&tree->lock);
+	spin_unlock(&shard->lock);
 }
 
 /* frees all zswap entries for the given swap type */
@@ -1220,16 +1246,22 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry, *n;
+	int i;
 
 	if (!tree)
 		return;
 
-	/* walk the tree and free everything */
-	spin_lock(&tree->lock);
-	rbtree_postorder_for_each_entry_safe(entry, n, &tree->rbroot, rbnode)
-		zswap_free_entry(entry);
-	tree->rbroot = RB_ROOT;
-	spin_unlock(&tree->lock);
+	/* walk each shard and free everything */
+	for (i = 0; i < ZSWAP_NR_SHARDS; i++) {
+		struct zswap_shard *shard = &tree->shards[i];
+
+		spin_lock(&shard->lock);
+		rbtree_postorder_for_each_entry_safe(entry, n, &shard->rbroot,
+						     rbnode)
+			zswap_free_entry(entry);
+		shard->rbroot = RB_ROOT;
+		spin_unlock(&shard->lock);
+	}
 	kfree(tree);
 	zswap_trees[type] = NULL;
 }
@@ -1237,6 +1269,7 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 static void zswap_frontswap_init(unsigned type)
 {
 	struct zswap_tree *tree;
+	int i;
 
 	tree = kzalloc(sizeof(*tree), GFP_KERNEL);
 	if (!tree) {
@@ -1244,8 +1277,10 @@ static void zswap_frontswap_init(unsigned type)
 		return;
 	}
 
-	tree->rbroot = RB_ROOT;
-	spin_lock_init(&tree->lock);
+	for (i = 0; i < ZSWAP_NR_SHARDS; i++) {
+		tree->shards[i].rbroot = RB_ROOT;
+		spin_lock_init(&tree->shards[i].lock);
+	}
 	zswap_trees[type] = tree;
 }
 
@@ -253,6 +253,7 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 	int err;
 	int in, out, out_sgs, in_sgs;
 	unsigned long flags;
+	bool kick;
 	struct virtio_chan *chan = client->trans;
 	struct scatterlist *sgs[2];
 
@@ -294,8 +295,16 @@ req_retry:
 			return -EIO;
 		}
 	}
-	virtqueue_kick(chan->vq);
+	/*
+	 * Notify the host outside the lock: with event index enabled
+	 * the prepare step returns false while the host is still
+	 * processing, so back-to-back submissions collapse into one
+	 * notification per batch instead of one costly exit each.
+	 */
+	kick = virtqueue_kick_prepare(chan->vq);
 	spin_unlock_irqrestore(&chan->lock, flags);
+	if (kick)
+		virtqueue_notify(chan->vq);
 
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	return 0;
@@ -390,6 +399,7 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 {
 	int in, out, err, out_sgs, in_sgs;
 	unsigned long flags;
+	bool kick;
 	int in_nr_pages = 0, out_nr_pages = 0;
 	struct page **in_pages = NULL, **out_pages = NULL;
 	struct virtio_chan *chan = client->trans;
@@ -493,8 +503,11 @@ req_retry_pinned:
 			goto err_out;
 		}
 	}
-	virtqueue_kick(chan->vq);
+	/* See p9_virtio_request(): notify the host outside the lock */
+	kick = virtqueue_kick_prepare(chan->vq);
 	spin_unlock_irqrestore(&chan->lock, flags);
+	if (kick)
+		virtqueue_notify(chan->vq);
 	kicked = 1;
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	err = wait_event_killable(req->wq, req->status >= REQ_STATUS_RCVD);
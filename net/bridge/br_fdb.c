@@ -334,6 +334,14 @@ out:
 	spin_unlock_bh(&br->hash_lock);
 }
 
+/* how many expired entries we delete per hash_lock acquisition; keeps
+ * the bh-off hold time short so learning isn't starved during mass
+ * expiry, without paying a lock round-trip per entry
+ */
+#define BR_FDB_CLEANUP_BATCH	16
+/* deletions allowed per gc_work run; leftovers age out on the next run */
+#define BR_FDB_CLEANUP_QUOTA	1024
+
 void br_fdb_cleanup(struct work_struct *work)
 {
 	struct net_bridge *br = container_of(work, struct net_bridge,
@@ -342,6 +350,8 @@ void br_fdb_cleanup(struct work_struct *work)
 	unsigned long delay = hold_time(br);
 	unsigned long work_delay = delay;
 	unsigned long now = jiffies;
+	int quota = BR_FDB_CLEANUP_QUOTA;
+	int batch = 0, scanned = 0;
 
 	/* this part is tricky, in order to avoid blocking learning and
 	 * consequently forwarding, we rely on rcu to delete objects with
@@ -351,19 +361,42 @@ void br_fdb_cleanup(struct work_struct *work)
 	hlist_for_each_entry_rcu(f, &br->fdb_list, fdb_node) {
 		unsigned long this_timer;
 
+		/* Don't sit on the lock across a long run of entries that
+		 * need no work; learning is blocked for as long as it is
+		 * held, so close an open batch after a bounded number of
+		 * scanned entries no matter how many were deleted.
+		 */
+		if (batch && ++scanned >= BR_FDB_CLEANUP_BATCH) {
+			spin_unlock_bh(&br->hash_lock);
+			batch = 0;
+		}
+
 		if (test_bit(BR_FDB_STATIC, &f->flags) ||
 		    test_bit(BR_FDB_ADDED_BY_EXT_LEARN, &f->flags))
 			continue;
-		this_timer = f->updated + delay;
+		this_timer = READ_ONCE(f->updated) + delay;
 		if (time_after(this_timer, now)) {
 			work_delay = min(work_delay, this_timer - now);
 		} else {
-			spin_lock_bh(&br->hash_lock);
+			if (!batch) {
+				spin_lock_bh(&br->hash_lock);
+				scanned = 0;
+			}
 			if (!hlist_unhashed(&f->fdb_node))
 				fdb_delete(br, f, true);
-			spin_unlock_bh(&br->hash_lock);
+			if (++batch == BR_FDB_CLEANUP_BATCH) {
+				spin_unlock_bh(&br->hash_lock);
+				batch = 0;
+			}
+			if (!--quota) {
+				/* finish aging the rest next run */
+				work_delay = 0;
+				break;
+			}
 		}
 	}
+	if (batch)
+		spin_unlock_bh(&br->hash_lock);
 	rcu_read_unlock();
 
 	/* Cleanup minimum 10 milliseconds apart */
@@ -588,7 +621,7 @@ void br_fdb_update(struct net_bridge *br, struct net_bridge_port *source,
 						  &fdb->flags);
 			}
 			if (now != fdb->updated)
-				fdb->updated = now;
+				WRITE_ONCE(fdb->updated, now);
 			if (unlikely(test_bit(BR_FDB_ADDED_BY_USER, &flags)))
 				set_bit(BR_FDB_ADDED_BY_USER, &fdb->flags);
 			if (unlikely(fdb_modified)) {
@@ -176,14 +176,39 @@ static void page_pool_dma_sync_for_device(struct page_pool *pool,
 					 pool->p.dma_dir);
 }
 
+static bool page_pool_dma_map(struct page_pool *pool, struct page *page)
+{
+	dma_addr_t dma;
+
+	/* Setup DMA mapping: use 'struct page' area for storing DMA-addr
+	 * since dma_addr_t can be either 32 or 64 bits and does not always fit
+	 * into page private data (i.e 32bit cpu with 64bit DMA caps)
+	 * This mapping is kept for lifetime of page, until leaving pool.
+	 */
+	dma = dma_map_page_attrs(pool->p.dev, page, 0,
+				 (PAGE_SIZE << pool->p.order),
+				 pool->p.dma_dir, DMA_ATTR_SKIP_CPU_SYNC);
+	if (dma_mapping_error(pool->p.dev, dma))
+		return false;
+
+	page->dma_addr = dma;
+
+	if (pool->p.flags & PP_FLAG_DMA_SYNC_DEV)
+		page_pool_dma_sync_for_device(pool, page, pool->p.max_len);
+
+	return true;
+}
+
 /* slow path */
 noinline
 static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 						 gfp_t _gfp)
 {
+	const int bulk = PP_ALLOC_CACHE_REFILL;
+	unsigned long nr_pages;
 	struct page *page;
 	gfp_t gfp = _gfp;
-	dma_addr_t dma;
+	int i, nid;
 
 	/* We could always set __GFP_COMP, and avoid this branch, as
 	 * prep_new_page() can handle order-0 with __GFP_COMP.
@@ -191,43 +216,61 @@ static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 	if (pool->p.order)
 		gfp |= __GFP_COMP;
 
-	/* FUTURE development:
-	 *
-	 * Current slow-path essentially falls back to single page
-	 * allocations, which doesn't improve performance.  This code
-	 * need bulk allocation support from the page allocator code.
-	 */
-
-	/* Cache was empty, do real allocation */
 #ifdef CONFIG_NUMA
-	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
+	nid = pool->p.nid;
 #else
-	page = alloc_pages(gfp, pool->p.order);
+	nid = NUMA_NO_NODE;
 #endif
-	if (!page)
+
+	/* Cache was empty (caller guarantees non-concurrent access), so
+	 * order-0 pools can refill a whole batch with a single trip into
+	 * the page allocator instead of paying the zone and percpu-list
+	 * overhead once per page.
+	 */
+	if (!pool->p.order) {
+		/* Unused alloc.cache slots must be NULL for the bulk API */
+		memset(pool->alloc.cache, 0, sizeof(void *) * bulk);
+
+		nr_pages = alloc_pages_bulk_array_node(gfp, nid, bulk,
+						       pool->alloc.cache);
+		if (unlikely(!nr_pages))
+			return NULL;
+
+		/* Pages have been filled into alloc.cache array, but count
+		 * is zero and the pages are not yet DMA mapped.
+		 */
+		for (i = 0; i < nr_pages; i++) {
+			page = pool->alloc.cache[i];
+			if ((pool->p.flags & PP_FLAG_DMA_MAP) &&
+			    unlikely(!page_pool_dma_map(pool, page))) {
+				put_page(page);
+				continue;
+			}
+			pool->alloc.cache[pool->alloc.count++] = page;
+			/* Track how many pages are held 'in-flight' */
+			pool->pages_state_hold_cnt++;
+			trace_page_pool_state_hold(pool, page,
+						   pool->pages_state_hold_cnt);
+		}
+
+		/* Return last page */
+		if (likely(pool->alloc.count > 0))
+			return pool->alloc.cache[--pool->alloc.count];
+
 		return NULL;
+	}
 
-	if (!(pool->p.flags & PP_FLAG_DMA_MAP))
-		goto skip_dma_map;
+	/* Higher-order pools still do real single page allocations */
+	page = alloc_pages_node(nid, gfp, pool->p.order);
+	if (!page)
+		return NULL;
 
-	/* Setup DMA mapping: use 'struct page' area for storing DMA-addr
-	 * since dma_addr_t can be either 32 or 64 bits and does not always fit
-	 * into page private data (i.e 32bit cpu with 64bit DMA caps)
-	 * This mapping is kept for lifetime of page, until leaving pool.
-	 */
-	dma = dma_map_page_attrs(pool->p.dev, page, 0,
-				 (PAGE_SIZE << pool->p.order),
-				 pool->p.dma_dir, DMA_ATTR_SKIP_CPU_SYNC);
-	if (dma_mapping_error(pool->p.dev, dma)) {
+	if ((pool->p.flags & PP_FLAG_DMA_MAP) &&
+	    unlikely(!page_pool_dma_map(pool, page))) {
 		put_page(page);
 		return NULL;
 	}
-	page->dma_addr = dma;
-
-	if (pool->p.flags & PP_FLAG_DMA_SYNC_DEV)
-		page_pool_dma_sync_for_device(pool, page, pool->p.max_len);
 
-skip_dma_map:
 	/* Track how many pages are held 'in-flight' */
 	pool->pages_state_hold_cnt++;
 
@@ -324,8 +367,11 @@ static bool __page_pool_recycle_into_ring(struct page_pool *pool,
 				   struct page *page)
 {
 	int ret;
-	/* BH protection not needed if current is serving softirq */
-	if (in_serving_softirq())
+	/* BH protection not needed if current is softirq or has BHs off,
+	 * e.g. a threaded NAPI poller or a TX completion handler running
+	 * under local_bh_disable().
+	 */
+	if (in_softirq())
 		ret = ptr_ring_produce(&pool->ring, page);
 	else
 		ret = ptr_ring_produce_bh(&pool->ring, page);
@@ -374,7 +420,7 @@ void __page_pool_put_page(struct page_pool *pool, struct page *page,
 			page_pool_dma_sync_for_device(pool, page,
 						      dma_sync_size);
 
-		if (allow_direct && in_serving_softirq())
+		if (allow_direct && in_softirq())
 			if (__page_pool_recycle_direct(page, pool))
 				return;
 
@@ -712,6 +712,61 @@ bool sk_mc_loop(struct sock *sk)
 }
 EXPORT_SYMBOL(sk_mc_loop);
 
+/* Pre-charge @bytes (rounded up to pages) against the protocol memory pool
+ * and park them in sk_forward_alloc.  The reclaim helpers never give the
+ * reserved part back (see sk_unused_reserved_mem()), so send/receive paths
+ * staying within the reservation run on sk_forward_alloc alone and skip the
+ * shared memory_allocated atomics entirely.
+ */
+static int sock_reserve_memory(struct sock *sk, int bytes)
+{
+	long allocated;
+	bool charged;
+	int pages;
+
+	if (!sk_has_account(sk))
+		return -EOPNOTSUPP;
+	if (!bytes)
+		return 0;
+
+	pages = sk_mem_pages(bytes);
+	if ((u64)sk->sk_reserved_mem +
+	    ((u64)pages << SK_MEM_QUANTUM_SHIFT) > INT_MAX / 2)
+		return -EINVAL;
+
+	/* pre-charge to memcg */
+	charged = !mem_cgroup_sockets_enabled || !sk->sk_memcg ||
+		  mem_cgroup_charge_skmem(sk->sk_memcg, pages);
+	if (!charged)
+		return -ENOMEM;
+
+	/* pre-charge to the protocol memory pool */
+	allocated = sk_memory_allocated_add(sk, pages);
+	/* If the system is already under memory pressure with this
+	 * pre-charge accounted, give up and return an error.
+	 */
+	if (allocated > sk_prot_mem_limits(sk, 1)) {
+		sk_memory_allocated_sub(sk, pages);
+		if (mem_cgroup_sockets_enabled && sk->sk_memcg)
+			mem_cgroup_uncharge_skmem(sk->sk_memcg, pages);
+		return -ENOMEM;
+	}
+	sk->sk_forward_alloc += pages << SK_MEM_QUANTUM_SHIFT;
+	sk->sk_reserved_mem += pages << SK_MEM_QUANTUM_SHIFT;
+
+	return 0;
+}
+
+static void sock_release_reserved_memory(struct sock *sk, int bytes)
+{
+	/* Round down bytes to a multiple of pages */
+	bytes = round_down(bytes, SK_MEM_QUANTUM);
+
+	WARN_ON(bytes > sk->sk_reserved_mem);
+	sk->sk_reserved_mem -= bytes;
+	sk_mem_reclaim(sk);
+}
+
 /*
  *	This is meant for all protocols to use and covers goings on
  *	at the socket level. Everything here is generic.
@@ -1140,6 +1195,9 @@ set_rcvbuf:
 			      (sk->sk_type == SOCK_DGRAM &&
 			       sk->sk_protocol == IPPROTO_UDP)))
 				ret = -ENOTSUPP;
+		} else if (sk->sk_family == PF_UNIX) {
+			if (sk->sk_type != SOCK_STREAM)
+				ret = -ENOTSUPP;
 		} else if (sk->sk_family != PF_RDS) {
 			ret = -ENOTSUPP;
 		}
@@ -1175,6 +1233,23 @@ set_rcvbuf:
 		ret = sock_setbindtodevice_locked(sk, val);
 		break;
 
+	case SO_RESERVE_MEM:
+	{
+		int delta;
+
+		if (val < 0) {
+			ret = -EINVAL;
+			break;
+		}
+
+		delta = val - sk->sk_reserved_mem;
+		if (delta < 0)
+			sock_release_reserved_memory(sk, -delta);
+		else
+			ret = sock_reserve_memory(sk, delta);
+		break;
+	}
+
 	default:
 		ret = -ENOPROTOOPT;
 		break;
@@ -1525,6 +1600,10 @@ int sock_getsockopt(struct socket *sock, int level, int optname,
 		v.val = sk->sk_bound_dev_if;
 		break;
 
+	case SO_RESERVE_MEM:
+		v.val = sk->sk_reserved_mem;
+		break;
+
 	default:
 		/* We implement the SO_SNDLOWAT etc to not be settable
 		 * (1003.1g 7).
@@ -1691,6 +1770,12 @@ static void __sk_destruct(struct rcu_head *head)
 	struct sock *sk = container_of(head, struct sock, sk_rcu);
 	struct sk_filter *filter;
 
+	/* Return any outstanding %SO_RESERVE_MEM quota to the protocol pool
+	 * before the protocol destructor checks sk_forward_alloc for leaks.
+	 */
+	if (sk->sk_reserved_mem)
+		sock_release_reserved_memory(sk, sk->sk_reserved_mem);
+
 	if (sk->sk_destruct)
 		sk->sk_destruct(sk);
 
@@ -1824,6 +1909,7 @@ struct sock *sk_clone_lock(const struct sock *sk, const gfp_t priority)
 		newsk->sk_dst_pending_confirm = 0;
 		newsk->sk_wmem_queued	= 0;
 		newsk->sk_forward_alloc = 0;
+		newsk->sk_reserved_mem  = 0;
 		atomic_set(&newsk->sk_drops, 0);
 		newsk->sk_send_head	= NULL;
 		newsk->sk_userlocks	= sk->sk_userlocks & ~SOCK_BINDPORT_LOCK;
@@ -424,9 +424,12 @@ static inline bool rt_is_expired(const struct rtable *rth)
 	return rth->rt_genid != rt_genid_ipv4(dev_net(rth->dst.dev));
 }
 
+static void rt_input_cache_flush(struct net *net);
+
 void rt_cache_flush(struct net *net)
 {
 	rt_genid_bump_ipv4(net);
+	rt_input_cache_flush(net);
 }
 
 static struct neighbour *ipv4_neigh_lookup(const struct dst_entry *dst,
@@ -2282,15 +2285,156 @@ martian_source:
 	goto out;
 }
 
+/* Small per-CPU cache of recent input route decisions, keyed by the
+ * fields a FIB rule or route lookup may depend on.  Forwarding workloads
+ * with a concentrated flow mix hit here and skip the trie walk entirely.
+ *
+ * Each slot holds a reference on its rtable, so a hit never touches freed
+ * memory; validity is still rechecked with rt_cache_valid(), which fails
+ * as soon as the netns genid is bumped by any FIB change.  The flush run
+ * from rt_cache_flush() drops the cached references, and because
+ * netdev_wait_allrefs() replays NETDEV_UNREGISTER (and thus the flush)
+ * while waiting, a slot installed concurrently with a flush cannot pin a
+ * dying device for good.  Only the owning CPU writes the key fields (with
+ * BHs off, so a softirq cannot observe a half-written slot); remote
+ * flushers touch nothing but the rt pointer, via xchg().
+ */
+#define RT_INPUT_CACHE_SIZE	8
+
+struct rt_input_cache_entry {
+	__be32			daddr;
+	__be32			saddr;
+	u32			mark;
+	int			iif;
+	u8			tos;
+	struct net		*net;
+	struct rtable		*rt;
+};
+
+static DEFINE_PER_CPU(struct rt_input_cache_entry,
+		      rt_input_cache[RT_INPUT_CACHE_SIZE]);
+
+static unsigned int rt_input_cache_hash(__be32 daddr, __be32 saddr, u32 mark)
+{
+	return jhash_3words((__force u32)daddr, (__force u32)saddr, mark, 0) &
+	       (RT_INPUT_CACHE_SIZE - 1);
+}
+
+static void rt_input_cache_flush(struct net *net)
+{
+	struct rt_input_cache_entry *e;
+	struct rtable *rt;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < RT_INPUT_CACHE_SIZE; i++) {
+			e = &per_cpu(rt_input_cache[i], cpu);
+			if (READ_ONCE(e->net) != net)
+				continue;
+			rt = xchg(&e->rt, NULL);
+			if (rt)
+				dst_release(&rt->dst);
+		}
+	}
+}
+
+/* FIB rules can match on L4 proto/ports (fib4_rules_early_flow_dissect()),
+ * which are not part of the cache key; while any such rule is installed two
+ * flows sharing (saddr, daddr, tos, mark, iif) may resolve through
+ * different tables, so the cache must stand aside.  Entries cached before
+ * the rule showed up are already dead: rule changes run rt_cache_flush(),
+ * and rt_cache_valid() rejects them on the next hit.
+ */
+static bool rt_input_cache_usable(const struct net *net)
+{
+#ifdef CONFIG_IP_MULTIPLE_TABLES
+	return !net->ipv4.fib_rules_require_fldissect;
+#else
+	return true;
+#endif
+}
+
+static bool rt_input_cache_get(struct sk_buff *skb, __be32 daddr, __be32 saddr,
+			       u8 tos, struct net_device *dev)
+{
+	struct rt_input_cache_entry *e;
+	struct rtable *rt = NULL;
+
+	local_bh_disable();
+	e = this_cpu_ptr(&rt_input_cache[rt_input_cache_hash(daddr, saddr,
+							     skb->mark)]);
+	if (e->daddr == daddr && e->saddr == saddr && e->mark == skb->mark &&
+	    e->iif == dev->ifindex && e->tos == tos && e->net == dev_net(dev)) {
+		rt = READ_ONCE(e->rt);
+		if (rt && !rt_cache_valid(rt)) {
+			/* Stale: drop the slot's reference right away so it
+			 * cannot keep a dead route (and its device) around.
+			 */
+			rt = xchg(&e->rt, NULL);
+			if (rt)
+				dst_release(&rt->dst);
+			rt = NULL;
+		}
+	}
+	if (rt)
+		skb_dst_set_noref(skb, &rt->dst);
+	local_bh_enable();
+	return rt != NULL;
+}
+
+static void rt_input_cache_store(struct sk_buff *skb, __be32 daddr,
+				 __be32 saddr, u8 tos, struct net_device *dev,
+				 const struct fib_result *res)
+{
+	struct rtable *rt = skb_rtable(skb), *old;
+	struct rt_input_cache_entry *e;
+	struct fib_nh_common *nhc;
+
+	if (!rt || rt->rt_type != RTN_UNICAST || !rt->rt_is_input)
+		return;
+	/* Multipath selection hashes on per-packet data beyond our key, and
+	 * anything the nexthop itself would not cache (exceptions, itag) is
+	 * too short-lived or too special to pin here.
+	 */
+	if (!res->fi || fib_info_num_path(res->fi) > 1)
+		return;
+	nhc = FIB_RES_NHC(*res);
+	if (rt != rcu_dereference(nhc->nhc_rth_input))
+		return;
+	if (!dst_hold_safe(&rt->dst))
+		return;
+
+	local_bh_disable();
+	e = this_cpu_ptr(&rt_input_cache[rt_input_cache_hash(daddr, saddr,
+							     skb->mark)]);
+	e->daddr = daddr;
+	e->saddr = saddr;
+	e->mark = skb->mark;
+	e->iif = dev->ifindex;
+	e->tos = tos;
+	e->net = dev_net(dev);
+	old = xchg(&e->rt, rt);
+	local_bh_enable();
+	if (old)
+		dst_release(&old->dst);
+}
+
 int ip_route_input_noref(struct sk_buff *skb, __be32 daddr, __be32 saddr,
 			 u8 tos, struct net_device *dev)
 {
+	bool use_cache = rt_input_cache_usable(dev_net(dev));
 	struct fib_result res;
 	int err;
 
 	tos &= IPTOS_RT_MASK;
 	rcu_read_lock();
+	if (use_cache && rt_input_cache_get(skb, daddr, saddr, tos, dev)) {
+		rcu_read_unlock();
+		return 0;
+	}
 	err = ip_route_input_rcu(skb, daddr, saddr, tos, dev, &res);
+	if (!err && use_cache)
+		rt_input_cache_store(skb, daddr, saddr, tos, dev, &res);
 	rcu_read_unlock();
 
 	return err;
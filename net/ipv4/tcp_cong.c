@@ -197,6 +197,9 @@ static void tcp_reinit_congestion_control(struct sock *sk,
 	icsk->icsk_ca_setsockopt = 1;
 	memset(icsk->icsk_ca_priv, 0, sizeof(icsk->icsk_ca_priv));
 
+	/* The new ca_ops may size TSO bursts differently */
+	tcp_sk(sk)->tso_segs_cached = 0;
+
 	if (sk->sk_state != TCP_CLOSE)
 		tcp_init_congestion_control(sk);
 }
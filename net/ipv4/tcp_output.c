@@ -1808,18 +1808,35 @@ static u32 tcp_tso_autosize(const struct sock *sk, unsigned int mss_now,
 
 /* Return the number of segments we want in the skb we are transmitting.
  * See if congestion control module wants to decide; otherwise, autosize.
+ *
+ * The result only depends on the (shifted) pacing rate and the mss, so
+ * cache it: a socket sending at a stable rate re-derives the same value
+ * on every tcp_write_xmit() call otherwise.
  */
 static u32 tcp_tso_segs(struct sock *sk, unsigned int mss_now)
 {
 	const struct tcp_congestion_ops *ca_ops = inet_csk(sk)->icsk_ca_ops;
+	unsigned long rate = sk->sk_pacing_rate >> READ_ONCE(sk->sk_pacing_shift);
+	struct tcp_sock *tp = tcp_sk(sk);
 	u32 min_tso, tso_segs;
 
+	if (tp->tso_segs_cached &&
+	    tp->tso_rate_cached == rate &&
+	    tp->tso_mss_cached == mss_now)
+		return tp->tso_segs_cached;
+
 	min_tso = ca_ops->min_tso_segs ?
 			ca_ops->min_tso_segs(sk) :
 			sock_net(sk)->ipv4.sysctl_tcp_min_tso_segs;
 
 	tso_segs = tcp_tso_autosize(sk, mss_now, min_tso);
-	return min_t(u32, tso_segs, sk->sk_gso_max_segs);
+	tso_segs = min_t(u32, tso_segs, sk->sk_gso_max_segs);
+
+	tp->tso_rate_cached = rate;
+	tp->tso_mss_cached = mss_now;
+	tp->tso_segs_cached = tso_segs;
+
+	return tso_segs;
 }
 
 /* Returns the portion of skb which can be sent right away */
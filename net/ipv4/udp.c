@@ -439,6 +439,73 @@ static struct sock *udp4_lib_lookup2(struct net *net,
 	return result;
 }
 
+/* Per-CPU cache of the last connected socket returned by
+ * __udp4_lib_lookup().  A 4-tuple-stable flow (e.g. QUIC) otherwise
+ * walks and re-scores a hash2 chain for every datagram just to find
+ * the same socket again.
+ *
+ * The cache holds a bare pointer: UDP sockets are SOCK_RCU_FREE and
+ * always unhash before destruction, and udp_lib_unhash() evicts the
+ * socket from all CPUs, so a cached pointer can only be observed while
+ * its memory is guaranteed valid inside the caller's RCU section.
+ * Hits are validated against the socket's own addressing fields, never
+ * against a cached key, so a stale or torn entry can only cause a miss.
+ */
+static DEFINE_PER_CPU(struct sock *, udp4_lookup_cache);
+
+static bool udp4_cache_match(struct sock *sk, struct net *net,
+			     __be32 saddr, __be16 sport,
+			     __be32 daddr, unsigned short hnum,
+			     int dif, int sdif)
+{
+	struct inet_sock *inet = inet_sk(sk);
+
+	return sk->sk_state == TCP_ESTABLISHED &&
+	       sk->sk_family == PF_INET &&
+	       net_eq(sock_net(sk), net) &&
+	       inet->inet_num == hnum &&
+	       inet->inet_rcv_saddr == daddr &&
+	       inet->inet_daddr == saddr &&
+	       inet->inet_dport == sport &&
+	       udp_sk_bound_dev_eq(net, sk->sk_bound_dev_if, dif, sdif);
+}
+
+static void udp4_cache_store(struct sock *sk)
+{
+	struct sock **entry;
+
+	/* Only a connected, non-reuseport PF_INET socket is the unique
+	 * best match for its 4-tuple; anything else must keep taking the
+	 * scored lookup.
+	 */
+	if (sk->sk_state != TCP_ESTABLISHED || sk->sk_family != PF_INET ||
+	    sk->sk_reuseport)
+		return;
+
+	entry = get_cpu_ptr(&udp4_lookup_cache);
+	WRITE_ONCE(*entry, sk);
+	/* Pairs with the barrier in udp_lib_unhash(): either the unhash
+	 * scan observes our store, or we observe the socket gone from
+	 * the hash and back out, so no freed socket can linger here.
+	 */
+	smp_mb();
+	if (unlikely(!sk_hashed(sk)))
+		WRITE_ONCE(*entry, NULL);
+	put_cpu_ptr(&udp4_lookup_cache);
+}
+
+static void udp4_cache_evict(struct sock *sk)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct sock **entry = per_cpu_ptr(&udp4_lookup_cache, cpu);
+
+		if (READ_ONCE(*entry) == sk)
+			WRITE_ONCE(*entry, NULL);
+	}
+}
+
 /* UDP is nearly always wildcards out the wazoo, it makes no sense to try
  * harder than this. -DaveM
  */
@@ -451,6 +518,16 @@ struct sock *__udp4_lib_lookup(struct net *net, __be32 saddr,
 	unsigned int hash2, slot2;
 	struct udp_hslot *hslot2;
 
+	if (udptable == &udp_table) {
+		struct sock **entry = get_cpu_ptr(&udp4_lookup_cache);
+
+		result = READ_ONCE(*entry);
+		put_cpu_ptr(&udp4_lookup_cache);
+		if (result && udp4_cache_match(result, net, saddr, sport,
+					       daddr, hnum, dif, sdif))
+			return result;
+	}
+
 	hash2 = ipv4_portaddr_hash(net, daddr, hnum);
 	slot2 = hash2 & udptable->mask;
 	hslot2 = &udptable->hash2[slot2];
@@ -469,6 +546,8 @@ struct sock *__udp4_lib_lookup(struct net *net, __be32 saddr,
 	}
 	if (IS_ERR(result))
 		return NULL;
+	if (result && udptable == &udp_table)
+		udp4_cache_store(result);
 	return result;
 }
 EXPORT_SYMBOL_GPL(__udp4_lib_lookup);
@@ -1906,6 +1985,10 @@ void udp_lib_unhash(struct sock *sk)
 			spin_unlock(&hslot2->lock);
 		}
 		spin_unlock_bh(&hslot->lock);
+
+		/* Pairs with the barrier in udp4_cache_store() */
+		smp_mb();
+		udp4_cache_evict(sk);
 	}
 }
 EXPORT_SYMBOL(udp_lib_unhash);
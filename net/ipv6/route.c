@@ -5105,6 +5105,7 @@ static int ip6_route_multipath_add(struct fib6_config *cfg,
 	struct fib6_info *rt_notif = NULL, *rt_last = NULL;
 	struct nl_info *info = &cfg->fc_nlinfo;
 	struct fib6_config r_cfg;
+	struct fib6_table *table;
 	struct rtnexthop *rtnh;
 	struct fib6_info *rt;
 	struct rt6_nh *err_nh;
@@ -5193,8 +5194,17 @@ static int ip6_route_multipath_add(struct fib6_config *cfg,
 	info->skip_notify_kernel = 1;
 
 	err_nh = NULL;
+
+	/* All nexthops go into the same table: insert them under a single
+	 * tb6_lock acquisition instead of paying a lock round-trip per
+	 * nexthop.  Everything fib6_add() does is already spinlock-safe
+	 * since it normally runs under this lock via __ip6_ins_rt().
+	 */
+	table = list_first_entry(&rt6_nh_list,
+				 struct rt6_nh, next)->fib6_info->fib6_table;
+	spin_lock_bh(&table->tb6_lock);
 	list_for_each_entry(nh, &rt6_nh_list, next) {
-		err = __ip6_ins_rt(nh->fib6_info, info, extack);
+		err = fib6_add(&table->tb6_root, nh->fib6_info, info, extack);
 		fib6_info_release(nh->fib6_info);
 
 		if (!err) {
@@ -5209,6 +5219,7 @@ static int ip6_route_multipath_add(struct fib6_config *cfg,
 		/* nh->fib6_info is used or freed at this point, reset to NULL*/
 		nh->fib6_info = NULL;
 		if (err) {
+			spin_unlock_bh(&table->tb6_lock);
 			if (replace && nhn)
 				NL_SET_ERR_MSG_MOD(extack,
 						   "multipath route replace failed (check consistency of installed routes)");
@@ -5228,6 +5239,7 @@ static int ip6_route_multipath_add(struct fib6_config *cfg,
 		cfg->fc_nlinfo.nlh->nlmsg_flags |= NLM_F_CREATE;
 		nhn++;
 	}
+	spin_unlock_bh(&table->tb6_lock);
 
 	/* An in-kernel notification should only be sent in case the new
 	 * multipath route is added as the first route in the node, or if
@@ -22,8 +22,18 @@ void nf_ct_ext_destroy(struct nf_conn *ct)
 	unsigned int i;
 	struct nf_ct_ext_type *t;
 
+	/* Nothing was ever attached, so no destructor has work to do. */
+	if (!ct->ext)
+		return;
+
+	rcu_read_lock();
 	for (i = 0; i < NF_CT_EXT_NUM; i++) {
-		rcu_read_lock();
+		/* Every destructor starts by looking up its own extension
+		 * area, so it is a no-op for ids this conntrack never added.
+		 */
+		if (!__nf_ct_ext_exist(ct->ext, i))
+			continue;
+
 		t = rcu_dereference(nf_ct_ext_types[i]);
 
 		/* Here the nf_ct_ext_type might have been unregisterd.
@@ -32,8 +42,8 @@ void nf_ct_ext_destroy(struct nf_conn *ct)
 		 */
 		if (t && t->destroy)
 			t->destroy(ct);
-		rcu_read_unlock();
 	}
+	rcu_read_unlock();
 
 	kfree(ct->ext);
 }
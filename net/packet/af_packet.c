@@ -586,11 +586,13 @@ static void init_prb_bdqc(struct packet_sock *po,
 	p1->version = po->tp_version;
 	p1->last_kactive_blk_num = 0;
 	po->stats.stats3.tp_freeze_q_cnt = 0;
-	if (req_u->req3.tp_retire_blk_tov)
+	if (req_u->req3.tp_retire_blk_tov) {
 		p1->retire_blk_tov = req_u->req3.tp_retire_blk_tov;
-	else
+		p1->fixed_blk_tov = 1;
+	} else {
 		p1->retire_blk_tov = prb_calc_retire_blk_tmo(po,
 						req_u->req3.tp_block_size);
+	}
 	p1->tov_in_jiffies = msecs_to_jiffies(p1->retire_blk_tov);
 	p1->blk_sizeof_priv = req_u->req3.tp_sizeof_priv;
 
@@ -671,6 +673,20 @@ static void prb_retire_rx_blk_timer_expired(struct timer_list *t)
 				/* An empty block. Just refresh the timer. */
 				goto refresh_timer;
 			}
+			/* A block already more than half full is filling
+			 * briskly; closing it now would chop a burst into
+			 * undersized blocks.  Give it one extra period to
+			 * fill up, unless user space requested a fixed
+			 * retirement bound.  Latency stays capped at twice
+			 * the timeout, and only when a big batch is about
+			 * to be delivered anyway.
+			 */
+			if (!pkc->fixed_blk_tov && !pkc->blk_tmo_extended &&
+			    (unsigned int)(pkc->nxt_offset - pkc->pkblk_start) >
+			    pkc->kblk_size / 2) {
+				pkc->blk_tmo_extended = 1;
+				goto refresh_timer;
+			}
 			prb_retire_current_block(pkc, po, TP_STATUS_BLK_TMO);
 			if (!prb_dispatch_next_block(pkc, po))
 				goto refresh_timer;
@@ -834,6 +850,7 @@ static void prb_open_block(struct tpacket_kbdq_core *pkc1,
 	pbd1->version = pkc1->version;
 	pkc1->prev = pkc1->nxt_offset;
 	pkc1->pkblk_end = pkc1->pkblk_start + pkc1->kblk_size;
+	pkc1->blk_tmo_extended = 0;
 
 	prb_thaw_queue(pkc1);
 	_prb_refresh_rx_retire_blk_timer(pkc1);
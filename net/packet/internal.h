@@ -20,6 +20,14 @@ struct tpacket_kbdq_core {
 	unsigned int	hdrlen;
 	unsigned char	reset_pending_on_curr_blk;
 	unsigned char   delete_blk_timer;
+	/* retirement of the active block was deferred once because it was
+	 * filling quickly when the timer fired
+	 */
+	unsigned char	blk_tmo_extended;
+	/* tp_retire_blk_tov came from user space: a hard latency bound,
+	 * never extended
+	 */
+	unsigned char	fixed_blk_tov;
 	unsigned short	kactive_blk_num;
 	unsigned short	blk_sizeof_priv;
 
@@ -144,8 +144,14 @@ static inline void dev_requeue_skb(struct sk_buff *skb, struct Qdisc *q)
 
 		skb = next;
 	}
-	if (lock)
+
+	if (lock) {
+		/* DRAINING keeps nolock_qdisc_is_empty() false so the xmit
+		 * fast path cannot bypass the qdisc ahead of requeued skbs.
+		 */
+		set_bit(__QDISC_STATE_DRAINING, &q->state);
 		spin_unlock(lock);
+	}
 	__netif_schedule(q);
 }
 
@@ -240,6 +246,11 @@ static struct sk_buff *dequeue_skb(struct Qdisc *q, bool *validate,
 				qdisc_qstats_backlog_dec(q, skb);
 				q->q.qlen--;
 			}
+			/* The last requeued skb is gone; lift the bypass ban.
+			 * Serialized against dev_requeue_skb() by qdisc_lock.
+			 */
+			if (lock && skb_queue_empty(&q->gso_skb))
+				clear_bit(__QDISC_STATE_DRAINING, &q->state);
 		} else {
 			skb = NULL;
 		}
@@ -384,7 +395,10 @@ void __qdisc_run(struct Qdisc *q)
 	while (qdisc_restart(q, &packets)) {
 		quota -= packets;
 		if (quota <= 0) {
-			__netif_schedule(q);
+			if (q->flags & TCQ_F_NOLOCK)
+				set_bit(__QDISC_STATE_MISSED, &q->state);
+			else
+				__netif_schedule(q);
 			break;
 		}
 	}
@@ -639,8 +653,10 @@ static struct sk_buff *pfifo_fast_dequeue(struct Qdisc *qdisc)
 {
 	struct pfifo_fast_priv *priv = qdisc_priv(qdisc);
 	struct sk_buff *skb = NULL;
+	bool need_retry = true;
 	int band;
 
+retry:
 	for (band = 0; band < PFIFO_FAST_BANDS && !skb; band++) {
 		struct skb_array *q = band2list(priv, band);
 
@@ -651,8 +667,23 @@ static struct sk_buff *pfifo_fast_dequeue(struct Qdisc *qdisc)
 	}
 	if (likely(skb)) {
 		qdisc_update_stats_at_dequeue(qdisc, skb);
-	} else {
-		WRITE_ONCE(qdisc->empty, true);
+	} else if (need_retry &&
+		   test_bit(__QDISC_STATE_MISSED, &qdisc->state)) {
+		/* Delay clearing the STATE_MISSED here to reduce
+		 * the overhead of the second spin_trylock() in
+		 * qdisc_run_begin() and __netif_schedule() calling
+		 * in qdisc_run_end().
+		 */
+		clear_bit(__QDISC_STATE_MISSED, &qdisc->state);
+
+		/* Make sure dequeuing the skb enqueued by the concurrent
+		 * sender that set MISSED is tried after the bit clearing.
+		 */
+		smp_mb__after_atomic();
+
+		need_retry = false;
+
+		goto retry;
 	}
 
 	return skb;
@@ -855,7 +886,6 @@ struct Qdisc *qdisc_alloc(struct netdev_queue *dev_queue,
 	sch->enqueue = ops->enqueue;
 	sch->dequeue = ops->dequeue;
 	sch->dev_queue = dev_queue;
-	sch->empty = true;
 	dev_hold(dev);
 	refcount_set(&sch->refcnt, 1);
 
@@ -1138,8 +1168,11 @@ static void dev_deactivate_queue(struct net_device *dev,
 		qdisc_reset(qdisc);
 
 		spin_unlock_bh(qdisc_lock(qdisc));
-		if (nolock)
+		if (nolock) {
+			clear_bit(__QDISC_STATE_MISSED, &qdisc->state);
+			clear_bit(__QDISC_STATE_DRAINING, &qdisc->state);
 			spin_unlock_bh(&qdisc->seqlock);
+		}
 	}
 }
 
@@ -421,10 +421,24 @@ void svc_xprt_do_enqueue(struct svc_xprt *xprt)
 	pool->sp_stats.sockets_queued++;
 	spin_unlock_bh(&pool->sp_lock);
 
+	/* If every thread was busy at the last enqueue and none has gone
+	 * idle since, scanning all of them again is pointless.  The
+	 * barrier pairs with the one in svc_get_next_xprt(): either an
+	 * idling thread sees the transport we queued above, or we see
+	 * SP_CONGESTED cleared and fall through to the scan.
+	 */
+	smp_mb();
+	if (test_bit(SP_CONGESTED, &pool->sp_flags))
+		goto out;
+
 	/* find a thread for this xprt */
 	rcu_read_lock();
 	list_for_each_entry_rcu(rqstp, &pool->sp_all_threads, rq_all) {
-		if (test_and_set_bit(RQ_BUSY, &rqstp->rq_flags))
+		/* the plain test keeps busy threads' rq_flags cachelines
+		 * shared while we scan past them
+		 */
+		if (test_bit(RQ_BUSY, &rqstp->rq_flags) ||
+		    test_and_set_bit(RQ_BUSY, &rqstp->rq_flags))
 			continue;
 		atomic_long_inc(&pool->sp_stats.threads_woken);
 		rqstp->rq_qtime = ktime_get();
@@ -435,6 +449,7 @@ void svc_xprt_do_enqueue(struct svc_xprt *xprt)
 	rqstp = NULL;
 out_unlock:
 	rcu_read_unlock();
+out:
 	put_cpu();
 	trace_svc_xprt_do_enqueue(xprt, rqstp);
 }
@@ -1836,6 +1836,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
 	struct sock *sk = sock->sk;
+	struct ubuf_info *uarg = NULL;
 	struct sock *other = NULL;
 	int err, size;
 	struct sk_buff *skb;
@@ -1866,22 +1867,43 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (sk->sk_shutdown & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	if (msg->msg_flags & MSG_ZEROCOPY && len &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = sock_zerocopy_alloc(sk, len);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		size = len - sent;
 
 		/* Keep two messages in the pipe so it schedules better */
 		size = min_t(int, size, (sk->sk_sndbuf >> 1) - 64);
 
-		/* allow fallback to order-0 allocations */
-		size = min_t(int, size, SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
+		if (uarg) {
+			/* The payload lives in pinned user pages; only a
+			 * frag-less head needs to be allocated.
+			 */
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
+		} else {
+			/* allow fallback to order-0 allocations */
+			size = min_t(int, size,
+				     SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
 
-		data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
+			data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
 
-		data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
+			data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
 
-		skb = sock_alloc_send_pskb(sk, size - data_len, data_len,
-					   msg->msg_flags & MSG_DONTWAIT, &err,
-					   get_order(UNIX_SKB_FRAGS_SZ));
+			skb = sock_alloc_send_pskb(sk, size - data_len,
+						   data_len,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err,
+						   get_order(UNIX_SKB_FRAGS_SZ));
+		}
 		if (!skb)
 			goto out_err;
 
@@ -1893,13 +1915,39 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		}
 		fds_sent = true;
 
-		skb_put(skb, size - data_len);
-		skb->data_len = data_len;
-		skb->len = size;
-		err = skb_copy_datagram_from_iter(skb, 0, &msg->msg_iter, size);
-		if (err) {
-			kfree_skb(skb);
-			goto out_err;
+		if (uarg) {
+			unsigned int truesize = skb->truesize;
+
+			err = skb_zerocopy_iter_stream(sk, skb, msg, size,
+						       uarg);
+			if (err <= 0) {
+				kfree_skb(skb);
+				if (!err)
+					err = -EFAULT;
+				goto out_err;
+			}
+			size = err;
+
+			/* __zerocopy_sg_from_iter() charged the pinned pages
+			 * to sk_wmem_queued as TCP would expect.  AF_UNIX
+			 * flow control lives in sk_wmem_alloc, which
+			 * sock_wfree() drops by the full truesize once the
+			 * receiver consumes the skb, so move the charge over.
+			 */
+			truesize = skb->truesize - truesize;
+			sk_wmem_queued_add(sk, -truesize);
+			sk_mem_uncharge(sk, truesize);
+			refcount_add(truesize, &sk->sk_wmem_alloc);
+		} else {
+			skb_put(skb, size - data_len);
+			skb->data_len = data_len;
+			skb->len = size;
+			err = skb_copy_datagram_from_iter(skb, 0,
+							  &msg->msg_iter, size);
+			if (err) {
+				kfree_skb(skb);
+				goto out_err;
+			}
 		}
 
 		unix_state_lock(other);
@@ -1918,6 +1966,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		sent += size;
 	}
 
+	sock_zerocopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -1930,6 +1979,12 @@ pipe_err:
 		send_sig(SIGPIPE, current, 0);
 	err = -EPIPE;
 out_err:
+	if (uarg) {
+		if (sent)
+			sock_zerocopy_put(uarg);
+		else
+			sock_zerocopy_put_abort(uarg, true);
+	}
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2476,6 +2531,10 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.flags = flags
 	};
 
+	/* MSG_ZEROCOPY completion notifications */
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_SOCKET, 0);
+
 	return unix_stream_read_generic(&state, true);
 }
 
@@ -2666,7 +2725,8 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	mask = 0;
 
 	/* exceptional events? */
-	if (sk->sk_err)
+	if (sk->sk_err ||
+	    !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (sk->sk_shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
@@ -29,7 +29,7 @@
 #include "xdp_umem.h"
 #include "xsk.h"
 
-#define TX_BATCH_SIZE 16
+#define TX_BATCH_SIZE 64
 
 static DEFINE_PER_CPU(struct list_head, xskmap_flush_list);
 
@@ -395,9 +395,19 @@ static int xsk_generic_xmit(struct sock *sk)
 			goto out;
 		}
 
+		/* This is the backpreassure mechanism for the Tx path.
+		 * Reserve space in the completion queue and only proceed
+		 * if there is space in it. This avoids having to implement
+		 * any buffering in the Tx path.  Checking up front also
+		 * saves allocating and copying an skb we could never send.
+		 */
+		if (xskq_prod_reserve(xs->umem->cq))
+			goto out;
+
 		len = desc.len;
 		skb = sock_alloc_send_skb(sk, len, 1, &err);
 		if (unlikely(!skb)) {
+			xskq_prod_cancel(xs->umem->cq);
 			err = -EAGAIN;
 			goto out;
 		}
@@ -406,12 +416,8 @@ static int xsk_generic_xmit(struct sock *sk)
 		addr = desc.addr;
 		buffer = xdp_umem_get_data(xs->umem, addr);
 		err = skb_store_bits(skb, 0, buffer, len);
-		/* This is the backpreassure mechanism for the Tx path.
-		 * Reserve space in the completion queue and only proceed
-		 * if there is space in it. This avoids having to implement
-		 * any buffering in the Tx path.
-		 */
-		if (unlikely(err) || xskq_prod_reserve(xs->umem->cq)) {
+		if (unlikely(err)) {
+			xskq_prod_cancel(xs->umem->cq);
 			kfree_skb(skb);
 			goto out;
 		}
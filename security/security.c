@@ -70,6 +70,33 @@ const char *const lockdown_reasons[LOCKDOWN_CONFIDENTIALITY_MAX+1] = {
 struct security_hook_heads security_hook_heads __lsm_ro_after_init;
 static BLOCKING_NOTIFIER_HEAD(blocking_lsm_notifier_chain);
 
+/*
+ * The hook lists above are only walked at registration time.  Run-time
+ * dispatch goes through per-hook slot arrays, filled in by
+ * security_add_hooks(), so that invoking a hook reads one dense array
+ * of function pointers instead of chasing hlist nodes through every
+ * module's registration table.  The arrays keep a terminating NULL
+ * entry, which is what the call_*_hook() iterators stop on.
+ *
+ * struct security_hook_heads is a sequence of struct hlist_head only,
+ * so it can be viewed as an array to turn a head pointer into a hook
+ * index.
+ */
+#define SECURITY_HOOK_COUNT \
+	(sizeof(struct security_hook_heads) / sizeof(struct hlist_head))
+/* Enough for every stackable module plus one exclusive major module. */
+#define SECURITY_HOOK_SLOTS	11
+
+static union security_list_options
+	security_hook_slots[SECURITY_HOOK_COUNT][SECURITY_HOOK_SLOTS]
+	__lsm_ro_after_init;
+static u8 security_hook_slot_used[SECURITY_HOOK_COUNT] __lsm_ro_after_init;
+
+static unsigned int security_head_index(struct hlist_head *head)
+{
+	return head - (struct hlist_head *)&security_hook_heads;
+}
+
 static struct kmem_cache *lsm_file_cache;
 static struct kmem_cache *lsm_inode_cache;
 
@@ -475,11 +502,19 @@ static int lsm_append(const char *new, char **result)
 void __init security_add_hooks(struct security_hook_list *hooks, int count,
 				char *lsm)
 {
+	unsigned int idx;
 	int i;
 
 	for (i = 0; i < count; i++) {
 		hooks[i].lsm = lsm;
 		hlist_add_tail_rcu(&hooks[i].list, hooks[i].head);
+
+		idx = security_head_index(hooks[i].head);
+		if (security_hook_slot_used[idx] >= SECURITY_HOOK_SLOTS - 1)
+			panic("%s - %s overflows a hook slot array.\n",
+			      __func__, lsm);
+		security_hook_slots[idx][security_hook_slot_used[idx]++] =
+			hooks[i].hook;
 	}
 
 	/*
@@ -492,6 +527,35 @@ void __init security_add_hooks(struct security_hook_list *hooks, int count,
 	}
 }
 
+#ifdef CONFIG_SECURITY_SELINUX_DISABLE
+void security_delete_hooks(struct security_hook_list *hooks, int count)
+{
+	struct security_hook_list *P;
+	unsigned int idx;
+	int i, n;
+
+	for (i = 0; i < count; i++)
+		hlist_del_rcu(&hooks[i].list);
+
+	/*
+	 * Rebuild the affected slot arrays from the surviving
+	 * registrations.  As with the RCU list removal above, a racing
+	 * caller may invoke a deleted hook one last time; the module
+	 * being deleted has to cope, exactly as before.
+	 */
+	for (i = 0; i < count; i++) {
+		idx = security_head_index(hooks[i].head);
+		n = 0;
+		hlist_for_each_entry(P, hooks[i].head, list)
+			security_hook_slots[idx][n++] = P->hook;
+		security_hook_slot_used[idx] = n;
+		while (n < SECURITY_HOOK_SLOTS)
+			memset(&security_hook_slots[idx][n++], 0,
+			       sizeof(union security_list_options));
+	}
+}
+#endif /* CONFIG_SECURITY_SELINUX_DISABLE */
+
 int call_blocking_lsm_notifier(enum lsm_event event, void *data)
 {
 	return blocking_notifier_call_chain(&blocking_lsm_notifier_chain,
@@ -669,7 +733,8 @@ static void __init lsm_early_task(struct task_struct *task)
 }
 
 /*
- * Hook list operation macros.
+ * Hook dispatch macros.  These walk the per-hook slot array, not the
+ * registration hlist; the slot index is a compile-time constant.
  *
  * call_void_hook:
  *	This is a hook that does not return a value.
@@ -678,21 +743,26 @@ static void __init lsm_early_task(struct task_struct *task)
  *	This is a hook that returns a value.
  */
 
+#define security_hook_index(FUNC) \
+	(offsetof(struct security_hook_heads, FUNC) / sizeof(struct hlist_head))
+
 #define call_void_hook(FUNC, ...)				\
 	do {							\
-		struct security_hook_list *P;			\
+		union security_list_options *P =		\
+			security_hook_slots[security_hook_index(FUNC)]; \
 								\
-		hlist_for_each_entry(P, &security_hook_heads.FUNC, list) \
-			P->hook.FUNC(__VA_ARGS__);		\
+		for (; P->FUNC; P++)				\
+			P->FUNC(__VA_ARGS__);			\
 	} while (0)
 
 #define call_int_hook(FUNC, IRC, ...) ({			\
 	int RC = IRC;						\
 	do {							\
-		struct security_hook_list *P;			\
+		union security_list_options *P =		\
+			security_hook_slots[security_hook_index(FUNC)]; \
 								\
-		hlist_for_each_entry(P, &security_hook_heads.FUNC, list) { \
-			RC = P->hook.FUNC(__VA_ARGS__);		\
+		for (; P->FUNC; P++) {				\
+			RC = P->FUNC(__VA_ARGS__);		\
 			if (RC != 0)				\
 				break;				\
 		}						\
@@ -13,6 +13,8 @@
 #include <linux/types.h>
 #include <linux/stddef.h>
 #include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/fs.h>
 #include <linux/dcache.h>
@@ -31,7 +33,8 @@
 #include "avc_ss.h"
 #include "classmap.h"
 
-#define AVC_CACHE_SLOTS			512
+#define AVC_CACHE_SLOTS			512	/* default, must be a power of two */
+#define AVC_CACHE_SLOTS_MAX		32768
 #define AVC_DEF_CACHE_THRESHOLD		512
 #define AVC_CACHE_RECLAIM		16
 
@@ -65,10 +68,20 @@ struct avc_xperms_node {
 	struct list_head xpd_head; /* list head of extended_perms_decision */
 };
 
+/*
+ * The hash table proper.  Readers and writers reach it through an RCU
+ * protected pointer so that it can be replaced at runtime by a larger
+ * (or smaller) table without quiescing permission checks; see
+ * avc_set_cache_slots().
+ */
+struct avc_cache_table {
+	unsigned int		nr_slots;	/* always a power of two */
+	struct hlist_head	*slots;		/* head for avc_node->list */
+	spinlock_t		*slots_lock;	/* lock for writes */
+};
+
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
-	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
+	struct avc_cache_table __rcu *table;
 	atomic_t		active_nodes;
 	u32			latest_notif;	/* latest revocation notification */
 };
@@ -90,17 +103,34 @@ struct selinux_avc {
 
 static struct selinux_avc selinux_avc;
 
+/*
+ * The boot-time table is statically allocated so that selinux_avc_init()
+ * cannot fail; tables installed later via avc_set_cache_slots() come from
+ * the allocator.  Reclaim scan positions are kept per-cpu so that
+ * concurrent reclaimers start in different regions of the table instead
+ * of bouncing a shared counter between CPUs.
+ */
+static struct hlist_head avc_init_slots[AVC_CACHE_SLOTS];
+static spinlock_t avc_init_slots_lock[AVC_CACHE_SLOTS];
+static struct avc_cache_table avc_init_table = {
+	.nr_slots	= AVC_CACHE_SLOTS,
+	.slots		= avc_init_slots,
+	.slots_lock	= avc_init_slots_lock,
+};
+static DEFINE_MUTEX(avc_table_mutex);	/* serializes table replacement */
+static DEFINE_PER_CPU(u32, avc_reclaim_hint);
+
 void selinux_avc_init(struct selinux_avc **avc)
 {
 	int i;
 
 	selinux_avc.avc_cache_threshold = AVC_DEF_CACHE_THRESHOLD;
 	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		INIT_HLIST_HEAD(&selinux_avc.avc_cache.slots[i]);
-		spin_lock_init(&selinux_avc.avc_cache.slots_lock[i]);
+		INIT_HLIST_HEAD(&avc_init_slots[i]);
+		spin_lock_init(&avc_init_slots_lock[i]);
 	}
+	RCU_INIT_POINTER(selinux_avc.avc_cache.table, &avc_init_table);
 	atomic_set(&selinux_avc.avc_cache.active_nodes, 0);
-	atomic_set(&selinux_avc.avc_cache.lru_hint, 0);
 	*avc = &selinux_avc;
 }
 
@@ -121,9 +151,42 @@ static struct kmem_cache *avc_xperms_data_cachep;
 static struct kmem_cache *avc_xperms_decision_cachep;
 static struct kmem_cache *avc_xperms_cachep;
 
-static inline int avc_hash(u32 ssid, u32 tsid, u16 tclass)
+static inline int avc_hash(struct avc_cache_table *table,
+			   u32 ssid, u32 tsid, u16 tclass)
+{
+	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (table->nr_slots - 1);
+}
+
+static void avc_free_table(struct avc_cache_table *table)
+{
+	kvfree(table->slots_lock);
+	kvfree(table->slots);
+	kfree(table);
+}
+
+static struct avc_cache_table *avc_alloc_table(unsigned int nr_slots)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	struct avc_cache_table *table;
+	unsigned int i;
+
+	table = kzalloc(sizeof(*table), GFP_KERNEL);
+	if (!table)
+		return NULL;
+
+	table->slots = kvcalloc(nr_slots, sizeof(*table->slots), GFP_KERNEL);
+	table->slots_lock = kvcalloc(nr_slots, sizeof(*table->slots_lock),
+				     GFP_KERNEL);
+	if (!table->slots || !table->slots_lock) {
+		avc_free_table(table);
+		return NULL;
+	}
+
+	table->nr_slots = nr_slots;
+	for (i = 0; i < nr_slots; i++) {
+		INIT_HLIST_HEAD(&table->slots[i]);
+		spin_lock_init(&table->slots_lock[i]);
+	}
+	return table;
 }
 
 /**
@@ -149,16 +212,19 @@ void __init avc_init(void)
 
 int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 {
-	int i, chain_len, max_chain_len, slots_used;
+	int i, chain_len, max_chain_len, slots_used, nr_slots;
+	struct avc_cache_table *table;
 	struct avc_node *node;
 	struct hlist_head *head;
 
 	rcu_read_lock();
 
+	table = rcu_dereference(avc->avc_cache.table);
+	nr_slots = table->nr_slots;
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		head = &avc->avc_cache.slots[i];
+	for (i = 0; i < nr_slots; i++) {
+		head = &table->slots[i];
 		if (!hlist_empty(head)) {
 			slots_used++;
 			chain_len = 0;
@@ -174,7 +240,7 @@ int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&avc->avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, nr_slots, max_chain_len);
 }
 
 /*
@@ -463,33 +529,40 @@ static inline int avc_reclaim_node(struct selinux_avc *avc)
 	struct avc_node *node;
 	int hvalue, try, ecx;
 	unsigned long flags;
+	struct avc_cache_table *table;
 	struct hlist_head *head;
 	spinlock_t *lock;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
-		hvalue = atomic_inc_return(&avc->avc_cache.lru_hint) &
-			(AVC_CACHE_SLOTS - 1);
-		head = &avc->avc_cache.slots[hvalue];
-		lock = &avc->avc_cache.slots_lock[hvalue];
+	rcu_read_lock();
+	table = rcu_dereference(avc->avc_cache.table);
+	for (try = 0, ecx = 0; try < table->nr_slots; try++) {
+		/*
+		 * Advancing a per-cpu scan position keeps concurrent
+		 * reclaimers working on different regions of the table
+		 * instead of contending on one shared counter and then
+		 * on each other's buckets.
+		 */
+		hvalue = this_cpu_inc_return(avc_reclaim_hint) &
+			(table->nr_slots - 1);
+		head = &table->slots[hvalue];
+		lock = &table->slots_lock[hvalue];
 
 		if (!spin_trylock_irqsave(lock, flags))
 			continue;
 
-		rcu_read_lock();
 		hlist_for_each_entry(node, head, list) {
 			avc_node_delete(avc, node);
 			avc_cache_stats_incr(reclaims);
 			ecx++;
 			if (ecx >= AVC_CACHE_RECLAIM) {
-				rcu_read_unlock();
 				spin_unlock_irqrestore(lock, flags);
 				goto out;
 			}
 		}
-		rcu_read_unlock();
 		spin_unlock_irqrestore(lock, flags);
 	}
 out:
+	rcu_read_unlock();
 	return ecx;
 }
 
@@ -524,11 +597,13 @@ static inline struct avc_node *avc_search_node(struct selinux_avc *avc,
 					       u32 ssid, u32 tsid, u16 tclass)
 {
 	struct avc_node *node, *ret = NULL;
+	struct avc_cache_table *table;
 	int hvalue;
 	struct hlist_head *head;
 
-	hvalue = avc_hash(ssid, tsid, tclass);
-	head = &avc->avc_cache.slots[hvalue];
+	table = rcu_dereference(avc->avc_cache.table);
+	hvalue = avc_hash(table, ssid, tsid, tclass);
+	head = &table->slots[hvalue];
 	hlist_for_each_entry_rcu(node, head, list) {
 		if (ssid == node->ae.ssid &&
 		    tclass == node->ae.tclass &&
@@ -615,6 +690,7 @@ static struct avc_node *avc_insert(struct selinux_avc *avc,
 				   struct avc_xperms_node *xp_node)
 {
 	struct avc_node *pos, *node = NULL;
+	struct avc_cache_table *table;
 	int hvalue;
 	unsigned long flag;
 	spinlock_t *lock;
@@ -633,9 +709,16 @@ static struct avc_node *avc_insert(struct selinux_avc *avc,
 		return NULL;
 	}
 
-	hvalue = avc_hash(ssid, tsid, tclass);
-	head = &avc->avc_cache.slots[hvalue];
-	lock = &avc->avc_cache.slots_lock[hvalue];
+	/*
+	 * The caller's RCU read-side section pins the table: the
+	 * synchronize_rcu() in avc_set_cache_slots() cannot complete
+	 * before we drop the bucket lock, so a retired table is always
+	 * flushed after the last insertion into it has finished.
+	 */
+	table = rcu_dereference(avc->avc_cache.table);
+	hvalue = avc_hash(table, ssid, tsid, tclass);
+	head = &table->slots[hvalue];
+	lock = &table->slots_lock[hvalue];
 	spin_lock_irqsave(lock, flag);
 	hlist_for_each_entry(pos, head, list) {
 		if (pos->ae.ssid == ssid &&
@@ -834,6 +917,7 @@ static int avc_update_node(struct selinux_avc *avc,
 	int hvalue, rc = 0;
 	unsigned long flag;
 	struct avc_node *pos, *node, *orig = NULL;
+	struct avc_cache_table *table;
 	struct hlist_head *head;
 	spinlock_t *lock;
 
@@ -859,10 +943,11 @@ static int avc_update_node(struct selinux_avc *avc,
 	}
 
 	/* Lock the target slot */
-	hvalue = avc_hash(ssid, tsid, tclass);
+	table = rcu_dereference(avc->avc_cache.table);
+	hvalue = avc_hash(table, ssid, tsid, tclass);
 
-	head = &avc->avc_cache.slots[hvalue];
-	lock = &avc->avc_cache.slots_lock[hvalue];
+	head = &table->slots[hvalue];
+	lock = &table->slots_lock[hvalue];
 
 	spin_lock_irqsave(lock, flag);
 
@@ -929,10 +1014,8 @@ out:
 	return rc;
 }
 
-/**
- * avc_flush - Flush the cache
- */
-static void avc_flush(struct selinux_avc *avc)
+static void avc_flush_table(struct selinux_avc *avc,
+			    struct avc_cache_table *table)
 {
 	struct hlist_head *head;
 	struct avc_node *node;
@@ -940,9 +1023,9 @@ static void avc_flush(struct selinux_avc *avc)
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		head = &avc->avc_cache.slots[i];
-		lock = &avc->avc_cache.slots_lock[i];
+	for (i = 0; i < table->nr_slots; i++) {
+		head = &table->slots[i];
+		lock = &table->slots_lock[i];
 
 		spin_lock_irqsave(lock, flag);
 		/*
@@ -957,6 +1040,77 @@ static void avc_flush(struct selinux_avc *avc)
 	}
 }
 
+/**
+ * avc_flush - Flush the cache
+ */
+static void avc_flush(struct selinux_avc *avc)
+{
+	struct avc_cache_table *table;
+
+	rcu_read_lock();
+	table = rcu_dereference(avc->avc_cache.table);
+	avc_flush_table(avc, table);
+	rcu_read_unlock();
+}
+
+unsigned int avc_get_cache_slots(struct selinux_avc *avc)
+{
+	unsigned int nr_slots;
+
+	rcu_read_lock();
+	nr_slots = rcu_dereference(avc->avc_cache.table)->nr_slots;
+	rcu_read_unlock();
+
+	return nr_slots;
+}
+
+/**
+ * avc_set_cache_slots - Resize the cache hash table.
+ * @avc: the access vector cache
+ * @nr_slots: requested number of hash buckets
+ *
+ * Install a fresh table with @nr_slots buckets and retire the current
+ * one.  Cached entries are not migrated; they are dropped with the old
+ * table and repopulated on demand, exactly as after avc_flush() on a
+ * policy reload.  Returns %0 on success, -%EINVAL if @nr_slots is not a
+ * power of two within limits, or -%ENOMEM.
+ */
+int avc_set_cache_slots(struct selinux_avc *avc, unsigned int nr_slots)
+{
+	struct avc_cache_table *new, *old;
+
+	if (!is_power_of_2(nr_slots) || nr_slots > AVC_CACHE_SLOTS_MAX)
+		return -EINVAL;
+
+	new = avc_alloc_table(nr_slots);
+	if (!new)
+		return -ENOMEM;
+
+	mutex_lock(&avc_table_mutex);
+	old = rcu_dereference_protected(avc->avc_cache.table,
+					lockdep_is_held(&avc_table_mutex));
+	if (old->nr_slots == nr_slots) {
+		mutex_unlock(&avc_table_mutex);
+		avc_free_table(new);
+		return 0;
+	}
+
+	rcu_assign_pointer(avc->avc_cache.table, new);
+	/*
+	 * Wait out every lookup and in-flight insertion that may still
+	 * be using the old table; after the grace period it is
+	 * unreachable and can be emptied and freed.
+	 */
+	synchronize_rcu();
+	avc_flush_table(avc, old);
+	mutex_unlock(&avc_table_mutex);
+
+	if (old != &avc_init_table)
+		avc_free_table(old);
+
+	return 0;
+}
+
 /**
  * avc_ss_reset - Flush the cache and revalidate migrated permissions.
  * @seqno: policy sequence number
@@ -186,6 +186,8 @@ int avc_get_hash_stats(struct selinux_avc *avc, char *page);
 unsigned int avc_get_cache_threshold(struct selinux_avc *avc);
 void avc_set_cache_threshold(struct selinux_avc *avc,
 			     unsigned int cache_threshold);
+unsigned int avc_get_cache_slots(struct selinux_avc *avc);
+int avc_set_cache_slots(struct selinux_avc *avc, unsigned int nr_slots);
 
 /* Attempt to free avc node cache */
 void avc_disable(void);
@@ -1468,6 +1468,60 @@ out:
 	return ret;
 }
 
+static ssize_t sel_read_avc_cache_slots(struct file *filp, char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct selinux_fs_info *fsi = file_inode(filp)->i_sb->s_fs_info;
+	struct selinux_state *state = fsi->state;
+	char tmpbuf[TMPBUFLEN];
+	ssize_t length;
+
+	length = scnprintf(tmpbuf, TMPBUFLEN, "%u",
+			   avc_get_cache_slots(state->avc));
+	return simple_read_from_buffer(buf, count, ppos, tmpbuf, length);
+}
+
+static ssize_t sel_write_avc_cache_slots(struct file *file,
+					 const char __user *buf,
+					 size_t count, loff_t *ppos)
+
+{
+	struct selinux_fs_info *fsi = file_inode(file)->i_sb->s_fs_info;
+	struct selinux_state *state = fsi->state;
+	char *page;
+	ssize_t ret;
+	unsigned int new_value;
+
+	ret = avc_has_perm(&selinux_state,
+			   current_sid(), SECINITSID_SECURITY,
+			   SECCLASS_SECURITY, SECURITY__SETSECPARAM,
+			   NULL);
+	if (ret)
+		return ret;
+
+	if (count >= PAGE_SIZE)
+		return -ENOMEM;
+
+	/* No partial writes. */
+	if (*ppos != 0)
+		return -EINVAL;
+
+	page = memdup_user_nul(buf, count);
+	if (IS_ERR(page))
+		return PTR_ERR(page);
+
+	ret = -EINVAL;
+	if (sscanf(page, "%u", &new_value) != 1)
+		goto out;
+
+	ret = avc_set_cache_slots(state->avc, new_value);
+	if (!ret)
+		ret = count;
+out:
+	kfree(page);
+	return ret;
+}
+
 static ssize_t sel_read_avc_hash_stats(struct file *filp, char __user *buf,
 				       size_t count, loff_t *ppos)
 {
@@ -1520,6 +1574,12 @@ static const struct file_operations sel_avc_cache_threshold_ops = {
 	.llseek		= generic_file_llseek,
 };
 
+static const struct file_operations sel_avc_cache_slots_ops = {
+	.read		= sel_read_avc_cache_slots,
+	.write		= sel_write_avc_cache_slots,
+	.llseek		= generic_file_llseek,
+};
+
 static const struct file_operations sel_avc_hash_stats_ops = {
 	.read		= sel_read_avc_hash_stats,
 	.llseek		= generic_file_llseek,
@@ -1603,6 +1663,7 @@ static int sel_make_avc_files(struct dentry *dir)
 	static const struct tree_descr files[] = {
 		{ "cache_threshold",
 		  &sel_avc_cache_threshold_ops, S_IRUGO|S_IWUSR },
+		{ "cache_slots", &sel_avc_cache_slots_ops, S_IRUGO|S_IWUSR },
 		{ "hash_stats", &sel_avc_hash_stats_ops, S_IRUGO },
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 		{ "cache_stats", &sel_avc_cache_stats_ops, S_IRUGO },
@@ -693,6 +693,7 @@ int snd_pcm_new_stream(struct snd_pcm *pcm, int stream, int substream_count)
 		substream->group = &substream->self_group;
 		snd_pcm_group_init(&substream->self_group);
 		list_add_tail(&substream->link_list, &substream->self_group.substreams);
+		INIT_LIST_HEAD(&substream->sweep_list);
 		atomic_set(&substream->mmap_count, 0);
 		prev = substream;
 	}
@@ -1213,6 +1214,7 @@ static void snd_pcm_proc_done(void)
 
 static int __init alsa_pcm_init(void)
 {
+	snd_pcm_sweep_init();
 	snd_ctl_register_ioctl(snd_pcm_control_ioctl);
 	snd_ctl_register_ioctl_compat(snd_pcm_control_ioctl);
 	snd_pcm_proc_init();
@@ -1224,6 +1226,7 @@ static void __exit alsa_pcm_exit(void)
 	snd_ctl_unregister_ioctl(snd_pcm_control_ioctl);
 	snd_ctl_unregister_ioctl_compat(snd_pcm_control_ioctl);
 	snd_pcm_proc_done();
+	snd_pcm_sweep_shutdown();
 }
 
 module_init(alsa_pcm_init)
@@ -8,6 +8,7 @@
 #include <linux/slab.h>
 #include <linux/sched/signal.h>
 #include <linux/time.h>
+#include <linux/hrtimer.h>
 #include <linux/math64.h>
 #include <linux/export.h>
 #include <sound/core.h>
@@ -1816,6 +1817,130 @@ void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
 }
 EXPORT_SYMBOL(snd_pcm_period_elapsed);
 
+/*
+ * Timer-driven period sweep
+ *
+ * A single system-wide hrtimer which calls snd_pcm_period_elapsed() for
+ * all registered substreams in one pass.  Drivers whose hardware can run
+ * with period interrupts disabled register here instead, so N streams
+ * cost one timer expiry per period instead of N interrupts, and streams
+ * opened with SNDRV_PCM_INFO_NO_PERIOD_WAKEUP still get their hw_ptr
+ * (and mmap'ed status page) refreshed for applications polling it.
+ *
+ * The timer fires at the shortest period time of all registered
+ * substreams and stops itself when the last one is removed.
+ */
+static struct {
+	spinlock_t lock;
+	struct list_head substreams;
+	struct hrtimer timer;
+	ktime_t interval;
+	bool running;
+} snd_pcm_sweep;
+
+static enum hrtimer_restart snd_pcm_sweep_callback(struct hrtimer *timer)
+{
+	struct snd_pcm_substream *substream;
+	enum hrtimer_restart ret = HRTIMER_RESTART;
+	unsigned long flags;
+
+	spin_lock_irqsave(&snd_pcm_sweep.lock, flags);
+	list_for_each_entry(substream, &snd_pcm_sweep.substreams, sweep_list)
+		snd_pcm_period_elapsed(substream);
+	if (list_empty(&snd_pcm_sweep.substreams)) {
+		snd_pcm_sweep.running = false;
+		ret = HRTIMER_NORESTART;
+	} else {
+		hrtimer_forward_now(timer, snd_pcm_sweep.interval);
+	}
+	spin_unlock_irqrestore(&snd_pcm_sweep.lock, flags);
+	return ret;
+}
+
+/* recompute the sweep interval; caller holds snd_pcm_sweep.lock */
+static void snd_pcm_sweep_update_interval(void)
+{
+	struct snd_pcm_substream *substream;
+	ktime_t interval = KTIME_MAX;
+
+	list_for_each_entry(substream, &snd_pcm_sweep.substreams, sweep_list)
+		interval = min_t(ktime_t, interval,
+				 substream->sweep_interval);
+	snd_pcm_sweep.interval = interval;
+}
+
+/**
+ * snd_pcm_sweep_start - drive period processing from the global sweep timer
+ * @substream: the pcm substream instance
+ *
+ * Registers the substream with the global sweep timer, which then calls
+ * snd_pcm_period_elapsed() for it once per period time until it is
+ * removed again.  Sweeps hitting a substream which is not (yet or any
+ * more) running are cheap no-ops, so this may stay registered across
+ * start/stop triggers.
+ *
+ * Call this from the hw_params callback, after the period size and rate
+ * have been set up.  It must not be called from the trigger callback or
+ * any other context holding the stream lock, since the timer callback
+ * takes the sweep lock before the stream locks.  Call
+ * snd_pcm_sweep_stop() from hw_free at the latest.
+ */
+void snd_pcm_sweep_start(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned long flags;
+
+	substream->sweep_interval =
+		ns_to_ktime(div_u64((u64)runtime->period_size * NSEC_PER_SEC,
+				    runtime->rate));
+
+	spin_lock_irqsave(&snd_pcm_sweep.lock, flags);
+	if (list_empty(&substream->sweep_list))
+		list_add_tail(&substream->sweep_list,
+			      &snd_pcm_sweep.substreams);
+	snd_pcm_sweep_update_interval();
+	if (!snd_pcm_sweep.running) {
+		snd_pcm_sweep.running = true;
+		hrtimer_start(&snd_pcm_sweep.timer, snd_pcm_sweep.interval,
+			      HRTIMER_MODE_REL);
+	}
+	spin_unlock_irqrestore(&snd_pcm_sweep.lock, flags);
+}
+EXPORT_SYMBOL(snd_pcm_sweep_start);
+
+/**
+ * snd_pcm_sweep_stop - remove a substream from the global sweep timer
+ * @substream: the pcm substream instance
+ *
+ * Counterpart of snd_pcm_sweep_start(); the same calling context rules
+ * apply.  When this returns, the sweep timer no longer references the
+ * substream.
+ */
+void snd_pcm_sweep_stop(struct snd_pcm_substream *substream)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&snd_pcm_sweep.lock, flags);
+	list_del_init(&substream->sweep_list);
+	if (!list_empty(&snd_pcm_sweep.substreams))
+		snd_pcm_sweep_update_interval();
+	spin_unlock_irqrestore(&snd_pcm_sweep.lock, flags);
+}
+EXPORT_SYMBOL(snd_pcm_sweep_stop);
+
+void snd_pcm_sweep_init(void)
+{
+	spin_lock_init(&snd_pcm_sweep.lock);
+	INIT_LIST_HEAD(&snd_pcm_sweep.substreams);
+	hrtimer_init(&snd_pcm_sweep.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	snd_pcm_sweep.timer.function = snd_pcm_sweep_callback;
+}
+
+void snd_pcm_sweep_shutdown(void)
+{
+	hrtimer_cancel(&snd_pcm_sweep.timer);
+}
+
 /*
  * Wait until avail_min data becomes available
  * Returns a negative error code if any error occurs during operation.
@@ -2910,53 +2910,138 @@ static int snd_pcm_delay(struct snd_pcm_substream *substream,
 	return err;
 }
 		
-static int snd_pcm_sync_ptr(struct snd_pcm_substream *substream,
-			    struct snd_pcm_sync_ptr __user *_sync_ptr)
+/*
+ * core of SNDRV_PCM_IOCTL_SYNC_PTR with the payload already in the
+ * kernel; shared with the vectored variant below
+ */
+static int snd_pcm_do_sync_ptr(struct snd_pcm_substream *substream,
+			       struct snd_pcm_sync_ptr *sync_ptr)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
-	struct snd_pcm_sync_ptr sync_ptr;
 	volatile struct snd_pcm_mmap_status *status;
 	volatile struct snd_pcm_mmap_control *control;
 	int err;
 
-	memset(&sync_ptr, 0, sizeof(sync_ptr));
-	if (get_user(sync_ptr.flags, (unsigned __user *)&(_sync_ptr->flags)))
-		return -EFAULT;
-	if (copy_from_user(&sync_ptr.c.control, &(_sync_ptr->c.control), sizeof(struct snd_pcm_mmap_control)))
-		return -EFAULT;	
 	status = runtime->status;
 	control = runtime->control;
-	if (sync_ptr.flags & SNDRV_PCM_SYNC_PTR_HWSYNC) {
+	if (sync_ptr->flags & SNDRV_PCM_SYNC_PTR_HWSYNC) {
 		err = snd_pcm_hwsync(substream);
 		if (err < 0)
 			return err;
 	}
 	snd_pcm_stream_lock_irq(substream);
-	if (!(sync_ptr.flags & SNDRV_PCM_SYNC_PTR_APPL)) {
+	if (!(sync_ptr->flags & SNDRV_PCM_SYNC_PTR_APPL)) {
 		err = pcm_lib_apply_appl_ptr(substream,
-					     sync_ptr.c.control.appl_ptr);
+					     sync_ptr->c.control.appl_ptr);
 		if (err < 0) {
 			snd_pcm_stream_unlock_irq(substream);
 			return err;
 		}
 	} else {
-		sync_ptr.c.control.appl_ptr = control->appl_ptr;
+		sync_ptr->c.control.appl_ptr = control->appl_ptr;
 	}
-	if (!(sync_ptr.flags & SNDRV_PCM_SYNC_PTR_AVAIL_MIN))
-		control->avail_min = sync_ptr.c.control.avail_min;
+	if (!(sync_ptr->flags & SNDRV_PCM_SYNC_PTR_AVAIL_MIN))
+		control->avail_min = sync_ptr->c.control.avail_min;
 	else
-		sync_ptr.c.control.avail_min = control->avail_min;
-	sync_ptr.s.status.state = status->state;
-	sync_ptr.s.status.hw_ptr = status->hw_ptr;
-	sync_ptr.s.status.tstamp = status->tstamp;
-	sync_ptr.s.status.suspended_state = status->suspended_state;
-	sync_ptr.s.status.audio_tstamp = status->audio_tstamp;
+		sync_ptr->c.control.avail_min = control->avail_min;
+	sync_ptr->s.status.state = status->state;
+	sync_ptr->s.status.hw_ptr = status->hw_ptr;
+	sync_ptr->s.status.tstamp = status->tstamp;
+	sync_ptr->s.status.suspended_state = status->suspended_state;
+	sync_ptr->s.status.audio_tstamp = status->audio_tstamp;
 	snd_pcm_stream_unlock_irq(substream);
+	return 0;
+}
+
+static int snd_pcm_sync_ptr(struct snd_pcm_substream *substream,
+			    struct snd_pcm_sync_ptr __user *_sync_ptr)
+{
+	struct snd_pcm_sync_ptr sync_ptr;
+	int err;
+
+	memset(&sync_ptr, 0, sizeof(sync_ptr));
+	if (get_user(sync_ptr.flags, (unsigned __user *)&(_sync_ptr->flags)))
+		return -EFAULT;
+	if (copy_from_user(&sync_ptr.c.control, &(_sync_ptr->c.control), sizeof(struct snd_pcm_mmap_control)))
+		return -EFAULT;
+	err = snd_pcm_do_sync_ptr(substream, &sync_ptr);
+	if (err < 0)
+		return err;
 	if (copy_to_user(_sync_ptr, &sync_ptr, sizeof(sync_ptr)))
 		return -EFAULT;
 	return 0;
 }
 
+/* in-kernel cap on SNDRV_PCM_IOCTL_SYNC_PTR_VEC vector length */
+#define SNDRV_PCM_SYNC_VEC_MAX	256
+
+static int snd_pcm_sync_vec_one(struct snd_pcm_substream *substream,
+				struct snd_pcm_sync_vec_entry *entry)
+{
+	struct snd_pcm_substream *target;
+	struct fd f;
+	int err;
+
+	if (entry->fd < 0) {
+		if (PCM_RUNTIME_CHECK(substream))
+			return -ENXIO;
+		return snd_pcm_do_sync_ptr(substream, &entry->sync);
+	}
+
+	f = fdget(entry->fd);
+	if (!f.file)
+		return -EBADFD;
+	if (!is_pcm_file(f.file)) {
+		err = -EBADFD;
+		goto out;
+	}
+	target = ((struct snd_pcm_file *)f.file->private_data)->substream;
+	if (PCM_RUNTIME_CHECK(target)) {
+		err = -ENXIO;
+		goto out;
+	}
+	err = snd_power_wait(target->pcm->card, SNDRV_CTL_POWER_D0);
+	if (err < 0)
+		goto out;
+	err = snd_pcm_do_sync_ptr(target, &entry->sync);
+ out:
+	fdput(f);
+	return err;
+}
+
+static int snd_pcm_sync_ptr_vec(struct snd_pcm_substream *substream,
+				struct snd_pcm_sync_vec __user *_vec)
+{
+	struct snd_pcm_sync_vec vec;
+	struct snd_pcm_sync_vec_entry *entries;
+	size_t size;
+	unsigned int i;
+	int err = 0;
+
+	if (copy_from_user(&vec, _vec, sizeof(vec)))
+		return -EFAULT;
+	if (vec.reserved)
+		return -EINVAL;
+	if (!vec.count || vec.count > SNDRV_PCM_SYNC_VEC_MAX)
+		return -EINVAL;
+	size = array_size(vec.count, sizeof(*entries));
+	entries = kvmalloc(size, GFP_KERNEL);
+	if (!entries)
+		return -ENOMEM;
+	if (copy_from_user(entries, _vec->entries, size)) {
+		err = -EFAULT;
+		goto out;
+	}
+	for (i = 0; i < vec.count; i++)
+		entries[i].result = snd_pcm_sync_vec_one(substream,
+							 &entries[i]);
+	if (copy_to_user(_vec->entries, entries, size))
+		err = -EFAULT;
+ out:
+	kvfree(entries);
+	return err;
+}
+
 struct snd_pcm_mmap_status32 {
 	snd_pcm_state_t state;
 	s32 pad1;
@@ -3230,6 +3315,8 @@ static int snd_pcm_common_ioctl(struct file *file,
 		return snd_pcm_ioctl_sync_ptr_compat(substream, arg);
 	case __SNDRV_PCM_IOCTL_SYNC_PTR64:
 		return snd_pcm_sync_ptr(substream, arg);
+	case SNDRV_PCM_IOCTL_SYNC_PTR_VEC:
+		return snd_pcm_sync_ptr_vec(substream, arg);
 #ifdef CONFIG_SND_SUPPORT_OLD_API
 	case SNDRV_PCM_IOCTL_HW_REFINE_OLD:
 		return snd_pcm_hw_refine_old_user(substream, arg);
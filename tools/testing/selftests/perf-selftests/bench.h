@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Shared plumbing for the performance selftests: monotonic timing,
+ * threshold lookup and the machine-readable result record.
+ *
+ * Every benchmark emits exactly one record of the form
+ *
+ *	# PERF <name> ops=<N> total_ns=<N> ns_per_op=<N> threshold_ns=<N>
+ *
+ * followed by a TAP ok/not ok line, so a qualification pipeline can both
+ * gate on the TAP result and archive the raw numbers.  The pass/fail
+ * threshold is the compiled-in default unless <NAME>_THRESHOLD_NS is set
+ * in the environment; a threshold of 0 makes the run report-only, which
+ * is how baselines are collected on new hardware.
+ */
+#ifndef _PERF_SELFTESTS_BENCH_H
+#define _PERF_SELFTESTS_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../kselftest.h"
+
+static inline unsigned long long bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline unsigned long long bench_threshold_ns(const char *name,
+						    unsigned long long def)
+{
+	char var[64];
+	const char *val;
+
+	snprintf(var, sizeof(var), "%s_THRESHOLD_NS", name);
+	val = getenv(var);
+	return val ? strtoull(val, NULL, 0) : def;
+}
+
+static inline void bench_report(const char *name, unsigned long long ops,
+				unsigned long long ns,
+				unsigned long long threshold)
+{
+	unsigned long long ns_per_op = ops ? ns / ops : 0;
+
+	printf("# PERF %s ops=%llu total_ns=%llu ns_per_op=%llu threshold_ns=%llu\n",
+	       name, ops, ns, ns_per_op, threshold);
+
+	if (threshold && ns_per_op > threshold)
+		ksft_test_result_fail("%s: %llu ns/op exceeds threshold %llu\n",
+				      name, ns_per_op, threshold);
+	else
+		ksft_test_result_pass("%s: %llu ns/op\n", name, ns_per_op);
+}
+
+#endif /* _PERF_SELFTESTS_BENCH_H */
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Measure futex wake chains out of kernel/futex.c.
+ *
+ * NR_WAITERS threads park on a shared futex word; the main thread waits
+ * until all of them have announced themselves, bumps the word and issues
+ * one FUTEX_WAKE for the lot.  Only the wake syscall is timed, and ops
+ * counts the threads the kernel actually woke, so the reported ns/op is
+ * the per-waiter cost of the hash bucket walk plus wake_up_process().
+ *
+ * A waiter that announced itself but has not yet reached futex_wait()
+ * sees the bumped word and returns EAGAIN instead of sleeping, so there
+ * are no lost wakeups; such waiters simply do not count towards ops.
+ */
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+#include "bench.h"
+
+#define NR_WAITERS	8
+#define WARMUP_ITERS	200
+#define TIMED_ITERS	2000
+#define DEFAULT_THRESHOLD_NS	50000ULL
+
+static unsigned int gate;
+static atomic_int parked;
+static atomic_int stop;
+
+static int futex(unsigned int *uaddr, int op, unsigned int val)
+{
+	return syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+}
+
+static void *waiter_fn(void *arg)
+{
+	while (!atomic_load(&stop)) {
+		unsigned int seq = __atomic_load_n(&gate, __ATOMIC_ACQUIRE);
+
+		atomic_fetch_add(&parked, 1);
+		futex(&gate, FUTEX_WAIT_PRIVATE, seq);
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t threads[NR_WAITERS];
+	unsigned long long t0, ns = 0, ops = 0;
+	int i, woken;
+
+	ksft_print_header();
+	ksft_set_plan(1);
+
+	for (i = 0; i < NR_WAITERS; i++)
+		if (pthread_create(&threads[i], NULL, waiter_fn, NULL))
+			ksft_exit_fail_msg("pthread_create: %m\n");
+
+	for (i = 0; i < WARMUP_ITERS + TIMED_ITERS; i++) {
+		while (atomic_load(&parked) < NR_WAITERS)
+			sched_yield();
+		atomic_store(&parked, 0);
+
+		__atomic_add_fetch(&gate, 1, __ATOMIC_RELEASE);
+		t0 = bench_now_ns();
+		woken = futex(&gate, FUTEX_WAKE_PRIVATE, NR_WAITERS);
+		if (i >= WARMUP_ITERS) {
+			ns += bench_now_ns() - t0;
+			ops += woken;
+		}
+	}
+
+	/*
+	 * A waiter may park just after the final wake; keep bumping and
+	 * waking until every thread has been reaped.
+	 */
+	atomic_store(&stop, 1);
+	for (i = 0; i < NR_WAITERS; i++) {
+		while (pthread_tryjoin_np(threads[i], NULL) == EBUSY) {
+			__atomic_add_fetch(&gate, 1, __ATOMIC_RELEASE);
+			futex(&gate, FUTEX_WAKE_PRIVATE, NR_WAITERS);
+			sched_yield();
+		}
+	}
+
+	bench_report("futex_wake", ops, ns,
+		     bench_threshold_ns("FUTEX_WAKE", DEFAULT_THRESHOLD_NS));
+
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+	ksft_exit_pass();
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Measure anonymous fault scaling out of mm/memory.c.
+ *
+ * NR_THREADS threads each take a private anonymous mapping and touch one
+ * byte per page, so every touch is a minor fault through
+ * handle_mm_fault() with all threads sharing one mm and its mmap_sem.
+ * One op is one faulted page; the threads start together behind a
+ * barrier and the clock stops when the last one finishes, so lock
+ * contention shows up in the reported ns/op rather than hiding in skew.
+ */
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define NR_THREADS	4
+#define BYTES_PER_THREAD	(64UL * 1024 * 1024)
+#define DEFAULT_THRESHOLD_NS	20000ULL
+
+static pthread_barrier_t barrier;
+static long page_size;
+
+static void *fault_fn(void *arg)
+{
+	unsigned long off;
+	char *map;
+
+	map = mmap(NULL, BYTES_PER_THREAD, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		/* still meet the barrier so main doesn't block forever */
+		pthread_barrier_wait(&barrier);
+		return (void *)1;
+	}
+
+	pthread_barrier_wait(&barrier);
+
+	for (off = 0; off < BYTES_PER_THREAD; off += page_size)
+		map[off] = 1;
+
+	munmap(map, BYTES_PER_THREAD);
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t threads[NR_THREADS];
+	unsigned long long t0, ns, ops;
+	void *err = NULL, *thread_err;
+	int i;
+
+	ksft_print_header();
+	ksft_set_plan(1);
+
+	page_size = sysconf(_SC_PAGESIZE);
+	pthread_barrier_init(&barrier, NULL, NR_THREADS + 1);
+
+	for (i = 0; i < NR_THREADS; i++)
+		if (pthread_create(&threads[i], NULL, fault_fn, NULL))
+			ksft_exit_fail_msg("pthread_create: %m\n");
+
+	pthread_barrier_wait(&barrier);
+	t0 = bench_now_ns();
+
+	for (i = 0; i < NR_THREADS; i++) {
+		pthread_join(threads[i], &thread_err);
+		if (thread_err)
+			err = thread_err;
+	}
+	ns = bench_now_ns() - t0;
+
+	if (err)
+		ksft_exit_fail_msg("mmap failed in a worker thread\n");
+
+	ops = NR_THREADS * (BYTES_PER_THREAD / page_size);
+	bench_report("mmap_fault", ops, ns,
+		     bench_threshold_ns("MMAP_FAULT", DEFAULT_THRESHOLD_NS));
+
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+	ksft_exit_pass();
+}
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Measure pipe throughput out of fs/pipe.c.
+ *
+ * A forked child drains the pipe as fast as it can while the parent
+ * streams CHUNK_SIZE writes into it, so the pipe stays full and the
+ * timed loop exercises pipe_write()'s buffer handling, wakeups and the
+ * copy in/out of pipe buffers.  One op is one CHUNK_SIZE write; the
+ * aggregate throughput is printed alongside for human consumption.
+ */
+#define _GNU_SOURCE
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#define CHUNK_SIZE	(64 * 1024)
+#define TOTAL_BYTES	(256UL * 1024 * 1024)
+#define DEFAULT_THRESHOLD_NS	500000ULL
+
+int main(void)
+{
+	unsigned long long t0, ns, ops = 0;
+	unsigned long left;
+	char *buf;
+	int pipefd[2];
+	ssize_t ret;
+	pid_t pid;
+
+	ksft_print_header();
+	ksft_set_plan(1);
+
+	buf = malloc(CHUNK_SIZE);
+	if (!buf)
+		ksft_exit_fail_msg("malloc: %m\n");
+	memset(buf, 0x5a, CHUNK_SIZE);
+
+	if (pipe(pipefd) < 0)
+		ksft_exit_fail_msg("pipe: %m\n");
+
+	pid = fork();
+	if (pid < 0)
+		ksft_exit_fail_msg("fork: %m\n");
+	if (pid == 0) {
+		close(pipefd[1]);
+		while (read(pipefd[0], buf, CHUNK_SIZE) > 0)
+			;
+		_exit(0);
+	}
+	close(pipefd[0]);
+
+	t0 = bench_now_ns();
+	for (left = TOTAL_BYTES; left; left -= CHUNK_SIZE) {
+		ret = write(pipefd[1], buf, CHUNK_SIZE);
+		if (ret != CHUNK_SIZE)
+			ksft_exit_fail_msg("write: %m\n");
+		ops++;
+	}
+	ns = bench_now_ns() - t0;
+
+	close(pipefd[1]);
+	waitpid(pid, NULL, 0);
+
+	ksft_print_msg("pipe throughput: %llu MB/s\n",
+		       ns ? TOTAL_BYTES * 1000ULL / ns : 0);
+	bench_report("pipe_throughput", ops, ns,
+		     bench_threshold_ns("PIPE_THROUGHPUT",
+					DEFAULT_THRESHOLD_NS));
+
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+	ksft_exit_pass();
+}
@@ -44,8 +44,35 @@ irqfd_inject(struct work_struct *work)
 	struct kvm_kernel_irqfd *irqfd =
 		container_of(work, struct kvm_kernel_irqfd, inject);
 	struct kvm *kvm = irqfd->kvm;
+	struct kvm_kernel_irq_routing_entry irq;
+	unsigned seq;
+	int idx;
 
 	if (!irqfd->resampler) {
+		/*
+		 * When the gsi maps to a single routing entry, use the
+		 * cached copy kept up to date by irqfd_update() instead of
+		 * having kvm_set_irq() walk the routing table for every
+		 * injection.  This is the path high-rate sources (e.g.
+		 * vhost queues) take on archs without an inatomic
+		 * injection fastpath.
+		 */
+		idx = srcu_read_lock(&kvm->irq_srcu);
+		do {
+			seq = read_seqcount_begin(&irqfd->irq_entry_sc);
+			irq = irqfd->irq_entry;
+		} while (read_seqcount_retry(&irqfd->irq_entry_sc, seq));
+		srcu_read_unlock(&kvm->irq_srcu, idx);
+
+		/* Like kvm_set_irq(), ->set is called on a local copy. */
+		if (irq.type && irq.set) {
+			irq.set(&irq, kvm, KVM_USERSPACE_IRQ_SOURCE_ID, 1,
+				false);
+			irq.set(&irq, kvm, KVM_USERSPACE_IRQ_SOURCE_ID, 0,
+				false);
+			return;
+		}
+
 		kvm_set_irq(kvm, KVM_USERSPACE_IRQ_SOURCE_ID, irqfd->gsi, 1,
 				false);
 		kvm_set_irq(kvm, KVM_USERSPACE_IRQ_SOURCE_ID, irqfd->gsi, 0,